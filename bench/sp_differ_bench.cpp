@@ -0,0 +1,412 @@
+#include "../src/core/case.h"
+#include "../src/core/diff.h"
+#include "../src/core/io.h"
+#include "../src/core/sha256.h"
+#include "../src/core/validate.h"
+#include "../src/runner/worker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+  std::string filter;
+  // Target wall time of one sample; each benchmark takes kSamples of them.
+  double sample_ms = 40.0;
+  bool list = false;
+};
+
+constexpr int kSamples = 5;
+
+struct BenchResult {
+  std::string name;
+  double ns_per_op = 0.0;
+  double ns_per_op_min = 0.0;
+  uint64_t iterations = 0;
+  size_t bytes_per_op = 0;
+};
+
+// Keeps the compiler from discarding a result the benchmark never reads.
+template <typename T>
+void KeepAlive(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+// Doubles the iteration count until one sample takes sample_ms, then reports
+// the median of kSamples samples. The median shrugs off the odd descheduled
+// sample; the minimum is kept as well for noisy machines.
+template <typename Fn>
+BenchResult Measure(const std::string& name, size_t bytes_per_op, const BenchOptions& options,
+                    Fn fn) {
+  using Clock = std::chrono::steady_clock;
+  auto run = [&fn](uint64_t iterations) {
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+      fn();
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  };
+
+  uint64_t iterations = 1;
+  double target_ns = options.sample_ms * 1e6;
+  for (;;) {
+    double elapsed = run(iterations);
+    if (elapsed >= target_ns || iterations >= (1ull << 40)) {
+      break;
+    }
+    // Jump most of the way once the timing is meaningful.
+    double scale = elapsed > target_ns / 100 ? target_ns / elapsed * 1.1 : 10.0;
+    iterations = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(iterations * scale));
+  }
+
+  std::vector<double> samples;
+  for (int s = 0; s < kSamples; ++s) {
+    samples.push_back(run(iterations) / static_cast<double>(iterations));
+  }
+  std::sort(samples.begin(), samples.end());
+  BenchResult result;
+  result.name = name;
+  result.ns_per_op = samples[kSamples / 2];
+  result.ns_per_op_min = samples[0];
+  result.iterations = iterations * kSamples;
+  result.bytes_per_op = bytes_per_op;
+  return result;
+}
+
+struct Suite {
+  BenchOptions options;
+  std::vector<BenchResult> results;
+
+  template <typename Fn>
+  void Add(const std::string& name, size_t bytes_per_op, Fn fn) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+      return;
+    }
+    if (options.list) {
+      std::cout << name << std::endl;
+      return;
+    }
+    BenchResult result = Measure(name, bytes_per_op, options, fn);
+    std::cout << "BENCH: " << result.name << std::fixed << std::setprecision(1)
+              << " ns_per_op=" << result.ns_per_op << " ns_per_op_min=" << result.ns_per_op_min;
+    if (bytes_per_op > 0) {
+      std::cout << " mb_per_s=" << bytes_per_op * 1e3 / result.ns_per_op;
+    }
+    std::cout << std::endl;
+    results.push_back(result);
+  }
+};
+
+std::vector<uint8_t> HexText(size_t bytes) {
+  static const char kDigits[] = "0123456789abcdef";
+  std::vector<uint8_t> text;
+  uint32_t state = 0x12345678;
+  for (size_t i = 0; i < bytes; ++i) {
+    state = state * 1664525u + 1013904223u;
+    text.push_back(static_cast<uint8_t>(kDigits[state >> 28]));
+    text.push_back(static_cast<uint8_t>(kDigits[(state >> 24) & 0xf]));
+  }
+  return text;
+}
+
+// The example vector with its input repeated to input_count entries.
+std::vector<uint8_t> CaseWithInputs(const sp_differ::Case& example, size_t input_count) {
+  sp_differ::Case c = example;
+  c.inputs.clear();
+  for (size_t i = 0; i < input_count; ++i) {
+    sp_differ::InputEntry input = example.inputs[0];
+    input.outpoint_vout = static_cast<uint32_t>(i);
+    c.inputs.push_back(input);
+  }
+  std::vector<uint8_t> payload;
+  sp_differ::SerializeCaseV1(c, &payload);
+  return payload;
+}
+
+// The example vector paying label_count labeled spend keys.
+std::vector<uint8_t> CaseWithLabels(const sp_differ::Case& example, size_t label_count) {
+  sp_differ::Case c = example;
+  c.labels.clear();
+  for (size_t i = 0; i < label_count; ++i) {
+    c.labels.push_back(static_cast<uint32_t>((i + 1) * 2654435761u));
+  }
+  std::vector<uint8_t> payload;
+  sp_differ::SerializeCaseV1(c, &payload);
+  return payload;
+}
+
+std::vector<uint8_t> OutputWith(uint16_t count) {
+  std::vector<uint8_t> output = {1, 0, static_cast<uint8_t>(count & 0xff),
+                                 static_cast<uint8_t>(count >> 8)};
+  output.resize(4 + count * (33 + 32), 0x02);
+  return output;
+}
+
+// Distinct records, or the same records in reverse order.
+std::vector<uint8_t> OutputWithRecords(uint16_t count, bool reversed) {
+  std::vector<uint8_t> output = OutputWith(count);
+  for (uint16_t i = 0; i < count; ++i) {
+    uint16_t record = reversed ? count - 1 - i : i;
+    output[4 + i * 33] = static_cast<uint8_t>(record);
+    output[4 + i * 33 + 1] = static_cast<uint8_t>(record >> 8);
+    output[4 + count * 33 + i * 32] = static_cast<uint8_t>(record);
+    output[4 + count * 33 + i * 32 + 1] = static_cast<uint8_t>(record >> 8);
+  }
+  return output;
+}
+
+void RunCoreBenchmarks(Suite* suite, const std::vector<uint8_t>& example_payload,
+                       const sp_differ::Case& example) {
+  std::string error;
+  std::vector<uint8_t> decoded;
+  for (size_t bytes : {64u, 1024u, 65536u}) {
+    std::vector<uint8_t> text = HexText(bytes);
+    suite->Add("decode_hex/" + std::to_string(bytes) + "B", text.size(), [&] {
+      sp_differ::DecodeHex(text.data(), text.size(), &decoded, &error);
+      KeepAlive(decoded);
+    });
+  }
+
+  for (size_t inputs : {1u, 16u, 256u}) {
+    std::vector<uint8_t> payload = CaseWithInputs(example, inputs);
+    sp_differ::Case parsed;
+    sp_differ::CaseView view;
+    suite->Add("parse_case_v1/inputs=" + std::to_string(inputs), payload.size(), [&] {
+      sp_differ::ParseCaseV1(payload, &parsed, &error);
+      KeepAlive(parsed);
+    });
+    suite->Add("parse_case_view_v1/inputs=" + std::to_string(inputs), payload.size(), [&] {
+      sp_differ::ParseCaseViewV1(payload.data(), payload.size(), &view, &error);
+      KeepAlive(view);
+    });
+  }
+
+  suite->Add("validate_case_header", example_payload.size(), [&] {
+    bool ok = sp_differ::ValidateCaseHeader(example_payload.data(), example_payload.size(), &error);
+    KeepAlive(ok);
+  });
+
+  for (uint16_t count : {0, 1, 16}) {
+    std::vector<uint8_t> output = OutputWith(count);
+    suite->Add("validate_output_payload/outputs=" + std::to_string(count), output.size(), [&] {
+      bool ok = sp_differ::ValidateOutputPayload(output.data(), output.size(), &error);
+      KeepAlive(ok);
+    });
+  }
+
+  // The equal path of both compare modes, and the record matching an
+  // unordered compare falls back to when the order differs.
+  sp_differ::DiffScratch scratch;
+  std::vector<sp_differ::FieldDiff> diffs;
+  for (uint16_t count : {1, 16, 256}) {
+    std::vector<uint8_t> left = OutputWithRecords(count, false);
+    std::vector<uint8_t> right = OutputWithRecords(count, true);
+    std::string suffix = "/outputs=" + std::to_string(count);
+    suite->Add("outputs_equal/ordered" + suffix, left.size(), [&] {
+      bool equal = sp_differ::OutputsEqual(left.data(), left.size(), left.data(), left.size(),
+                                           sp_differ::CompareMode::kOrdered, &scratch);
+      KeepAlive(equal);
+    });
+    suite->Add("outputs_equal/unordered_reversed" + suffix, left.size(), [&] {
+      bool equal = sp_differ::OutputsEqual(left.data(), left.size(), right.data(), right.size(),
+                                           sp_differ::CompareMode::kUnordered, &scratch);
+      KeepAlive(equal);
+    });
+    suite->Add("diff_outputs/ordered_reversed" + suffix, left.size(), [&] {
+      sp_differ::DiffOutputs(left.data(), left.size(), right.data(), right.size(),
+                             sp_differ::CompareMode::kOrdered, &scratch, &diffs);
+      KeepAlive(diffs);
+    });
+  }
+}
+
+// Each SHA-256 backend the CPU supports, on one block and on the per-output
+// tweak hashes of a case: 37-byte messages under the SharedSecret tag.
+void RunHashBenchmarks(Suite* suite) {
+  const sp_differ::Sha256Backend active = sp_differ::Sha256ActiveBackend();
+  std::vector<uint8_t> messages(64 * 37, 0x5a);
+  std::vector<uint8_t> digests(64 * 32);
+  for (sp_differ::Sha256Backend backend :
+       {sp_differ::Sha256Backend::kScalar, sp_differ::Sha256Backend::kAvx2,
+        sp_differ::Sha256Backend::kShaNi}) {
+    if (!sp_differ::Sha256UseBackend(backend)) {
+      continue;
+    }
+    std::string name = sp_differ::Sha256BackendName(backend);
+    suite->Add("sha256/" + name + "/64B", 64, [&] {
+      sp_differ::Sha256 sha;
+      sp_differ::Sha256Init(&sha);
+      sp_differ::Sha256Update(&sha, messages.data(), 64);
+      sp_differ::Sha256Final(&sha, digests.data());
+      KeepAlive(digests);
+    });
+    for (size_t count : {1u, 8u, 64u}) {
+      suite->Add("tagged_hash_many/" + name + "/outputs=" + std::to_string(count), count * 37,
+                 [&] {
+                   sp_differ::TaggedHashMany(sp_differ::HashTag::kBip352SharedSecret,
+                                             messages.data(), 37, count, digests.data());
+                   KeepAlive(digests);
+                 });
+    }
+  }
+  sp_differ::Sha256UseBackend(active);
+}
+
+// FFI round trip: one case in, one result out, through the loaded library.
+// The label sweep stops at max_labels, since a slow worker would spend
+// seconds on a single receiver with thousands of labels.
+void RunWorkerBenchmarks(Suite* suite, const std::string& name,
+                         const std::vector<uint8_t>& example_payload,
+                         const sp_differ::Case& example, size_t max_labels) {
+  const size_t kLabelCounts[] = {16, 256, 4096};
+  if (suite->options.list) {
+    suite->Add("run_worker/" + name, 0, [] {});
+    suite->Add("run_worker_batch64/" + name, 0, [] {});
+    for (size_t labels : kLabelCounts) {
+      if (labels <= max_labels) {
+        suite->Add("run_worker_labels/" + name + "/labels=" + std::to_string(labels), 0, [] {});
+      }
+    }
+    return;
+  }
+  sp_differ::WorkerApi api;
+  std::string error;
+  if (!sp_differ::LoadWorker(sp_differ::ResolveWorkerPath(name), &api, &error)) {
+    std::cerr << "NOTE: skipping " << name << " worker: " << error << std::endl;
+    return;
+  }
+  std::vector<uint8_t> output;
+  suite->Add("run_worker/" + name, example_payload.size(), [&] {
+    sp_differ::RunWorker(api, example_payload, &output, &error);
+    KeepAlive(output);
+  });
+
+  // Per-call cost of a 64-case batch; divide by 64 for the per-case cost.
+  std::vector<uint8_t> inputs;
+  std::vector<size_t> offsets(1, 0);
+  for (int i = 0; i < 64; ++i) {
+    inputs.insert(inputs.end(), example_payload.begin(), example_payload.end());
+    offsets.push_back(inputs.size());
+  }
+  std::vector<uint8_t> outputs;
+  std::vector<size_t> output_offsets;
+  suite->Add("run_worker_batch64/" + name, inputs.size(), [&] {
+    sp_differ::RunWorkerBatch(api, inputs.data(), inputs.size(), offsets, &outputs,
+                              &output_offsets, &error);
+    KeepAlive(outputs);
+  });
+
+  // One output to a receiver with many labels: the labeled spend keys,
+  // not the output, dominate the cost.
+  for (size_t labels : kLabelCounts) {
+    if (labels > max_labels) {
+      continue;
+    }
+    std::vector<uint8_t> payload = CaseWithLabels(example, labels);
+    suite->Add("run_worker_labels/" + name + "/labels=" + std::to_string(labels), payload.size(),
+               [&] {
+                 sp_differ::RunWorker(api, payload, &output, &error);
+                 KeepAlive(output);
+               });
+  }
+  sp_differ::UnloadWorker(&api);
+}
+
+void AppendJsonString(const std::string& text, std::ostream& out) {
+  out << '"';
+  for (char ch : text) {
+    if (ch == '"' || ch == '\\') {
+      out << '\\';
+    }
+    out << ch;
+  }
+  out << '"';
+}
+
+// Every result is a "lower is better" ns/op figure; scripts/bench.py adds the
+// macro results and does the baseline comparison.
+bool WriteJson(const std::string& path, const std::vector<BenchResult>& results,
+               std::string* error) {
+  std::ofstream out(path, std::ios::trunc);
+  out << "{\"schema\":1,\"suite\":\"micro\",\"results\":[";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchResult& result = results[i];
+    out << (i == 0 ? "\n" : ",\n") << "  {\"name\":";
+    AppendJsonString(result.name, out);
+    out << std::fixed << std::setprecision(3) << ",\"value\":" << result.ns_per_op
+        << ",\"unit\":\"ns/op\",\"better\":\"lower\",\"min\":" << result.ns_per_op_min
+        << ",\"iterations\":" << result.iterations << ",\"bytes_per_op\":" << result.bytes_per_op
+        << "}";
+  }
+  out << "\n]}\n";
+  if (!out) {
+    *error = "unable to write " + path;
+    return false;
+  }
+  return true;
+}
+
+void PrintUsage() {
+  std::cout << "usage: sp_differ_bench [--filter <substring>] [--sample-ms <ms>] [--out <json>]"
+            << " [--list]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Suite suite;
+  std::string out_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc) {
+      suite.options.filter = argv[++i];
+    } else if (arg == "--sample-ms" && i + 1 < argc) {
+      suite.options.sample_ms = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--out" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else if (arg == "--list") {
+      suite.options.list = true;
+    } else if (arg == "--help" || arg == "-h") {
+      PrintUsage();
+      return 0;
+    } else {
+      std::cerr << "FAIL: unexpected argument " << arg << std::endl;
+      PrintUsage();
+      return 2;
+    }
+  }
+
+  std::string error;
+  std::vector<uint8_t> example_payload;
+  sp_differ::Case example;
+  if (!sp_differ::ReadCasePayload("tests/vectors/example.hex", &example_payload, &error) ||
+      !sp_differ::ParseCaseV1(example_payload, &example, &error)) {
+    std::cerr << "FAIL: tests/vectors/example.hex: " << error << std::endl;
+    return 2;
+  }
+
+  RunCoreBenchmarks(&suite, example_payload, example);
+  RunHashBenchmarks(&suite);
+  RunWorkerBenchmarks(&suite, "cpp", example_payload, example, 4096);
+  RunWorkerBenchmarks(&suite, "rust", example_payload, example, 256);
+
+  if (!out_path.empty() && !suite.options.list && !WriteJson(out_path, suite.results, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  return 0;
+}
@@ -17,6 +17,15 @@ extern "C" {
 #endif
 
 #define SP_DIFFER_WORKER_API_VERSION 1
+#define SP_DIFFER_WORKER_BATCH_API_VERSION 1
+
+/* Returned by sp_differ_worker_run_into when the caller buffer is too small. */
+#define SP_DIFFER_WORKER_NEED_BUFFER 1
+
+/* Capability bits returned by sp_differ_worker_capabilities. */
+#define SP_DIFFER_WORKER_CAP_REENTRANT (1u << 0)
+#define SP_DIFFER_WORKER_CAP_BATCH (1u << 1)
+#define SP_DIFFER_WORKER_CAP_RUN_INTO (1u << 2)
 
 typedef enum sp_differ_status {
   SP_DIFFER_STATUS_OK = 0,
@@ -55,10 +64,84 @@ int sp_differ_worker_run(const uint8_t* input, size_t input_len,
                          uint8_t** output, size_t* output_len);
 
 /*
- * Frees a buffer returned by sp_differ_worker_run.
+ * Frees a buffer returned by sp_differ_worker_run or
+ * sp_differ_worker_run_batch.
  */
 void sp_differ_worker_free(uint8_t* output);
 
+/*
+ * Optional. Returns the batch ABI version implemented by
+ * sp_differ_worker_run_batch. Runners only call the batch entry point when
+ * this returns SP_DIFFER_WORKER_BATCH_API_VERSION and fall back to
+ * sp_differ_worker_run otherwise.
+ */
+uint32_t sp_differ_worker_batch_api_version(void);
+
+/*
+ * Optional. Executes case_count test cases in a single call.
+ *
+ * Inputs:
+ *   - inputs: canonical case payloads packed back to back
+ *   - input_offsets: case_count + 1 offsets into inputs; case i spans
+ *     [input_offsets[i], input_offsets[i + 1])
+ *   - case_count: number of cases in the batch
+ *
+ * Outputs:
+ *   - output: pointer to a worker-owned buffer holding every result payload
+ *     back to back, in case order
+ *   - output_len: length of the output buffer in bytes
+ *   - output_offsets: caller-provided array of case_count + 1 entries; the
+ *     worker stores offsets so that result i spans
+ *     [output_offsets[i], output_offsets[i + 1]). An empty span means the
+ *     case failed as if sp_differ_worker_run had returned nonzero.
+ *
+ * Ownership:
+ *   - The worker owns the output buffer and must free it via
+ *     sp_differ_worker_free.
+ *
+ * Returns:
+ *   - 0 on success, nonzero if the whole batch failed (no output is produced).
+ */
+int sp_differ_worker_run_batch(const uint8_t* inputs, const size_t* input_offsets,
+                               size_t case_count, uint8_t** output, size_t* output_len,
+                               size_t* output_offsets);
+
+/*
+ * Optional. Executes a single test case into a caller-owned buffer.
+ *
+ * Inputs:
+ *   - input: pointer to canonical case bytes (spec/FORMAT.md)
+ *   - input_len: length of input in bytes
+ *   - output: caller-owned buffer, may be null when output_capacity is 0
+ *   - output_capacity: size of the output buffer in bytes
+ *
+ * Outputs:
+ *   - output_len: number of result bytes written to output, or the number
+ *     of bytes required when SP_DIFFER_WORKER_NEED_BUFFER is returned
+ *
+ * Returns:
+ *   - 0 on success.
+ *   - SP_DIFFER_WORKER_NEED_BUFFER if output_capacity is too small. Nothing
+ *     is written; the caller may grow the buffer and call again.
+ *   - Any other nonzero value on failure (no output is produced).
+ */
+int sp_differ_worker_run_into(const uint8_t* input, size_t input_len, uint8_t* output,
+                              size_t output_capacity, size_t* output_len);
+
+/*
+ * Optional. Returns a bitmask of SP_DIFFER_WORKER_CAP_* values.
+ *
+ *   - SP_DIFFER_WORKER_CAP_REENTRANT: every run entry point may be called
+ *     concurrently from multiple threads.
+ *   - SP_DIFFER_WORKER_CAP_BATCH: sp_differ_worker_run_batch is available.
+ *   - SP_DIFFER_WORKER_CAP_RUN_INTO: sp_differ_worker_run_into is available.
+ *
+ * When this symbol is exported, runners only use the optional entry points
+ * whose bits are set. When it is absent, runners detect optional entry points
+ * by symbol and treat the worker as not reentrant.
+ */
+uint32_t sp_differ_worker_capabilities(void);
+
 #ifdef __cplusplus
 }
 #endif
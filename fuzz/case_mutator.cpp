@@ -0,0 +1,310 @@
+#include "case_mutator.h"
+
+#include "../src/core/case.h"
+#include "../src/core/generate.h"
+
+#include <cstring>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+constexpr size_t kFlagsOffset = 9;
+constexpr size_t kOutputCountOffset = 15;
+constexpr uint32_t kFlagNegative = 1u << 0;
+constexpr uint32_t kFlagPrivkeys = 1u << 1;
+constexpr uint32_t kFlagPubkeys = 1u << 2;
+
+enum Mutation {
+  kFlipNegative,
+  kToggleKeyMaterial,
+  kAddInput,
+  kDropInput,
+  kSwapInputType,
+  kFlipKeyBit,
+  kSetPubkeyPrefix,
+  kCopyPubkey,
+  kSetLabel,
+  kAddLabel,
+  kDropLabel,
+  kOutpoint,
+  kSeed,
+  kOutputCount,
+  kMutationCount,
+};
+
+const uint32_t kInterestingLabels[] = {0, 1, 2, 0x7fffffff, 0x80000000, 0xfffffffe, 0xffffffff};
+const uint8_t kPubkeyPrefixes[] = {0x02, 0x03, 0x04, 0x00};
+
+// splitmix64; one instance per call, seeded from the fuzzer's seed.
+struct Rng {
+  uint64_t state;
+
+  uint64_t Next() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  size_t Below(size_t bound) { return bound == 0 ? 0 : static_cast<size_t>(Next() % bound); }
+
+  void Fill(uint8_t* out, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+      out[i] = static_cast<uint8_t>(Next());
+    }
+  }
+};
+
+void StoreU32(uint8_t* p, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint8_t* Writable(uint8_t* data, const uint8_t* field) {
+  return data + (field - data);
+}
+
+struct Field {
+  uint8_t* data;
+  size_t len;
+};
+
+// Every key the case carries: per-input private and public keys, then the
+// scan and spend keys.
+std::vector<Field> KeyFields(uint8_t* data, const CaseView& view, bool pubkeys_only) {
+  std::vector<Field> fields;
+  for (size_t i = 0; i < view.header.input_count; ++i) {
+    InputView input = GetInput(view, i);
+    if (input.privkey && !pubkeys_only) {
+      fields.push_back({Writable(data, input.privkey), kPrivkeySize});
+    }
+    if (input.pubkey) {
+      fields.push_back({Writable(data, input.pubkey), kPubkeySize});
+    }
+  }
+  fields.push_back({Writable(data, view.scan_pubkey), kPubkeySize});
+  fields.push_back({Writable(data, view.spend_pubkey), kPubkeySize});
+  return fields;
+}
+
+void RandomPubkey(Rng* rng, std::vector<uint8_t>* out) {
+  out->resize(kPubkeySize);
+  rng->Fill(out->data(), out->size());
+  (*out)[0] = static_cast<uint8_t>(0x02 + (rng->Next() & 1));
+}
+
+InputEntry RandomInput(Rng* rng, uint32_t flags) {
+  InputEntry input;
+  input.outpoint_txid.resize(kTxidSize);
+  rng->Fill(input.outpoint_txid.data(), kTxidSize);
+  input.outpoint_vout = static_cast<uint32_t>(rng->Below(4));
+  input.input_type = static_cast<uint8_t>(1 + rng->Below(3));
+  if (flags & kFlagPrivkeys) {
+    input.privkey.resize(kPrivkeySize);
+    rng->Fill(input.privkey.data(), kPrivkeySize);
+  }
+  if (flags & kFlagPubkeys) {
+    RandomPubkey(rng, &input.pubkey);
+  }
+  return input;
+}
+
+// Applies a mutation that changes the layout by editing an owning copy and
+// re-encoding it. Returns size unchanged when the result would not fit.
+size_t Rebuild(uint8_t* data, size_t size, size_t max_size, const CaseView& view,
+               Mutation mutation, Rng* rng) {
+  Case c;
+  CaseFromView(view, &c);
+  switch (mutation) {
+    case kToggleKeyMaterial: {
+      uint32_t bit = (rng->Next() & 1) ? kFlagPrivkeys : kFlagPubkeys;
+      c.header.flags ^= bit;
+      for (InputEntry& input : c.inputs) {
+        if (bit == kFlagPrivkeys && input.privkey.empty()) {
+          input.privkey.resize(kPrivkeySize);
+          rng->Fill(input.privkey.data(), kPrivkeySize);
+        } else if (bit == kFlagPubkeys && input.pubkey.empty()) {
+          RandomPubkey(rng, &input.pubkey);
+        }
+      }
+      break;
+    }
+    case kAddInput: {
+      if (c.inputs.size() >= 0xffff) {
+        return size;
+      }
+      InputEntry input = c.inputs.empty() || rng->Below(4) == 0
+                             ? RandomInput(rng, c.header.flags)
+                             : c.inputs[rng->Below(c.inputs.size())];
+      c.inputs.insert(c.inputs.begin() + rng->Below(c.inputs.size() + 1), input);
+      break;
+    }
+    case kDropInput:
+      if (c.inputs.empty()) {
+        return size;
+      }
+      c.inputs.erase(c.inputs.begin() + rng->Below(c.inputs.size()));
+      break;
+    case kAddLabel: {
+      if (c.labels.size() >= 0xffff) {
+        return size;
+      }
+      uint32_t label = !c.labels.empty() && rng->Below(4) == 0
+                           ? c.labels[rng->Below(c.labels.size())]
+                           : static_cast<uint32_t>(rng->Below(8));
+      c.labels.insert(c.labels.begin() + rng->Below(c.labels.size() + 1), label);
+      break;
+    }
+    case kDropLabel:
+      if (c.labels.empty()) {
+        return size;
+      }
+      c.labels.erase(c.labels.begin() + rng->Below(c.labels.size()));
+      break;
+    default:
+      return size;
+  }
+
+  static thread_local std::vector<uint8_t> encoded;
+  SerializeCaseV1(c, &encoded);
+  if (encoded.size() > max_size) {
+    return size;
+  }
+  std::memcpy(data, encoded.data(), encoded.size());
+  return encoded.size();
+}
+
+size_t MutateInPlace(uint8_t* data, size_t size, const CaseView& view, Mutation mutation,
+                     Rng* rng) {
+  size_t input_count = view.header.input_count;
+  switch (mutation) {
+    case kFlipNegative:
+      data[kFlagsOffset] ^= static_cast<uint8_t>(kFlagNegative);
+      break;
+    case kSwapInputType: {
+      if (input_count == 0) {
+        break;
+      }
+      InputView input = GetInput(view, rng->Below(input_count));
+      uint8_t* type = Writable(data, input.outpoint_txid) + kTxidSize + 4;
+      if (rng->Below(16) == 0) {
+        // Rarely step outside the valid range to exercise the type check.
+        *type = static_cast<uint8_t>(rng->Next() & 1 ? 0 : 4 + rng->Below(252));
+      } else {
+        *type = static_cast<uint8_t>(1 + (*type + rng->Below(2)) % 3);
+      }
+      break;
+    }
+    case kFlipKeyBit: {
+      std::vector<Field> fields = KeyFields(data, view, false);
+      Field field = fields[rng->Below(fields.size())];
+      field.data[rng->Below(field.len)] ^= static_cast<uint8_t>(1u << rng->Below(8));
+      break;
+    }
+    case kSetPubkeyPrefix: {
+      std::vector<Field> fields = KeyFields(data, view, true);
+      fields[rng->Below(fields.size())].data[0] =
+          kPubkeyPrefixes[rng->Below(sizeof(kPubkeyPrefixes))];
+      break;
+    }
+    case kCopyPubkey: {
+      std::vector<Field> fields = KeyFields(data, view, true);
+      Field from = fields[rng->Below(fields.size())];
+      Field to = fields[rng->Below(fields.size())];
+      std::memmove(to.data, from.data, kPubkeySize);
+      break;
+    }
+    case kSetLabel: {
+      if (view.label_count == 0) {
+        break;
+      }
+      size_t index = rng->Below(view.label_count);
+      uint32_t value = rng->Below(4) == 0
+                           ? static_cast<uint32_t>(rng->Next())
+                           : kInterestingLabels[rng->Below(sizeof(kInterestingLabels) / 4)];
+      if (rng->Below(4) == 0) {
+        value = GetLabel(view, rng->Below(view.label_count));
+      }
+      StoreU32(Writable(data, view.labels) + index * 4, value);
+      break;
+    }
+    case kOutpoint: {
+      if (input_count == 0) {
+        break;
+      }
+      uint8_t* txid = Writable(data, GetInput(view, rng->Below(input_count)).outpoint_txid);
+      switch (rng->Below(3)) {
+        case 0:
+          txid[rng->Below(kTxidSize)] ^= static_cast<uint8_t>(1u << rng->Below(8));
+          break;
+        case 1:
+          StoreU32(txid + kTxidSize, rng->Below(2) ? static_cast<uint32_t>(rng->Below(4))
+                                                   : 0xffffffffu);
+          break;
+        default:
+          // Duplicate another outpoint, which stresses outpoint ordering.
+          std::memmove(txid, GetInput(view, rng->Below(input_count)).outpoint_txid,
+                       kTxidSize + 4);
+          break;
+      }
+      break;
+    }
+    case kSeed:
+      for (int i = 0; i < 8; ++i) {
+        data[1 + i] = static_cast<uint8_t>(rng->Next());
+      }
+      break;
+    case kOutputCount: {
+      uint16_t count = static_cast<uint16_t>(rng->Below(4) == 0 ? rng->Next() : rng->Below(8));
+      data[kOutputCountOffset] = static_cast<uint8_t>(count);
+      data[kOutputCountOffset + 1] = static_cast<uint8_t>(count >> 8);
+      break;
+    }
+    default:
+      break;
+  }
+  return size;
+}
+
+}  // namespace
+
+size_t MutateCase(uint8_t* data, size_t size, size_t max_size, uint32_t seed,
+                  ByteMutator byte_mutator) {
+  Rng rng{0x5eed000000000000ull | seed};
+  CaseView view;
+  if (!ParseCaseViewV1(data, size, &view, nullptr)) {
+    if (byte_mutator && rng.Below(4) == 0) {
+      return byte_mutator(data, size, max_size);
+    }
+    GeneratorOptions options;
+    options.campaign_seed = rng.Next();
+    static thread_local std::vector<uint8_t> generated;
+    GenerateCase(options, 0, &generated, nullptr);
+    if (generated.size() > max_size) {
+      return byte_mutator ? byte_mutator(data, size, max_size) : size;
+    }
+    std::memcpy(data, generated.data(), generated.size());
+    return generated.size();
+  }
+
+  // One in sixteen edits stays byte-level so the parser's error paths keep
+  // getting exercised.
+  if (byte_mutator && rng.Below(16) == 0) {
+    return byte_mutator(data, size, max_size);
+  }
+  Mutation mutation = static_cast<Mutation>(rng.Below(kMutationCount));
+  switch (mutation) {
+    case kToggleKeyMaterial:
+    case kAddInput:
+    case kDropInput:
+    case kAddLabel:
+    case kDropLabel:
+      return Rebuild(data, size, max_size, view, mutation, &rng);
+    default:
+      return MutateInPlace(data, size, view, mutation, &rng);
+  }
+}
+
+}  // namespace sp_differ
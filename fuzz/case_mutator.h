@@ -0,0 +1,25 @@
+#ifndef SP_DIFFER_FUZZ_CASE_MUTATOR_H
+#define SP_DIFFER_FUZZ_CASE_MUTATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sp_differ {
+
+// Byte-level mutator used when the structured mutations do not apply, with
+// the signature of LLVMFuzzerMutate.
+typedef size_t (*ByteMutator)(uint8_t* data, size_t size, size_t max_size);
+
+// Mutates the v1 case in data[0, size) in place and returns its new size,
+// which never exceeds max_size. A parseable case gets one structured edit
+// that keeps it parseable most of the time: flag flips, inputs added or
+// dropped, input types swapped, keys and labels rewritten. Input that does
+// not parse is replaced by a generated case (or handed to byte_mutator), so
+// the fuzzer climbs back to valid structure quickly. The edit depends only
+// on seed and the input.
+size_t MutateCase(uint8_t* data, size_t size, size_t max_size, uint32_t seed,
+                  ByteMutator byte_mutator);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_FUZZ_CASE_MUTATOR_H
@@ -0,0 +1,86 @@
+// In-process differential fuzz target. Both workers are loaded once, every
+// input runs through each of them, and any difference in their outputs
+// aborts so the fuzzer records the input as a crash.
+//
+// Workers default to the C++ and Rust builds; SP_DIFFER_FUZZ_LEFT and
+// SP_DIFFER_FUZZ_RIGHT accept a path or "cpp"/"rust" to override them.
+
+#include "case_mutator.h"
+
+#include "../src/core/io.h"
+#include "../src/runner/worker.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+extern "C" size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t max_size);
+
+namespace {
+
+sp_differ::WorkerApi g_left;
+sp_differ::WorkerApi g_right;
+std::vector<uint8_t> g_left_output;
+std::vector<uint8_t> g_right_output;
+
+void LoadOrDie(const char* env, const char* fallback, sp_differ::WorkerApi* api) {
+  const char* arg = std::getenv(env);
+  std::string path = sp_differ::ResolveWorkerPath(arg && *arg ? arg : fallback);
+  std::string error;
+  if (!sp_differ::LoadWorker(path, api, &error)) {
+    std::fprintf(stderr, "FAIL: %s: %s\n", path.c_str(), error.c_str());
+    std::exit(2);
+  }
+}
+
+void PrintHex(const char* label, const uint8_t* data, size_t len) {
+  std::fprintf(stderr, "  %s: ", label);
+  for (size_t i = 0; i < len; ++i) {
+    std::fprintf(stderr, "%02x", data[i]);
+  }
+  std::fprintf(stderr, "\n");
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerInitialize(int* /*argc*/, char*** /*argv*/) {
+  LoadOrDie("SP_DIFFER_FUZZ_LEFT", "cpp", &g_left);
+  LoadOrDie("SP_DIFFER_FUZZ_RIGHT", "rust", &g_right);
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  std::string left_error;
+  std::string right_error;
+  bool left_ok = sp_differ::RunWorker(g_left, data, size, &g_left_output, &left_error);
+  bool right_ok = sp_differ::RunWorker(g_right, data, size, &g_right_output, &right_error);
+  if (left_ok && right_ok) {
+    left_ok = sp_differ::ValidateOutputPayload(g_left_output, &left_error);
+    right_ok = sp_differ::ValidateOutputPayload(g_right_output, &right_error);
+  }
+  bool agree = left_ok == right_ok && (!left_ok || g_left_output == g_right_output);
+  if (agree) {
+    return 0;
+  }
+
+  std::fprintf(stderr, "MISMATCH: workers disagree\n");
+  PrintHex("case", data, size);
+  if (left_ok) {
+    PrintHex("left", g_left_output.data(), g_left_output.size());
+  } else {
+    std::fprintf(stderr, "  left: %s\n", left_error.c_str());
+  }
+  if (right_ok) {
+    PrintHex("right", g_right_output.data(), g_right_output.size());
+  } else {
+    std::fprintf(stderr, "  right: %s\n", right_error.c_str());
+  }
+  std::abort();
+}
+
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t* data, size_t size, size_t max_size,
+                                          unsigned int seed) {
+  return sp_differ::MutateCase(data, size, max_size, seed, LLVMFuzzerMutate);
+}
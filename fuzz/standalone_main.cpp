@@ -0,0 +1,152 @@
+// Driver for the fuzz target on toolchains without libFuzzer. It replays the
+// given cases (to reproduce a crash artifact) and, with -runs=N, feeds them
+// through N rounds of the structured mutator. There is no coverage feedback,
+// so this is a smoke and throughput check rather than a real fuzzer.
+//
+// usage: sp_differ_fuzz_standalone [-runs=N] [-seed=S] [-max_len=N] <case|dir|glob>...
+
+#include "../src/core/corpus.h"
+#include "../src/core/io.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t* data, size_t size, size_t max_size,
+                                          unsigned int seed);
+
+namespace {
+
+uint64_t g_byte_state = 1;
+
+uint64_t NextByteRandom() {
+  g_byte_state ^= g_byte_state << 13;
+  g_byte_state ^= g_byte_state >> 7;
+  g_byte_state ^= g_byte_state << 17;
+  return g_byte_state;
+}
+
+// Reseeds every mutation cycle so whole runs replay from -seed, as they
+// would under libFuzzer.
+const size_t kCycleLength = 64;
+
+}  // namespace
+
+// Stand-in for libFuzzer's byte mutator: flip a bit, overwrite, insert, or
+// erase a byte.
+extern "C" size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t max_size) {
+  uint64_t r = NextByteRandom();
+  size_t at = size == 0 ? 0 : static_cast<size_t>((r >> 8) % size);
+  switch (r & 3) {
+    case 0:
+      if (size > 0) {
+        data[at] ^= static_cast<uint8_t>(1u << ((r >> 4) & 7));
+      }
+      return size;
+    case 1:
+      if (size > 0) {
+        data[at] = static_cast<uint8_t>(r >> 40);
+      }
+      return size;
+    case 2:
+      if (size < max_size) {
+        std::memmove(data + at + 1, data + at, size - at);
+        data[at] = static_cast<uint8_t>(r >> 40);
+        return size + 1;
+      }
+      return size;
+    default:
+      if (size > 0) {
+        std::memmove(data + at, data + at + 1, size - at - 1);
+        return size - 1;
+      }
+      return size;
+  }
+}
+
+int main(int argc, char** argv) {
+  uint64_t runs = 0;
+  uint32_t seed = 1;
+  size_t max_len = 4096;
+  std::vector<std::string> specs;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("-runs=", 0) == 0) {
+      runs = std::strtoull(arg.c_str() + 6, nullptr, 10);
+    } else if (arg.rfind("-seed=", 0) == 0) {
+      seed = static_cast<uint32_t>(std::strtoul(arg.c_str() + 6, nullptr, 10));
+    } else if (arg.rfind("-max_len=", 0) == 0) {
+      max_len = static_cast<size_t>(std::strtoull(arg.c_str() + 9, nullptr, 10));
+    } else if (!arg.empty() && arg[0] == '-') {
+      std::fprintf(stderr, "FAIL: unexpected argument %s\n", arg.c_str());
+      return 2;
+    } else {
+      specs.push_back(arg);
+    }
+  }
+
+  LLVMFuzzerInitialize(&argc, &argv);
+
+  std::vector<std::vector<uint8_t>> corpus;
+  for (const std::string& spec : specs) {
+    std::vector<std::string> paths;
+    std::string error;
+    // A file is one case, such as a crash artifact being replayed;
+    // ListCaseFiles would read it as a list of paths.
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(spec, ec)) {
+      paths.push_back(spec);
+    } else if (!sp_differ::ListCaseFiles(spec, &paths, &error)) {
+      std::fprintf(stderr, "FAIL: %s: %s\n", spec.c_str(), error.c_str());
+      return 2;
+    }
+    for (const std::string& path : paths) {
+      std::vector<uint8_t> payload;
+      if (!sp_differ::ReadCasePayload(path, &payload, &error)) {
+        std::fprintf(stderr, "FAIL: %s: %s\n", path.c_str(), error.c_str());
+        return 2;
+      }
+      LLVMFuzzerTestOneInput(payload.data(), payload.size());
+      corpus.push_back(std::move(payload));
+    }
+  }
+  std::printf("REPLAY: cases=%zu\n", corpus.size());
+  if (runs == 0) {
+    return 0;
+  }
+  if (corpus.empty()) {
+    // The mutator turns anything unparseable into a generated case.
+    corpus.emplace_back();
+  }
+
+  std::vector<uint8_t> buffer(max_len);
+  size_t size = 0;
+  auto began = std::chrono::steady_clock::now();
+  for (uint64_t run = 0; run < runs; ++run) {
+    if (run % kCycleLength == 0) {
+      const std::vector<uint8_t>& start = corpus[(run / kCycleLength) % corpus.size()];
+      size = start.size() < max_len ? start.size() : max_len;
+      if (size > 0) {
+        std::memcpy(buffer.data(), start.data(), size);
+      }
+      g_byte_state = 0x9e3779b97f4a7c15ull ^ (seed + run);
+    }
+    size = LLVMFuzzerCustomMutator(buffer.data(), size, max_len,
+                                   seed * 0x9e3779b9u + static_cast<uint32_t>(run));
+    LLVMFuzzerTestOneInput(buffer.data(), size);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - began;
+  double seconds = elapsed.count();
+  std::printf("FUZZ: runs=%llu elapsed_s=%.3f execs_per_s=%.1f\n",
+              static_cast<unsigned long long>(runs), seconds,
+              seconds > 0.0 ? runs / seconds : 0.0);
+  return 0;
+}
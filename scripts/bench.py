@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""Runs the micro and macro benchmarks and compares them with a baseline."""
+
+import argparse
+import hashlib
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+
+ROOT = Path(__file__).resolve().parents[1]
+BUILD = ROOT / "build"
+
+
+def run_micro(sample_ms: float, bench_filter: str) -> list:
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        out_path = Path(tmp_dir) / "micro.json"
+        cmd = [str(BUILD / "sp_differ_bench"), "--sample-ms", str(sample_ms), "--out", str(out_path)]
+        if bench_filter:
+            cmd += ["--filter", bench_filter]
+        subprocess.check_call(cmd, cwd=ROOT)
+        return json.loads(out_path.read_text())["results"]
+
+
+def _metric(line_prefix: str, key: str, output: str) -> float:
+    for line in output.splitlines():
+        if line.startswith(line_prefix):
+            match = re.search(rf"\b{key}=([0-9.]+)", line)
+            if match:
+                return float(match.group(1))
+    raise RuntimeError(f"no {key} in {line_prefix} output")
+
+
+def _best_rate(cmd: list, line_prefix: str, repeat: int) -> float:
+    best = 0.0
+    for _ in range(repeat):
+        result = subprocess.run(cmd, cwd=ROOT, check=True, capture_output=True, text=True)
+        best = max(best, _metric(line_prefix, "cases_per_s", result.stdout))
+    return best
+
+
+def _bench_corpus(gen: str, gen_args: list) -> Path:
+    """The generated corpus for gen_args, reused only while both the arguments
+    and the generator binary are unchanged: a rebuilt generator may emit
+    different cases, and timing a stale corpus would compare unlike work."""
+    key = hashlib.sha256(Path(gen).read_bytes())
+    key.update("\0".join(gen_args).encode())
+    corpus = BUILD / f"bench-corpus-{key.hexdigest()[:16]}.bin"
+    if corpus.exists():
+        return corpus
+    for stale in BUILD.glob("bench-corpus-*.bin"):
+        stale.unlink()
+    # Written under a temporary name so an interrupted run leaves no corpus
+    # that a later run would take as complete.
+    partial = corpus.with_suffix(".tmp")
+    subprocess.check_call([gen, *gen_args, "--format", "binary", "--out", str(partial)], cwd=ROOT)
+    partial.replace(corpus)
+    return corpus
+
+
+def run_macro(cases: int, jobs: int, repeat: int) -> list:
+    """End-to-end cases per second: generation alone, and a generated corpus
+    streamed through sp_differ_compare against both workers. The best of
+    `repeat` runs is kept, which is the figure least disturbed by other load."""
+    gen = str(BUILD / "sp_differ_gen")
+    gen_args = ["--seed", "1", "--count", str(cases)]
+    corpus = _bench_corpus(gen, gen_args)
+
+    results = []
+
+    def add(name: str, value: float) -> None:
+        results.append({"name": name, "value": value, "unit": "cases/s", "better": "higher"})
+        print(f"BENCH: {name} cases_per_s={value:.1f}")
+
+    add("macro/generate", _best_rate([gen, *gen_args, "--format", "null"], "GEN:", repeat))
+    compare = [str(BUILD / "sp_differ_compare"), "--stream", str(corpus), "--jobs", str(jobs)]
+    add("macro/compare_stream/cpp-rust", _best_rate(compare, "BATCH:", repeat))
+    add(
+        "macro/compare_stream/cpp-cpp",
+        _best_rate(compare + ["--left", "cpp", "--right", "cpp"], "BATCH:", repeat),
+    )
+    return results
+
+
+def compare_with_baseline(
+    current: list, baseline: list, threshold: float, report_missing: bool
+) -> int:
+    """Prints one row per benchmark and returns the number of regressions,
+    i.e. results worse than the baseline by more than threshold percent."""
+    base_by_name = {entry["name"]: entry for entry in baseline}
+    regressions = 0
+    print(f"{'benchmark':48} {'baseline':>14} {'current':>14} {'change':>8}")
+    for entry in current:
+        base = base_by_name.pop(entry["name"], None)
+        if base is None or base["value"] <= 0:
+            print(f"{entry['name']:48} {'-':>14} {entry['value']:>14.1f} {'new':>8}")
+            continue
+        change = (entry["value"] - base["value"]) / base["value"] * 100.0
+        worse = change if entry["better"] == "lower" else -change
+        status = ""
+        if worse > threshold:
+            status = "  REGRESSION"
+            regressions += 1
+        print(
+            f"{entry['name']:48} {base['value']:>14.1f} {entry['value']:>14.1f} "
+            f"{change:>+7.1f}%{status}"
+        )
+    for name in base_by_name if report_missing else []:
+        print(f"{name:48} {'':>14} {'-':>14} {'missing':>8}")
+    return regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="sp-differ benchmark suite")
+    parser.add_argument("--out", type=Path, default=BUILD / "bench.json", help="JSON results")
+    parser.add_argument("--baseline", type=Path, help="earlier results to compare against")
+    parser.add_argument(
+        "--threshold", type=float, default=10.0, help="regression threshold in percent"
+    )
+    parser.add_argument("--filter", default="", help="only micro benchmarks containing this")
+    parser.add_argument("--sample-ms", type=float, default=40.0, help="micro sample length")
+    parser.add_argument("--macro-cases", type=int, default=200000, help="generated corpus size")
+    parser.add_argument("--jobs", type=int, default=0, help="compare jobs, 0 for all cores")
+    parser.add_argument("--repeat", type=int, default=3, help="macro runs per benchmark")
+    parser.add_argument("--no-macro", action="store_true", help="skip the macro benchmarks")
+    args = parser.parse_args()
+
+    # Read first: the baseline may be the file this run is about to overwrite.
+    baseline = json.loads(args.baseline.read_text()) if args.baseline else None
+    try:
+        results = run_micro(args.sample_ms, args.filter)
+        if not args.no_macro:
+            results += run_macro(args.macro_cases, args.jobs, args.repeat)
+    except (OSError, subprocess.CalledProcessError, RuntimeError) as exc:
+        print(f"FAIL: {exc}", file=sys.stderr)
+        return 2
+
+    report = {
+        "schema": 1,
+        "host": {
+            "machine": platform.machine(),
+            "system": platform.system(),
+            "cpus": os.cpu_count(),
+        },
+        "results": results,
+    }
+    args.out.parent.mkdir(parents=True, exist_ok=True)
+    args.out.write_text(json.dumps(report, indent=1) + "\n")
+    print(f"OK: wrote {len(results)} results to {args.out}")
+
+    if baseline:
+        if baseline.get("host") != report["host"]:
+            print("NOTE: baseline was recorded on a different host", file=sys.stderr)
+        regressions = compare_with_baseline(
+            results, baseline["results"], args.threshold, not args.filter and not args.no_macro
+        )
+        if regressions:
+            print(f"FAIL: {regressions} regressions beyond {args.threshold:.1f}%", file=sys.stderr)
+            return 1
+        print(f"OK: no regressions beyond {args.threshold:.1f}%")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
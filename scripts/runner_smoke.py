@@ -11,7 +11,13 @@ from ctypes import CDLL, POINTER, c_size_t, c_uint8, c_uint32
 
 
 ROOT = Path(__file__).resolve().parents[1]
-WORKER_CPP = ROOT / "workers" / "cpp" / "sp_differ_worker.cpp"
+WORKER_SOURCES = [
+    ROOT / "workers" / "cpp" / "sp_differ_worker.cpp",
+    ROOT / "workers" / "cpp" / "bip352.cpp",
+    ROOT / "workers" / "cpp" / "secp256k1.cpp",
+    ROOT / "src" / "core" / "case.cpp",
+    ROOT / "src" / "core" / "sha256.cpp",
+]
 
 
 def read_payload(path: Path) -> bytes:
@@ -46,7 +52,7 @@ def build_worker(out_path: Path) -> None:
         "-shared",
         "-o",
         str(out_path),
-        str(WORKER_CPP),
+        *(str(source) for source in WORKER_SOURCES),
     ]
     subprocess.check_call(cmd)
 
@@ -0,0 +1,248 @@
+#include "../core/canonical.h"
+#include "../core/corpus.h"
+#include "../core/hash.h"
+#include "../core/io.h"
+#include "../core/pack.h"
+#include "../runner/scheduler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr size_t kChunkSize = 64;
+
+enum class CaseState : uint8_t {
+  kParsed,
+  kUnparsed,
+  kUnreadable,
+};
+
+struct Corpus {
+  std::string spec;
+  std::vector<std::string> paths;
+  sp_differ::PackedCorpus packed;
+};
+
+size_t CaseCount(const Corpus& corpus) {
+  return corpus.packed.base ? static_cast<size_t>(corpus.packed.case_count) : corpus.paths.size();
+}
+
+std::string CaseName(const Corpus& corpus, size_t index) {
+  return corpus.packed.base ? corpus.spec + "#" + std::to_string(index) : corpus.paths[index];
+}
+
+// Points payload at case index, reading it into buffer for case files.
+bool LoadCase(const Corpus& corpus, size_t index, std::vector<uint8_t>* buffer,
+              const uint8_t** payload, size_t* payload_len, std::string* error) {
+  if (corpus.packed.base) {
+    return sp_differ::GetPackedCase(corpus.packed, index, payload, payload_len, error);
+  }
+  if (!sp_differ::ReadCasePayload(corpus.paths[index], buffer, error)) {
+    return false;
+  }
+  *payload = buffer->data();
+  *payload_len = buffer->size();
+  return true;
+}
+
+// Whether cases a and b have the same canonical form. A shared 64-bit hash
+// alone is not proof enough to delete a file.
+bool SameCanonicalCase(const Corpus& corpus, size_t a, size_t b, std::vector<uint8_t>* buffer,
+                       std::vector<uint8_t>* canonical_a, std::vector<uint8_t>* canonical_b,
+                       std::string* error) {
+  const uint8_t* payload = nullptr;
+  size_t payload_len = 0;
+  if (!LoadCase(corpus, a, buffer, &payload, &payload_len, error)) {
+    return false;
+  }
+  sp_differ::CanonicalizeCase(payload, payload_len, canonical_a);
+  if (!LoadCase(corpus, b, buffer, &payload, &payload_len, error)) {
+    return false;
+  }
+  sp_differ::CanonicalizeCase(payload, payload_len, canonical_b);
+  return *canonical_a == *canonical_b;
+}
+
+void PrintUsage() {
+  std::cout << "usage: sp_differ_dedup <dir|glob|list|pack> [--jobs <n|0>] [--list]"
+            << " [--out <pack>] [--delete]" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Corpus corpus;
+  sp_differ::SchedulerOptions scheduler;
+  bool list = false;
+  bool remove_duplicates = false;
+  std::string out_path;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--jobs" || arg == "-j") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --jobs requires a value" << std::endl;
+        return 2;
+      }
+      uint64_t jobs = 0;
+      if (!sp_differ::ParseUnsigned(argv[++i], UINT32_MAX, &jobs)) {
+        std::cerr << "FAIL: --jobs requires a non-negative integer" << std::endl;
+        return 2;
+      }
+      scheduler.jobs = static_cast<unsigned>(jobs);
+    } else if (arg == "--list") {
+      list = true;
+    } else if (arg == "--delete") {
+      remove_duplicates = true;
+    } else if (arg == "--out") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --out requires a path" << std::endl;
+        return 2;
+      }
+      out_path = argv[++i];
+    } else if (arg == "--help" || arg == "-h") {
+      PrintUsage();
+      return 0;
+    } else if (corpus.spec.empty()) {
+      corpus.spec = arg;
+    } else {
+      std::cerr << "FAIL: unexpected argument" << std::endl;
+      return 2;
+    }
+  }
+  if (corpus.spec.empty()) {
+    PrintUsage();
+    return 2;
+  }
+
+  std::string error;
+  bool packed = sp_differ::IsPackedCorpus(corpus.spec);
+  if (packed && remove_duplicates) {
+    std::cerr << "FAIL: --delete works on case files; use --out to write a packed corpus"
+              << std::endl;
+    return 2;
+  }
+  bool opened = packed ? sp_differ::OpenPackedCorpus(corpus.spec, &corpus.packed, &error)
+                       : sp_differ::ListCaseFiles(corpus.spec, &corpus.paths, &error);
+  if (!opened) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  size_t count = CaseCount(corpus);
+  scheduler.jobs = sp_differ::ResolveJobCount(scheduler.jobs);
+  scheduler.chunk_size = kChunkSize;
+  std::vector<uint64_t> hashes(count, 0);
+  std::vector<CaseState> states(count, CaseState::kUnreadable);
+  std::vector<std::vector<uint8_t>> buffers(scheduler.jobs);
+  std::vector<std::vector<uint8_t>> scratch(scheduler.jobs);
+
+  // Hashing, and for case files reading, is the expensive part and runs in
+  // parallel; picking the first of each hash is a cheap pass in case order,
+  // so the result does not depend on the job count.
+  sp_differ::RunWorkStealing(count, scheduler, [&](unsigned thread, size_t begin, size_t end) {
+    std::string case_error;
+    for (size_t i = begin; i < end; ++i) {
+      const uint8_t* payload = nullptr;
+      size_t payload_len = 0;
+      if (!LoadCase(corpus, i, &buffers[thread], &payload, &payload_len, &case_error)) {
+        continue;
+      }
+      states[i] = sp_differ::CanonicalizeCase(payload, payload_len, &scratch[thread])
+                      ? CaseState::kParsed
+                      : CaseState::kUnparsed;
+      hashes[i] = sp_differ::HashCase(scratch[thread].data(), scratch[thread].size());
+    }
+  });
+
+  std::unordered_map<uint64_t, size_t> first_seen;
+  first_seen.reserve(count);
+  std::vector<uint8_t> keep(count, 0);
+  std::vector<size_t> first_of(count, 0);
+  size_t unique = 0;
+  size_t duplicates = 0;
+  size_t unparsed = 0;
+  size_t unreadable = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (states[i] == CaseState::kUnreadable) {
+      ++unreadable;
+      std::cerr << "ERROR: " << CaseName(corpus, i) << ": unreadable" << std::endl;
+      continue;
+    }
+    unparsed += states[i] == CaseState::kUnparsed;
+    auto inserted = first_seen.emplace(hashes[i], i);
+    if (inserted.second) {
+      keep[i] = 1;
+      ++unique;
+      continue;
+    }
+    ++duplicates;
+    first_of[i] = inserted.first->second;
+    if (list) {
+      std::cout << "DUPLICATE: " << CaseName(corpus, i) << " of "
+                << CaseName(corpus, inserted.first->second) << std::endl;
+    }
+  }
+
+  int rc = unreadable == 0 ? 0 : 2;
+  if (!out_path.empty()) {
+    sp_differ::PackWriter writer;
+    bool ok = sp_differ::BeginPackedCorpus(out_path, &writer, &error);
+    for (size_t i = 0; ok && i < count; ++i) {
+      const uint8_t* payload = nullptr;
+      size_t payload_len = 0;
+      ok = !keep[i] || (LoadCase(corpus, i, &buffers[0], &payload, &payload_len, &error) &&
+                        sp_differ::AppendPackedCase(&writer, payload, payload_len, &error));
+    }
+    if (!ok || !sp_differ::FinishPackedCorpus(&writer, &error)) {
+      std::cerr << "FAIL: " << out_path << ": " << error << std::endl;
+      rc = 2;
+    }
+  }
+  if (remove_duplicates) {
+    std::vector<uint8_t> canonical;
+    std::vector<uint8_t> first_canonical;
+    for (size_t i = 0; i < count; ++i) {
+      // A list file or overlapping globs can name one file twice; that is
+      // not a copy to delete.
+      std::error_code ec;
+      if (keep[i] || states[i] == CaseState::kUnreadable ||
+          std::filesystem::equivalent(corpus.paths[i], corpus.paths[first_of[i]], ec)) {
+        continue;
+      }
+      error.clear();
+      if (!SameCanonicalCase(corpus, i, first_of[i], &buffers[0], &canonical, &first_canonical,
+                             &error)) {
+        std::cerr << "FAIL: not deleting " << corpus.paths[i] << ": "
+                  << (error.empty() ? "hash collision with " + corpus.paths[first_of[i]] : error)
+                  << std::endl;
+        rc = 2;
+        continue;
+      }
+      if (!std::filesystem::remove(corpus.paths[i], ec)) {
+        std::cerr << "FAIL: unable to delete " << corpus.paths[i] << std::endl;
+        rc = 2;
+      }
+    }
+  }
+  sp_differ::ClosePackedCorpus(&corpus.packed);
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  double seconds = elapsed.count();
+  std::cout << "DEDUP: cases=" << count << " unique=" << unique << " duplicates=" << duplicates
+            << " unparsed=" << unparsed << " unreadable=" << unreadable
+            << " jobs=" << scheduler.jobs << std::fixed << std::setprecision(3)
+            << " elapsed_s=" << seconds << std::setprecision(1)
+            << " cases_per_s=" << (seconds > 0.0 ? count / seconds : 0.0) << std::endl;
+  return rc;
+}
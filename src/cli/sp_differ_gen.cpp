@@ -0,0 +1,174 @@
+#include "../core/generate.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+enum class OutputFormat {
+  kBinary,
+  kHex,
+  kNull,
+};
+
+constexpr size_t kFlushSize = 1u << 20;
+
+void PrintUsage() {
+  std::cout << "usage: sp_differ_gen [--seed <n>] [--start <index>] [--count <n>]"
+            << " [--format binary|hex|null] [--out <path|->]" << std::endl;
+  std::cout << "                     [--max-inputs <n>] [--max-outputs <n>] [--max-labels <n>]"
+            << " [--invalid <per-mille>] [--no-privkeys] [--no-pubkeys]" << std::endl;
+}
+
+bool ParseNumber(const char* text, uint64_t* out) {
+  char* end = nullptr;
+  *out = std::strtoull(text, &end, 0);
+  return end != text && *end == '\0';
+}
+
+void AppendHex(const uint8_t* data, size_t len, std::vector<uint8_t>* out) {
+  static const char kDigits[] = "0123456789abcdef";
+  for (size_t i = 0; i < len; ++i) {
+    out->push_back(static_cast<uint8_t>(kDigits[data[i] >> 4]));
+    out->push_back(static_cast<uint8_t>(kDigits[data[i] & 0x0f]));
+  }
+  out->push_back('\n');
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sp_differ::GeneratorOptions options;
+  uint64_t start = 0;
+  uint64_t count = 1;
+  OutputFormat format = OutputFormat::kBinary;
+  std::string out_path = "-";
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    uint64_t value = 0;
+    bool has_value = i + 1 < argc;
+    if (arg == "--help" || arg == "-h") {
+      PrintUsage();
+      return 0;
+    } else if (arg == "--no-privkeys") {
+      options.privkeys = false;
+    } else if (arg == "--no-pubkeys") {
+      options.pubkeys = false;
+    } else if (arg == "--format" && has_value) {
+      std::string name = argv[++i];
+      if (name == "binary") {
+        format = OutputFormat::kBinary;
+      } else if (name == "hex") {
+        format = OutputFormat::kHex;
+      } else if (name == "null") {
+        format = OutputFormat::kNull;
+      } else {
+        std::cerr << "FAIL: --format requires binary, hex, or null" << std::endl;
+        return 2;
+      }
+    } else if (arg == "--out" && has_value) {
+      out_path = argv[++i];
+    } else if (!has_value || !ParseNumber(argv[i + 1], &value)) {
+      std::cerr << "FAIL: unexpected argument " << arg << std::endl;
+      return 2;
+    } else {
+      ++i;
+      if (arg == "--seed") {
+        options.campaign_seed = value;
+      } else if (arg == "--start") {
+        start = value;
+      } else if (arg == "--count") {
+        count = value;
+      } else if (arg == "--max-inputs" && value <= 0xffff) {
+        options.max_inputs = static_cast<uint16_t>(value);
+      } else if (arg == "--max-outputs" && value <= 0xffff) {
+        options.max_outputs = static_cast<uint16_t>(value);
+      } else if (arg == "--max-labels" && value <= 0xffff) {
+        options.max_labels = static_cast<uint16_t>(value);
+      } else if (arg == "--invalid" && value <= 1000) {
+        options.invalid_per_mille = static_cast<uint32_t>(value);
+      } else {
+        std::cerr << "FAIL: unexpected argument " << arg << std::endl;
+        return 2;
+      }
+    }
+  }
+
+  std::FILE* out = nullptr;
+  if (format != OutputFormat::kNull) {
+    if (out_path == "-") {
+#if defined(_WIN32)
+      _setmode(_fileno(stdout), _O_BINARY);
+#endif
+      out = stdout;
+    } else {
+      out = std::fopen(out_path.c_str(), "wb");
+      if (!out) {
+        std::cerr << "FAIL: unable to open " << out_path << std::endl;
+        return 2;
+      }
+    }
+  }
+
+  // Cases are generated straight into the tail of the output buffer, which
+  // is flushed whenever it passes kFlushSize.
+  size_t max_case = sp_differ::MaxGeneratedCaseSize(options);
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kFlushSize + 2 * max_case + 8);
+  std::vector<uint8_t> scratch(max_case);
+  uint64_t bytes = 0;
+  bool write_failed = false;
+  auto began = std::chrono::steady_clock::now();
+  for (uint64_t index = start; index < start + count && !write_failed; ++index) {
+    if (format == OutputFormat::kHex) {
+      size_t size = sp_differ::GenerateCase(options, index, scratch.data(), nullptr);
+      AppendHex(scratch.data(), size, &buffer);
+    } else {
+      size_t at = buffer.size();
+      buffer.resize(at + 4 + max_case);
+      size_t size = sp_differ::GenerateCase(options, index, buffer.data() + at + 4, nullptr);
+      for (int b = 0; b < 4; ++b) {
+        buffer[at + b] = static_cast<uint8_t>(size >> (8 * b));
+      }
+      buffer.resize(at + 4 + size);
+    }
+    if (buffer.size() >= kFlushSize) {
+      bytes += buffer.size();
+      write_failed = out && std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size();
+      buffer.clear();
+    }
+  }
+  bytes += buffer.size();
+  if (out && !write_failed) {
+    write_failed = std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size() ||
+                   std::fflush(out) != 0;
+  }
+  if (out && out != stdout) {
+    std::fclose(out);
+  }
+  if (write_failed) {
+    std::cerr << "FAIL: write error" << std::endl;
+    return 2;
+  }
+
+  if (format == OutputFormat::kNull) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - began;
+    double seconds = elapsed.count();
+    std::cout << "GEN: cases=" << count << " bytes=" << bytes << std::fixed
+              << std::setprecision(3) << " elapsed_s=" << seconds << std::setprecision(1)
+              << " cases_per_s=" << (seconds > 0.0 ? count / seconds : 0.0) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,138 @@
+#include "../core/corpus.h"
+#include "../core/io.h"
+#include "../core/pack.h"
+#include "../core/validate.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+void PrintUsage() {
+  std::cout << "usage: sp_differ_pack pack <out.pack> <dir|glob|list>..." << std::endl;
+  std::cout << "       sp_differ_pack unpack <in.pack> <dir>" << std::endl;
+  std::cout << "       sp_differ_pack info <in.pack>" << std::endl;
+}
+
+int Pack(const std::string& out_path, const std::vector<std::string>& specs) {
+  std::string error;
+  std::vector<std::string> case_paths;
+  for (const std::string& spec : specs) {
+    std::vector<std::string> listed;
+    if (!sp_differ::ListCaseFiles(spec, &listed, &error)) {
+      std::cerr << "FAIL: " << spec << ": " << error << std::endl;
+      return 2;
+    }
+    case_paths.insert(case_paths.end(), listed.begin(), listed.end());
+  }
+
+  sp_differ::PackWriter writer;
+  if (!sp_differ::BeginPackedCorpus(out_path, &writer, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  // A failed pack leaves no half-written file behind.
+  auto discard = [&]() {
+    writer.stream.close();
+    std::error_code ec;
+    std::filesystem::remove(out_path, ec);
+    return 2;
+  };
+  std::vector<uint8_t> payload;
+  for (const std::string& path : case_paths) {
+    // The runners drop a case whose header does not validate before it
+    // reaches a worker, so such a file is refused here rather than packed.
+    // Cases with a valid header and a malformed body stay: they are how
+    // workers are tested on bad input.
+    if (!sp_differ::ReadCasePayload(path, &payload, &error) ||
+        !sp_differ::ValidateCaseHeader(payload, &error)) {
+      std::cerr << "FAIL: " << path << ": " << error << std::endl;
+      return discard();
+    }
+    if (!sp_differ::AppendPackedCase(&writer, payload.data(), payload.size(), &error)) {
+      std::cerr << "FAIL: " << error << std::endl;
+      return discard();
+    }
+  }
+  if (!sp_differ::FinishPackedCorpus(&writer, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+
+  std::cout << "OK: packed " << case_paths.size() << " cases into " << out_path << std::endl;
+  return 0;
+}
+
+int Unpack(const std::string& in_path, const std::string& out_dir) {
+  std::string error;
+  sp_differ::PackedCorpus corpus;
+  if (!sp_differ::OpenPackedCorpus(in_path, &corpus, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  std::error_code ec;
+  std::filesystem::create_directories(out_dir, ec);
+
+  int rc = 0;
+  for (size_t i = 0; i < corpus.case_count && rc == 0; ++i) {
+    const uint8_t* payload = nullptr;
+    size_t payload_len = 0;
+    char name[32];
+    std::snprintf(name, sizeof(name), "case-%06zu.hex", i);
+    std::string path = (std::filesystem::path(out_dir) / name).string();
+    if (!sp_differ::GetPackedCase(corpus, i, &payload, &payload_len, &error) ||
+        !sp_differ::WriteCasePayloadHex(path, payload, payload_len, &error)) {
+      std::cerr << "FAIL: case " << i << ": " << error << std::endl;
+      rc = 2;
+    }
+  }
+  if (rc == 0) {
+    std::cout << "OK: unpacked " << corpus.case_count << " cases into " << out_dir << std::endl;
+  }
+  sp_differ::ClosePackedCorpus(&corpus);
+  return rc;
+}
+
+int Info(const std::string& in_path) {
+  std::string error;
+  sp_differ::PackedCorpus corpus;
+  if (!sp_differ::OpenPackedCorpus(in_path, &corpus, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  std::cout << "cases=" << corpus.case_count << " data_bytes=" << corpus.data_len
+            << " file_bytes=" << corpus.size << std::endl;
+  sp_differ::ClosePackedCorpus(&corpus);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    PrintUsage();
+    return 2;
+  }
+  std::string command = argv[1];
+  if (command == "--help" || command == "-h") {
+    PrintUsage();
+    return 0;
+  }
+  if (command == "pack" && argc >= 4) {
+    return Pack(argv[2], std::vector<std::string>(argv + 3, argv + argc));
+  }
+  if (command == "unpack" && argc == 4) {
+    return Unpack(argv[2], argv[3]);
+  }
+  if (command == "info" && argc == 3) {
+    return Info(argv[2]);
+  }
+  std::cerr << "FAIL: unexpected arguments" << std::endl;
+  PrintUsage();
+  return 2;
+}
@@ -0,0 +1,543 @@
+#include "cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace sp_differ {
+namespace {
+
+const char kCacheMagic[8] = {'S', 'P', 'D', 'C', 'A', 'C', 'H', '1'};
+constexpr uint64_t kMinSlotCount = 1024;
+
+uint64_t LoadU64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+uint32_t LoadU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void StoreU64(uint64_t value, uint8_t* p) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void StoreU32(uint32_t value, uint8_t* p) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// Both halves are already XXH64 digests; the multiply only spreads the
+// library hash so the same case under two libraries lands apart.
+uint64_t MixKey(uint64_t library, uint64_t case_hash) {
+    uint64_t key = case_hash ^ (library * 0x9e3779b97f4a7c15ull);
+    key ^= key >> 32;
+    return key;
+}
+
+std::string CachePath(const OutputCache& cache, const char* name) {
+    return (std::filesystem::path(cache.dir) / name).string();
+}
+
+bool SeekFile(std::FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// Maps the first len bytes of path read-only.
+bool MapRegion(const std::string& path, size_t len, const uint8_t** base,
+               std::vector<uint8_t>* copy, std::string* error) {
+#if defined(_WIN32)
+    std::ifstream file(path, std::ios::binary);
+    copy->resize(len);
+    if (!file.read(reinterpret_cast<char*>(copy->data()), static_cast<std::streamsize>(len))) {
+        *error = "unable to read " + path;
+        return false;
+    }
+    *base = copy->data();
+    return true;
+#else
+    (void)copy;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        *error = "unable to open " + path;
+        return false;
+    }
+    void* view = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        *error = "unable to map " + path;
+        return false;
+    }
+    *base = static_cast<const uint8_t*>(view);
+    return true;
+#endif
+}
+
+void UnmapRegion(const uint8_t** base, size_t len) {
+#if !defined(_WIN32)
+    if (*base) {
+        munmap(const_cast<uint8_t*>(*base), len);
+    }
+#else
+    (void)len;
+#endif
+    *base = nullptr;
+}
+
+// Reads the index header. Returns false when there is no usable index.
+bool ReadIndexHeader(const std::string& path, uint64_t* slot_count, uint64_t* entry_count,
+                     uint64_t* data_size, uint64_t* generation, size_t* index_size) {
+    std::error_code ec;
+    uint64_t file_size = std::filesystem::file_size(path, ec);
+    std::ifstream file(path, std::ios::binary);
+    uint8_t header[kCacheHeaderSize];
+    if (ec || !file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        std::memcmp(header, kCacheMagic, sizeof(kCacheMagic)) != 0) {
+        return false;
+    }
+    uint64_t slots = LoadU64(header + 8);
+    if (slots == 0 || (slots & (slots - 1)) != 0 ||
+        slots > (file_size - kCacheHeaderSize) / kCacheSlotSize ||
+        file_size != kCacheHeaderSize + slots * kCacheSlotSize) {
+        return false;
+    }
+    *slot_count = slots;
+    *entry_count = LoadU64(header + 16);
+    *data_size = LoadU64(header + 24);
+    *generation = LoadU64(header + 32);
+    *index_size = static_cast<size_t>(file_size);
+    return true;
+}
+
+// Index of the mapped slot holding the key, or slot_count when absent.
+uint64_t FindSlot(const OutputCache& cache, uint64_t library, uint64_t case_hash) {
+    if (cache.slot_count == 0) {
+        return 0;
+    }
+    uint64_t mask = cache.slot_count - 1;
+    for (uint64_t i = MixKey(library, case_hash) & mask, probes = 0; probes < cache.slot_count;
+         i = (i + 1) & mask, ++probes) {
+        const uint8_t* slot = cache.slots + i * kCacheSlotSize;
+        if (LoadU32(slot + 24) == 0) {
+            break;
+        }
+        if (LoadU64(slot) == library && LoadU64(slot + 8) == case_hash) {
+            return i;
+        }
+    }
+    return cache.slot_count;
+}
+
+// Points output at a record inside the data mapping after checking that it
+// carries the expected key.
+bool MappedRecord(const OutputCache& cache, const CacheEntry& entry, const uint8_t** output) {
+    if (entry.offset > cache.data_mapped ||
+        cache.data_mapped - entry.offset < kCacheRecordHeaderSize + uint64_t{entry.length}) {
+        return false;
+    }
+    const uint8_t* record = cache.data_base + entry.offset;
+    if (LoadU64(record) != entry.library || LoadU64(record + 8) != entry.case_hash ||
+        LoadU32(record + 16) != entry.length) {
+        return false;
+    }
+    *output = record + kCacheRecordHeaderSize;
+    return true;
+}
+
+CacheEntry SlotEntry(const OutputCache& cache, uint64_t index) {
+    const uint8_t* slot = cache.slots + index * kCacheSlotSize;
+    CacheEntry entry;
+    entry.library = LoadU64(slot);
+    entry.case_hash = LoadU64(slot + 8);
+    entry.offset = LoadU64(slot + 16);
+    entry.length = LoadU32(slot + 24);
+    entry.last_used = LoadU32(slot + 28);
+    return entry;
+}
+
+// Reads an entry written during this run back from the data file. Caller
+// holds cache->mutex.
+bool ReadAddedRecord(OutputCache* cache, const CacheEntry& entry, std::vector<uint8_t>* out) {
+    size_t start = out->size();
+    out->resize(start + entry.length);
+    bool ok = std::fflush(cache->data_file) == 0 &&
+              SeekFile(cache->data_file, entry.offset + kCacheRecordHeaderSize) &&
+              std::fread(out->data() + start, 1, entry.length, cache->data_file) == entry.length;
+    if (!SeekFile(cache->data_file, cache->data_size) || !ok) {
+        out->resize(start);
+        return false;
+    }
+    return true;
+}
+
+void AppendRecordHeader(const CacheEntry& entry, std::vector<uint8_t>* out) {
+    uint8_t header[kCacheRecordHeaderSize] = {};
+    StoreU64(entry.library, header);
+    StoreU64(entry.case_hash, header + 8);
+    StoreU32(entry.length, header + 16);
+    out->insert(out->end(), header, header + sizeof(header));
+}
+
+// Moves a fully written path + ".tmp" over path.
+bool ReplaceWithTmp(const std::string& path, std::string* error) {
+    std::error_code ec;
+    std::filesystem::rename(path + ".tmp", path, ec);
+    if (ec) {
+        *error = "unable to replace " + path;
+        return false;
+    }
+    return true;
+}
+
+bool WriteFileAtomically(const std::string& path, const std::vector<uint8_t>& bytes,
+                         std::string* error) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(bytes.data()),
+                        static_cast<std::streamsize>(bytes.size()))) {
+            *error = "unable to write " + tmp;
+            return false;
+        }
+    }
+    return ReplaceWithTmp(path, error);
+}
+
+void ReleaseLock(OutputCache* cache) {
+#if !defined(_WIN32)
+    if (cache->lock_fd >= 0) {
+        close(cache->lock_fd);
+    }
+#endif
+    cache->lock_fd = -1;
+}
+
+void ReleaseMappings(OutputCache* cache) {
+    UnmapRegion(&cache->index_base, cache->index_size);
+    UnmapRegion(&cache->data_base, cache->data_mapped);
+    cache->slots = nullptr;
+}
+
+void AbandonCache(OutputCache* cache) {
+    if (cache->data_file) {
+        std::fclose(cache->data_file);
+        cache->data_file = nullptr;
+    }
+    ReleaseMappings(cache);
+    ReleaseLock(cache);
+}
+
+}  // namespace
+
+size_t CacheKeyHash::operator()(const std::pair<uint64_t, uint64_t>& key) const {
+    return static_cast<size_t>(MixKey(key.first, key.second));
+}
+
+bool OpenOutputCache(const std::string& dir, uint64_t max_bytes, OutputCache* cache,
+                     std::string* error) {
+    cache->dir = dir;
+    cache->max_bytes = max_bytes;
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        *error = "unable to create cache directory " + dir;
+        return false;
+    }
+
+#if !defined(_WIN32)
+    // One writer at a time. A second process still gets hits, since the
+    // writer only ever replaces files by rename.
+    cache->lock_fd = open(CachePath(*cache, "lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (cache->lock_fd < 0) {
+        *error = "unable to open cache lock";
+        return false;
+    }
+    cache->read_only = flock(cache->lock_fd, LOCK_EX | LOCK_NB) != 0;
+#endif
+
+    std::string index_path = CachePath(*cache, "index");
+    std::string data_path = CachePath(*cache, "data");
+    uint64_t generation = 0;
+    uint64_t data_size = 0;
+    uint64_t file_size = std::filesystem::file_size(data_path, ec);
+    if (ec) {
+        file_size = 0;
+        ec.clear();
+    }
+    if (!ReadIndexHeader(index_path, &cache->slot_count, &cache->entry_count, &data_size,
+                         &generation, &cache->index_size) ||
+        data_size > file_size) {
+        cache->slot_count = 0;
+        cache->entry_count = 0;
+        cache->index_size = 0;
+        data_size = 0;
+    }
+
+    if (!cache->read_only) {
+        if (file_size == 0 && data_size == 0) {
+            std::ofstream(data_path, std::ios::binary | std::ios::trunc);
+        } else if (file_size != data_size) {
+            std::filesystem::resize_file(data_path, data_size, ec);
+        }
+        cache->data_file = ec ? nullptr : std::fopen(data_path.c_str(), "r+b");
+        if (!cache->data_file || !SeekFile(cache->data_file, data_size)) {
+            ReleaseLock(cache);
+            *error = "unable to open cache data " + data_path;
+            return false;
+        }
+        cache->generation = static_cast<uint32_t>(generation + 1);
+    }
+    cache->data_size = data_size;
+
+    std::vector<uint8_t>* index_copy = nullptr;
+    std::vector<uint8_t>* data_copy = nullptr;
+#if defined(_WIN32)
+    index_copy = &cache->index_copy;
+    data_copy = &cache->data_copy;
+#endif
+    if ((cache->slot_count > 0 &&
+         !MapRegion(index_path, cache->index_size, &cache->index_base, index_copy, error)) ||
+        (data_size > 0 && !MapRegion(data_path, static_cast<size_t>(data_size),
+                                     &cache->data_base, data_copy, error))) {
+        AbandonCache(cache);
+        return false;
+    }
+    cache->slots = cache->index_base ? cache->index_base + kCacheHeaderSize : nullptr;
+    cache->data_mapped = static_cast<size_t>(data_size);
+    if (!cache->read_only && cache->slot_count > 0) {
+        cache->touched.reset(new std::atomic<uint8_t>[cache->slot_count]());
+    }
+    return true;
+}
+
+bool LookupCachedOutput(OutputCache* cache, uint64_t library_hash, uint64_t case_hash,
+                        std::vector<uint8_t>* out) {
+    uint64_t index = FindSlot(*cache, library_hash, case_hash);
+    if (index < cache->slot_count) {
+        const uint8_t* output = nullptr;
+        CacheEntry entry = SlotEntry(*cache, index);
+        if (MappedRecord(*cache, entry, &output)) {
+            out->insert(out->end(), output, output + entry.length);
+            if (cache->touched) {
+                cache->touched[index].store(1, std::memory_order_relaxed);
+            }
+            cache->hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    } else if (!cache->read_only) {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        auto it = cache->added.find(std::make_pair(library_hash, case_hash));
+        if (it != cache->added.end() && ReadAddedRecord(cache, it->second, out)) {
+            cache->hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    cache->misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool StoreCachedOutput(OutputCache* cache, uint64_t library_hash, uint64_t case_hash,
+                       const uint8_t* output, size_t output_len, std::string* error) {
+    if (cache->read_only || output_len == 0 || output_len > UINT32_MAX ||
+        FindSlot(*cache, library_hash, case_hash) < cache->slot_count) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    auto key = std::make_pair(library_hash, case_hash);
+    if (cache->added.count(key) != 0) {
+        return true;
+    }
+    // Admitting past the budget would let one run grow the data file and
+    // this map without bound; close trims to three quarters of the budget,
+    // so later runs store again.
+    if (cache->max_bytes > 0 &&
+        cache->data_size + kCacheRecordHeaderSize + output_len > cache->max_bytes) {
+        ++cache->skipped;
+        return true;
+    }
+    CacheEntry entry;
+    entry.library = library_hash;
+    entry.case_hash = case_hash;
+    entry.offset = cache->data_size;
+    entry.length = static_cast<uint32_t>(output_len);
+    entry.last_used = cache->generation;
+    cache->record.clear();
+    AppendRecordHeader(entry, &cache->record);
+    cache->record.insert(cache->record.end(), output, output + output_len);
+    if (std::fwrite(cache->record.data(), 1, cache->record.size(), cache->data_file) !=
+        cache->record.size()) {
+        *error = "unable to append to cache data";
+        return false;
+    }
+    cache->data_size += cache->record.size();
+    cache->added.emplace(key, entry);
+    cache->stored.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool CloseOutputCache(OutputCache* cache, CacheStats* stats, std::string* error) {
+    if (stats) {
+        stats->hits = cache->hits.load();
+        stats->misses = cache->misses.load();
+        stats->stored = cache->stored.load();
+        stats->skipped = cache->skipped;
+        stats->entries = cache->entry_count;
+        stats->data_size = cache->data_size;
+    }
+    if (cache->read_only || !cache->data_file) {
+        AbandonCache(cache);
+        return true;
+    }
+
+    std::vector<CacheEntry> entries;
+    entries.reserve(cache->entry_count + cache->added.size());
+    for (uint64_t i = 0; i < cache->slot_count; ++i) {
+        CacheEntry entry = SlotEntry(*cache, i);
+        if (entry.length == 0) {
+            continue;
+        }
+        if (cache->touched[i].load(std::memory_order_relaxed)) {
+            entry.last_used = cache->generation;
+        }
+        entries.push_back(entry);
+    }
+    for (const auto& added : cache->added) {
+        entries.push_back(added.second);
+    }
+
+    if (std::fflush(cache->data_file) != 0) {
+        AbandonCache(cache);
+        *error = "unable to flush cache data";
+        return false;
+    }
+    uint64_t evicted = 0;
+    // A declined store means the data is full: compact so the next run can
+    // store again.
+    if (cache->max_bytes > 0 &&
+        (cache->data_size > cache->max_bytes || cache->skipped > 0)) {
+        // Most recently used first; ties keep data order so the rewrite
+        // reads the old file mostly front to back.
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const CacheEntry& a, const CacheEntry& b) {
+                             return a.last_used > b.last_used;
+                         });
+        uint64_t budget = cache->max_bytes / 4 * 3;
+        uint64_t kept_bytes = 0;
+        size_t kept = 0;
+        while (kept < entries.size() &&
+               kept_bytes + kCacheRecordHeaderSize + entries[kept].length <= budget) {
+            kept_bytes += kCacheRecordHeaderSize + entries[kept].length;
+            ++kept;
+        }
+        evicted = entries.size() - kept;
+        entries.resize(kept);
+
+        // Kept records are streamed into a new file one at a time, so
+        // compaction holds a single output in memory, not the whole data.
+        std::string data_path = CachePath(*cache, "data");
+        std::string tmp_path = data_path + ".tmp";
+        std::ofstream compacted(tmp_path, std::ios::binary | std::ios::trunc);
+        uint64_t compacted_size = 0;
+        std::vector<uint8_t> output;
+        std::vector<CacheEntry> rewritten;
+        for (CacheEntry entry : entries) {
+            const uint8_t* mapped = nullptr;
+            output.clear();
+            if (MappedRecord(*cache, entry, &mapped)) {
+                output.assign(mapped, mapped + entry.length);
+            } else if (!ReadAddedRecord(cache, entry, &output)) {
+                ++evicted;
+                continue;
+            }
+            entry.offset = compacted_size;
+            cache->record.clear();
+            AppendRecordHeader(entry, &cache->record);
+            cache->record.insert(cache->record.end(), output.begin(), output.end());
+            compacted.write(reinterpret_cast<const char*>(cache->record.data()),
+                            static_cast<std::streamsize>(cache->record.size()));
+            compacted_size += cache->record.size();
+            rewritten.push_back(entry);
+        }
+        compacted.close();
+        entries.swap(rewritten);
+        std::fclose(cache->data_file);
+        cache->data_file = nullptr;
+        ReleaseMappings(cache);
+        bool written = static_cast<bool>(compacted);
+        if (!written) {
+            *error = "unable to write " + tmp_path;
+        }
+        if (!written || !ReplaceWithTmp(data_path, error)) {
+            ReleaseLock(cache);
+            return false;
+        }
+        cache->data_size = compacted_size;
+    }
+    if (cache->data_file && std::fclose(cache->data_file) != 0) {
+        cache->data_file = nullptr;
+        AbandonCache(cache);
+        *error = "unable to flush cache data";
+        return false;
+    }
+    cache->data_file = nullptr;
+    ReleaseMappings(cache);
+
+    uint64_t slot_count = kMinSlotCount;
+    while (slot_count < entries.size() * 2) {
+        slot_count *= 2;
+    }
+    std::vector<uint8_t> index(kCacheHeaderSize + slot_count * kCacheSlotSize, 0);
+    std::memcpy(index.data(), kCacheMagic, sizeof(kCacheMagic));
+    StoreU64(slot_count, index.data() + 8);
+    StoreU64(entries.size(), index.data() + 16);
+    StoreU64(cache->data_size, index.data() + 24);
+    StoreU64(cache->generation, index.data() + 32);
+    uint8_t* slots = index.data() + kCacheHeaderSize;
+    for (const CacheEntry& entry : entries) {
+        uint64_t i = MixKey(entry.library, entry.case_hash) & (slot_count - 1);
+        while (LoadU32(slots + i * kCacheSlotSize + 24) != 0) {
+            i = (i + 1) & (slot_count - 1);
+        }
+        uint8_t* slot = slots + i * kCacheSlotSize;
+        StoreU64(entry.library, slot);
+        StoreU64(entry.case_hash, slot + 8);
+        StoreU64(entry.offset, slot + 16);
+        StoreU32(entry.length, slot + 24);
+        StoreU32(entry.last_used, slot + 28);
+    }
+    bool ok = WriteFileAtomically(CachePath(*cache, "index"), index, error);
+    ReleaseLock(cache);
+    if (stats) {
+        stats->evicted = evicted;
+        stats->entries = entries.size();
+        stats->data_size = cache->data_size;
+    }
+    return ok;
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,116 @@
+#ifndef SP_DIFFER_CORE_CACHE_H
+#define SP_DIFFER_CORE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sp_differ {
+
+// Persistent worker output cache. A cache directory holds two files (all
+// integers little-endian):
+//   index: header { magic "SPDCACH1" (8), slot_count u64, entry_count u64,
+//                   data_size u64, generation u64, reserved (24) }
+//          slot_count x { library u64, case u64, offset u64, length u32,
+//                         last_used u32 }
+//   data:  records { library u64, case u64, length u32, reserved u32,
+//                    output [length] } back to back
+// The index is an open-addressed table with linear probing and a power-of-two
+// slot count, so it is mapped and probed in place; a slot with length 0 is
+// empty. Records repeat their key, which lets a lookup reject a slot that
+// does not match its data.
+constexpr size_t kCacheHeaderSize = 64;
+constexpr size_t kCacheSlotSize = 32;
+constexpr size_t kCacheRecordHeaderSize = 24;
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stored = 0;
+    // Outputs not stored because the data had reached max_bytes.
+    uint64_t skipped = 0;
+    uint64_t evicted = 0;
+    uint64_t entries = 0;
+    uint64_t data_size = 0;
+};
+
+struct CacheEntry {
+    uint64_t library = 0;
+    uint64_t case_hash = 0;
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    uint32_t last_used = 0;
+};
+
+struct CacheKeyHash {
+    size_t operator()(const std::pair<uint64_t, uint64_t>& key) const;
+};
+
+struct OutputCache {
+    std::string dir;
+    uint64_t max_bytes = 0;
+    // Bumped on every writable open; slots hit or stored during the run are
+    // stamped with it, and eviction drops the oldest stamps first.
+    uint32_t generation = 0;
+    // Another process holds the cache: lookups work, nothing is stored.
+    bool read_only = false;
+
+    // Index and data as of open, mapped read-only.
+    const uint8_t* index_base = nullptr;
+    size_t index_size = 0;
+    const uint8_t* slots = nullptr;
+    uint64_t slot_count = 0;
+    uint64_t entry_count = 0;
+    const uint8_t* data_base = nullptr;
+    size_t data_mapped = 0;
+    std::unique_ptr<std::atomic<uint8_t>[]> touched;
+
+    // Entries stored by this run, appended to the data file as they arrive.
+    std::mutex mutex;
+    std::FILE* data_file = nullptr;
+    uint64_t data_size = 0;
+    std::unordered_map<std::pair<uint64_t, uint64_t>, CacheEntry, CacheKeyHash> added;
+    std::vector<uint8_t> record;
+    uint64_t skipped = 0;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> stored{0};
+    int lock_fd = -1;
+#if defined(_WIN32)
+    // No mmap wrapper on Windows; the files are read into memory instead.
+    std::vector<uint8_t> index_copy;
+    std::vector<uint8_t> data_copy;
+#endif
+};
+
+// Opens or creates the cache in dir. Data beyond what the index covers (left
+// by a run that did not close the cache) is discarded.
+bool OpenOutputCache(const std::string& dir, uint64_t max_bytes, OutputCache* cache,
+                     std::string* error);
+
+// Appends the cached output for (library_hash, case_hash) to out. Thread-safe;
+// entries present at open are served from the mapping without locking.
+bool LookupCachedOutput(OutputCache* cache, uint64_t library_hash, uint64_t case_hash,
+                        std::vector<uint8_t>* out);
+
+// Records a validated output. Thread-safe; a no-op when read-only, and once
+// the data has reached max_bytes, so a run never grows it past the budget.
+bool StoreCachedOutput(OutputCache* cache, uint64_t library_hash, uint64_t case_hash,
+                       const uint8_t* output, size_t output_len, std::string* error);
+
+// Writes the merged index. When the data passes max_bytes (after the budget
+// shrinks) or the run declined a store for lack of room, the least recently
+// used entries are dropped until it fits in three quarters of it, so the
+// next few runs have room to store again.
+bool CloseOutputCache(OutputCache* cache, CacheStats* stats, std::string* error);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_CACHE_H
@@ -0,0 +1,116 @@
+#include "cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kLibrary = 0x1111;
+constexpr uint64_t kOtherLibrary = 0x2222;
+
+std::vector<uint8_t> Output(uint8_t fill) {
+    return std::vector<uint8_t>(100, fill);
+}
+
+bool Hit(sp_differ::OutputCache* cache, uint64_t library, uint64_t case_hash, uint8_t fill) {
+    std::vector<uint8_t> out;
+    return sp_differ::LookupCachedOutput(cache, library, case_hash, &out) && out == Output(fill);
+}
+
+}  // namespace
+
+int main() {
+    const std::string dir = "build/sp_differ_core_cache_smoke.cache";
+    std::filesystem::remove_all(dir);
+    std::string error;
+    sp_differ::CacheStats stats;
+
+    // First run: everything misses, stores are visible within the run.
+    {
+        sp_differ::OutputCache cache;
+        std::vector<uint8_t> out;
+        if (!sp_differ::OpenOutputCache(dir, 1 << 20, &cache, &error) ||
+            sp_differ::LookupCachedOutput(&cache, kLibrary, 1, &out)) {
+            std::cerr << "FAIL: fresh cache " << error << std::endl;
+            return 2;
+        }
+        for (uint8_t i = 1; i <= 3; ++i) {
+            std::vector<uint8_t> output = Output(i);
+            if (!sp_differ::StoreCachedOutput(&cache, kLibrary, i, output.data(), output.size(),
+                                              &error)) {
+                std::cerr << "FAIL: " << error << std::endl;
+                return 2;
+            }
+        }
+        if (!Hit(&cache, kLibrary, 2, 2) ||
+            !sp_differ::CloseOutputCache(&cache, &stats, &error) || stats.entries != 3) {
+            std::cerr << "FAIL: first run " << error << std::endl;
+            return 2;
+        }
+    }
+
+    // A run that did not close leaves data the index does not cover.
+    {
+        std::ofstream data(dir + "/data", std::ios::binary | std::ios::app);
+        data << "torn record";
+    }
+
+    // Second run: served from the mapped index; only case 1 is used.
+    {
+        sp_differ::OutputCache cache;
+        std::vector<uint8_t> out;
+        if (!sp_differ::OpenOutputCache(dir, 1 << 20, &cache, &error) ||
+            !Hit(&cache, kLibrary, 1, 1) ||
+            sp_differ::LookupCachedOutput(&cache, kOtherLibrary, 1, &out) ||
+            !sp_differ::CloseOutputCache(&cache, &stats, &error) || stats.hits != 1 ||
+            stats.misses != 1 || stats.entries != 3) {
+            std::cerr << "FAIL: second run " << error << std::endl;
+            return 2;
+        }
+    }
+
+    // Third run: a budget of one record evicts all but the most recently
+    // used entry.
+    {
+        sp_differ::OutputCache cache;
+        if (!sp_differ::OpenOutputCache(dir, 200, &cache, &error) ||
+            !sp_differ::CloseOutputCache(&cache, &stats, &error) || stats.evicted != 2 ||
+            stats.entries != 1 || stats.data_size != sp_differ::kCacheRecordHeaderSize + 100) {
+            std::cerr << "FAIL: eviction " << error << std::endl;
+            return 2;
+        }
+    }
+    {
+        sp_differ::OutputCache cache;
+        if (!sp_differ::OpenOutputCache(dir, 1 << 20, &cache, &error) ||
+            !Hit(&cache, kLibrary, 1, 1) || Hit(&cache, kLibrary, 2, 2) ||
+            !sp_differ::CloseOutputCache(&cache, &stats, &error)) {
+            std::cerr << "FAIL: after eviction " << error << std::endl;
+            return 2;
+        }
+    }
+
+    // Fourth run: stores stop once the data would pass the budget, and the
+    // full cache is compacted on close.
+    {
+        sp_differ::OutputCache cache;
+        bool stored = sp_differ::OpenOutputCache(dir, 300, &cache, &error);
+        for (uint8_t i = 4; stored && i <= 5; ++i) {
+            std::vector<uint8_t> output = Output(i);
+            stored = sp_differ::StoreCachedOutput(&cache, kLibrary, i, output.data(),
+                                                  output.size(), &error);
+        }
+        if (!stored || !Hit(&cache, kLibrary, 4, 4) || Hit(&cache, kLibrary, 5, 5) ||
+            !sp_differ::CloseOutputCache(&cache, &stats, &error) || stats.stored != 1 ||
+            stats.skipped != 1 || stats.evicted != 1 || stats.entries != 1) {
+            std::cerr << "FAIL: store budget " << error << std::endl;
+            return 2;
+        }
+    }
+
+    std::filesystem::remove_all(dir);
+    std::cout << "OK: output cache" << std::endl;
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "canonical.h"
+
+#include "case.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+constexpr size_t kSeedOffset = 1;
+constexpr size_t kSeedSize = 8;
+constexpr size_t kFlagsOffset = kSeedOffset + kSeedSize;
+// The flag bits that change what a worker computes: private keys and public
+// keys present. Bit 0 only marks a case as expected to fail, and the rest
+// are unassigned.
+constexpr uint32_t kWorkerFlags = (1u << 1) | (1u << 2);
+constexpr size_t kMinHashSetSlots = 1024;
+
+size_t SlotOf(uint64_t hash, size_t mask) {
+    // Case hashes are XXH64 outputs, so their low bits are already uniform.
+    return static_cast<size_t>(hash) & mask;
+}
+
+void Grow(CaseHashSet* set) {
+    std::vector<uint64_t> old;
+    old.swap(set->slots);
+    set->slots.assign(old.empty() ? kMinHashSetSlots : old.size() * 2, 0);
+    size_t mask = set->slots.size() - 1;
+    for (uint64_t hash : old) {
+        if (hash == 0) {
+            continue;
+        }
+        size_t i = SlotOf(hash, mask);
+        while (set->slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        set->slots[i] = hash;
+    }
+}
+
+}  // namespace
+
+bool CanonicalizeCase(const uint8_t* payload, size_t payload_len, std::vector<uint8_t>* out) {
+    out->assign(payload, payload + payload_len);
+    CaseView view;
+    std::string error;
+    if (!ParseCaseViewV1(payload, payload_len, &view, &error)) {
+        return false;
+    }
+    // The v1 parser accepts exactly one encoding per Case (fixed-width
+    // fields, counts that must match, no trailing bytes), so the payload is
+    // already what SerializeCaseV1 would produce apart from the header
+    // fields no worker reads.
+    for (size_t i = 0; i < kSeedSize; ++i) {
+        (*out)[kSeedOffset + i] = 0;
+    }
+    uint32_t flags = view.header.flags & kWorkerFlags;
+    for (size_t i = 0; i < 4; ++i) {
+        (*out)[kFlagsOffset + i] = static_cast<uint8_t>(flags >> (8 * i));
+    }
+    return true;
+}
+
+uint64_t CanonicalCaseHash(const uint8_t* payload, size_t payload_len,
+                           std::vector<uint8_t>* scratch) {
+    CanonicalizeCase(payload, payload_len, scratch);
+    return HashCase(scratch->data(), scratch->size());
+}
+
+size_t CaseHashSlotsFor(size_t max_bytes) {
+    size_t slots = kMinHashSetSlots;
+    while (slots * 2 * sizeof(uint64_t) <= max_bytes) {
+        slots *= 2;
+    }
+    return slots;
+}
+
+bool InsertCaseHash(CaseHashSet* set, uint64_t hash) {
+    if (hash == 0) {
+        bool inserted = !set->has_zero;
+        set->has_zero = true;
+        return inserted;
+    }
+    if ((set->size + 1) * 2 > set->slots.size()) {
+        if (set->max_slots == 0 || set->slots.size() < set->max_slots) {
+            Grow(set);
+        } else {
+            // Evicting single hashes would leave holes in other hashes'
+            // probe runs; starting over keeps every lookup exact.
+            std::fill(set->slots.begin(), set->slots.end(), 0);
+            set->forgotten += set->size;
+            set->size = 0;
+        }
+    }
+    size_t mask = set->slots.size() - 1;
+    size_t i = SlotOf(hash, mask);
+    while (set->slots[i] != 0) {
+        if (set->slots[i] == hash) {
+            return false;
+        }
+        i = (i + 1) & mask;
+    }
+    set->slots[i] = hash;
+    ++set->size;
+    return true;
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,48 @@
+#ifndef SP_DIFFER_CORE_CANONICAL_H
+#define SP_DIFFER_CORE_CANONICAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sp_differ {
+
+// Writes the canonical form of a case: for a case that parses as v1, the
+// payload with its seed zeroed and every flag bit but the key-presence bits
+// cleared. The seed and the negative-case bit only record how a case was
+// made; nothing a worker returns depends on them. Input and label order are
+// kept, since order-dependent behaviour is exactly what a differential run
+// should catch. Returns false, and copies the payload unchanged, when it
+// does not parse.
+bool CanonicalizeCase(const uint8_t* payload, size_t payload_len, std::vector<uint8_t>* out);
+
+// HashCase of the canonical form. Cases with equal canonical hashes give
+// every worker the same work. scratch is reused between calls.
+uint64_t CanonicalCaseHash(const uint8_t* payload, size_t payload_len,
+                           std::vector<uint8_t>* scratch);
+
+// Insert-only set of 64-bit case hashes for dropping duplicates from a
+// stream. Open addressing over a flat array keeps it at 16 bytes per case or
+// less. Since a stream is unbounded, max_slots caps the table: once it is
+// half full at that size, it is emptied and starts over. A forgotten case
+// is only run again, never mistaken for a repeat.
+struct CaseHashSet {
+    std::vector<uint64_t> slots;
+    size_t size = 0;
+    // 0 marks an empty slot, so a zero hash is tracked separately.
+    bool has_zero = false;
+    // Largest table size, a power of two; 0 for no limit.
+    size_t max_slots = 0;
+    // Hashes dropped when the capped table started over.
+    uint64_t forgotten = 0;
+};
+
+// The max_slots whose table fits in max_bytes.
+size_t CaseHashSlotsFor(size_t max_bytes);
+
+// Returns true when hash was not in the set yet.
+bool InsertCaseHash(CaseHashSet* set, uint64_t hash);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_CANONICAL_H
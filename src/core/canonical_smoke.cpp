@@ -0,0 +1,98 @@
+#include "canonical.h"
+#include "case.h"
+#include "io.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main() {
+    std::string error;
+    std::vector<uint8_t> example;
+    if (!sp_differ::ReadCasePayload("tests/vectors/example.hex", &example, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+
+    // The canonical form is the serialized Case with a zero seed and only
+    // the key-presence flags.
+    sp_differ::Case parsed;
+    std::vector<uint8_t> canonical;
+    std::vector<uint8_t> serialized;
+    if (!sp_differ::ParseCaseV1(example, &parsed, &error) ||
+        !sp_differ::CanonicalizeCase(example.data(), example.size(), &canonical)) {
+        std::cerr << "FAIL: example does not canonicalize" << std::endl;
+        return 2;
+    }
+    parsed.header.seed = 0;
+    parsed.header.flags &= (1u << 1) | (1u << 2);
+    sp_differ::SerializeCaseV1(parsed, &serialized);
+    if (canonical != serialized) {
+        std::cerr << "FAIL: canonical form differs from the reserialized case" << std::endl;
+        return 2;
+    }
+
+    // A different seed, negative bit, or unassigned flag is the same case; a
+    // different key-presence flag or label is not.
+    std::vector<uint8_t> scratch;
+    std::vector<uint8_t> reseeded = example;
+    reseeded[1] ^= 0x5a;
+    std::vector<uint8_t> negative = example;
+    negative[9] |= 1;
+    negative[12] |= 0x80;
+    std::vector<uint8_t> with_pubkeys = example;
+    with_pubkeys[9] |= 1u << 2;
+    std::vector<uint8_t> relabeled = example;
+    relabeled.back() ^= 1;
+    uint64_t base = sp_differ::CanonicalCaseHash(example.data(), example.size(), &scratch);
+    if (sp_differ::CanonicalCaseHash(reseeded.data(), reseeded.size(), &scratch) != base ||
+        sp_differ::CanonicalCaseHash(negative.data(), negative.size(), &scratch) != base ||
+        sp_differ::CanonicalCaseHash(with_pubkeys.data(), with_pubkeys.size(), &scratch) ==
+            base ||
+        sp_differ::CanonicalCaseHash(relabeled.data(), relabeled.size(), &scratch) == base) {
+        std::cerr << "FAIL: canonical hash equivalence" << std::endl;
+        return 2;
+    }
+
+    // Unparseable payloads are compared byte for byte, seed included.
+    std::vector<uint8_t> truncated(example.begin(), example.end() - 1);
+    std::vector<uint8_t> truncated_reseeded(reseeded.begin(), reseeded.end() - 1);
+    if (sp_differ::CanonicalizeCase(truncated.data(), truncated.size(), &canonical) ||
+        canonical != truncated ||
+        sp_differ::CanonicalCaseHash(truncated.data(), truncated.size(), &scratch) ==
+            sp_differ::CanonicalCaseHash(truncated_reseeded.data(), truncated_reseeded.size(),
+                                         &scratch)) {
+        std::cerr << "FAIL: unparseable payload canonicalization" << std::endl;
+        return 2;
+    }
+
+    sp_differ::CaseHashSet set;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        if (!sp_differ::InsertCaseHash(&set, i * 0x9e3779b97f4a7c15ull)) {
+            std::cerr << "FAIL: fresh hash reported as duplicate" << std::endl;
+            return 2;
+        }
+    }
+    if (sp_differ::InsertCaseHash(&set, 0) || sp_differ::InsertCaseHash(&set, 0x9e3779b97f4a7c15ull) ||
+        set.size != 9999) {
+        std::cerr << "FAIL: duplicate hash accepted" << std::endl;
+        return 2;
+    }
+
+    // A capped set stops growing and starts over when full, but still
+    // recognizes what it holds.
+    sp_differ::CaseHashSet capped;
+    capped.max_slots = sp_differ::CaseHashSlotsFor(16 << 10);
+    for (uint64_t i = 1; i <= 10000; ++i) {
+        sp_differ::InsertCaseHash(&capped, i * 0x9e3779b97f4a7c15ull);
+    }
+    if (capped.slots.size() != 2048 || capped.size + capped.forgotten != 10000 ||
+        capped.size > 1024 ||
+        sp_differ::InsertCaseHash(&capped, 10000 * 0x9e3779b97f4a7c15ull)) {
+        std::cerr << "FAIL: capped hash set" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: case canonicalization" << std::endl;
+    return 0;
+}
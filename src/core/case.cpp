@@ -7,174 +7,218 @@
 namespace sp_differ {
 namespace {
 
-bool ReadU8(const std::vector<uint8_t>& buf, size_t* off, uint8_t* out) {
-    if (*off + 1 > buf.size()) {
-        return false;
-    }
-    *out = buf[*off];
-    *off += 1;
-    return true;
-}
+constexpr size_t kInputFixedSize = kTxidSize + 4 + 1;
 
-bool ReadU16(const std::vector<uint8_t>& buf, size_t* off, uint16_t* out) {
-    if (*off + 2 > buf.size()) {
-        return false;
-    }
-    *out = static_cast<uint16_t>(buf[*off] | (static_cast<uint16_t>(buf[*off + 1]) << 8));
-    *off += 2;
-    return true;
+uint16_t LoadU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (static_cast<uint16_t>(p[1]) << 8));
 }
 
-bool ReadU32(const std::vector<uint8_t>& buf, size_t* off, uint32_t* out) {
-    if (*off + 4 > buf.size()) {
-        return false;
-    }
-    *out = static_cast<uint32_t>(buf[*off]) |
-           (static_cast<uint32_t>(buf[*off + 1]) << 8) |
-           (static_cast<uint32_t>(buf[*off + 2]) << 16) |
-           (static_cast<uint32_t>(buf[*off + 3]) << 24);
-    *off += 4;
-    return true;
+uint32_t LoadU32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
 }
 
-bool ReadU64(const std::vector<uint8_t>& buf, size_t* off, uint64_t* out) {
-    if (*off + 8 > buf.size()) {
-        return false;
-    }
-    *out = static_cast<uint64_t>(buf[*off]) |
-           (static_cast<uint64_t>(buf[*off + 1]) << 8) |
-           (static_cast<uint64_t>(buf[*off + 2]) << 16) |
-           (static_cast<uint64_t>(buf[*off + 3]) << 24) |
-           (static_cast<uint64_t>(buf[*off + 4]) << 32) |
-           (static_cast<uint64_t>(buf[*off + 5]) << 40) |
-           (static_cast<uint64_t>(buf[*off + 6]) << 48) |
-           (static_cast<uint64_t>(buf[*off + 7]) << 56);
-    *off += 8;
-    return true;
+uint64_t LoadU64(const uint8_t* p) {
+    return static_cast<uint64_t>(LoadU32(p)) | (static_cast<uint64_t>(LoadU32(p + 4)) << 32);
 }
 
-bool ReadBytes(const std::vector<uint8_t>& buf, size_t* off, size_t count, std::vector<uint8_t>* out) {
-    if (*off + count > buf.size()) {
-        return false;
+// Returns a pointer to the next count bytes and advances off, or null when
+// fewer than count bytes remain.
+const uint8_t* Take(const uint8_t* buf, size_t len, size_t* off, size_t count) {
+    if (count > len - *off) {
+        return nullptr;
     }
-    out->assign(buf.begin() + static_cast<long>(*off), buf.begin() + static_cast<long>(*off + count));
+    const uint8_t* p = buf + *off;
     *off += count;
-    return true;
+    return p;
 }
 
 bool IsValidInputType(uint8_t input_type) {
     return input_type == 0x01 || input_type == 0x02 || input_type == 0x03;
 }
 
+void StoreU16(uint16_t value, std::vector<uint8_t>* out) {
+    out->push_back(static_cast<uint8_t>(value));
+    out->push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void StoreU32(uint32_t value, std::vector<uint8_t>* out) {
+    for (int i = 0; i < 4; ++i) {
+        out->push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void StoreFixed(const std::vector<uint8_t>& field, size_t size, std::vector<uint8_t>* out) {
+    size_t used = field.size() < size ? field.size() : size;
+    out->insert(out->end(), field.begin(), field.begin() + used);
+    out->insert(out->end(), size - used, 0);
+}
+
+bool Fail(std::string* error, const char* message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
 }  // namespace
 
-bool ParseCaseV1(const std::vector<uint8_t>& payload, Case* out, std::string* error) {
+bool ParseCaseViewV1(const uint8_t* payload, size_t payload_len, CaseView* out, std::string* error) {
     if (!out) {
-        if (error) {
-            *error = "output case is null";
-        }
-        return false;
+        return Fail(error, "output case is null");
+    }
+    if (!payload && payload_len != 0) {
+        return Fail(error, "payload is null");
     }
 
     size_t off = 0;
-    CaseHeader header;
-    if (!ReadU8(payload, &off, &header.version)) {
-        if (error) {
-            *error = "unexpected end of data";
-        }
-        return false;
+    CaseView view;
+    const uint8_t* version = Take(payload, payload_len, &off, 1);
+    if (!version) {
+        return Fail(error, "unexpected end of data");
     }
-    if (header.version != 1) {
-        if (error) {
-            *error = "unsupported version";
-        }
-        return false;
+    view.header.version = version[0];
+    if (view.header.version != 1) {
+        return Fail(error, "unsupported version");
     }
-    if (!ReadU64(payload, &off, &header.seed) ||
-        !ReadU32(payload, &off, &header.flags) ||
-        !ReadU16(payload, &off, &header.input_count) ||
-        !ReadU16(payload, &off, &header.output_count)) {
-        if (error) {
-            *error = "unexpected end of data";
-        }
-        return false;
+    const uint8_t* fields = Take(payload, payload_len, &off, 8 + 4 + 2 + 2);
+    if (!fields) {
+        return Fail(error, "unexpected end of data");
     }
-
-    Case parsed;
-    parsed.header = header;
-
-    bool has_priv = (header.flags & (1u << 1)) != 0;
-    bool has_pub = (header.flags & (1u << 2)) != 0;
-
-    parsed.inputs.reserve(header.input_count);
-    for (uint16_t i = 0; i < header.input_count; ++i) {
-        InputEntry entry;
-        if (!ReadBytes(payload, &off, 32, &entry.outpoint_txid) ||
-            !ReadU32(payload, &off, &entry.outpoint_vout) ||
-            !ReadU8(payload, &off, &entry.input_type)) {
-            if (error) {
-                *error = "unexpected end of data";
-            }
-            return false;
-        }
-        if (!IsValidInputType(entry.input_type)) {
-            if (error) {
-                *error = "unknown input type";
-            }
-            return false;
+    view.header.seed = LoadU64(fields);
+    view.header.flags = LoadU32(fields + 8);
+    view.header.input_count = LoadU16(fields + 12);
+    view.header.output_count = LoadU16(fields + 14);
+
+    bool has_priv = (view.header.flags & (1u << 1)) != 0;
+    bool has_pub = (view.header.flags & (1u << 2)) != 0;
+    view.input_stride =
+        kInputFixedSize + (has_priv ? kPrivkeySize : 0) + (has_pub ? kPubkeySize : 0);
+
+    // Entries are checked one at a time so that a bad input type is reported
+    // ahead of a truncation further on, as the owning parser always did.
+    view.inputs = payload + off;
+    for (uint16_t i = 0; i < view.header.input_count; ++i) {
+        const uint8_t* fixed = Take(payload, payload_len, &off, kInputFixedSize);
+        if (!fixed) {
+            return Fail(error, "unexpected end of data");
         }
-        if (has_priv && !ReadBytes(payload, &off, 32, &entry.privkey)) {
-            if (error) {
-                *error = "unexpected end of data";
-            }
-            return false;
+        if (!IsValidInputType(fixed[kTxidSize + 4])) {
+            return Fail(error, "unknown input type");
         }
-        if (has_pub && !ReadBytes(payload, &off, 33, &entry.pubkey)) {
-            if (error) {
-                *error = "unexpected end of data";
-            }
-            return false;
+        if (!Take(payload, payload_len, &off, view.input_stride - kInputFixedSize)) {
+            return Fail(error, "unexpected end of data");
         }
-        parsed.inputs.push_back(entry);
     }
 
-    if (!ReadBytes(payload, &off, 33, &parsed.scan_pubkey) ||
-        !ReadBytes(payload, &off, 33, &parsed.spend_pubkey)) {
-        if (error) {
-            *error = "unexpected end of data";
-        }
-        return false;
+    view.scan_pubkey = Take(payload, payload_len, &off, kPubkeySize);
+    view.spend_pubkey = Take(payload, payload_len, &off, kPubkeySize);
+    const uint8_t* label_count = Take(payload, payload_len, &off, 2);
+    if (!view.scan_pubkey || !view.spend_pubkey || !label_count) {
+        return Fail(error, "unexpected end of data");
+    }
+    view.label_count = LoadU16(label_count);
+    view.labels = Take(payload, payload_len, &off, static_cast<size_t>(view.label_count) * 4);
+    if (!view.labels) {
+        return Fail(error, "unexpected end of data");
     }
 
-    uint16_t label_count = 0;
-    if (!ReadU16(payload, &off, &label_count)) {
-        if (error) {
-            *error = "unexpected end of data";
-        }
-        return false;
+    if (off != payload_len) {
+        return Fail(error, "trailing bytes");
     }
 
-    parsed.labels.reserve(label_count);
-    for (uint16_t i = 0; i < label_count; ++i) {
-        uint32_t label = 0;
-        if (!ReadU32(payload, &off, &label)) {
-            if (error) {
-                *error = "unexpected end of data";
-            }
-            return false;
-        }
-        parsed.labels.push_back(label);
+    *out = view;
+    return true;
+}
+
+InputView GetInput(const CaseView& view, size_t index) {
+    const uint8_t* entry = view.inputs + index * view.input_stride;
+    InputView input;
+    input.outpoint_txid = entry;
+    input.outpoint_vout = LoadU32(entry + kTxidSize);
+    input.input_type = entry[kTxidSize + 4];
+    const uint8_t* keys = entry + kInputFixedSize;
+    if ((view.header.flags & (1u << 1)) != 0) {
+        input.privkey = keys;
+        keys += kPrivkeySize;
+    }
+    if ((view.header.flags & (1u << 2)) != 0) {
+        input.pubkey = keys;
     }
+    return input;
+}
+
+uint32_t GetLabel(const CaseView& view, size_t index) {
+    return LoadU32(view.labels + index * 4);
+}
 
-    if (off != payload.size()) {
-        if (error) {
-            *error = "trailing bytes";
+void CaseFromView(const CaseView& view, Case* out) {
+    Case parsed;
+    parsed.header = view.header;
+    parsed.inputs.resize(view.header.input_count);
+    for (size_t i = 0; i < parsed.inputs.size(); ++i) {
+        InputView input = GetInput(view, i);
+        InputEntry& entry = parsed.inputs[i];
+        entry.outpoint_txid.assign(input.outpoint_txid, input.outpoint_txid + kTxidSize);
+        entry.outpoint_vout = input.outpoint_vout;
+        entry.input_type = input.input_type;
+        if (input.privkey) {
+            entry.privkey.assign(input.privkey, input.privkey + kPrivkeySize);
+        }
+        if (input.pubkey) {
+            entry.pubkey.assign(input.pubkey, input.pubkey + kPubkeySize);
         }
-        return false;
     }
-
+    parsed.scan_pubkey.assign(view.scan_pubkey, view.scan_pubkey + kPubkeySize);
+    parsed.spend_pubkey.assign(view.spend_pubkey, view.spend_pubkey + kPubkeySize);
+    parsed.labels.resize(view.label_count);
+    for (size_t i = 0; i < parsed.labels.size(); ++i) {
+        parsed.labels[i] = GetLabel(view, i);
+    }
     *out = std::move(parsed);
+}
+
+bool ParseCaseV1(const std::vector<uint8_t>& payload, Case* out, std::string* error) {
+    if (!out) {
+        return Fail(error, "output case is null");
+    }
+    CaseView view;
+    if (!ParseCaseViewV1(payload.data(), payload.size(), &view, error)) {
+        return false;
+    }
+    CaseFromView(view, out);
     return true;
 }
 
+void SerializeCaseV1(const Case& c, std::vector<uint8_t>* out) {
+    bool has_priv = (c.header.flags & (1u << 1)) != 0;
+    bool has_pub = (c.header.flags & (1u << 2)) != 0;
+    out->clear();
+    out->push_back(c.header.version);
+    StoreU32(static_cast<uint32_t>(c.header.seed), out);
+    StoreU32(static_cast<uint32_t>(c.header.seed >> 32), out);
+    StoreU32(c.header.flags, out);
+    StoreU16(static_cast<uint16_t>(c.inputs.size()), out);
+    StoreU16(c.header.output_count, out);
+    for (const InputEntry& input : c.inputs) {
+        StoreFixed(input.outpoint_txid, kTxidSize, out);
+        StoreU32(input.outpoint_vout, out);
+        out->push_back(input.input_type);
+        if (has_priv) {
+            StoreFixed(input.privkey, kPrivkeySize, out);
+        }
+        if (has_pub) {
+            StoreFixed(input.pubkey, kPubkeySize, out);
+        }
+    }
+    StoreFixed(c.scan_pubkey, kPubkeySize, out);
+    StoreFixed(c.spend_pubkey, kPubkeySize, out);
+    StoreU16(static_cast<uint16_t>(c.labels.size()), out);
+    for (uint32_t label : c.labels) {
+        StoreU32(label, out);
+    }
+}
+
 }  // namespace sp_differ
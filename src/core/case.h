@@ -31,8 +31,47 @@ struct Case {
     std::vector<uint32_t> labels;
 };
 
+constexpr size_t kTxidSize = 32;
+constexpr size_t kPrivkeySize = 32;
+constexpr size_t kPubkeySize = 33;
+
+// Borrowed view of one input entry. Pointers refer into the parsed payload;
+// privkey and pubkey are null when the case flags leave them out.
+struct InputView {
+    const uint8_t* outpoint_txid = nullptr;
+    uint32_t outpoint_vout = 0;
+    uint8_t input_type = 0;
+    const uint8_t* privkey = nullptr;
+    const uint8_t* pubkey = nullptr;
+};
+
+// Validated, non-owning view of a v1 case. Input entries share one stride, so
+// any entry is reachable in O(1) without decoding the ones before it. The view
+// is only valid while the payload it was parsed from is alive.
+struct CaseView {
+    CaseHeader header;
+    const uint8_t* inputs = nullptr;
+    size_t input_stride = 0;
+    const uint8_t* scan_pubkey = nullptr;
+    const uint8_t* spend_pubkey = nullptr;
+    uint16_t label_count = 0;
+    const uint8_t* labels = nullptr;
+};
+
+// Validates payload in a single pass without allocating.
+bool ParseCaseViewV1(const uint8_t* payload, size_t payload_len, CaseView* out, std::string* error);
+InputView GetInput(const CaseView& view, size_t index);
+uint32_t GetLabel(const CaseView& view, size_t index);
+// Copies a view into an owning Case.
+void CaseFromView(const CaseView& view, Case* out);
+
 bool ParseCaseV1(const std::vector<uint8_t>& payload, Case* out, std::string* error);
 
+// Encodes c as a v1 payload. input_count and label_count are taken from the
+// vector sizes, and each input carries the key material its flags call for,
+// zero-padded or cut to the fixed key size.
+void SerializeCaseV1(const Case& c, std::vector<uint8_t>* out);
+
 }  // namespace sp_differ
 
 #endif  // SP_DIFFER_CORE_CASE_H
@@ -1,6 +1,7 @@
 #include "case.h"
 #include "io.h"
 
+#include <algorithm>
 #include <iostream>
 
 int main() {
@@ -22,6 +23,55 @@ int main() {
         return 2;
     }
 
+    sp_differ::CaseView view;
+    if (!sp_differ::ParseCaseViewV1(payload.data(), payload.size(), &view, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+    sp_differ::InputView first = sp_differ::GetInput(view, 0);
+    if (first.outpoint_vout != parsed.inputs[0].outpoint_vout ||
+        first.input_type != parsed.inputs[0].input_type ||
+        !std::equal(parsed.scan_pubkey.begin(), parsed.scan_pubkey.end(), view.scan_pubkey) ||
+        view.label_count != parsed.labels.size()) {
+        std::cerr << "FAIL: view disagrees with owning case" << std::endl;
+        return 2;
+    }
+
+    // Two inputs with private keys only, and two labels.
+    std::vector<uint8_t> crafted = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0x02, 0, 0, 0, 2, 0, 1, 0};
+    for (uint8_t i = 0; i < 2; ++i) {
+        crafted.insert(crafted.end(), sp_differ::kTxidSize, static_cast<uint8_t>(0xa0 + i));
+        crafted.insert(crafted.end(), {static_cast<uint8_t>(i + 5), 0, 0, 0, 0x02});
+        crafted.insert(crafted.end(), sp_differ::kPrivkeySize, static_cast<uint8_t>(0xb0 + i));
+    }
+    crafted.insert(crafted.end(), 2 * sp_differ::kPubkeySize, 0x02);
+    crafted.insert(crafted.end(), {2, 0, 1, 0, 0, 0, 0x78, 0x56, 0x34, 0x12});
+    if (!sp_differ::ParseCaseViewV1(crafted.data(), crafted.size(), &view, &error)) {
+        std::cerr << "FAIL: crafted case: " << error << std::endl;
+        return 2;
+    }
+    sp_differ::InputView second = sp_differ::GetInput(view, 1);
+    if (second.outpoint_txid[0] != 0xa1 || second.outpoint_vout != 6 || !second.privkey ||
+        second.privkey[0] != 0xb1 || second.pubkey || sp_differ::GetLabel(view, 1) != 0x12345678) {
+        std::cerr << "FAIL: crafted case fields" << std::endl;
+        return 2;
+    }
+    sp_differ::Case owned;
+    sp_differ::CaseFromView(view, &owned);
+    std::vector<uint8_t> encoded;
+    sp_differ::SerializeCaseV1(owned, &encoded);
+    if (encoded != crafted) {
+        std::cerr << "FAIL: serialized case does not round-trip" << std::endl;
+        return 2;
+    }
+
+    crafted[17 + sp_differ::kTxidSize + 4] = 0x09;
+    if (sp_differ::ParseCaseViewV1(crafted.data(), crafted.size(), &view, &error) ||
+        error != "unknown input type") {
+        std::cerr << "FAIL: bad input type should not parse" << std::endl;
+        return 2;
+    }
+
     if (payload.size() > 1) {
         std::vector<uint8_t> truncated(payload.begin(), payload.end() - 1);
         sp_differ::Case should_fail;
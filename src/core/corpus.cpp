@@ -0,0 +1,122 @@
+#include "corpus.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <glob.h>
+#endif
+
+namespace sp_differ {
+namespace {
+
+bool HasGlobChars(const std::string& spec) {
+    return spec.find_first_of("*?[") != std::string::npos;
+}
+
+bool IsCaseFile(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    return ext == ".hex" || ext == ".bin";
+}
+
+bool ListDirectory(const std::string& dir, std::vector<std::string>* out, std::string* error) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(dir, ec);
+    if (ec) {
+        if (error) {
+            *error = "unable to read corpus directory";
+        }
+        return false;
+    }
+    for (const auto& entry : it) {
+        if (entry.is_regular_file(ec) && IsCaseFile(entry.path())) {
+            out->push_back(entry.path().string());
+        }
+    }
+    std::sort(out->begin(), out->end());
+    return true;
+}
+
+bool ListGlob(const std::string& pattern, std::vector<std::string>* out, std::string* error) {
+#if defined(_WIN32)
+    (void)pattern;
+    (void)out;
+    if (error) {
+        *error = "glob patterns are not supported on this platform";
+    }
+    return false;
+#else
+    glob_t matches{};
+    int rc = glob(pattern.c_str(), 0, nullptr, &matches);
+    if (rc == GLOB_NOMATCH) {
+        globfree(&matches);
+        return true;
+    }
+    if (rc != 0) {
+        globfree(&matches);
+        if (error) {
+            *error = "glob expansion failed";
+        }
+        return false;
+    }
+    for (size_t i = 0; i < matches.gl_pathc; ++i) {
+        out->push_back(matches.gl_pathv[i]);
+    }
+    globfree(&matches);
+    return true;
+#endif
+}
+
+bool ListFromFile(const std::string& path, std::vector<std::string>* out, std::string* error) {
+    std::ifstream file(path);
+    if (!file) {
+        if (error) {
+            *error = "unable to read corpus list";
+        }
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+        size_t end = line.find_last_not_of(" \t\r");
+        out->push_back(line.substr(begin, end - begin + 1));
+    }
+    return true;
+}
+
+}  // namespace
+
+bool ListCaseFiles(const std::string& spec, std::vector<std::string>* out, std::string* error) {
+    if (!out) {
+        if (error) {
+            *error = "output list is null";
+        }
+        return false;
+    }
+
+    std::vector<std::string> paths;
+    std::error_code ec;
+    bool ok = false;
+    if (std::filesystem::is_directory(spec, ec)) {
+        ok = ListDirectory(spec, &paths, error);
+    } else if (HasGlobChars(spec)) {
+        ok = ListGlob(spec, &paths, error);
+    } else {
+        ok = ListFromFile(spec, &paths, error);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    *out = std::move(paths);
+    return true;
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,17 @@
+#ifndef SP_DIFFER_CORE_CORPUS_H
+#define SP_DIFFER_CORE_CORPUS_H
+
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+
+// Expands a corpus spec into a list of case file paths. The spec is a
+// directory (every *.hex and *.bin file directly inside it, sorted), a glob
+// pattern (sorted), or a list file with one case path per line in the given
+// order ('#' starts a comment).
+bool ListCaseFiles(const std::string& spec, std::vector<std::string>* out, std::string* error);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_CORPUS_H
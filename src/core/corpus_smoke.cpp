@@ -0,0 +1,35 @@
+#include "corpus.h"
+
+#include <iostream>
+
+int main() {
+    std::string error;
+    std::vector<std::string> paths;
+    if (!sp_differ::ListCaseFiles("tests/vectors", &paths, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+
+    if (paths.size() != 2 || paths[0] != "tests/vectors/example.hex") {
+        std::cerr << "FAIL: unexpected directory listing" << std::endl;
+        return 2;
+    }
+
+    if (!sp_differ::ListCaseFiles("tests/vectors/ex*.hex", &paths, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+
+    if (paths.size() != 1 || paths[0] != "tests/vectors/example.hex") {
+        std::cerr << "FAIL: unexpected glob expansion" << std::endl;
+        return 2;
+    }
+
+    if (sp_differ::ListCaseFiles("tests/vectors/missing.list", &paths, &error)) {
+        std::cerr << "FAIL: missing list file should not load" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: corpus listing" << std::endl;
+    return 0;
+}
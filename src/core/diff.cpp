@@ -0,0 +1,244 @@
+#include "diff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+#define SP_DIFFER_DIFF_SSE2 1
+#include <emmintrin.h>
+#else
+#define SP_DIFFER_DIFF_SSE2 0
+#endif
+
+namespace sp_differ {
+namespace {
+
+constexpr size_t kOutputHeaderSize = 4;
+constexpr size_t kOutputPubkeySize = 33;
+constexpr size_t kTweakSize = 32;
+constexpr size_t kRecordSize = kOutputPubkeySize + kTweakSize;
+
+// A validated v1 output: pubkeys first, then the tweaks in the same order.
+struct OutputRecords {
+    const uint8_t* pubkeys = nullptr;
+    const uint8_t* tweaks = nullptr;
+    size_t count = 0;
+};
+
+OutputRecords RecordsOf(const uint8_t* output, size_t output_len) {
+    OutputRecords records;
+    records.count = (output_len - kOutputHeaderSize) / kRecordSize;
+    records.pubkeys = output + kOutputHeaderSize;
+    records.tweaks = records.pubkeys + records.count * kOutputPubkeySize;
+    return records;
+}
+
+// Records are short and fixed-size, so two 16-byte compares beat a memcmp
+// call; SSE2 is part of every x86-64 target.
+bool Equal32(const uint8_t* a, const uint8_t* b) {
+#if SP_DIFFER_DIFF_SSE2
+    __m128i low = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+    __m128i high = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16)));
+    return _mm_movemask_epi8(_mm_and_si128(low, high)) == 0xffff;
+#else
+    return std::memcmp(a, b, 32) == 0;
+#endif
+}
+
+bool PubkeyEqual(const uint8_t* a, const uint8_t* b) {
+    return a[32] == b[32] && Equal32(a, b);
+}
+
+bool RecordEqual(const OutputRecords& a, size_t i, const OutputRecords& b, size_t j) {
+    return PubkeyEqual(a.pubkeys + i * kOutputPubkeySize, b.pubkeys + j * kOutputPubkeySize) &&
+           Equal32(a.tweaks + i * kTweakSize, b.tweaks + j * kTweakSize);
+}
+
+uint64_t Load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t Mix(uint64_t hash, uint64_t word) {
+    hash ^= word;
+    hash *= 0x9e3779b97f4a7c15ull;
+    return hash ^ (hash >> 29);
+}
+
+// Only used to find candidate partners, which are then compared in full,
+// so a fast multiply-xorshift over the 65 record bytes is enough.
+uint64_t RecordHash(const OutputRecords& records, size_t i) {
+    const uint8_t* pubkey = records.pubkeys + i * kOutputPubkeySize;
+    const uint8_t* tweak = records.tweaks + i * kTweakSize;
+    uint64_t hash = pubkey[32];
+    for (size_t w = 0; w < 32; w += 8) {
+        hash = Mix(hash, Load64(pubkey + w));
+        hash = Mix(hash, Load64(tweak + w));
+    }
+    return hash;
+}
+
+// Matches every right record to an unmatched equal left record through an
+// open-addressed table of left indices. Afterwards scratch->matched flags
+// the matched left records; unmatched right indices go to unmatched_right
+// when it is non-null. Returns the number of matched pairs.
+size_t MatchRecords(const OutputRecords& left, const OutputRecords& right, DiffScratch* scratch,
+                    std::vector<uint32_t>* unmatched_right) {
+    size_t table_size = 16;
+    while (table_size < left.count * 2) {
+        table_size <<= 1;
+    }
+    size_t mask = table_size - 1;
+    scratch->hashes.resize(left.count);
+    scratch->slots.assign(table_size, 0);
+    scratch->matched.assign(left.count, 0);
+    for (size_t i = 0; i < left.count; ++i) {
+        uint64_t hash = RecordHash(left, i);
+        scratch->hashes[i] = hash;
+        size_t slot = static_cast<size_t>(hash) & mask;
+        while (scratch->slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        scratch->slots[slot] = static_cast<uint32_t>(i + 1);
+    }
+
+    size_t matched = 0;
+    for (size_t j = 0; j < right.count; ++j) {
+        uint64_t hash = RecordHash(right, j);
+        bool found = false;
+        for (size_t slot = static_cast<size_t>(hash) & mask; scratch->slots[slot] != 0;
+             slot = (slot + 1) & mask) {
+            size_t i = scratch->slots[slot] - 1;
+            if (!scratch->matched[i] && scratch->hashes[i] == hash &&
+                RecordEqual(left, i, right, j)) {
+                scratch->matched[i] = 1;
+                found = true;
+                break;
+            }
+        }
+        if (found) {
+            ++matched;
+        } else if (unmatched_right) {
+            unmatched_right->push_back(static_cast<uint32_t>(j));
+        }
+    }
+    return matched;
+}
+
+void AddDiff(std::vector<FieldDiff>* diffs, DiffField field, size_t index, bool in_left,
+             bool in_right) {
+    FieldDiff diff;
+    diff.field = field;
+    diff.index = static_cast<uint32_t>(index);
+    diff.in_left = in_left;
+    diff.in_right = in_right;
+    diffs->push_back(diff);
+}
+
+}  // namespace
+
+bool OutputsEqual(const uint8_t* left, size_t left_len, const uint8_t* right, size_t right_len,
+                  CompareMode mode, DiffScratch* scratch) {
+    if (left[1] != right[1] || left_len != right_len) {
+        return false;
+    }
+    if (std::memcmp(left, right, left_len) == 0) {
+        return true;
+    }
+    if (mode == CompareMode::kOrdered || left[2] != right[2] || left[3] != right[3]) {
+        return false;
+    }
+    OutputRecords left_records = RecordsOf(left, left_len);
+    return MatchRecords(left_records, RecordsOf(right, right_len), scratch, nullptr) ==
+           left_records.count;
+}
+
+void DiffOutputs(const uint8_t* left, size_t left_len, const uint8_t* right, size_t right_len,
+                 CompareMode mode, DiffScratch* scratch, std::vector<FieldDiff>* diffs) {
+    diffs->clear();
+    if (left[0] != right[0]) {
+        AddDiff(diffs, DiffField::kVersion, 0, true, true);
+    }
+    if (left[1] != right[1]) {
+        AddDiff(diffs, DiffField::kStatus, 0, true, true);
+    }
+    if (left[2] != right[2] || left[3] != right[3]) {
+        AddDiff(diffs, DiffField::kOutputCount, 0, true, true);
+    }
+    OutputRecords left_records = RecordsOf(left, left_len);
+    OutputRecords right_records = RecordsOf(right, right_len);
+
+    if (mode == CompareMode::kUnordered) {
+        std::vector<uint32_t> unmatched_right;
+        MatchRecords(left_records, right_records, scratch, &unmatched_right);
+        for (size_t i = 0; i < left_records.count; ++i) {
+            if (!scratch->matched[i]) {
+                AddDiff(diffs, DiffField::kRecord, i, true, false);
+            }
+        }
+        for (uint32_t j : unmatched_right) {
+            AddDiff(diffs, DiffField::kRecord, j, false, true);
+        }
+        return;
+    }
+
+    size_t common = std::min(left_records.count, right_records.count);
+    for (size_t i = 0; i < common; ++i) {
+        if (!PubkeyEqual(left_records.pubkeys + i * kOutputPubkeySize,
+                         right_records.pubkeys + i * kOutputPubkeySize)) {
+            AddDiff(diffs, DiffField::kPubkey, i, true, true);
+        }
+        if (!Equal32(left_records.tweaks + i * kTweakSize,
+                     right_records.tweaks + i * kTweakSize)) {
+            AddDiff(diffs, DiffField::kTweak, i, true, true);
+        }
+    }
+    for (size_t i = common; i < std::max(left_records.count, right_records.count); ++i) {
+        AddDiff(diffs, DiffField::kRecord, i, i < left_records.count, i < right_records.count);
+    }
+}
+
+std::string FormatFieldDiffs(const std::vector<FieldDiff>& diffs, size_t max_fields) {
+    std::string text;
+    size_t shown = std::min(diffs.size(), max_fields);
+    for (size_t k = 0; k < shown; ++k) {
+        const FieldDiff& diff = diffs[k];
+        if (!text.empty()) {
+            text += ' ';
+        }
+        text += DiffFieldName(diff.field);
+        if (diff.field == DiffField::kPubkey || diff.field == DiffField::kTweak ||
+            diff.field == DiffField::kRecord) {
+            text += "[" + std::to_string(diff.index) + "]";
+        }
+        if (diff.in_left != diff.in_right) {
+            text += diff.in_left ? "(left)" : "(right)";
+        }
+    }
+    if (diffs.size() > shown) {
+        text += " (+" + std::to_string(diffs.size() - shown) + " more)";
+    }
+    return text;
+}
+
+MismatchSignature SignatureOfDiff(const std::vector<FieldDiff>& diffs, int left_status,
+                                  int right_status) {
+    MismatchSignature signature;
+    signature.left_status = left_status;
+    signature.right_status = right_status;
+    if (!diffs.empty()) {
+        signature.field = diffs[0].field;
+        if (diffs[0].field == DiffField::kPubkey || diffs[0].field == DiffField::kTweak ||
+            diffs[0].field == DiffField::kRecord) {
+            signature.output_index = diffs[0].index;
+        }
+    }
+    return signature;
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,64 @@
+#ifndef SP_DIFFER_CORE_DIFF_H
+#define SP_DIFFER_CORE_DIFF_H
+
+#include "signature.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+
+enum class CompareMode : uint8_t {
+    // Outputs must match byte for byte.
+    kOrdered,
+    // Output records (a pubkey with its tweak) may come in any order; the
+    // two outputs must hold the same multiset of records.
+    kUnordered,
+};
+
+// One diverging field of two v1 outputs.
+struct FieldDiff {
+    DiffField field = DiffField::kLength;
+    // Record index for pubkey, tweak, and record diffs.
+    uint32_t index = 0;
+    // Which outputs hold the field: both when the values differ, one when
+    // the other output has no such record.
+    bool in_left = true;
+    bool in_right = true;
+};
+
+// Reusable buffers for the order-insensitive paths, one per thread.
+struct DiffScratch {
+    std::vector<uint64_t> hashes;
+    std::vector<uint32_t> slots;
+    std::vector<uint8_t> matched;
+};
+
+// Equality under mode. The outputs must have passed ValidateOutputPayload.
+// The common equal case is a status check and one wide compare; unordered
+// outputs that differ byte-wise are matched record by record through a
+// hash table, never sorted.
+bool OutputsEqual(const uint8_t* left, size_t left_len, const uint8_t* right, size_t right_len,
+                  CompareMode mode, DiffScratch* scratch);
+
+// Every diverging field in one pass, in output order: version, status, and
+// output count first, then each record. Ordered mode compares record i of
+// each side field by field; records past the shorter output are reported as
+// held by one side. Unordered mode reports each record left without a
+// partner as kRecord on its own side. Empty when the outputs are equal.
+void DiffOutputs(const uint8_t* left, size_t left_len, const uint8_t* right, size_t right_len,
+                 CompareMode mode, DiffScratch* scratch, std::vector<FieldDiff>* diffs);
+
+// e.g. "pubkey[2] tweak[2] record[5](left)", listing at most max_fields
+// and counting the rest as "(+N more)".
+std::string FormatFieldDiffs(const std::vector<FieldDiff>& diffs, size_t max_fields);
+
+// Signature of a mismatch from its first diverging field.
+MismatchSignature SignatureOfDiff(const std::vector<FieldDiff>& diffs, int left_status,
+                                  int right_status);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_DIFF_H
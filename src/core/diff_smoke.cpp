@@ -0,0 +1,134 @@
+#include "diff.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A status-ok v1 output whose record i carries the byte tags[i] in every
+// pubkey and tweak byte (the pubkey parity byte is always 0x02).
+std::vector<uint8_t> MakeOutput(const std::vector<uint8_t>& tags) {
+    uint16_t count = static_cast<uint16_t>(tags.size());
+    std::vector<uint8_t> output = {1, 0, static_cast<uint8_t>(count & 0xff),
+                                   static_cast<uint8_t>(count >> 8)};
+    for (uint8_t tag : tags) {
+        output.push_back(0x02);
+        output.insert(output.end(), 32, tag);
+    }
+    for (uint8_t tag : tags) {
+        output.insert(output.end(), 32, tag);
+    }
+    return output;
+}
+
+bool Equal(const std::vector<uint8_t>& left, const std::vector<uint8_t>& right,
+           sp_differ::CompareMode mode, sp_differ::DiffScratch* scratch) {
+    return sp_differ::OutputsEqual(left.data(), left.size(), right.data(), right.size(), mode,
+                                   scratch);
+}
+
+std::string Diff(const std::vector<uint8_t>& left, const std::vector<uint8_t>& right,
+                 sp_differ::CompareMode mode, sp_differ::DiffScratch* scratch) {
+    std::vector<sp_differ::FieldDiff> diffs;
+    sp_differ::DiffOutputs(left.data(), left.size(), right.data(), right.size(), mode, scratch,
+                           &diffs);
+    return sp_differ::FormatFieldDiffs(diffs, 4);
+}
+
+bool Expect(const std::string& what, const std::string& got, const std::string& want) {
+    if (got != want) {
+        std::cerr << "FAIL: " << what << ": got '" << got << "', want '" << want << "'"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    const sp_differ::CompareMode ordered = sp_differ::CompareMode::kOrdered;
+    const sp_differ::CompareMode unordered = sp_differ::CompareMode::kUnordered;
+    sp_differ::DiffScratch scratch;
+
+    std::vector<uint8_t> left = MakeOutput({1, 2, 3});
+    if (!Equal(left, left, ordered, &scratch) || !Equal(left, left, unordered, &scratch) ||
+        !Expect("equal", Diff(left, left, ordered, &scratch), "")) {
+        return 2;
+    }
+
+    // Every diverging field is listed, not just the first.
+    std::vector<uint8_t> right = left;
+    right[4 + 33 + 7] ^= 1;
+    right[4 + 3 * 33 + 2 * 32 + 31] ^= 1;
+    if (Equal(left, right, ordered, &scratch) ||
+        !Expect("fields", Diff(left, right, ordered, &scratch), "pubkey[1] tweak[2]")) {
+        return 2;
+    }
+
+    // Reordered records only match without ordering.
+    right = MakeOutput({3, 1, 2});
+    if (Equal(left, right, ordered, &scratch) || !Equal(left, right, unordered, &scratch) ||
+        !Expect("reordered", Diff(left, right, unordered, &scratch), "")) {
+        return 2;
+    }
+
+    // A changed record shows up once on each side, by its own index.
+    right = MakeOutput({3, 9, 1});
+    if (Equal(left, right, unordered, &scratch) ||
+        !Expect("unmatched", Diff(left, right, unordered, &scratch),
+                "record[1](left) record[1](right)")) {
+        return 2;
+    }
+
+    // Multiplicity counts: {1, 1, 2} is not {1, 2, 2}.
+    if (Equal(MakeOutput({1, 1, 2}), MakeOutput({1, 2, 2}), unordered, &scratch)) {
+        std::cerr << "FAIL: multisets with different counts compared equal" << std::endl;
+        return 2;
+    }
+
+    // A pubkey and tweak from different records do not pair up.
+    right = MakeOutput({1, 2, 3});
+    std::swap_ranges(right.begin() + 4 + 3 * 33, right.begin() + 4 + 3 * 33 + 32,
+                     right.begin() + 4 + 3 * 33 + 32);
+    if (Equal(left, right, unordered, &scratch)) {
+        std::cerr << "FAIL: records with swapped tweaks compared equal" << std::endl;
+        return 2;
+    }
+
+    right = MakeOutput({1, 2});
+    if (!Expect("count", Diff(left, right, ordered, &scratch), "output_count record[2](left)")) {
+        return 2;
+    }
+    right = {1, 4, 0, 0};
+    if (!Expect("status", Diff(left, right, ordered, &scratch),
+                "status output_count record[0](left) record[1](left) (+1 more)")) {
+        return 2;
+    }
+    std::vector<sp_differ::FieldDiff> diffs;
+    sp_differ::DiffOutputs(left.data(), left.size(), right.data(), right.size(), ordered,
+                           &scratch, &diffs);
+    sp_differ::MismatchSignature signature = sp_differ::SignatureOfDiff(diffs, 0, 4);
+    if (signature.field != sp_differ::DiffField::kStatus || signature.right_status != 4) {
+        std::cerr << "FAIL: status diff signature" << std::endl;
+        return 2;
+    }
+
+    // Many records, reversed, go through the table without collisions
+    // mattering.
+    std::vector<uint8_t> tags;
+    std::vector<uint8_t> reversed;
+    for (int i = 0; i < 2000; ++i) {
+        tags.push_back(static_cast<uint8_t>(i * 7));
+    }
+    reversed.assign(tags.rbegin(), tags.rend());
+    if (!Equal(MakeOutput(tags), MakeOutput(reversed), unordered, &scratch)) {
+        std::cerr << "FAIL: reversed large output compared unequal" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: output diff" << std::endl;
+    return 0;
+}
@@ -0,0 +1,625 @@
+#include "generate.h"
+
+#include "case.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+constexpr size_t kHeaderSize = 1 + 8 + 4 + 2 + 2;
+constexpr size_t kKeyTableSize = 64;
+
+struct KeyPair {
+    uint8_t privkey[kPrivkeySize];
+    uint8_t pubkey[kPubkeySize];
+};
+
+// Scalars k_i = SHA256("sp-differ generator key <i>") mod n with their
+// compressed public keys k_i * G, precomputed so the generator can emit
+// consistent key pairs without doing curve arithmetic.
+const KeyPair kKeyTable[kKeyTableSize] = {
+    {{0xb2, 0x6b, 0xa4, 0x32, 0x4c, 0x41, 0x21, 0xde, 0x15, 0xb4, 0x42, 0x14,
+      0x35, 0x96, 0xc6, 0x7f, 0x51, 0xd8, 0xee, 0x72, 0x57, 0xd9, 0xb3, 0x1d,
+      0xa3, 0x5a, 0xc3, 0xd8, 0x83, 0xba, 0x3a, 0x60},
+     {0x03, 0x2a, 0xbe, 0xef, 0x17, 0x9d, 0x05, 0xc6, 0x0a, 0x14, 0x5f, 0x0d,
+      0x94, 0xef, 0x07, 0xfc, 0xc8, 0xc5, 0x1c, 0xb3, 0xa4, 0x8b, 0x72, 0xce,
+      0x52, 0x72, 0x63, 0xfd, 0x8a, 0xac, 0xc6, 0x02, 0x9d}},
+    {{0xae, 0xa1, 0x0a, 0xd7, 0x78, 0xe2, 0x77, 0x64, 0x47, 0x79, 0xcc, 0x56,
+      0x88, 0x30, 0x1e, 0x8f, 0xd3, 0x0b, 0xf5, 0xb3, 0xe4, 0x82, 0xbd, 0xec,
+      0xc7, 0xa9, 0x54, 0x7e, 0xbc, 0x6f, 0x29, 0x9d},
+     {0x03, 0x5c, 0x9b, 0x19, 0x1f, 0xb7, 0xc2, 0x48, 0xf2, 0xce, 0x88, 0x62,
+      0xa8, 0x59, 0x07, 0x4a, 0xe3, 0x6c, 0xfa, 0x55, 0x88, 0x6c, 0x96, 0x8f,
+      0x0f, 0xbd, 0xe5, 0x46, 0x2d, 0x8a, 0x8e, 0x7a, 0x9b}},
+    {{0x3f, 0x91, 0xfd, 0xe4, 0xf2, 0x13, 0x0f, 0x71, 0xec, 0x0c, 0xa3, 0xe1,
+      0x8d, 0xda, 0x1b, 0xd3, 0x8b, 0x57, 0x53, 0x9e, 0xaf, 0x03, 0x7c, 0xbb,
+      0x9a, 0xf0, 0x48, 0xeb, 0xd1, 0x17, 0x35, 0xd9},
+     {0x02, 0xf2, 0x2f, 0xc0, 0xc9, 0x90, 0x05, 0x64, 0xd0, 0xba, 0xf8, 0x23,
+      0xe9, 0x2d, 0x5e, 0x17, 0x6b, 0xd7, 0x58, 0xba, 0x7c, 0xa3, 0x4d, 0x2b,
+      0x55, 0xa5, 0xa3, 0x68, 0x79, 0xf8, 0xdb, 0xd2, 0x6d}},
+    {{0x0f, 0x21, 0xc5, 0x9d, 0x19, 0x83, 0xd8, 0x8d, 0xcc, 0x5c, 0x9c, 0xb9,
+      0x70, 0xd5, 0x95, 0x77, 0x58, 0x26, 0xaa, 0x8b, 0x4a, 0xed, 0x0b, 0x68,
+      0x03, 0x8a, 0x13, 0xcd, 0x98, 0xaf, 0x9a, 0x8b},
+     {0x02, 0x72, 0xf4, 0x1a, 0x72, 0xfe, 0xfc, 0xb6, 0x32, 0x25, 0x11, 0xfd,
+      0xe8, 0x3c, 0x6b, 0x4a, 0xd5, 0xf8, 0x78, 0x45, 0xa0, 0x15, 0xed, 0x0c,
+      0x24, 0x47, 0x3a, 0x59, 0xf3, 0x68, 0x66, 0xdb, 0xdd}},
+    {{0x66, 0x24, 0xf3, 0xce, 0x82, 0x97, 0x55, 0xa3, 0xf1, 0x71, 0x97, 0x7b,
+      0x23, 0xd2, 0x48, 0xd2, 0xf8, 0x50, 0xcb, 0xc3, 0xbe, 0x49, 0xa7, 0xfe,
+      0xf2, 0x8f, 0xce, 0xa9, 0x9d, 0x98, 0xa2, 0x12},
+     {0x03, 0x58, 0xbe, 0x67, 0x32, 0xd4, 0x98, 0xe0, 0x75, 0x29, 0xb2, 0x55,
+      0xe0, 0x64, 0x72, 0x01, 0x91, 0x1e, 0xd9, 0x9d, 0x76, 0x6e, 0xb4, 0x79,
+      0x2e, 0x98, 0xb6, 0x91, 0xa4, 0x4b, 0x5b, 0x23, 0x4f}},
+    {{0xee, 0xf3, 0x15, 0x6d, 0x62, 0x2c, 0xb1, 0xa6, 0x6e, 0xf1, 0x33, 0x34,
+      0x68, 0xf5, 0xe0, 0x2c, 0xa2, 0x47, 0x11, 0x22, 0x8a, 0xe9, 0xef, 0xcd,
+      0x7e, 0x9e, 0xcb, 0xc1, 0x29, 0x85, 0x40, 0x15},
+     {0x02, 0x8f, 0x09, 0x5a, 0xf3, 0x5b, 0xd0, 0x9e, 0xdf, 0x0c, 0x58, 0x73,
+      0x17, 0x83, 0xc5, 0x0b, 0xb6, 0x27, 0x57, 0xe8, 0x4e, 0x46, 0x0a, 0xb8,
+      0x40, 0x1b, 0x9f, 0xb6, 0x71, 0x46, 0x59, 0x8a, 0xbc}},
+    {{0x6d, 0x5c, 0x1e, 0x74, 0x25, 0xd2, 0x63, 0xbe, 0xff, 0xaa, 0x5b, 0x20,
+      0x0e, 0x0f, 0xfe, 0x87, 0x29, 0x54, 0x01, 0x91, 0x1d, 0xb8, 0xc1, 0xf0,
+      0x07, 0x49, 0x0f, 0xcf, 0x1a, 0xb9, 0x14, 0x34},
+     {0x02, 0x65, 0xee, 0xa3, 0x69, 0x7b, 0x5a, 0x46, 0xc4, 0x41, 0x73, 0x5b,
+      0xa0, 0xce, 0xaa, 0xcc, 0x8f, 0xc8, 0x8e, 0x45, 0xc7, 0xc2, 0x3a, 0x7e,
+      0xc9, 0x62, 0x74, 0x85, 0xb1, 0x0d, 0x83, 0x6b, 0x96}},
+    {{0xee, 0x2b, 0x69, 0x29, 0x7a, 0xb3, 0xa9, 0x6b, 0xbf, 0xc9, 0x1a, 0xcb,
+      0x36, 0x9a, 0x91, 0x48, 0x50, 0xb0, 0xf8, 0xa4, 0x64, 0x56, 0x9d, 0x93,
+      0xf0, 0xe2, 0x39, 0x37, 0xe4, 0xd5, 0x4b, 0xe5},
+     {0x02, 0xcf, 0x20, 0xe9, 0x31, 0x9b, 0xcc, 0xb5, 0x48, 0x3f, 0xf8, 0x44,
+      0x42, 0x70, 0xa0, 0x59, 0x4c, 0x32, 0x0b, 0xf0, 0x13, 0x43, 0x1e, 0x4b,
+      0x0c, 0x75, 0x92, 0xd1, 0xc7, 0x1b, 0x11, 0x7d, 0x8b}},
+    {{0x2b, 0x9f, 0x0a, 0x31, 0xd6, 0x52, 0x7d, 0x8b, 0x6a, 0x08, 0x54, 0xab,
+      0x84, 0x3d, 0x18, 0x73, 0xce, 0x99, 0xbf, 0xd7, 0xa3, 0x0b, 0xb7, 0xb6,
+      0x9d, 0x38, 0x01, 0x16, 0x41, 0x94, 0xe4, 0xfc},
+     {0x02, 0xb8, 0x87, 0x2b, 0xf2, 0x23, 0x26, 0x5f, 0x53, 0xff, 0xe1, 0xdc,
+      0x8c, 0x35, 0xce, 0xd5, 0x49, 0x1d, 0x26, 0x3b, 0x45, 0xf9, 0xa4, 0x83,
+      0x60, 0xa0, 0xf7, 0xaf, 0x6c, 0x7b, 0x0b, 0xd6, 0x55}},
+    {{0x36, 0x9c, 0x43, 0x11, 0x87, 0x26, 0x2e, 0x78, 0xc9, 0x5c, 0x19, 0x28,
+      0xbb, 0x95, 0x87, 0xdf, 0x08, 0xc2, 0xbf, 0xaa, 0x03, 0x2b, 0xbd, 0x47,
+      0x16, 0xe2, 0x4a, 0x83, 0x70, 0xa1, 0x52, 0xfd},
+     {0x03, 0x82, 0xb6, 0xbb, 0x27, 0xbc, 0x51, 0x6b, 0x3a, 0x5c, 0x3e, 0x30,
+      0xff, 0x02, 0xbb, 0xdd, 0x7e, 0x4f, 0x6c, 0x76, 0xbb, 0xbf, 0x79, 0xeb,
+      0x37, 0x92, 0x56, 0xff, 0xd8, 0x35, 0x30, 0x76, 0x98}},
+    {{0xac, 0x64, 0xdb, 0x04, 0x66, 0x44, 0x34, 0x6c, 0x30, 0xcd, 0x9b, 0x34,
+      0x87, 0xd5, 0x34, 0x4b, 0xbd, 0x0d, 0x5c, 0x7d, 0xd4, 0xcd, 0xfc, 0x33,
+      0x53, 0x80, 0x9c, 0xa6, 0x9c, 0x80, 0x4d, 0x3e},
+     {0x02, 0x4e, 0x69, 0x97, 0x59, 0x9f, 0xc7, 0x11, 0x77, 0x75, 0x75, 0x9b,
+      0xad, 0x30, 0xaa, 0xe3, 0x39, 0x35, 0x4c, 0x96, 0x19, 0xe2, 0xf1, 0xf6,
+      0xd1, 0x7c, 0x47, 0x02, 0x16, 0x36, 0x6c, 0xe1, 0x19}},
+    {{0x69, 0x5b, 0x2e, 0xbd, 0x27, 0xdb, 0x41, 0x32, 0x58, 0x08, 0x47, 0x13,
+      0xc1, 0x22, 0xf0, 0xde, 0xf3, 0x46, 0xf0, 0x77, 0xf2, 0xb7, 0x70, 0x78,
+      0xf2, 0xde, 0x12, 0x33, 0xcc, 0x73, 0xa9, 0x54},
+     {0x03, 0x1a, 0x6d, 0xbb, 0x41, 0x71, 0x5c, 0x8b, 0xe7, 0x89, 0xb7, 0x51,
+      0xe6, 0x11, 0xf6, 0xfe, 0xa9, 0x33, 0x83, 0x91, 0xf8, 0xfd, 0xbf, 0x51,
+      0x83, 0x33, 0x8a, 0x16, 0x1e, 0xdc, 0xc5, 0xb3, 0xef}},
+    {{0x3c, 0xda, 0x1e, 0x22, 0x77, 0xf3, 0x67, 0x7f, 0x57, 0x63, 0xc4, 0xe7,
+      0xc8, 0xf9, 0xe2, 0x72, 0xdf, 0x00, 0xe0, 0x8f, 0x9a, 0xd4, 0x9e, 0x33,
+      0x04, 0x7a, 0x06, 0x17, 0x94, 0x55, 0x2e, 0xcc},
+     {0x02, 0xf5, 0x07, 0xb2, 0x17, 0xf2, 0xc5, 0x24, 0xa5, 0x90, 0x3a, 0x4b,
+      0x4c, 0x5b, 0x39, 0xe9, 0xde, 0xc9, 0xeb, 0x2b, 0xee, 0x45, 0x8a, 0x6f,
+      0x11, 0x17, 0x81, 0xf2, 0xb8, 0x2e, 0xf6, 0xfb, 0xa7}},
+    {{0x52, 0xa6, 0xc4, 0xe3, 0x20, 0x9a, 0x0b, 0xa7, 0x89, 0x16, 0xaf, 0x3e,
+      0x84, 0xb0, 0xd4, 0xbf, 0x9b, 0x0d, 0x5c, 0xdb, 0xd9, 0x35, 0x9b, 0xb8,
+      0xef, 0x94, 0xe0, 0x8b, 0xfe, 0x2c, 0x55, 0xaa},
+     {0x02, 0x78, 0xad, 0x6b, 0xf5, 0x39, 0x26, 0x8a, 0xd9, 0x33, 0xfc, 0x56,
+      0x23, 0x56, 0x7a, 0xb0, 0x9f, 0x3d, 0x05, 0x97, 0x0e, 0x18, 0x17, 0x4b,
+      0x6e, 0x31, 0x8f, 0xf8, 0xe1, 0x1f, 0x0a, 0xde, 0xe3}},
+    {{0xae, 0xcc, 0x05, 0xc6, 0x98, 0x6f, 0x3b, 0x96, 0xb6, 0xe8, 0x77, 0x40,
+      0x95, 0xf4, 0x20, 0xf3, 0xad, 0xff, 0x4d, 0x8d, 0x16, 0x7c, 0x34, 0xb7,
+      0x5f, 0xce, 0x2e, 0x04, 0x55, 0xd1, 0x49, 0x5b},
+     {0x02, 0x09, 0xed, 0xd7, 0xcf, 0x7d, 0xc1, 0x2b, 0xd2, 0x05, 0x20, 0x92,
+      0xd3, 0x7b, 0x7b, 0x3d, 0x8c, 0x3d, 0x86, 0x2d, 0x15, 0x06, 0x3c, 0x7c,
+      0x61, 0x49, 0x60, 0x40, 0x8f, 0xae, 0xf1, 0xbb, 0x5f}},
+    {{0xf6, 0x2f, 0x6c, 0xe4, 0x19, 0x86, 0x59, 0xf5, 0x29, 0x50, 0xcc, 0xd4,
+      0xa8, 0x71, 0x47, 0xda, 0x6c, 0x8f, 0xe2, 0x13, 0xd5, 0xa2, 0xe8, 0x31,
+      0x4e, 0xe5, 0x08, 0x85, 0xe7, 0x53, 0x49, 0x5d},
+     {0x02, 0xea, 0x2b, 0x24, 0x7c, 0xe5, 0x4e, 0x02, 0x95, 0x97, 0x5c, 0xe0,
+      0xea, 0xed, 0x1b, 0x6a, 0x65, 0xb5, 0x90, 0xe9, 0xa5, 0xdd, 0xfb, 0x95,
+      0x7f, 0x70, 0x69, 0x3b, 0x08, 0x25, 0x82, 0x51, 0x53}},
+    {{0x5b, 0x55, 0x15, 0xcb, 0xb5, 0x38, 0x1b, 0x17, 0x92, 0x94, 0x3c, 0xc5,
+      0x43, 0xdd, 0x90, 0xad, 0x95, 0x3f, 0xfe, 0xff, 0x66, 0x42, 0x62, 0xd1,
+      0x96, 0x29, 0x6c, 0x79, 0x01, 0x09, 0x4a, 0xfd},
+     {0x02, 0xd9, 0x5a, 0x14, 0x9a, 0x3d, 0xa2, 0x16, 0x08, 0x83, 0xb1, 0x1e,
+      0x1c, 0x88, 0x1c, 0x9b, 0xd7, 0x22, 0xa0, 0x92, 0xff, 0x3e, 0x4c, 0x77,
+      0xea, 0xdd, 0xfc, 0x27, 0x09, 0xbd, 0x16, 0xb5, 0x2e}},
+    {{0xe6, 0x9d, 0xb0, 0x10, 0x32, 0x7d, 0x46, 0x15, 0x38, 0xec, 0x6f, 0x7b,
+      0xe8, 0xe2, 0xad, 0xeb, 0x95, 0x7d, 0xcc, 0x36, 0xd7, 0x41, 0xe1, 0x9b,
+      0xff, 0x7d, 0x37, 0x2b, 0x8a, 0x09, 0x29, 0xba},
+     {0x02, 0x72, 0x99, 0xf1, 0xb6, 0xdf, 0x9f, 0x69, 0x61, 0x04, 0x45, 0xd7,
+      0x0a, 0xf9, 0xee, 0x3d, 0x1e, 0x54, 0x90, 0x8e, 0x1f, 0x92, 0x3c, 0x9b,
+      0xcb, 0x32, 0x96, 0x04, 0x2d, 0x63, 0x4c, 0x58, 0x45}},
+    {{0xc9, 0xc7, 0x21, 0x06, 0x33, 0x22, 0x6a, 0x42, 0xaa, 0xa0, 0xae, 0xe8,
+      0x64, 0xc6, 0x00, 0x9c, 0x01, 0xb2, 0x10, 0xc1, 0x33, 0xf6, 0x2d, 0x21,
+      0x77, 0xda, 0xfb, 0xbe, 0x01, 0xf2, 0x23, 0x7c},
+     {0x02, 0x0a, 0x85, 0x4d, 0x25, 0x08, 0xfc, 0x4f, 0x4a, 0x84, 0x1a, 0x83,
+      0x59, 0x80, 0xca, 0xe5, 0x72, 0x62, 0xc7, 0x03, 0x99, 0x9e, 0xde, 0x29,
+      0xc5, 0x7e, 0xd3, 0x4c, 0x3d, 0x16, 0x08, 0xde, 0xcc}},
+    {{0x4c, 0x14, 0xc3, 0xab, 0x77, 0x59, 0x11, 0x48, 0xa9, 0x42, 0x00, 0xe8,
+      0x55, 0x06, 0xcf, 0xc7, 0x53, 0xb6, 0xfe, 0x45, 0x1e, 0x9f, 0xd4, 0x53,
+      0xeb, 0x53, 0x1e, 0xed, 0xf8, 0xbe, 0xbd, 0x6e},
+     {0x03, 0x86, 0x00, 0xd6, 0x48, 0xc0, 0x39, 0xdb, 0x2e, 0x21, 0xd8, 0x90,
+      0xa9, 0x18, 0xb9, 0x8f, 0xc5, 0xcc, 0x6c, 0x9c, 0x55, 0x13, 0x0c, 0xe9,
+      0x57, 0x7d, 0x16, 0xd9, 0x25, 0x44, 0x28, 0x99, 0x26}},
+    {{0xef, 0xa3, 0x55, 0xc2, 0xed, 0x11, 0xec, 0x14, 0x4d, 0xc4, 0x4d, 0x2d,
+      0x00, 0x72, 0x4f, 0x87, 0x81, 0xec, 0x8b, 0x06, 0x05, 0x7b, 0x25, 0x1a,
+      0x01, 0xa8, 0x34, 0x66, 0x34, 0x41, 0x4b, 0x8c},
+     {0x03, 0x5e, 0xa2, 0x07, 0x85, 0x23, 0x80, 0xd7, 0x18, 0xa1, 0x86, 0x7f,
+      0x1a, 0x1b, 0x2e, 0x7b, 0x1c, 0x12, 0x92, 0x61, 0x2a, 0x9e, 0x6b, 0x2f,
+      0xe3, 0xdf, 0x52, 0xad, 0x29, 0x62, 0xc0, 0xe3, 0x07}},
+    {{0xaf, 0xbf, 0xd3, 0x30, 0xa8, 0x4a, 0x96, 0x71, 0x22, 0x8c, 0xd6, 0x1f,
+      0xd3, 0xe8, 0xf6, 0x1e, 0x1a, 0x69, 0x79, 0x1a, 0x67, 0x05, 0x77, 0x7e,
+      0x0f, 0x40, 0xb5, 0x93, 0xfd, 0xae, 0x78, 0x2d},
+     {0x02, 0x47, 0x3e, 0xd4, 0xa1, 0xc6, 0x07, 0x9d, 0x25, 0x3e, 0xf4, 0x80,
+      0x18, 0x05, 0xdd, 0x63, 0x0a, 0x1c, 0x11, 0x41, 0x98, 0xde, 0xed, 0xbf,
+      0xe7, 0xca, 0x0d, 0xbe, 0x5a, 0xca, 0x8a, 0x36, 0x75}},
+    {{0x65, 0x34, 0x1f, 0x71, 0x1f, 0x73, 0xa3, 0x4e, 0x94, 0x64, 0x47, 0xf0,
+      0x28, 0x83, 0x86, 0xa7, 0x75, 0x38, 0x0a, 0x14, 0x28, 0xf8, 0x1e, 0xb4,
+      0xea, 0xd2, 0xe8, 0x89, 0xdd, 0x91, 0xf7, 0x3d},
+     {0x02, 0x3d, 0x06, 0x35, 0xbb, 0x1f, 0x13, 0x99, 0x3b, 0x9b, 0xaf, 0x29,
+      0x54, 0x33, 0xbf, 0x7d, 0x60, 0x19, 0xb3, 0xaa, 0x15, 0x25, 0x74, 0xe3,
+      0x7b, 0xd6, 0xdf, 0x02, 0x0b, 0x3a, 0x62, 0x6e, 0xd6}},
+    {{0xdf, 0xb0, 0x6c, 0xa6, 0x8d, 0xd3, 0xd3, 0x8c, 0x8e, 0x27, 0x42, 0xbf,
+      0x71, 0x29, 0x7b, 0x2b, 0x3b, 0x28, 0xd9, 0x1f, 0x15, 0xf8, 0xf9, 0x1b,
+      0xdf, 0x70, 0x28, 0xa5, 0x9e, 0x03, 0x9c, 0x3a},
+     {0x02, 0x15, 0x1b, 0x5b, 0x33, 0x37, 0x5f, 0xc2, 0x07, 0x26, 0xbe, 0xf5,
+      0xf4, 0x0d, 0x2f, 0x4b, 0xb6, 0xeb, 0x30, 0x9f, 0x47, 0x88, 0x9f, 0xec,
+      0x4e, 0xbc, 0xb8, 0x82, 0xd4, 0x7f, 0x31, 0x4d, 0xb1}},
+    {{0x24, 0x67, 0xf1, 0xa2, 0x0e, 0x45, 0x4d, 0x41, 0x05, 0xfc, 0x69, 0xd7,
+      0xb7, 0x56, 0x0e, 0x63, 0xfc, 0x57, 0x87, 0x94, 0x62, 0xf6, 0xa1, 0xfe,
+      0x22, 0xe0, 0x49, 0xb6, 0x48, 0xde, 0xf6, 0x58},
+     {0x02, 0x11, 0xb2, 0xea, 0xee, 0x25, 0x3b, 0xa9, 0x40, 0x9d, 0x02, 0xd8,
+      0x17, 0xf8, 0x78, 0x34, 0x9b, 0x4f, 0x10, 0x4e, 0xb4, 0x43, 0xcc, 0xb5,
+      0x92, 0xbb, 0x15, 0x30, 0x18, 0x74, 0x25, 0xb6, 0x28}},
+    {{0xa2, 0x51, 0xa7, 0x04, 0x5e, 0x6f, 0x33, 0xf2, 0xb4, 0x9e, 0xc4, 0xbe,
+      0x57, 0xa3, 0xf2, 0xc6, 0x40, 0x59, 0xa8, 0x0a, 0x55, 0x5a, 0x31, 0xfe,
+      0x3e, 0x66, 0xfc, 0x08, 0x41, 0x87, 0x4b, 0x71},
+     {0x02, 0xf5, 0x78, 0xf2, 0xd9, 0xf2, 0xca, 0x95, 0xe1, 0x9c, 0x87, 0x40,
+      0x81, 0x2a, 0x62, 0x42, 0x22, 0xa0, 0x7e, 0xae, 0x22, 0x17, 0x50, 0xbf,
+      0x7f, 0xe9, 0xe8, 0x6b, 0x5c, 0xc1, 0x71, 0xac, 0x27}},
+    {{0x7a, 0x6b, 0x1d, 0x48, 0xac, 0x72, 0xdc, 0xc0, 0xd8, 0x96, 0x76, 0x18,
+      0xe6, 0xf2, 0xe1, 0x6d, 0xc8, 0xd9, 0xe6, 0x35, 0xe5, 0x6a, 0xab, 0x90,
+      0x42, 0x7f, 0xf1, 0x13, 0xb5, 0xc8, 0x35, 0xba},
+     {0x03, 0x2c, 0x31, 0xee, 0x81, 0xe1, 0x11, 0x23, 0xe3, 0x16, 0x99, 0xc1,
+      0xdb, 0xfb, 0x68, 0xff, 0xd0, 0x3f, 0x3b, 0x3c, 0x05, 0x2f, 0x14, 0xc4,
+      0x5e, 0x2e, 0x2d, 0xe5, 0xa6, 0xdf, 0x42, 0x95, 0x83}},
+    {{0xec, 0x59, 0xe2, 0xd3, 0xfa, 0x82, 0x67, 0xcb, 0x04, 0xbf, 0xb4, 0xf6,
+      0x29, 0xd8, 0xd4, 0x12, 0xe9, 0x5e, 0x31, 0x26, 0xb7, 0x6b, 0xeb, 0xbe,
+      0x4a, 0xd8, 0x9f, 0xc3, 0x70, 0x00, 0xbf, 0x67},
+     {0x02, 0x96, 0xf4, 0x09, 0x4a, 0xc2, 0x4a, 0x6a, 0xe7, 0x36, 0x87, 0x02,
+      0x48, 0x91, 0xbf, 0x77, 0x17, 0x45, 0xf0, 0xe1, 0x88, 0x92, 0xca, 0xbb,
+      0x55, 0xb2, 0x98, 0xbc, 0xc7, 0x09, 0xa6, 0x5a, 0x2c}},
+    {{0x4f, 0xd3, 0xe9, 0x2c, 0xf8, 0x43, 0xf6, 0xab, 0x0c, 0x4e, 0xb5, 0xc6,
+      0x26, 0xc8, 0x6a, 0xa2, 0x58, 0xfc, 0x20, 0x75, 0x1c, 0x38, 0x0d, 0x4a,
+      0x25, 0x6f, 0xf7, 0xc6, 0x3d, 0x95, 0x15, 0x3f},
+     {0x03, 0x86, 0xbb, 0xe8, 0x99, 0x64, 0x89, 0x36, 0x20, 0xe0, 0x40, 0xfe,
+      0xd1, 0xe7, 0x65, 0x34, 0x91, 0xa9, 0x4c, 0x6b, 0xf6, 0x5e, 0x7c, 0x0f,
+      0xc4, 0x5c, 0x59, 0xca, 0x22, 0xdd, 0xee, 0xdd, 0xfc}},
+    {{0xad, 0x41, 0xfe, 0xb5, 0x73, 0x76, 0x4c, 0x98, 0x9b, 0x8c, 0x52, 0x9d,
+      0xf7, 0xe1, 0x0b, 0x34, 0x48, 0xe0, 0xc5, 0x55, 0x55, 0x06, 0x67, 0xe0,
+      0x31, 0x3c, 0xdb, 0x6e, 0x4c, 0x63, 0x1d, 0xac},
+     {0x02, 0xe7, 0xa5, 0x13, 0x1d, 0x70, 0x7d, 0x9c, 0x1b, 0x32, 0x67, 0x26,
+      0x89, 0x07, 0x21, 0xff, 0xc9, 0xf2, 0xac, 0x3e, 0xed, 0x61, 0x69, 0x5d,
+      0xf3, 0xa5, 0xca, 0x92, 0x64, 0x75, 0xc7, 0x9a, 0xcc}},
+    {{0xcd, 0x9c, 0x34, 0xc8, 0x27, 0xc3, 0xcf, 0x2b, 0xe3, 0xe6, 0xab, 0xd0,
+      0x95, 0x2e, 0x0b, 0x92, 0xcf, 0x58, 0x8f, 0x9d, 0x5e, 0x66, 0xed, 0xdb,
+      0x21, 0x58, 0xa9, 0x07, 0x3e, 0x1b, 0x88, 0xeb},
+     {0x02, 0x3d, 0xc3, 0xc5, 0x5a, 0x02, 0x7b, 0xdf, 0x6a, 0x1f, 0x17, 0xe7,
+      0x84, 0x4d, 0x3f, 0x50, 0x94, 0xa6, 0x34, 0xb3, 0x42, 0x87, 0x80, 0x8a,
+      0x06, 0xd1, 0x01, 0x5e, 0xc1, 0x6c, 0x12, 0x67, 0x1c}},
+    {{0x9c, 0x06, 0xd0, 0xf3, 0xbe, 0x46, 0xdc, 0xf4, 0x63, 0xf5, 0x1c, 0x5a,
+      0x7e, 0x4d, 0x2c, 0x8e, 0x24, 0xc5, 0xea, 0x6e, 0x4e, 0x00, 0x7a, 0x85,
+      0x73, 0x39, 0x97, 0x28, 0xdd, 0x57, 0xae, 0xf0},
+     {0x03, 0xb3, 0x17, 0x16, 0xea, 0x92, 0x77, 0xfb, 0x01, 0xc1, 0x5b, 0x44,
+      0x22, 0xa4, 0x87, 0x57, 0x7b, 0x02, 0x63, 0xde, 0x81, 0x32, 0xfd, 0x87,
+      0x82, 0x85, 0x28, 0x5a, 0x7e, 0x95, 0xe7, 0x87, 0x74}},
+    {{0x28, 0x7e, 0x48, 0x85, 0x11, 0x26, 0x3a, 0xcc, 0x3d, 0xb5, 0x99, 0x00,
+      0xd3, 0x13, 0x92, 0xb7, 0x2e, 0x3c, 0x1b, 0xda, 0x49, 0xae, 0x01, 0xc0,
+      0xed, 0x03, 0x21, 0x04, 0x85, 0xd3, 0xfa, 0x5c},
+     {0x03, 0x44, 0x41, 0xe9, 0x68, 0xb1, 0xfa, 0x5b, 0x0b, 0x49, 0x44, 0x1f,
+      0x58, 0x22, 0x8e, 0x84, 0x6f, 0xb8, 0x94, 0x6e, 0x75, 0x87, 0x2a, 0x21,
+      0xb5, 0x67, 0x7f, 0xd5, 0xeb, 0x26, 0x5a, 0x52, 0xe3}},
+    {{0x16, 0xd2, 0x10, 0x27, 0xb3, 0x8f, 0x3d, 0x6a, 0xfd, 0xa0, 0xf8, 0x65,
+      0x53, 0x41, 0xd3, 0x20, 0x28, 0xb3, 0x16, 0x95, 0xb9, 0x53, 0x3c, 0x63,
+      0x8d, 0x95, 0xc5, 0x4e, 0xbf, 0x6c, 0x5c, 0xc0},
+     {0x03, 0xba, 0x2f, 0x03, 0xd2, 0x42, 0xa4, 0xbf, 0x6b, 0x52, 0xb3, 0x6c,
+      0x16, 0xc3, 0x9f, 0x71, 0xa1, 0x90, 0xe3, 0x86, 0xee, 0xd7, 0x8a, 0xa1,
+      0x57, 0x35, 0xfe, 0x9c, 0x25, 0xfd, 0x39, 0x92, 0x70}},
+    {{0x52, 0xd2, 0x14, 0x49, 0x8a, 0x97, 0xed, 0x01, 0x46, 0x07, 0x22, 0x76,
+      0xb5, 0xac, 0x41, 0x8a, 0x52, 0x41, 0x9d, 0x88, 0xba, 0xe9, 0xf8, 0x8d,
+      0xf0, 0xd9, 0xce, 0x16, 0x8d, 0xfb, 0x79, 0xbd},
+     {0x03, 0xc7, 0x07, 0xea, 0x9f, 0x1f, 0x24, 0xc6, 0x06, 0xfe, 0x77, 0x7d,
+      0xbb, 0x9b, 0x09, 0xb7, 0x0d, 0x88, 0xa4, 0xc7, 0x31, 0x36, 0x19, 0xe9,
+      0x42, 0x3a, 0x25, 0x8e, 0xd8, 0xe8, 0x94, 0x72, 0xb4}},
+    {{0x94, 0xe2, 0x8b, 0xad, 0x54, 0xc5, 0xb1, 0x63, 0xd9, 0x67, 0xc4, 0x95,
+      0x8c, 0xe1, 0x29, 0x3c, 0x74, 0x05, 0x42, 0x84, 0xda, 0x97, 0x35, 0xdb,
+      0x95, 0x7e, 0xad, 0x64, 0x4c, 0xf7, 0x53, 0xb0},
+     {0x02, 0x09, 0xf6, 0x0a, 0xcb, 0x94, 0xb0, 0xf4, 0xcb, 0x1e, 0x20, 0xd1,
+      0xfb, 0x82, 0x77, 0x6a, 0x9c, 0x14, 0x35, 0x7a, 0xd7, 0xaa, 0xe1, 0x8f,
+      0x27, 0x4b, 0xc7, 0x75, 0x72, 0xb6, 0x88, 0x22, 0xe9}},
+    {{0x08, 0xc4, 0xf4, 0xd8, 0x85, 0x57, 0x85, 0x9c, 0x44, 0x95, 0x5b, 0xb6,
+      0xba, 0xed, 0x94, 0x8e, 0x05, 0xef, 0x36, 0xf9, 0x98, 0x1f, 0xa4, 0xd4,
+      0x35, 0x8d, 0x10, 0xa4, 0x1a, 0xcc, 0x47, 0xc1},
+     {0x02, 0x50, 0x93, 0x2e, 0xf7, 0x6d, 0x39, 0xdb, 0xae, 0x1a, 0x41, 0xd4,
+      0x2f, 0xdf, 0xe6, 0x4a, 0x9e, 0xbf, 0x31, 0x32, 0x8b, 0xad, 0xc9, 0x9b,
+      0xf5, 0xf4, 0x53, 0x97, 0x13, 0xce, 0x1d, 0xcc, 0x67}},
+    {{0x4e, 0xb3, 0x12, 0xf4, 0xff, 0x72, 0xbc, 0x12, 0xe1, 0x38, 0x43, 0x42,
+      0x83, 0x9e, 0xee, 0x5b, 0xc3, 0x91, 0x2c, 0x8c, 0xc4, 0xcf, 0x5c, 0xe9,
+      0x20, 0x7d, 0x79, 0x69, 0xf0, 0xa6, 0x76, 0x0b},
+     {0x03, 0xc0, 0x6f, 0x0f, 0x61, 0x17, 0xd5, 0x12, 0x49, 0x17, 0xdf, 0xb7,
+      0x93, 0xca, 0x08, 0xf0, 0xac, 0xf1, 0x87, 0xd6, 0x61, 0xda, 0x64, 0xa8,
+      0xcd, 0xb0, 0xeb, 0x93, 0x4a, 0x80, 0x17, 0x25, 0x30}},
+    {{0xcf, 0x3e, 0x04, 0xc9, 0x80, 0x1d, 0x3d, 0x37, 0x84, 0x8b, 0x33, 0xd4,
+      0xde, 0x84, 0x92, 0x47, 0x8c, 0xb2, 0x7b, 0xca, 0x6d, 0x1f, 0xcf, 0x16,
+      0x96, 0x2c, 0xdb, 0xaa, 0x5a, 0x16, 0x69, 0xc9},
+     {0x02, 0xc0, 0xb0, 0x08, 0xbd, 0x91, 0x4b, 0xed, 0x4f, 0x2a, 0x57, 0x74,
+      0x6c, 0xc8, 0xe0, 0x49, 0x67, 0x3f, 0x6c, 0xb0, 0xde, 0x72, 0x29, 0x58,
+      0xf3, 0x9d, 0x71, 0x51, 0x50, 0x5e, 0xad, 0x0d, 0x0f}},
+    {{0xf8, 0x0f, 0x12, 0x60, 0x22, 0x1c, 0x2b, 0xd8, 0xde, 0x4c, 0xc7, 0xa5,
+      0x87, 0x6c, 0xba, 0xda, 0x2a, 0xf6, 0xeb, 0x34, 0xcb, 0x81, 0xf8, 0xd9,
+      0xf0, 0xf7, 0xfc, 0x43, 0xf6, 0xe5, 0xae, 0x8c},
+     {0x03, 0xca, 0x06, 0x9e, 0x72, 0xbd, 0xa7, 0x46, 0x13, 0x64, 0x33, 0xca,
+      0x50, 0xe6, 0x2d, 0xce, 0xdb, 0x85, 0xac, 0x29, 0x1d, 0x08, 0xf7, 0xc6,
+      0xb0, 0x7b, 0x77, 0x75, 0x02, 0xe5, 0x50, 0x11, 0xd8}},
+    {{0x44, 0xde, 0x2a, 0x7c, 0x64, 0xa8, 0x43, 0xf0, 0x0c, 0x30, 0xa6, 0x8e,
+      0xa9, 0x06, 0x93, 0x17, 0x1e, 0xe4, 0x70, 0x27, 0xb3, 0xbd, 0x14, 0x5e,
+      0xde, 0x1b, 0x98, 0xde, 0x32, 0x61, 0xdc, 0xa8},
+     {0x02, 0xad, 0x6c, 0x76, 0x0a, 0xe0, 0x05, 0xb7, 0x5a, 0x76, 0x27, 0x67,
+      0x73, 0x8b, 0x30, 0xfc, 0x49, 0x59, 0x00, 0x23, 0x51, 0x73, 0xac, 0x52,
+      0x26, 0xe6, 0x1d, 0xf5, 0x93, 0xb8, 0xf3, 0x20, 0x63}},
+    {{0x18, 0x81, 0x82, 0x8d, 0xa0, 0x48, 0xe4, 0xf4, 0xaf, 0x4e, 0xdb, 0xbc,
+      0xe6, 0x80, 0xf1, 0x45, 0xc9, 0xd3, 0x37, 0xf6, 0x09, 0x5c, 0xb4, 0xcd,
+      0x3a, 0x85, 0x25, 0xff, 0xd0, 0x32, 0xb6, 0xf5},
+     {0x03, 0xf7, 0x2b, 0x04, 0x91, 0xa6, 0xaa, 0x06, 0x1a, 0x98, 0xe7, 0xb8,
+      0x27, 0xe6, 0x3d, 0x92, 0x8a, 0xeb, 0x33, 0x87, 0x6a, 0xcb, 0x63, 0x5b,
+      0xc2, 0xbc, 0x64, 0x59, 0x08, 0x10, 0x7d, 0x68, 0x96}},
+    {{0x45, 0x12, 0x85, 0xcb, 0xb8, 0x7e, 0xac, 0xf3, 0x59, 0x4e, 0x41, 0x9c,
+      0x4a, 0x73, 0x7b, 0xa4, 0x48, 0x56, 0x3e, 0xec, 0x38, 0xa2, 0xd2, 0xa2,
+      0x18, 0xd1, 0x25, 0xd8, 0x58, 0x50, 0x8c, 0xba},
+     {0x02, 0x78, 0xc7, 0x03, 0x36, 0x03, 0x4a, 0x6e, 0xb9, 0xca, 0xab, 0xd0,
+      0x04, 0xd6, 0x1d, 0x42, 0x55, 0x57, 0x33, 0x01, 0xc7, 0x33, 0x83, 0x34,
+      0x35, 0x97, 0xb7, 0x2e, 0x4c, 0x17, 0x77, 0x19, 0x56}},
+    {{0xf6, 0x0e, 0x9e, 0x3a, 0x08, 0xaf, 0xfb, 0xb8, 0xc5, 0x88, 0x2b, 0xd3,
+      0xfa, 0x4f, 0x3b, 0x84, 0x31, 0x62, 0xdc, 0x0c, 0xbf, 0xfd, 0x6d, 0xca,
+      0x7a, 0x8f, 0x7a, 0x16, 0xfd, 0x75, 0x83, 0x0e},
+     {0x03, 0x7f, 0xc6, 0xa6, 0x0b, 0xce, 0xb5, 0x2c, 0x40, 0x5d, 0xde, 0x35,
+      0xe9, 0x25, 0x65, 0x06, 0x33, 0x7d, 0x7f, 0x33, 0x4b, 0x3e, 0x24, 0xf5,
+      0xbe, 0x31, 0x97, 0xc0, 0x65, 0x23, 0xe1, 0x4e, 0x36}},
+    {{0xfc, 0xa8, 0xda, 0x10, 0xc4, 0x95, 0xf0, 0x58, 0x1e, 0xb3, 0xd0, 0xd4,
+      0xfb, 0x80, 0x7f, 0xc0, 0x5b, 0xc8, 0x5b, 0x85, 0xa8, 0x71, 0xe5, 0x58,
+      0xdd, 0xa2, 0x9e, 0x34, 0x57, 0xcf, 0x83, 0x26},
+     {0x03, 0x3c, 0xdb, 0x7d, 0x03, 0x31, 0x30, 0xa6, 0x50, 0xa5, 0xe9, 0xe1,
+      0xeb, 0x05, 0x29, 0x1a, 0xb1, 0xfe, 0xae, 0xf1, 0x37, 0x4d, 0x67, 0x4b,
+      0xba, 0xa4, 0x4d, 0x85, 0xa8, 0xd0, 0xdd, 0x9a, 0xa2}},
+    {{0xd5, 0x79, 0x18, 0x40, 0x98, 0x9a, 0xcd, 0xde, 0x16, 0x0d, 0x29, 0xf7,
+      0x0f, 0x64, 0x80, 0xfd, 0xf2, 0x2b, 0xa2, 0xb9, 0x01, 0x07, 0x17, 0xe9,
+      0xac, 0x61, 0x25, 0xf6, 0x58, 0x9d, 0x83, 0xe4},
+     {0x02, 0x44, 0x28, 0xc0, 0xfa, 0xff, 0x4f, 0xf8, 0xab, 0xae, 0x9a, 0xac,
+      0xa5, 0x28, 0x37, 0xce, 0x8e, 0x11, 0xba, 0x9e, 0x1d, 0x13, 0x85, 0xfb,
+      0xc5, 0xff, 0xe2, 0x14, 0x7c, 0x9e, 0x51, 0x7b, 0x14}},
+    {{0x35, 0xcd, 0x7a, 0xfb, 0x01, 0xe4, 0x6e, 0x81, 0xe7, 0x1e, 0x36, 0x08,
+      0xf2, 0x13, 0xee, 0x47, 0x28, 0xfb, 0xc7, 0xd6, 0x0c, 0xc3, 0xbc, 0x94,
+      0xe1, 0xd4, 0xa4, 0xc6, 0x40, 0x88, 0x00, 0x10},
+     {0x02, 0x04, 0x62, 0xe5, 0xb7, 0x03, 0x0c, 0x6a, 0xd3, 0xad, 0x73, 0x40,
+      0xb1, 0xcf, 0x80, 0x66, 0x73, 0x3a, 0x0e, 0x35, 0x57, 0x1c, 0x8e, 0x4f,
+      0x45, 0x9d, 0x9c, 0x0e, 0x6c, 0x69, 0x0b, 0xb5, 0xb2}},
+    {{0xb1, 0xf7, 0x23, 0xb4, 0x7b, 0x1b, 0x5d, 0xa9, 0x69, 0xff, 0xf1, 0x62,
+      0xea, 0xd8, 0x12, 0x4f, 0x8f, 0xd1, 0x31, 0xb3, 0x3c, 0x2f, 0xc9, 0x1d,
+      0xbf, 0x74, 0xb4, 0xa1, 0x1a, 0xe5, 0xfe, 0x6b},
+     {0x02, 0x56, 0xd6, 0x5b, 0x72, 0x7c, 0xd9, 0x0e, 0xf8, 0x19, 0xee, 0x6a,
+      0xf9, 0x4d, 0xa1, 0x44, 0x5a, 0x8e, 0x9f, 0xde, 0x00, 0x17, 0x6b, 0x55,
+      0xca, 0xaa, 0xa8, 0xdc, 0x1a, 0x06, 0xea, 0x8b, 0x6c}},
+    {{0x07, 0xf8, 0x0e, 0x8e, 0xe5, 0x83, 0xa9, 0x80, 0x81, 0x46, 0x4b, 0xe2,
+      0x66, 0x9c, 0x00, 0xb4, 0x66, 0x70, 0x7a, 0xcd, 0x5b, 0xbd, 0x05, 0x2e,
+      0x05, 0xc8, 0xaf, 0x78, 0xa5, 0x36, 0x02, 0xd2},
+     {0x03, 0x44, 0x43, 0x3b, 0xbc, 0x18, 0x82, 0x31, 0xcd, 0x95, 0x44, 0x48,
+      0xee, 0x21, 0x07, 0x22, 0x88, 0x59, 0x95, 0x16, 0xf8, 0xce, 0xfc, 0x32,
+      0x23, 0xe1, 0xce, 0x6d, 0x9b, 0x7d, 0x00, 0xb3, 0x2d}},
+    {{0x1b, 0x06, 0x7c, 0xf5, 0xb2, 0xbc, 0xd9, 0x1f, 0x70, 0x6d, 0x67, 0xe6,
+      0x5b, 0x50, 0x17, 0xb3, 0x6b, 0x4c, 0x1b, 0xbe, 0x49, 0xf3, 0x31, 0xf5,
+      0x31, 0x2a, 0x64, 0x05, 0xdc, 0xf5, 0x14, 0x6a},
+     {0x03, 0x4d, 0xfe, 0x15, 0x5a, 0xb4, 0x2c, 0x57, 0x71, 0x23, 0xc5, 0x13,
+      0x9b, 0x5a, 0x77, 0x0f, 0x87, 0xf4, 0x08, 0x44, 0x83, 0x74, 0xe1, 0xd6,
+      0xff, 0x1a, 0xe9, 0xd8, 0x41, 0xde, 0xf6, 0x94, 0xee}},
+    {{0x39, 0x91, 0xf4, 0xfa, 0x6f, 0xb0, 0xc8, 0x16, 0x3e, 0xc4, 0x0b, 0x28,
+      0xdc, 0x17, 0x2a, 0x43, 0x61, 0x9f, 0xe7, 0x5d, 0x60, 0x1c, 0xac, 0x6e,
+      0x46, 0xaa, 0x44, 0xe3, 0x4d, 0xca, 0x06, 0x5f},
+     {0x02, 0x8e, 0x3c, 0x59, 0x1e, 0x02, 0x00, 0x42, 0x2d, 0xd4, 0xa2, 0x70,
+      0xfb, 0x19, 0xe2, 0x19, 0xe8, 0xfa, 0x05, 0x76, 0x33, 0xac, 0x61, 0xb0,
+      0x89, 0xfd, 0x18, 0x63, 0x18, 0x46, 0x06, 0x0f, 0x8b}},
+    {{0xca, 0x34, 0x89, 0x04, 0xc9, 0x52, 0x89, 0xbe, 0x56, 0x22, 0x1e, 0x29,
+      0xe4, 0x86, 0xf0, 0x78, 0xc1, 0x6f, 0x9c, 0x74, 0xfe, 0xcd, 0x45, 0xd9,
+      0x19, 0x08, 0xa7, 0xc0, 0x62, 0x6f, 0x5f, 0x64},
+     {0x03, 0x9e, 0xbe, 0x80, 0xf9, 0x94, 0xc8, 0xba, 0x95, 0x55, 0x59, 0x74,
+      0x1a, 0xfc, 0x0b, 0x44, 0xce, 0x51, 0x39, 0x05, 0xcb, 0x57, 0x44, 0x2d,
+      0xd7, 0x17, 0x42, 0xac, 0x64, 0xa1, 0x3a, 0x3b, 0x23}},
+    {{0xcb, 0x86, 0xe2, 0x35, 0x95, 0x46, 0xb9, 0xa9, 0x4e, 0x95, 0x92, 0x3e,
+      0xfb, 0x1f, 0x41, 0x30, 0xe3, 0x27, 0xa4, 0x7f, 0xe9, 0x3d, 0xa3, 0xd9,
+      0x35, 0x21, 0x46, 0x07, 0x40, 0xf8, 0x3f, 0xc1},
+     {0x03, 0x58, 0xf2, 0x32, 0xa4, 0x20, 0x78, 0xc9, 0x2c, 0xb8, 0x9b, 0x65,
+      0x6f, 0xc6, 0x59, 0x72, 0xff, 0x73, 0xf8, 0xca, 0xfd, 0xc1, 0x94, 0xaf,
+      0x30, 0xde, 0xbc, 0xf8, 0xf1, 0x3c, 0xdf, 0xd6, 0xa7}},
+    {{0xc8, 0xb7, 0x58, 0x65, 0xaa, 0xa8, 0x86, 0x82, 0x42, 0xe2, 0xe7, 0xd3,
+      0x5d, 0xa8, 0xb0, 0x17, 0xcd, 0x29, 0x41, 0xd3, 0x05, 0xa0, 0x26, 0xd7,
+      0xc1, 0xac, 0x5b, 0x38, 0xa4, 0x0c, 0x35, 0xaf},
+     {0x03, 0x06, 0xf9, 0x9f, 0x5c, 0xea, 0xce, 0xdf, 0x8c, 0x52, 0x0e, 0xe1,
+      0x43, 0xe7, 0x37, 0xc5, 0x0b, 0x94, 0x31, 0xe3, 0x56, 0x7b, 0x56, 0x4c,
+      0xb1, 0x4d, 0x62, 0x5c, 0xd9, 0x08, 0xc8, 0xea, 0x0c}},
+    {{0x6d, 0x14, 0x5c, 0xda, 0xae, 0x81, 0x50, 0x70, 0xbb, 0x32, 0x2c, 0x85,
+      0x5b, 0xaa, 0xae, 0xc6, 0x89, 0x07, 0xaf, 0x3f, 0xbf, 0x94, 0xda, 0x7c,
+      0x6e, 0xc9, 0xe4, 0xdc, 0xbf, 0xb8, 0xbf, 0x0f},
+     {0x03, 0x8b, 0x92, 0xf8, 0xa0, 0x52, 0x04, 0xd4, 0xce, 0x38, 0x65, 0xfc,
+      0x93, 0x1a, 0xa4, 0x91, 0x4e, 0xd9, 0xdb, 0x53, 0xcf, 0xfb, 0xdf, 0xc5,
+      0x1a, 0xdd, 0xa3, 0x40, 0x0b, 0x14, 0x84, 0xa1, 0x7f}},
+    {{0x1a, 0x2d, 0x32, 0x14, 0x6d, 0xe3, 0x77, 0x41, 0x57, 0xdc, 0x42, 0x7c,
+      0x76, 0x66, 0xe5, 0x3a, 0x16, 0x0d, 0xbe, 0x23, 0x2e, 0x2e, 0xaa, 0xe4,
+      0x58, 0xf6, 0x3d, 0x55, 0xb7, 0xc1, 0xe4, 0x27},
+     {0x02, 0x81, 0x67, 0x54, 0x35, 0xa8, 0x68, 0x37, 0xce, 0xf1, 0xc9, 0x7c,
+      0x19, 0x37, 0xfa, 0x13, 0x61, 0xf6, 0xbb, 0xa9, 0x67, 0xd6, 0x6d, 0xb6,
+      0x84, 0x53, 0xf5, 0xa2, 0xdb, 0x3f, 0xe7, 0x01, 0xdf}},
+    {{0xf0, 0xb4, 0xb6, 0x6a, 0xb8, 0x23, 0x9c, 0xe3, 0x68, 0xb3, 0x7b, 0x16,
+      0x11, 0x2d, 0x72, 0xc3, 0xdd, 0x87, 0x33, 0x45, 0xe3, 0xb3, 0xf8, 0x02,
+      0xcd, 0xd8, 0x23, 0xbb, 0xd7, 0x9f, 0xda, 0x9f},
+     {0x03, 0x2a, 0x3a, 0x47, 0x71, 0xc3, 0x59, 0x60, 0x0b, 0x52, 0x49, 0xb9,
+      0xe8, 0xe0, 0x0c, 0xd1, 0x12, 0x19, 0xf0, 0xef, 0x2d, 0x41, 0x49, 0x23,
+      0xa1, 0xf0, 0x30, 0xd3, 0x81, 0x8a, 0xe9, 0xbe, 0x56}},
+    {{0x31, 0x98, 0x67, 0x1b, 0x3e, 0x25, 0x42, 0xaf, 0xaa, 0xc8, 0xf1, 0xdf,
+      0x9f, 0x05, 0xa3, 0x3b, 0xef, 0x96, 0x41, 0x65, 0x7b, 0xbf, 0x34, 0xa0,
+      0x63, 0x2c, 0x03, 0xc6, 0x4e, 0x66, 0xb6, 0x2c},
+     {0x02, 0x93, 0x6d, 0xcd, 0x76, 0xd7, 0xee, 0x5b, 0xf3, 0x62, 0xb9, 0x52,
+      0x40, 0x1a, 0xfa, 0xf5, 0x86, 0x76, 0xb6, 0x26, 0x17, 0xef, 0x7f, 0x50,
+      0xa2, 0x1f, 0x4b, 0xd6, 0x60, 0x8d, 0x97, 0xdd, 0x0a}},
+    {{0xd0, 0x0b, 0xe4, 0x5b, 0x2a, 0xbf, 0xb2, 0xc8, 0x60, 0x32, 0x47, 0x67,
+      0x2e, 0x6c, 0xb5, 0x93, 0xe9, 0x2e, 0x67, 0xb8, 0x31, 0xf4, 0x87, 0x30,
+      0xfc, 0xc3, 0xb1, 0x7d, 0x3a, 0x43, 0x50, 0x3a},
+     {0x02, 0xe9, 0x97, 0x18, 0xc0, 0x14, 0x04, 0x7d, 0x75, 0x04, 0x50, 0xcd,
+      0xbf, 0xd5, 0xa8, 0x24, 0xe3, 0x40, 0xc0, 0xd9, 0xa6, 0x31, 0x1b, 0x2f,
+      0x64, 0x36, 0x75, 0x88, 0x44, 0x71, 0x67, 0x3b, 0x4b}},
+    {{0xbb, 0x40, 0xb6, 0x4c, 0xa5, 0x27, 0xfe, 0xa4, 0xce, 0x86, 0x37, 0xf1,
+      0x71, 0xc4, 0xef, 0x89, 0x17, 0x65, 0x61, 0xe3, 0x83, 0x63, 0x31, 0xbe,
+      0xf6, 0xd1, 0xb0, 0x81, 0x97, 0x2b, 0x99, 0xec},
+     {0x02, 0xb7, 0xbd, 0x34, 0x9c, 0x1d, 0x92, 0x4b, 0xc3, 0x9d, 0x69, 0x1f,
+      0x3a, 0x6d, 0x37, 0xcd, 0xa7, 0xc8, 0xc4, 0xa5, 0xd8, 0x79, 0x01, 0xbb,
+      0x6e, 0x67, 0x47, 0x32, 0x64, 0x01, 0x3a, 0x02, 0x6e}},
+    {{0xcf, 0x6a, 0xb0, 0xcb, 0x41, 0xe2, 0xd9, 0x6a, 0xcf, 0x78, 0xd2, 0x9d,
+      0xfc, 0xb5, 0xcd, 0x8d, 0xfd, 0x47, 0xd7, 0x68, 0x56, 0xdd, 0xdf, 0x4d,
+      0xc0, 0x0d, 0x52, 0x7a, 0xb9, 0xf0, 0x16, 0xd0},
+     {0x02, 0xd0, 0x6c, 0x4a, 0x36, 0x0c, 0x25, 0x7b, 0x1f, 0xf1, 0x5d, 0x50,
+      0x39, 0x4b, 0x67, 0xe2, 0x24, 0xd3, 0x4c, 0x2b, 0x08, 0xcb, 0x06, 0xcb,
+      0xf8, 0x8c, 0xa8, 0xe0, 0x50, 0xfb, 0xec, 0x70, 0x0c}},
+    {{0x76, 0x33, 0x02, 0x71, 0x49, 0xff, 0x78, 0x02, 0x40, 0xc6, 0x25, 0xfa,
+      0xfb, 0x5f, 0x15, 0x2b, 0x29, 0x04, 0xf0, 0x6a, 0x14, 0xa5, 0x8c, 0x7e,
+      0x0e, 0x7f, 0x8c, 0x26, 0x82, 0x33, 0xb0, 0x8f},
+     {0x03, 0xd0, 0xfb, 0x0b, 0xa4, 0x84, 0x71, 0x29, 0xd4, 0x43, 0x7e, 0xe8,
+      0xa9, 0x25, 0xce, 0xda, 0x21, 0xa5, 0x5c, 0x57, 0xb4, 0xf4, 0x12, 0x4f,
+      0x94, 0xc1, 0x4c, 0xc9, 0xc6, 0xa6, 0x63, 0x59, 0xea}},
+    {{0xc9, 0xec, 0x94, 0x76, 0x95, 0x06, 0xd4, 0xf2, 0x12, 0x2e, 0xcf, 0xf6,
+      0xfb, 0x2b, 0xef, 0xa2, 0xc2, 0xc2, 0xaf, 0x92, 0x7c, 0x3f, 0x70, 0x58,
+      0x54, 0xad, 0xe7, 0x44, 0x8b, 0xa1, 0x0a, 0xed},
+     {0x03, 0xd7, 0x56, 0xf0, 0x5b, 0x25, 0x02, 0xdc, 0xe6, 0x2c, 0xbd, 0xeb,
+      0x4f, 0x07, 0x57, 0xd2, 0xd9, 0xae, 0xe6, 0x24, 0x7f, 0xbd, 0xae, 0xcb,
+      0x65, 0x6c, 0x39, 0xf4, 0x16, 0x9b, 0x1e, 0xa2, 0x27}},
+    {{0x5f, 0xb2, 0xbe, 0x84, 0xe4, 0x49, 0xc1, 0x77, 0x8c, 0x34, 0x20, 0xa5,
+      0xb1, 0x39, 0xb8, 0x8e, 0xc4, 0x5e, 0xae, 0xdd, 0x30, 0xc4, 0xf4, 0x13,
+      0x8b, 0x17, 0x50, 0x1e, 0x42, 0x8c, 0xcb, 0x96},
+     {0x02, 0x16, 0x49, 0x32, 0xc7, 0x69, 0x50, 0x9b, 0x32, 0x94, 0xa5, 0xe5,
+      0x00, 0x3b, 0x9e, 0xed, 0x6e, 0xcc, 0xd0, 0x14, 0xd7, 0xb9, 0x6f, 0xec,
+      0x30, 0x5a, 0xa0, 0xa8, 0x8c, 0x49, 0x8e, 0x69, 0xb7}},
+};
+
+// secp256k1 group order, big-endian.
+const uint8_t kCurveOrder[kPrivkeySize] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xfe, 0xba, 0xae, 0xdc, 0xe6, 0xaf, 0x48, 0xa0, 0x3b,
+    0xbf, 0xd2, 0x5e, 0x8c, 0xd0, 0x36, 0x41, 0x41};
+
+uint64_t Mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Counter-based generator: word i of a case is Mix64 of (key, i), so no
+// state carries over from one case to the next.
+struct CounterRng {
+    uint64_t key;
+    uint64_t counter;
+
+    uint64_t Next() {
+        return Mix64(key + ++counter * 0x9e3779b97f4a7c15ULL);
+    }
+
+    // Uniform in [0, bound) for bound < 2^32.
+    uint32_t Below(uint32_t bound) {
+        return static_cast<uint32_t>(((Next() >> 32) * bound) >> 32);
+    }
+};
+
+uint8_t* PutU16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value);
+    p[1] = static_cast<uint8_t>(value >> 8);
+    return p + 2;
+}
+
+uint8_t* PutU32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    return p + 4;
+}
+
+uint8_t* PutU64(uint8_t* p, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    return p + 8;
+}
+
+uint8_t* PutRandom(uint8_t* p, size_t len, CounterRng* rng) {
+    while (len >= 8) {
+        uint64_t word = rng->Next();
+        std::memcpy(p, &word, 8);
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        uint64_t word = rng->Next();
+        std::memcpy(p, &word, len);
+        p += len;
+    }
+    return p;
+}
+
+// Vouts and labels are mostly small, like real ones, with the occasional
+// full-width value to reach the edges.
+uint32_t SmallOrWide(CounterRng* rng) {
+    return rng->Below(4) == 0 ? static_cast<uint32_t>(rng->Next()) : rng->Below(8);
+}
+
+}  // namespace
+
+const char* GeneratedDefectName(GeneratedDefect defect) {
+    switch (defect) {
+        case GeneratedDefect::kNone:
+            return "none";
+        case GeneratedDefect::kBadVersion:
+            return "bad_version";
+        case GeneratedDefect::kNoInputs:
+            return "no_inputs";
+        case GeneratedDefect::kUnknownInputType:
+            return "unknown_input_type";
+        case GeneratedDefect::kBadPubkeyPrefix:
+            return "bad_pubkey_prefix";
+        case GeneratedDefect::kKeyMismatch:
+            return "key_mismatch";
+        case GeneratedDefect::kZeroPrivkey:
+            return "zero_privkey";
+        case GeneratedDefect::kPrivkeyOverflow:
+            return "privkey_overflow";
+        case GeneratedDefect::kTruncated:
+            return "truncated";
+        case GeneratedDefect::kTrailingBytes:
+            return "trailing_bytes";
+    }
+    return "unknown";
+}
+
+size_t MaxGeneratedCaseSize(const GeneratorOptions& options) {
+    size_t input_size = kTxidSize + 4 + 1 + kPrivkeySize + kPubkeySize;
+    return kHeaderSize + static_cast<size_t>(options.max_inputs) * input_size +
+           2 * kPubkeySize + 2 + static_cast<size_t>(options.max_labels) * 4 + 1;
+}
+
+size_t GenerateCase(const GeneratorOptions& options, uint64_t index, uint8_t* out,
+                    GeneratedDefect* defect) {
+    uint64_t key = Mix64(options.campaign_seed ^ Mix64(index + 0x9e3779b97f4a7c15ULL));
+    CounterRng rng{key, 0};
+
+    GeneratedDefect planted = GeneratedDefect::kNone;
+    if (options.invalid_per_mille > 0 && rng.Below(1000) < options.invalid_per_mille) {
+        planted = static_cast<GeneratedDefect>(1 + rng.Below(kGeneratedDefectCount - 1));
+    }
+
+    bool has_priv = options.privkeys;
+    bool has_pub = options.pubkeys;
+    if (has_priv && has_pub) {
+        uint32_t mode = rng.Below(3);
+        has_priv = mode != 1;
+        has_pub = mode != 0;
+    }
+    // Key defects need the matching key material; fall back to a defect
+    // every case can carry when it is not enabled.
+    if ((planted == GeneratedDefect::kKeyMismatch && !(options.privkeys && options.pubkeys)) ||
+        ((planted == GeneratedDefect::kZeroPrivkey ||
+          planted == GeneratedDefect::kPrivkeyOverflow) && !options.privkeys)) {
+        planted = GeneratedDefect::kUnknownInputType;
+    }
+    if (planted == GeneratedDefect::kKeyMismatch) {
+        has_priv = true;
+        has_pub = true;
+    } else if (planted == GeneratedDefect::kZeroPrivkey ||
+               planted == GeneratedDefect::kPrivkeyOverflow) {
+        has_priv = true;
+    }
+
+    uint16_t max_inputs = options.max_inputs == 0 ? 1 : options.max_inputs;
+    uint16_t input_count = static_cast<uint16_t>(1 + rng.Below(max_inputs));
+    if (planted == GeneratedDefect::kNoInputs) {
+        input_count = 0;
+    }
+    uint16_t max_outputs = options.max_outputs == 0 ? 1 : options.max_outputs;
+    uint16_t output_count = static_cast<uint16_t>(1 + rng.Below(max_outputs));
+    uint16_t label_count = static_cast<uint16_t>(rng.Below(options.max_labels + 1u));
+    uint32_t target = input_count == 0 ? 0 : rng.Below(input_count);
+
+    uint32_t flags = (has_priv ? 1u << 1 : 0) | (has_pub ? 1u << 2 : 0) |
+                     (planted != GeneratedDefect::kNone ? 1u : 0);
+    uint8_t* p = out;
+    *p++ = planted == GeneratedDefect::kBadVersion ? 2 : 1;
+    p = PutU64(p, key);
+    p = PutU32(p, flags);
+    p = PutU16(p, input_count);
+    p = PutU16(p, output_count);
+
+    for (uint32_t i = 0; i < input_count; ++i) {
+        p = PutRandom(p, kTxidSize, &rng);
+        p = PutU32(p, SmallOrWide(&rng));
+        *p++ = static_cast<uint8_t>(1 + rng.Below(3));
+        if (i == target && planted == GeneratedDefect::kUnknownInputType) {
+            static const uint8_t kBadTypes[3] = {0x00, 0x04, 0xff};
+            p[-1] = kBadTypes[rng.Below(3)];
+        }
+        uint32_t pair = rng.Below(kKeyTableSize);
+        if (has_priv) {
+            std::memcpy(p, kKeyTable[pair].privkey, kPrivkeySize);
+            if (i == target && planted == GeneratedDefect::kZeroPrivkey) {
+                std::memset(p, 0, kPrivkeySize);
+            } else if (i == target && planted == GeneratedDefect::kPrivkeyOverflow) {
+                std::memcpy(p, kCurveOrder, kPrivkeySize);
+            }
+            p += kPrivkeySize;
+        }
+        if (has_pub) {
+            if (i == target && planted == GeneratedDefect::kKeyMismatch) {
+                pair = (pair + 1) % kKeyTableSize;
+            }
+            std::memcpy(p, kKeyTable[pair].pubkey, kPubkeySize);
+            p += kPubkeySize;
+        }
+    }
+
+    uint8_t* scan = p;
+    std::memcpy(p, kKeyTable[rng.Below(kKeyTableSize)].pubkey, kPubkeySize);
+    p += kPubkeySize;
+    std::memcpy(p, kKeyTable[rng.Below(kKeyTableSize)].pubkey, kPubkeySize);
+    p += kPubkeySize;
+    if (planted == GeneratedDefect::kBadPubkeyPrefix) {
+        static const uint8_t kBadPrefixes[3] = {0x00, 0x04, 0x05};
+        scan[0] = kBadPrefixes[rng.Below(3)];
+    }
+
+    p = PutU16(p, label_count);
+    for (uint16_t i = 0; i < label_count; ++i) {
+        p = PutU32(p, SmallOrWide(&rng));
+    }
+
+    size_t size = static_cast<size_t>(p - out);
+    if (planted == GeneratedDefect::kTruncated) {
+        size = 1 + rng.Below(static_cast<uint32_t>(size - 1));
+    } else if (planted == GeneratedDefect::kTrailingBytes) {
+        out[size++] = static_cast<uint8_t>(rng.Next());
+    }
+    if (defect) {
+        *defect = planted;
+    }
+    return size;
+}
+
+void GenerateCase(const GeneratorOptions& options, uint64_t index, std::vector<uint8_t>* out,
+                  GeneratedDefect* defect) {
+    out->resize(MaxGeneratedCaseSize(options));
+    out->resize(GenerateCase(options, index, out->data(), defect));
+}
+
+}  // namespace sp_differ
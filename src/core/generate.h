@@ -0,0 +1,57 @@
+#ifndef SP_DIFFER_CORE_GENERATE_H
+#define SP_DIFFER_CORE_GENERATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sp_differ {
+
+// Deliberate defects the generator can plant in a case. Every defective case
+// also sets the negative flag (bit 0).
+enum class GeneratedDefect : uint8_t {
+    kNone,
+    kBadVersion,
+    kNoInputs,
+    kUnknownInputType,
+    kBadPubkeyPrefix,
+    kKeyMismatch,
+    kZeroPrivkey,
+    kPrivkeyOverflow,
+    kTruncated,
+    kTrailingBytes,
+};
+
+constexpr size_t kGeneratedDefectCount = 10;
+
+const char* GeneratedDefectName(GeneratedDefect defect);
+
+struct GeneratorOptions {
+    // Case N of a campaign depends only on (campaign_seed, N).
+    uint64_t campaign_seed = 0;
+    uint16_t max_inputs = 4;
+    uint16_t max_outputs = 4;
+    uint16_t max_labels = 3;
+    // Key material each case may carry; a case picks private keys, public
+    // keys, or both from whichever are enabled.
+    bool privkeys = true;
+    bool pubkeys = true;
+    // Share of cases, in thousandths, that carry a defect.
+    uint32_t invalid_per_mille = 0;
+};
+
+// Upper bound on the size of any case the options can produce.
+size_t MaxGeneratedCaseSize(const GeneratorOptions& options);
+
+// Writes case `index` of the campaign into out, which must hold at least
+// MaxGeneratedCaseSize bytes, and returns its size. Cases come from a
+// counter-based RNG keyed by (campaign_seed, index), so any case can be
+// regenerated on its own in O(1). The header seed records the case key.
+size_t GenerateCase(const GeneratorOptions& options, uint64_t index, uint8_t* out,
+                    GeneratedDefect* defect);
+void GenerateCase(const GeneratorOptions& options, uint64_t index, std::vector<uint8_t>* out,
+                  GeneratedDefect* defect);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_GENERATE_H
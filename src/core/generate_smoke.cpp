@@ -0,0 +1,75 @@
+#include "case.h"
+#include "generate.h"
+#include "validate.h"
+
+#include <iostream>
+
+int main() {
+    sp_differ::GeneratorOptions options;
+    options.campaign_seed = 42;
+    options.invalid_per_mille = 250;
+
+    std::vector<uint8_t> buffer(sp_differ::MaxGeneratedCaseSize(options));
+    std::vector<uint8_t> again;
+    size_t valid = 0;
+    size_t defective = 0;
+    uint32_t input_types = 0;
+    for (uint64_t index = 0; index < 4000; ++index) {
+        sp_differ::GeneratedDefect defect;
+        size_t size = sp_differ::GenerateCase(options, index, buffer.data(), &defect);
+        std::vector<uint8_t> payload(buffer.begin(), buffer.begin() + size);
+
+        sp_differ::GeneratedDefect again_defect;
+        sp_differ::GenerateCase(options, index, &again, &again_defect);
+        if (again != payload || again_defect != defect) {
+            std::cerr << "FAIL: case " << index << " is not reproducible" << std::endl;
+            return 2;
+        }
+
+        sp_differ::CaseView view;
+        std::string error;
+        bool parsed = sp_differ::ParseCaseViewV1(payload.data(), payload.size(), &view, &error);
+        bool framing_defect = defect == sp_differ::GeneratedDefect::kBadVersion ||
+                              defect == sp_differ::GeneratedDefect::kUnknownInputType ||
+                              defect == sp_differ::GeneratedDefect::kTruncated ||
+                              defect == sp_differ::GeneratedDefect::kTrailingBytes;
+        if (parsed == framing_defect) {
+            std::cerr << "FAIL: case " << index << " (" << sp_differ::GeneratedDefectName(defect)
+                      << ") parse result " << parsed << std::endl;
+            return 2;
+        }
+        if (!parsed) {
+            ++defective;
+            continue;
+        }
+        if (((view.header.flags & 1u) != 0) != (defect != sp_differ::GeneratedDefect::kNone)) {
+            std::cerr << "FAIL: case " << index << " negative flag" << std::endl;
+            return 2;
+        }
+        if (defect == sp_differ::GeneratedDefect::kNone) {
+            ++valid;
+            for (size_t i = 0; i < view.header.input_count; ++i) {
+                input_types |= 1u << sp_differ::GetInput(view, i).input_type;
+            }
+        } else {
+            ++defective;
+        }
+    }
+    if (valid == 0 || defective == 0 || input_types != 0x0e) {
+        std::cerr << "FAIL: generator coverage" << std::endl;
+        return 2;
+    }
+
+    std::vector<uint8_t> other;
+    options.campaign_seed = 43;
+    sp_differ::GenerateCase(options, 0, &other, nullptr);
+    options.campaign_seed = 42;
+    sp_differ::GenerateCase(options, 0, &again, nullptr);
+    if (other == again) {
+        std::cerr << "FAIL: campaign seed has no effect" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: case generator" << std::endl;
+    return 0;
+}
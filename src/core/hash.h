@@ -0,0 +1,20 @@
+#ifndef SP_DIFFER_CORE_HASH_H
+#define SP_DIFFER_CORE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sp_differ {
+
+// XXH64 (seed 0) of a case payload. Identifies cases in reports and names
+// artifacts; it consumes eight bytes per step, so hashing every case of a
+// run costs far less than running it.
+uint64_t HashCase(const uint8_t* data, size_t len);
+
+// HashCase over a whole file; identifies a worker library build.
+bool HashFile(const std::string& path, uint64_t* hash, std::string* error);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_HASH_H
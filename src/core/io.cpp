@@ -1,11 +1,17 @@
 #include "io.h"
 
-#include <cctype>
 #include <cstdint>
 #include <fstream>
 #include <string>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SP_DIFFER_HEX_SIMD 1
+#include <immintrin.h>
+#else
+#define SP_DIFFER_HEX_SIMD 0
+#endif
+
 namespace sp_differ {
 namespace {
 
@@ -27,19 +33,14 @@ bool ReadFile(const std::string& path, std::vector<uint8_t>* out) {
     return file.good();
 }
 
-bool LooksLikeHex(const std::vector<uint8_t>& buf) {
-    if (buf.empty()) {
-        return false;
-    }
-    for (uint8_t byte : buf) {
-        if (std::isspace(static_cast<unsigned char>(byte))) {
-            continue;
-        }
-        if (!std::isxdigit(static_cast<unsigned char>(byte))) {
-            return false;
-        }
-    }
-    return true;
+enum class HexScan {
+    kDecoded,
+    kNotHex,
+    kOddLength,
+};
+
+bool IsHexSpace(uint8_t byte) {
+    return byte == ' ' || (byte >= '\t' && byte <= '\r');
 }
 
 int HexValue(uint8_t byte) {
@@ -55,58 +56,275 @@ int HexValue(uint8_t byte) {
     return -1;
 }
 
-bool DecodeHex(const std::vector<uint8_t>& input, std::vector<uint8_t>* out) {
-    std::vector<uint8_t> cleaned;
-    cleaned.reserve(input.size());
-    for (uint8_t byte : input) {
-        if (std::isspace(static_cast<unsigned char>(byte))) {
-            continue;
-        }
-        cleaned.push_back(byte);
+// Decoder state shared by the scalar and vector loops. pending holds a high
+// nibble waiting for its partner, or -1; digits may be split by whitespace.
+struct HexCursor {
+    const uint8_t* in;
+    size_t len;
+    size_t pos;
+    uint8_t* out;
+    size_t written;
+    int pending;
+};
+
+// Consumes one input byte. Returns false on a byte that is neither a hex
+// digit nor whitespace.
+bool ScalarStep(HexCursor* c) {
+    uint8_t byte = c->in[c->pos++];
+    int value = HexValue(byte);
+    if (value < 0) {
+        return IsHexSpace(byte);
     }
-    if (cleaned.size() % 2 != 0) {
-        return false;
+    if (c->pending < 0) {
+        c->pending = value;
+    } else {
+        c->out[c->written++] = static_cast<uint8_t>((c->pending << 4) | value);
+        c->pending = -1;
     }
-    out->clear();
-    out->reserve(cleaned.size() / 2);
-    for (size_t i = 0; i < cleaned.size(); i += 2) {
-        int hi = HexValue(cleaned[i]);
-        int lo = HexValue(cleaned[i + 1]);
-        if (hi < 0 || lo < 0) {
+    return true;
+}
+
+// Called by the vector loops when a block contains whitespace. Steps over the
+// whitespace run, plus whatever is needed to get back to a pair boundary, so
+// the next block starts on a fresh pair.
+bool ScalarResync(HexCursor* c) {
+    do {
+        if (!ScalarStep(c)) {
             return false;
         }
-        out->push_back(static_cast<uint8_t>((hi << 4) | lo));
-    }
+    } while (c->pos < c->len && (c->pending >= 0 || IsHexSpace(c->in[c->pos])));
     return true;
 }
 
+HexScan FinishScan(HexCursor* c) {
+    while (c->pos < c->len) {
+        if (!ScalarStep(c)) {
+            return HexScan::kNotHex;
+        }
+    }
+    return c->pending >= 0 ? HexScan::kOddLength : HexScan::kDecoded;
+}
+
+HexScan ScanHexScalar(HexCursor* c) {
+    return FinishScan(c);
+}
+
+#if SP_DIFFER_HEX_SIMD
+// Both vector loops classify a whole block at once (digit, letter,
+// whitespace), bail out on anything else, and turn a whitespace-free block
+// into nibbles that maddubs folds pairwise into bytes. A block with
+// whitespace still emits its leading whole pairs, then hands the rest of the
+// run to ScalarResync. Stores may run up to one block past the output;
+// callers leave that much slack.
+__attribute__((target("sse4.1"))) HexScan ScanHexSse41(HexCursor* c) {
+    const __m128i zero_char = _mm_set1_epi8('0');
+    const __m128i a_char = _mm_set1_epi8('a');
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i tab_char = _mm_set1_epi8('\t');
+    const __m128i space_char = _mm_set1_epi8(' ');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i five = _mm_set1_epi8(5);
+    const __m128i four = _mm_set1_epi8(4);
+    const __m128i ten = _mm_set1_epi8(10);
+    const __m128i weights = _mm_set1_epi16(0x0110);
+
+    while (c->len - c->pos >= 16) {
+        __m128i text = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c->in + c->pos));
+        __m128i digit = _mm_sub_epi8(text, zero_char);
+        __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+        __m128i alpha = _mm_sub_epi8(_mm_or_si128(text, case_bit), a_char);
+        __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, five), alpha);
+        __m128i control = _mm_sub_epi8(text, tab_char);
+        __m128i is_space = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(control, four), control),
+                                        _mm_cmpeq_epi8(text, space_char));
+        __m128i valid = _mm_or_si128(_mm_or_si128(is_digit, is_alpha), is_space);
+        if (_mm_movemask_epi8(valid) != 0xffff) {
+            return HexScan::kNotHex;
+        }
+
+        __m128i nibbles = _mm_blendv_epi8(_mm_add_epi8(alpha, ten), digit, is_digit);
+        __m128i words = _mm_maddubs_epi16(nibbles, weights);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(c->out + c->written),
+                         _mm_packus_epi16(words, words));
+
+        unsigned space_mask = static_cast<unsigned>(_mm_movemask_epi8(is_space));
+        if (space_mask == 0) {
+            c->pos += 16;
+            c->written += 8;
+            continue;
+        }
+        size_t pairs = static_cast<size_t>(__builtin_ctz(space_mask)) / 2;
+        c->pos += pairs * 2;
+        c->written += pairs;
+        if (!ScalarResync(c)) {
+            return HexScan::kNotHex;
+        }
+    }
+    return FinishScan(c);
+}
+
+__attribute__((target("avx2"))) HexScan ScanHexAvx2(HexCursor* c) {
+    const __m256i zero_char = _mm256_set1_epi8('0');
+    const __m256i a_char = _mm256_set1_epi8('a');
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i tab_char = _mm256_set1_epi8('\t');
+    const __m256i space_char = _mm256_set1_epi8(' ');
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i five = _mm256_set1_epi8(5);
+    const __m256i four = _mm256_set1_epi8(4);
+    const __m256i ten = _mm256_set1_epi8(10);
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+
+    while (c->len - c->pos >= 32) {
+        __m256i text = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c->in + c->pos));
+        __m256i digit = _mm256_sub_epi8(text, zero_char);
+        __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, nine), digit);
+        __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(text, case_bit), a_char);
+        __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, five), alpha);
+        __m256i control = _mm256_sub_epi8(text, tab_char);
+        __m256i is_space =
+            _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(control, four), control),
+                            _mm256_cmpeq_epi8(text, space_char));
+        __m256i valid = _mm256_or_si256(_mm256_or_si256(is_digit, is_alpha), is_space);
+        if (static_cast<uint32_t>(_mm256_movemask_epi8(valid)) != 0xffffffffu) {
+            return HexScan::kNotHex;
+        }
+
+        __m256i nibbles = _mm256_blendv_epi8(_mm256_add_epi8(alpha, ten), digit, is_digit);
+        __m256i words = _mm256_maddubs_epi16(nibbles, weights);
+        // packus works per 128-bit lane; gather the low qword of each lane.
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(c->out + c->written),
+                         _mm256_castsi256_si128(packed));
+
+        uint32_t space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(is_space));
+        if (space_mask == 0) {
+            c->pos += 32;
+            c->written += 16;
+            continue;
+        }
+        size_t pairs = static_cast<size_t>(__builtin_ctz(space_mask)) / 2;
+        c->pos += pairs * 2;
+        c->written += pairs;
+        if (!ScalarResync(c)) {
+            return HexScan::kNotHex;
+        }
+    }
+    return FinishScan(c);
+}
+#endif
+
+using HexScanFn = HexScan (*)(HexCursor*);
+
+HexScanFn SelectHexScan() {
+#if SP_DIFFER_HEX_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ScanHexAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return ScanHexSse41;
+    }
+#endif
+    return ScanHexScalar;
+}
+
+// Slack past len / 2 for the vector loops' full-width stores.
+constexpr size_t kHexOutputSlack = 32;
+
+// Classifies, strips whitespace, validates, and decodes in one pass.
+HexScan ScanHex(const uint8_t* text, size_t text_len, std::vector<uint8_t>* out) {
+    static const HexScanFn scan = SelectHexScan();
+    out->resize(text_len / 2 + kHexOutputSlack);
+    HexCursor cursor{text, text_len, 0, out->data(), 0, -1};
+    HexScan result = scan(&cursor);
+    out->resize(cursor.written);
+    return result;
+}
+
 }  // namespace
 
 bool ReadCasePayload(const std::string& path, std::vector<uint8_t>* out, std::string* error) {
     std::vector<uint8_t> raw;
-    if (!ReadFile(path, &raw)) {
+    return ReadCaseFile(path, &raw, error) && DecodeCasePayload(&raw, out, error);
+}
+
+bool ReadCaseFile(const std::string& path, std::vector<uint8_t>* raw, std::string* error) {
+    if (!ReadFile(path, raw)) {
         if (error) {
             *error = "unable to read case file";
         }
         return false;
     }
+    return true;
+}
 
-    if (LooksLikeHex(raw)) {
-        if (!DecodeHex(raw, out)) {
+bool DecodeCasePayload(std::vector<uint8_t>* raw, std::vector<uint8_t>* out, std::string* error) {
+    // A file made only of hex digits and whitespace is hex; anything else
+    // is taken as a raw binary payload.
+    if (!raw->empty()) {
+        HexScan scan = ScanHex(raw->data(), raw->size(), out);
+        if (scan == HexScan::kDecoded) {
+            return true;
+        }
+        if (scan == HexScan::kOddLength) {
             if (error) {
                 *error = "invalid hex encoding";
             }
             return false;
         }
-        return true;
     }
 
-    *out = std::move(raw);
+    out->swap(*raw);
+    return true;
+}
+
+bool DecodeHex(const uint8_t* text, size_t text_len, std::vector<uint8_t>* out,
+               std::string* error) {
+    if (ScanHex(text, text_len, out) != HexScan::kDecoded) {
+        out->clear();
+        if (error) {
+            *error = "invalid hex encoding";
+        }
+        return false;
+    }
+    return true;
+}
+
+bool WriteCasePayloadHex(const std::string& path, const uint8_t* payload, size_t payload_len,
+                         std::string* error) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string text;
+    text.reserve(payload_len * 2 + 1);
+    for (size_t i = 0; i < payload_len; ++i) {
+        text.push_back(kDigits[payload[i] >> 4]);
+        text.push_back(kDigits[payload[i] & 0x0f]);
+    }
+    text.push_back('\n');
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        if (error) {
+            *error = "unable to write case file";
+        }
+        return false;
+    }
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    if (!file.good()) {
+        if (error) {
+            *error = "unable to write case file";
+        }
+        return false;
+    }
     return true;
 }
 
 bool ValidateOutputPayload(const std::vector<uint8_t>& output, std::string* error) {
-    if (output.size() < 4) {
+    return ValidateOutputPayload(output.data(), output.size(), error);
+}
+
+bool ValidateOutputPayload(const uint8_t* output, size_t output_len, std::string* error) {
+    if (output_len < 4) {
         if (error) {
             *error = "output too short";
         }
@@ -126,7 +344,7 @@ bool ValidateOutputPayload(const std::vector<uint8_t>& output, std::string* erro
     }
 
     if (status != 0) {
-        if (output.size() != 4) {
+        if (output_len != 4) {
             if (error) {
                 *error = "non-ok status must have empty payload";
             }
@@ -136,7 +354,7 @@ bool ValidateOutputPayload(const std::vector<uint8_t>& output, std::string* erro
     }
 
     size_t expected = 4 + static_cast<size_t>(output_count) * (33 + 32);
-    if (output.size() != expected) {
+    if (output_len != expected) {
         if (error) {
             *error = "invalid payload length";
         }
@@ -146,4 +364,23 @@ bool ValidateOutputPayload(const std::vector<uint8_t>& output, std::string* erro
     return true;
 }
 
+bool ParseUnsigned(const char* text, uint64_t max, uint64_t* out) {
+    if (text == nullptr || *text == '\0') {
+        return false;
+    }
+    uint64_t value = 0;
+    for (const char* p = text; *p != '\0'; ++p) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        uint64_t digit = static_cast<uint64_t>(*p - '0');
+        if (digit > max || value > (max - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    *out = value;
+    return true;
+}
+
 }  // namespace sp_differ
@@ -9,7 +9,29 @@ namespace sp_differ {
 
 bool ReadCasePayload(const std::string& path, std::vector<uint8_t>* out, std::string* error);
 
+// The two halves of ReadCasePayload, for callers that time them apart:
+// ReadCaseFile loads the raw file, and DecodeCasePayload turns it into a
+// payload, decoding hex and taking anything else as binary. raw is consumed.
+bool ReadCaseFile(const std::string& path, std::vector<uint8_t>* raw, std::string* error);
+bool DecodeCasePayload(std::vector<uint8_t>* raw, std::vector<uint8_t>* out, std::string* error);
+
+// Decodes hex text, ignoring whitespace anywhere (including between the two
+// digits of a byte). Fails on any other character or an odd digit count.
+// Uses AVX2 or SSE4.1 when the CPU has them.
+bool DecodeHex(const uint8_t* text, size_t text_len, std::vector<uint8_t>* out,
+               std::string* error);
+
+// Writes payload as a single line of lowercase hex, the interchange format
+// used for vectors and artifacts.
+bool WriteCasePayloadHex(const std::string& path, const uint8_t* payload, size_t payload_len,
+                         std::string* error);
+
 bool ValidateOutputPayload(const std::vector<uint8_t>& output, std::string* error);
+bool ValidateOutputPayload(const uint8_t* output, size_t output_len, std::string* error);
+
+// Parses a decimal command-line count. Fails on an empty string, a sign,
+// any trailing character, or a value above max.
+bool ParseUnsigned(const char* text, uint64_t max, uint64_t* out);
 
 }  // namespace sp_differ
 
@@ -1,5 +1,6 @@
 #include "io.h"
 
+#include <cstdint>
 #include <iostream>
 
 int main() {
@@ -21,6 +22,70 @@ int main() {
         return 2;
     }
 
+    std::string roundtrip_path = "build/sp_differ_core_io_roundtrip.hex";
+    if (!sp_differ::WriteCasePayloadHex(roundtrip_path, payload.data(), payload.size(), &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+
+    std::vector<uint8_t> reread;
+    if (!sp_differ::ReadCasePayload(roundtrip_path, &reread, &error) || reread != payload) {
+        std::cerr << "FAIL: hex round trip changed the payload" << std::endl;
+        return 2;
+    }
+
+    // Long enough to cover the vector loops, with whitespace splitting pairs
+    // at every alignment and mixed-case digits.
+    std::string text;
+    std::vector<uint8_t> expected;
+    for (int i = 0; i < 300; ++i) {
+        static const char kDigits[] = "0123456789abcDEF";
+        text.push_back(kDigits[(i * 7) % 16]);
+        if (i % 37 == 0) {
+            text += " \n\t";
+        }
+        text.push_back(kDigits[(i * 5 + 3) % 16]);
+        expected.push_back(static_cast<uint8_t>((((i * 7) % 16) << 4) | ((i * 5 + 3) % 16)));
+        if (i % 23 == 0) {
+            text += "\r\n";
+        }
+    }
+    std::vector<uint8_t> decoded;
+    if (!sp_differ::DecodeHex(reinterpret_cast<const uint8_t*>(text.data()), text.size(), &decoded,
+                              &error) ||
+        decoded != expected) {
+        std::cerr << "FAIL: hex decode" << std::endl;
+        return 2;
+    }
+    text[text.size() - 40] = 'g';
+    if (sp_differ::DecodeHex(reinterpret_cast<const uint8_t*>(text.data()), text.size(), &decoded,
+                             &error)) {
+        std::cerr << "FAIL: invalid hex should not decode" << std::endl;
+        return 2;
+    }
+    text.assign(65, 'a');
+    if (sp_differ::DecodeHex(reinterpret_cast<const uint8_t*>(text.data()), text.size(), &decoded,
+                             &error)) {
+        std::cerr << "FAIL: odd digit count should not decode" << std::endl;
+        return 2;
+    }
+
+    uint64_t parsed = 0;
+    if (!sp_differ::ParseUnsigned("4096", UINT32_MAX, &parsed) || parsed != 4096 ||
+        !sp_differ::ParseUnsigned("18446744073709551615", UINT64_MAX, &parsed) ||
+        parsed != UINT64_MAX) {
+        std::cerr << "FAIL: unsigned parse" << std::endl;
+        return 2;
+    }
+    const char* bad_counts[] = {"", "-1", "+1", "4x", " 4", "0x10", "4294967296",
+                                "18446744073709551616"};
+    for (const char* text : bad_counts) {
+        if (sp_differ::ParseUnsigned(text, UINT32_MAX, &parsed)) {
+            std::cerr << "FAIL: unsigned parse accepted \"" << text << "\"" << std::endl;
+            return 2;
+        }
+    }
+
     std::cout << "OK: core io" << std::endl;
     return 0;
 }
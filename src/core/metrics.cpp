@@ -0,0 +1,228 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+constexpr int kSubBucketBits = 5;
+constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+// Values are clamped below 2^48 ns (about three days).
+constexpr int kMaxExponent = 47;
+constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+// Index of the highest set bit of a nonzero value.
+int HighestBit(uint64_t value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+size_t BucketOf(uint64_t ns) {
+    if (ns < kSubBuckets) {
+        return static_cast<size_t>(ns);
+    }
+    if (ns >> (kMaxExponent + 1)) {
+        return kBucketCount - 1;
+    }
+    int exponent = HighestBit(ns);
+    uint64_t mantissa = ns >> (exponent - kSubBucketBits);
+    return static_cast<size_t>((exponent - kSubBucketBits + 1) * kSubBuckets +
+                               (mantissa - kSubBuckets));
+}
+
+// Midpoint of the values that fall into bucket.
+uint64_t BucketValue(size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    int exponent = static_cast<int>(bucket / kSubBuckets) - 1 + kSubBucketBits;
+    uint64_t mantissa = kSubBuckets + bucket % kSubBuckets;
+    int shift = exponent - kSubBucketBits;
+    return (mantissa << shift) + ((1ull << shift) >> 1);
+}
+
+double Micros(uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+void AppendJsonString(const std::string& text, std::ostream& out) {
+    out << '"';
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            out << '\\' << ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+            out << escaped;
+        } else {
+            out << ch;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+const char* StageName(Stage stage) {
+    switch (stage) {
+        case Stage::kRead:
+            return "read";
+        case Stage::kDecode:
+            return "decode";
+        case Stage::kValidateCase:
+            return "validate_case";
+        case Stage::kLeftWorker:
+            return "left_worker";
+        case Stage::kRightWorker:
+            return "right_worker";
+        case Stage::kValidateOutput:
+            return "validate_output";
+        case Stage::kCompare:
+            return "compare";
+    }
+    return "unknown";
+}
+
+void RecordLatency(LatencyHistogram* histogram, uint64_t ns, uint64_t weight) {
+    if (weight == 0) {
+        return;
+    }
+    if (histogram->buckets.empty()) {
+        histogram->buckets.assign(kBucketCount, 0);
+    }
+    histogram->buckets[BucketOf(ns)] += weight;
+    histogram->count += weight;
+    histogram->total_ns += ns * weight;
+    histogram->min_ns = std::min(histogram->min_ns, ns);
+    histogram->max_ns = std::max(histogram->max_ns, ns);
+}
+
+void MergeLatency(LatencyHistogram* into, const LatencyHistogram& from) {
+    if (from.count == 0) {
+        return;
+    }
+    if (into->buckets.empty()) {
+        into->buckets.assign(kBucketCount, 0);
+    }
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        into->buckets[i] += from.buckets[i];
+    }
+    into->count += from.count;
+    into->total_ns += from.total_ns;
+    into->min_ns = std::min(into->min_ns, from.min_ns);
+    into->max_ns = std::max(into->max_ns, from.max_ns);
+}
+
+uint64_t LatencyPercentile(const LatencyHistogram& histogram, double quantile) {
+    if (histogram.count == 0) {
+        return 0;
+    }
+    quantile = std::min(1.0, std::max(0.0, quantile));
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * histogram.count));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < histogram.buckets.size(); ++i) {
+        seen += histogram.buckets[i];
+        if (seen >= rank) {
+            // The last bucket also holds every clamped value.
+            if (i + 1 == kBucketCount) {
+                return histogram.max_ns;
+            }
+            return std::min(histogram.max_ns, std::max(histogram.min_ns, BucketValue(i)));
+        }
+    }
+    return histogram.max_ns;
+}
+
+uint64_t MonotonicNs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - epoch)
+                                     .count());
+}
+
+uint64_t RecordStage(StageRecorder* recorder, Stage stage, uint64_t start_ns, uint64_t cases) {
+    if (!recorder) {
+        return 0;
+    }
+    uint64_t now = MonotonicNs();
+    uint64_t elapsed = now - start_ns;
+    if (cases > 0) {
+        RecordLatency(&recorder->stages[static_cast<size_t>(stage)], elapsed / cases, cases);
+    }
+    if (recorder->trace) {
+        recorder->events.push_back(
+            TraceEvent{stage, static_cast<uint32_t>(cases), start_ns, elapsed});
+    }
+    return now;
+}
+
+void MergeRecorder(StageRecorder* into, const StageRecorder& from) {
+    for (size_t i = 0; i < kStageCount; ++i) {
+        MergeLatency(&into->stages[i], from.stages[i]);
+    }
+}
+
+std::string FormatLatency(const LatencyHistogram& histogram) {
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(3)
+         << "p50_us=" << Micros(LatencyPercentile(histogram, 0.50))
+         << " p99_us=" << Micros(LatencyPercentile(histogram, 0.99))
+         << " p999_us=" << Micros(LatencyPercentile(histogram, 0.999))
+         << " max_us=" << Micros(histogram.max_ns);
+    return line.str();
+}
+
+bool WriteChromeTrace(const std::string& path, const std::vector<StageRecorder>& recorders,
+                      const std::vector<std::string>& thread_names,
+                      const std::array<std::string, kStageCount>& stage_names,
+                      std::string* error) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        *error = "unable to write " + path;
+        return false;
+    }
+    // Timestamps are microseconds; three decimals keep nanosecond detail.
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    out << std::fixed << std::setprecision(3);
+    for (size_t tid = 0; tid < recorders.size(); ++tid) {
+        out << (first ? "\n" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":";
+        AppendJsonString(tid < thread_names.size() ? thread_names[tid] : std::to_string(tid), out);
+        out << "}}";
+        first = false;
+        for (const TraceEvent& event : recorders[tid].events) {
+            out << ",\n{\"name\":";
+            AppendJsonString(stage_names[static_cast<size_t>(event.stage)], out);
+            out << ",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                << ",\"ts\":" << Micros(event.start_ns) << ",\"dur\":" << Micros(event.duration_ns)
+                << ",\"args\":{\"cases\":" << event.cases << "}}";
+        }
+    }
+    out << "\n]}\n";
+    out.flush();
+    if (!out) {
+        *error = "unable to write " + path;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace sp_differ
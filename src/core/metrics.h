@@ -0,0 +1,98 @@
+#ifndef SP_DIFFER_CORE_METRICS_H
+#define SP_DIFFER_CORE_METRICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+
+// The stages a case passes through in the runner and the compare.
+enum class Stage : uint8_t {
+    // File or stream read; for hex streams this includes the decode.
+    kRead,
+    kDecode,
+    kValidateCase,
+    kLeftWorker,
+    kRightWorker,
+    kValidateOutput,
+    kCompare,
+};
+
+constexpr size_t kStageCount = 7;
+
+// e.g. "left_worker".
+const char* StageName(Stage stage);
+
+// HDR-style log-linear histogram of nanosecond latencies. Values below 32 ns
+// are exact; above that each power of two is split into 32 buckets, so a
+// percentile is within about 3% of the true value. Buckets are allocated on
+// the first record, so an unused stage costs nothing but the struct.
+struct LatencyHistogram {
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t min_ns = UINT64_MAX;
+    uint64_t max_ns = 0;
+};
+
+// Adds weight samples of ns each.
+void RecordLatency(LatencyHistogram* histogram, uint64_t ns, uint64_t weight = 1);
+
+void MergeLatency(LatencyHistogram* into, const LatencyHistogram& from);
+
+// Value at quantile in [0, 1], clamped to the recorded min and max; 0 when
+// the histogram is empty.
+uint64_t LatencyPercentile(const LatencyHistogram& histogram, double quantile);
+
+// One traced span in Chrome trace-event terms: a complete ("X") event.
+struct TraceEvent {
+    Stage stage;
+    uint32_t cases;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+// Per-thread stage timings. A recorder is only ever written by its own
+// thread; recorders are merged once the run is over.
+struct StageRecorder {
+    std::array<LatencyHistogram, kStageCount> stages;
+    // Trace events are kept only when this is set.
+    bool trace = false;
+    std::vector<TraceEvent> events;
+};
+
+// Nanoseconds on the steady clock since the first call in this process.
+uint64_t MonotonicNs();
+
+// Records the span from start_ns to now against stage, spread evenly over
+// cases, and returns now so consecutive stages can chain their start times.
+// A null recorder records nothing and returns 0 without reading the clock.
+uint64_t RecordStage(StageRecorder* recorder, Stage stage, uint64_t start_ns,
+                     uint64_t cases = 1);
+
+// Start time for RecordStage; 0 without a recorder, so disabled runs never
+// read the clock.
+inline uint64_t StageStart(const StageRecorder* recorder) {
+    return recorder ? MonotonicNs() : 0;
+}
+
+void MergeRecorder(StageRecorder* into, const StageRecorder& from);
+
+// "p50_us=... p99_us=... p999_us=... max_us=..." for a summary line.
+std::string FormatLatency(const LatencyHistogram& histogram);
+
+// Writes the events of every recorder as Chrome trace-event JSON (load it
+// in chrome://tracing or Perfetto). Recorder i becomes thread i, named
+// thread_names[i]; stage_names overrides the event name of each stage, e.g.
+// to carry the worker name.
+bool WriteChromeTrace(const std::string& path, const std::vector<StageRecorder>& recorders,
+                      const std::vector<std::string>& thread_names,
+                      const std::array<std::string, kStageCount>& stage_names,
+                      std::string* error);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_METRICS_H
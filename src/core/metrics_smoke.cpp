@@ -0,0 +1,83 @@
+#include "metrics.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main() {
+    // Small values are exact; larger ones land within the bucket precision.
+    sp_differ::LatencyHistogram histogram;
+    for (uint64_t ns = 1; ns <= 1000; ++ns) {
+        sp_differ::RecordLatency(&histogram, ns * 1000);
+    }
+    uint64_t p50 = sp_differ::LatencyPercentile(histogram, 0.50);
+    uint64_t p99 = sp_differ::LatencyPercentile(histogram, 0.99);
+    if (histogram.count != 1000 || histogram.min_ns != 1000 || histogram.max_ns != 1000000 ||
+        p50 < 485000 || p50 > 515000 || p99 < 960000 || p99 > 1000000 ||
+        sp_differ::LatencyPercentile(histogram, 1.0) != 1000000) {
+        std::cerr << "FAIL: percentiles p50=" << p50 << " p99=" << p99 << std::endl;
+        return 2;
+    }
+    sp_differ::LatencyHistogram small;
+    sp_differ::RecordLatency(&small, 7, 3);
+    sp_differ::RecordLatency(&small, 1ull << 60);
+    if (sp_differ::LatencyPercentile(small, 0.5) != 7 || small.count != 4 ||
+        sp_differ::LatencyPercentile(small, 1.0) != (1ull << 60)) {
+        std::cerr << "FAIL: exact and clamped values" << std::endl;
+        return 2;
+    }
+
+    // Merging recorders adds their histograms stage by stage.
+    std::vector<sp_differ::StageRecorder> recorders(2);
+    recorders[1].trace = true;
+    uint64_t start = sp_differ::MonotonicNs();
+    sp_differ::RecordStage(&recorders[0], sp_differ::Stage::kRead, start);
+    sp_differ::RecordStage(&recorders[1], sp_differ::Stage::kRead, start, 4);
+    sp_differ::RecordStage(&recorders[1], sp_differ::Stage::kLeftWorker, start, 0);
+    if (sp_differ::RecordStage(nullptr, sp_differ::Stage::kRead, start) != 0 ||
+        sp_differ::StageStart(nullptr) != 0 || !recorders[0].events.empty() ||
+        recorders[1].events.size() != 2) {
+        std::cerr << "FAIL: stage recording" << std::endl;
+        return 2;
+    }
+    sp_differ::StageRecorder total;
+    for (const sp_differ::StageRecorder& recorder : recorders) {
+        sp_differ::MergeRecorder(&total, recorder);
+    }
+    if (total.stages[static_cast<size_t>(sp_differ::Stage::kRead)].count != 5 ||
+        total.stages[static_cast<size_t>(sp_differ::Stage::kLeftWorker)].count != 0) {
+        std::cerr << "FAIL: recorder merge" << std::endl;
+        return 2;
+    }
+
+    std::string path = "build/metrics_smoke_trace.json";
+    std::string error;
+    std::array<std::string, sp_differ::kStageCount> names;
+    for (size_t i = 0; i < sp_differ::kStageCount; ++i) {
+        names[i] = sp_differ::StageName(static_cast<sp_differ::Stage>(i));
+    }
+    names[static_cast<size_t>(sp_differ::Stage::kLeftWorker)] = "left_worker \"cpp\"";
+    if (!sp_differ::WriteChromeTrace(path, recorders, {"job 0", "job 1"}, names, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    std::string trace = text.str();
+    std::remove(path.c_str());
+    if (trace.find("\"traceEvents\":[") == std::string::npos ||
+        trace.find("\"name\":\"job 1\"") == std::string::npos ||
+        trace.find("\"name\":\"left_worker \\\"cpp\\\"\",\"cat\":\"stage\",\"ph\":\"X\"") ==
+            std::string::npos ||
+        trace.find("\"args\":{\"cases\":4}") == std::string::npos) {
+        std::cerr << "FAIL: trace contents" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: stage metrics" << std::endl;
+    return 0;
+}
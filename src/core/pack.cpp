@@ -0,0 +1,246 @@
+#include "pack.h"
+
+#include "io.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sp_differ {
+namespace {
+
+const char kPackMagic[8] = {'S', 'P', 'D', 'P', 'A', 'C', 'K', '1'};
+
+uint64_t LoadU64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+void StoreU64(uint64_t value, uint8_t* p) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+bool MapFile(const std::string& path, PackedCorpus* out, std::string* error) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        *error = "unable to open packed corpus";
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        *error = "packed corpus is empty";
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        *error = "unable to map packed corpus";
+        return false;
+    }
+    out->file = file;
+    out->mapping = mapping;
+    out->base = static_cast<const uint8_t*>(view);
+    out->size = static_cast<size_t>(size.QuadPart);
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        *error = "unable to open packed corpus";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        *error = "packed corpus is empty";
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        *error = "unable to map packed corpus";
+        return false;
+    }
+#if defined(MADV_SEQUENTIAL)
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+#endif
+    out->base = static_cast<const uint8_t*>(view);
+    out->size = static_cast<size_t>(st.st_size);
+    return true;
+#endif
+}
+
+}  // namespace
+
+bool IsPackedCorpus(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kPackMagic)] = {};
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, kPackMagic, sizeof(magic)) == 0;
+}
+
+bool OpenPackedCorpus(const std::string& path, PackedCorpus* out, std::string* error) {
+    PackedCorpus corpus;
+    if (!MapFile(path, &corpus, error)) {
+        return false;
+    }
+    if (corpus.size < kPackHeaderSize ||
+        std::memcmp(corpus.base, kPackMagic, sizeof(kPackMagic)) != 0) {
+        ClosePackedCorpus(&corpus);
+        *error = "not a packed corpus";
+        return false;
+    }
+    uint64_t case_count = LoadU64(corpus.base + 8);
+    uint64_t data_offset = LoadU64(corpus.base + 16);
+    uint64_t index_offset = LoadU64(corpus.base + 24);
+    if (data_offset < kPackHeaderSize || index_offset < data_offset ||
+        index_offset > corpus.size ||
+        case_count > (corpus.size - index_offset) / kPackIndexEntrySize) {
+        ClosePackedCorpus(&corpus);
+        *error = "packed corpus header out of range";
+        return false;
+    }
+    corpus.case_count = case_count;
+    corpus.data = corpus.base + data_offset;
+    corpus.data_len = static_cast<size_t>(index_offset - data_offset);
+    corpus.index = corpus.base + index_offset;
+    *out = corpus;
+    return true;
+}
+
+void ClosePackedCorpus(PackedCorpus* corpus) {
+    if (!corpus->base) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(corpus->base);
+    CloseHandle(static_cast<HANDLE>(corpus->mapping));
+    CloseHandle(static_cast<HANDLE>(corpus->file));
+#else
+    munmap(const_cast<uint8_t*>(corpus->base), corpus->size);
+#endif
+    *corpus = PackedCorpus();
+}
+
+bool GetPackedCase(const PackedCorpus& corpus, size_t index, const uint8_t** payload,
+                   size_t* payload_len, std::string* error) {
+    if (index >= corpus.case_count) {
+        if (error) {
+            *error = "packed case index out of range";
+        }
+        return false;
+    }
+    const uint8_t* entry = corpus.index + index * kPackIndexEntrySize;
+    uint64_t offset = LoadU64(entry);
+    uint64_t length = LoadU64(entry + 8);
+    if (offset > corpus.data_len || length > corpus.data_len - offset) {
+        if (error) {
+            *error = "packed case out of range";
+        }
+        return false;
+    }
+    *payload = corpus.data + offset;
+    *payload_len = static_cast<size_t>(length);
+    return true;
+}
+
+bool ReadCaseRef(const std::string& ref, std::vector<uint8_t>* out, std::string* error) {
+    size_t hash = ref.rfind('#');
+    if (hash == std::string::npos || hash + 1 == ref.size()) {
+        return ReadCasePayload(ref, out, error);
+    }
+    std::string path = ref.substr(0, hash);
+    char* end = nullptr;
+    unsigned long long index = std::strtoull(ref.c_str() + hash + 1, &end, 10);
+    if (*end != '\0' || !IsPackedCorpus(path)) {
+        return ReadCasePayload(ref, out, error);
+    }
+
+    PackedCorpus corpus;
+    if (!OpenPackedCorpus(path, &corpus, error)) {
+        return false;
+    }
+    const uint8_t* payload = nullptr;
+    size_t payload_len = 0;
+    bool found = GetPackedCase(corpus, static_cast<size_t>(index), &payload, &payload_len, error);
+    if (found) {
+        out->assign(payload, payload + payload_len);
+    }
+    ClosePackedCorpus(&corpus);
+    return found;
+}
+
+bool BeginPackedCorpus(const std::string& path, PackWriter* writer, std::string* error) {
+    writer->stream.open(path, std::ios::binary | std::ios::trunc);
+    if (!writer->stream) {
+        *error = "unable to create packed corpus";
+        return false;
+    }
+    writer->offsets.clear();
+    writer->lengths.clear();
+    writer->data_len = 0;
+    uint8_t header[kPackHeaderSize] = {};
+    writer->stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    return true;
+}
+
+bool AppendPackedCase(PackWriter* writer, const uint8_t* payload, size_t payload_len,
+                      std::string* error) {
+    writer->stream.write(reinterpret_cast<const char*>(payload),
+                         static_cast<std::streamsize>(payload_len));
+    if (!writer->stream) {
+        *error = "unable to write packed corpus";
+        return false;
+    }
+    writer->offsets.push_back(writer->data_len);
+    writer->lengths.push_back(payload_len);
+    writer->data_len += payload_len;
+    return true;
+}
+
+bool FinishPackedCorpus(PackWriter* writer, std::string* error) {
+    uint8_t entry[kPackIndexEntrySize];
+    for (size_t i = 0; i < writer->offsets.size(); ++i) {
+        StoreU64(writer->offsets[i], entry);
+        StoreU64(writer->lengths[i], entry + 8);
+        writer->stream.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+    }
+
+    uint8_t header[kPackHeaderSize];
+    std::memcpy(header, kPackMagic, sizeof(kPackMagic));
+    StoreU64(writer->offsets.size(), header + 8);
+    StoreU64(kPackHeaderSize, header + 16);
+    StoreU64(kPackHeaderSize + writer->data_len, header + 24);
+    writer->stream.seekp(0);
+    writer->stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    writer->stream.close();
+    if (writer->stream.fail()) {
+        *error = "unable to write packed corpus";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,63 @@
+#ifndef SP_DIFFER_CORE_PACK_H
+#define SP_DIFFER_CORE_PACK_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+
+// Packed corpus layout (all integers little-endian):
+//   header: magic "SPDPACK1" (8), case_count u64, data_offset u64, index_offset u64
+//   data:   raw v1 case payloads back to back
+//   index:  case_count x { offset u64 (relative to data_offset), length u64 }
+// The index is written last so a corpus can be packed in one streaming pass.
+constexpr size_t kPackHeaderSize = 32;
+constexpr size_t kPackIndexEntrySize = 16;
+
+struct PackedCorpus {
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+    uint64_t case_count = 0;
+    const uint8_t* data = nullptr;
+    size_t data_len = 0;
+    const uint8_t* index = nullptr;
+#if defined(_WIN32)
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// True when path starts with the packed corpus magic.
+bool IsPackedCorpus(const std::string& path);
+
+// Maps the corpus read-only. Only the header is validated, so opening is
+// O(1) regardless of corpus size; each index entry is checked on access.
+bool OpenPackedCorpus(const std::string& path, PackedCorpus* out, std::string* error);
+void ClosePackedCorpus(PackedCorpus* corpus);
+
+// Points payload at case index inside the mapping.
+bool GetPackedCase(const PackedCorpus& corpus, size_t index, const uint8_t** payload,
+                   size_t* payload_len, std::string* error);
+
+// Reads a case by reference: "<pack>#<index>" names one case of a packed
+// corpus (the form batch reports use), anything else is a case file.
+bool ReadCaseRef(const std::string& ref, std::vector<uint8_t>* out, std::string* error);
+
+struct PackWriter {
+    std::ofstream stream;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> lengths;
+    uint64_t data_len = 0;
+};
+
+bool BeginPackedCorpus(const std::string& path, PackWriter* writer, std::string* error);
+bool AppendPackedCase(PackWriter* writer, const uint8_t* payload, size_t payload_len,
+                      std::string* error);
+// Writes the index and patches the header.
+bool FinishPackedCorpus(PackWriter* writer, std::string* error);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_PACK_H
@@ -0,0 +1,60 @@
+#include "io.h"
+#include "pack.h"
+
+#include <iostream>
+
+int main() {
+    std::string error;
+    std::vector<uint8_t> example;
+    if (!sp_differ::ReadCasePayload("tests/vectors/example.hex", &example, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+
+    const std::string path = "build/sp_differ_core_pack_smoke.pack";
+    std::vector<uint8_t> second = {1, 2, 3};
+    sp_differ::PackWriter writer;
+    if (!sp_differ::BeginPackedCorpus(path, &writer, &error) ||
+        !sp_differ::AppendPackedCase(&writer, example.data(), example.size(), &error) ||
+        !sp_differ::AppendPackedCase(&writer, second.data(), second.size(), &error) ||
+        !sp_differ::FinishPackedCorpus(&writer, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+
+    if (!sp_differ::IsPackedCorpus(path) ||
+        sp_differ::IsPackedCorpus("tests/vectors/example.hex")) {
+        std::cerr << "FAIL: packed corpus detection" << std::endl;
+        return 2;
+    }
+
+    sp_differ::PackedCorpus corpus;
+    if (!sp_differ::OpenPackedCorpus(path, &corpus, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+    const uint8_t* payload = nullptr;
+    size_t payload_len = 0;
+    if (corpus.case_count != 2 ||
+        !sp_differ::GetPackedCase(corpus, 0, &payload, &payload_len, &error) ||
+        std::vector<uint8_t>(payload, payload + payload_len) != example ||
+        sp_differ::GetPackedCase(corpus, 2, &payload, &payload_len, &error)) {
+        std::cerr << "FAIL: packed corpus contents" << std::endl;
+        return 2;
+    }
+    sp_differ::ClosePackedCorpus(&corpus);
+
+    std::vector<uint8_t> by_ref;
+    if (!sp_differ::ReadCaseRef(path + "#1", &by_ref, &error) || by_ref != second) {
+        std::cerr << "FAIL: packed case reference" << std::endl;
+        return 2;
+    }
+
+    if (sp_differ::OpenPackedCorpus("tests/vectors/example.hex", &corpus, &error)) {
+        std::cerr << "FAIL: hex file should not open as a packed corpus" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: packed corpus" << std::endl;
+    return 0;
+}
@@ -0,0 +1,317 @@
+#include "reduce.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+constexpr uint32_t kFlagNegative = 1u << 0;
+constexpr uint32_t kFlagPrivkeys = 1u << 1;
+constexpr uint32_t kFlagPubkeys = 1u << 2;
+
+// Compressed encoding of the secp256k1 generator, the canonical public key.
+const uint8_t kGenerator[kPubkeySize] = {
+    0x02, 0x79, 0xbe, 0x66, 0x7e, 0xf9, 0xdc, 0xbb, 0xac, 0x55, 0xa0,
+    0x62, 0x95, 0xce, 0x87, 0x0b, 0x07, 0x02, 0x9b, 0xfc, 0xdb, 0x2d,
+    0xce, 0x28, 0xd9, 0x59, 0xf2, 0x81, 0x5b, 0x16, 0xf8, 0x17, 0x98,
+};
+
+std::vector<uint8_t> CanonicalPrivkey() {
+    std::vector<uint8_t> key(kPrivkeySize, 0);
+    key.back() = 1;
+    return key;
+}
+
+std::vector<uint8_t> CanonicalPubkey() {
+    return std::vector<uint8_t>(kGenerator, kGenerator + kPubkeySize);
+}
+
+// Runs one batch, leaving the verdicts in keep, and returns the index of the
+// first kept candidate, or candidates.size() when none was kept.
+size_t RunBatch(const std::vector<std::vector<uint8_t>>& candidates,
+                const BatchPredicate& predicate, std::vector<uint8_t>* keep,
+                ReduceStats* stats) {
+    keep->assign(candidates.size(), 0);
+    if (candidates.empty()) {
+        return 0;
+    }
+    predicate(candidates, keep);
+    ++stats->batches;
+    stats->candidates += candidates.size();
+    for (size_t i = 0; i < keep->size(); ++i) {
+        if ((*keep)[i]) {
+            return i;
+        }
+    }
+    return candidates.size();
+}
+
+// Case fields the delta debugger can remove elements from.
+struct InputSequence {
+    static size_t Length(const Case& c) { return c.inputs.size(); }
+    static void Erase(Case* c, size_t begin, size_t end) {
+        c->inputs.erase(c->inputs.begin() + begin, c->inputs.begin() + end);
+    }
+    static void Encode(const Case& c, std::vector<uint8_t>* out) { SerializeCaseV1(c, out); }
+};
+
+struct LabelSequence {
+    static size_t Length(const Case& c) { return c.labels.size(); }
+    static void Erase(Case* c, size_t begin, size_t end) {
+        c->labels.erase(c->labels.begin() + begin, c->labels.begin() + end);
+    }
+    static void Encode(const Case& c, std::vector<uint8_t>* out) { SerializeCaseV1(c, out); }
+};
+
+struct ByteSequence {
+    static size_t Length(const std::vector<uint8_t>& bytes) { return bytes.size(); }
+    static void Erase(std::vector<uint8_t>* bytes, size_t begin, size_t end) {
+        bytes->erase(bytes->begin() + begin, bytes->begin() + end);
+    }
+    static void Encode(const std::vector<uint8_t>& bytes, std::vector<uint8_t>* out) {
+        *out = bytes;
+    }
+};
+
+// Delta debugging over one sequence. At granularity n the sequence is cut
+// into n chunks and every "remove chunk i" candidate goes into one batch.
+// The first kept candidate replaces the value and the granularity steps
+// back. If none is kept the chunks are halved, until they are single
+// elements.
+template <typename Sequence, typename Value>
+bool Ddmin(Value* value, const BatchPredicate& predicate, ReduceStats* stats) {
+    bool changed = false;
+    size_t n = 1;
+    std::vector<Value> reduced;
+    std::vector<std::vector<uint8_t>> encoded;
+    std::vector<uint8_t> keep;
+    while (Sequence::Length(*value) > 0) {
+        size_t length = Sequence::Length(*value);
+        n = std::min(n, length);
+        size_t chunk = (length + n - 1) / n;
+        reduced.assign(n, *value);
+        encoded.resize(n);
+        size_t built = 0;
+        for (size_t begin = 0; begin < length; begin += chunk, ++built) {
+            Sequence::Erase(&reduced[built], begin, std::min(length, begin + chunk));
+            Sequence::Encode(reduced[built], &encoded[built]);
+        }
+        encoded.resize(built);
+
+        size_t first = RunBatch(encoded, predicate, &keep, stats);
+        if (first < encoded.size()) {
+            *value = std::move(reduced[first]);
+            ++stats->accepted;
+            changed = true;
+            n = std::max<size_t>(n - 1, 2);
+            continue;
+        }
+        if (chunk == 1) {
+            break;
+        }
+        n = std::min(2 * n, length);
+    }
+    return changed;
+}
+
+enum class EditKind {
+    kZeroSeed,
+    kZeroOutputCount,
+    kClearNegative,
+    kDropPrivkeys,
+    kDropPubkeys,
+    kZeroTxid,
+    kZeroVout,
+    kInputTypeOne,
+    kCanonicalPrivkey,
+    kCanonicalPubkey,
+    kCanonicalScan,
+    kCanonicalSpend,
+    kZeroLabel,
+};
+
+struct Edit {
+    EditKind kind;
+    size_t index;
+};
+
+// Applies edit to c and returns false when it would change nothing.
+bool ApplyEdit(Case* c, const Edit& edit) {
+    static const std::vector<uint8_t> kZeroTxid(kTxidSize, 0);
+    static const std::vector<uint8_t> kPrivkey = CanonicalPrivkey();
+    static const std::vector<uint8_t> kPubkey = CanonicalPubkey();
+    InputEntry* input = edit.index < c->inputs.size() ? &c->inputs[edit.index] : nullptr;
+    switch (edit.kind) {
+        case EditKind::kZeroSeed:
+            if (c->header.seed == 0) {
+                return false;
+            }
+            c->header.seed = 0;
+            return true;
+        case EditKind::kZeroOutputCount:
+            if (c->header.output_count == 0) {
+                return false;
+            }
+            c->header.output_count = 0;
+            return true;
+        case EditKind::kClearNegative:
+        case EditKind::kDropPrivkeys:
+        case EditKind::kDropPubkeys: {
+            uint32_t bit = edit.kind == EditKind::kClearNegative  ? kFlagNegative
+                           : edit.kind == EditKind::kDropPrivkeys ? kFlagPrivkeys
+                                                                  : kFlagPubkeys;
+            if ((c->header.flags & bit) == 0) {
+                return false;
+            }
+            c->header.flags &= ~bit;
+            for (InputEntry& entry : c->inputs) {
+                if (bit == kFlagPrivkeys) {
+                    entry.privkey.clear();
+                } else if (bit == kFlagPubkeys) {
+                    entry.pubkey.clear();
+                }
+            }
+            return true;
+        }
+        case EditKind::kZeroTxid:
+            if (!input || input->outpoint_txid == kZeroTxid) {
+                return false;
+            }
+            input->outpoint_txid = kZeroTxid;
+            return true;
+        case EditKind::kZeroVout:
+            if (!input || input->outpoint_vout == 0) {
+                return false;
+            }
+            input->outpoint_vout = 0;
+            return true;
+        case EditKind::kInputTypeOne:
+            if (!input || input->input_type == 1) {
+                return false;
+            }
+            input->input_type = 1;
+            return true;
+        case EditKind::kCanonicalPrivkey:
+            if (!input || input->privkey.empty() || input->privkey == kPrivkey) {
+                return false;
+            }
+            input->privkey = kPrivkey;
+            return true;
+        case EditKind::kCanonicalPubkey:
+            if (!input || input->pubkey.empty() || input->pubkey == kPubkey) {
+                return false;
+            }
+            input->pubkey = kPubkey;
+            return true;
+        case EditKind::kCanonicalScan:
+            if (c->scan_pubkey == kPubkey) {
+                return false;
+            }
+            c->scan_pubkey = kPubkey;
+            return true;
+        case EditKind::kCanonicalSpend:
+            if (c->spend_pubkey == kPubkey) {
+                return false;
+            }
+            c->spend_pubkey = kPubkey;
+            return true;
+        case EditKind::kZeroLabel:
+            if (edit.index >= c->labels.size() || c->labels[edit.index] == 0) {
+                return false;
+            }
+            c->labels[edit.index] = 0;
+            return true;
+    }
+    return false;
+}
+
+std::vector<Edit> ListEdits(const Case& c) {
+    std::vector<Edit> edits = {
+        {EditKind::kZeroSeed, 0},      {EditKind::kZeroOutputCount, 0},
+        {EditKind::kClearNegative, 0}, {EditKind::kDropPrivkeys, 0},
+        {EditKind::kDropPubkeys, 0},   {EditKind::kCanonicalScan, 0},
+        {EditKind::kCanonicalSpend, 0},
+    };
+    for (size_t i = 0; i < c.inputs.size(); ++i) {
+        edits.push_back({EditKind::kZeroTxid, i});
+        edits.push_back({EditKind::kZeroVout, i});
+        edits.push_back({EditKind::kInputTypeOne, i});
+        edits.push_back({EditKind::kCanonicalPrivkey, i});
+        edits.push_back({EditKind::kCanonicalPubkey, i});
+    }
+    for (size_t i = 0; i < c.labels.size(); ++i) {
+        edits.push_back({EditKind::kZeroLabel, i});
+    }
+    return edits;
+}
+
+// Tries every single-field simplification in one batch. When several are
+// kept, all of them are applied together if that combination is kept too;
+// otherwise only the first is taken and the rest are tried again next round.
+bool Simplify(Case* c, const BatchPredicate& predicate, ReduceStats* stats) {
+    bool changed = false;
+    std::vector<uint8_t> keep;
+    for (;;) {
+        std::vector<Edit> edits;
+        std::vector<std::vector<uint8_t>> encoded;
+        for (const Edit& edit : ListEdits(*c)) {
+            Case candidate = *c;
+            if (ApplyEdit(&candidate, edit)) {
+                edits.push_back(edit);
+                encoded.emplace_back();
+                SerializeCaseV1(candidate, &encoded.back());
+            }
+        }
+        size_t first = RunBatch(encoded, predicate, &keep, stats);
+        if (first >= encoded.size()) {
+            return changed;
+        }
+        changed = true;
+        ++stats->accepted;
+
+        size_t kept = std::count(keep.begin(), keep.end(), 1);
+        if (kept > 1) {
+            Case combined = *c;
+            for (size_t i = 0; i < edits.size(); ++i) {
+                if (keep[i]) {
+                    ApplyEdit(&combined, edits[i]);
+                }
+            }
+            std::vector<std::vector<uint8_t>> merged(1);
+            SerializeCaseV1(combined, &merged[0]);
+            std::vector<uint8_t> merged_keep;
+            if (RunBatch(merged, predicate, &merged_keep, stats) == 0) {
+                *c = std::move(combined);
+                continue;
+            }
+        }
+        ApplyEdit(c, edits[first]);
+    }
+}
+
+}  // namespace
+
+void MinimizeCase(Case* c, const BatchPredicate& predicate, ReduceStats* stats) {
+    ReduceStats local;
+    if (!stats) {
+        stats = &local;
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        changed |= Ddmin<InputSequence>(c, predicate, stats);
+        changed |= Ddmin<LabelSequence>(c, predicate, stats);
+        changed |= Simplify(c, predicate, stats);
+    }
+    c->header.input_count = static_cast<uint16_t>(c->inputs.size());
+}
+
+void MinimizeBytes(std::vector<uint8_t>* payload, const BatchPredicate& predicate,
+                   ReduceStats* stats) {
+    ReduceStats local;
+    Ddmin<ByteSequence>(payload, predicate, stats ? stats : &local);
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,43 @@
+#ifndef SP_DIFFER_CORE_REDUCE_H
+#define SP_DIFFER_CORE_REDUCE_H
+
+#include "case.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace sp_differ {
+
+// Tests a batch of encoded candidate cases and sets (*keep)[i] to 1 when
+// candidate i still shows the behaviour being minimized. keep arrives sized
+// to the batch and zeroed. Candidates within a batch are independent, so the
+// predicate is free to evaluate them in parallel.
+using BatchPredicate =
+    std::function<void(const std::vector<std::vector<uint8_t>>& candidates,
+                       std::vector<uint8_t>* keep)>;
+
+struct ReduceStats {
+    size_t batches = 0;
+    size_t candidates = 0;
+    size_t accepted = 0;
+};
+
+// Shrinks c while predicate keeps accepting it. Works on Case fields rather
+// than bytes, so every candidate parses: inputs and labels are removed by
+// delta debugging (all chunks at one granularity form one batch), then
+// fields are reset to canonical values (zero txids and vouts, input type 1,
+// private key 1, the generator point as every public key, no key material,
+// zero seed and output count). Repeats until a full sweep changes nothing.
+// The starting case is assumed to satisfy the predicate.
+void MinimizeCase(Case* c, const BatchPredicate& predicate, ReduceStats* stats);
+
+// Fallback for payloads that do not parse as a case: delta debugging over
+// the raw bytes.
+void MinimizeBytes(std::vector<uint8_t>* payload, const BatchPredicate& predicate,
+                   ReduceStats* stats);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_REDUCE_H
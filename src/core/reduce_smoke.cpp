@@ -0,0 +1,94 @@
+#include "case.h"
+#include "reduce.h"
+
+#include <iostream>
+
+namespace {
+
+// Stands in for a mismatch: needs an input spending vout 7 and the label 5.
+bool Interesting(const std::vector<uint8_t>& payload) {
+    sp_differ::CaseView view;
+    if (!sp_differ::ParseCaseViewV1(payload.data(), payload.size(), &view, nullptr)) {
+        return false;
+    }
+    bool vout = false;
+    for (size_t i = 0; i < view.header.input_count; ++i) {
+        vout |= sp_differ::GetInput(view, i).outpoint_vout == 7;
+    }
+    bool label = false;
+    for (size_t i = 0; i < view.label_count; ++i) {
+        label |= sp_differ::GetLabel(view, i) == 5;
+    }
+    return vout && label;
+}
+
+}  // namespace
+
+int main() {
+    sp_differ::Case c;
+    c.header.version = 1;
+    c.header.seed = 0x1234;
+    c.header.flags = 0x7;
+    c.header.output_count = 3;
+    for (uint32_t i = 0; i < 300; ++i) {
+        sp_differ::InputEntry input;
+        input.outpoint_txid.assign(sp_differ::kTxidSize, static_cast<uint8_t>(i));
+        input.outpoint_vout = i == 211 ? 7 : 1;
+        input.input_type = static_cast<uint8_t>(1 + i % 3);
+        input.privkey.assign(sp_differ::kPrivkeySize, 0x11);
+        input.pubkey.assign(sp_differ::kPubkeySize, 0x03);
+        c.inputs.push_back(input);
+    }
+    c.scan_pubkey.assign(sp_differ::kPubkeySize, 0x03);
+    c.spend_pubkey.assign(sp_differ::kPubkeySize, 0x02);
+    c.labels = {9, 8, 5, 3, 2, 1};
+
+    size_t evaluated = 0;
+    sp_differ::BatchPredicate predicate = [&](const std::vector<std::vector<uint8_t>>& candidates,
+                                              std::vector<uint8_t>* keep) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            (*keep)[i] = Interesting(candidates[i]) ? 1 : 0;
+            ++evaluated;
+        }
+    };
+    sp_differ::ReduceStats stats;
+    sp_differ::MinimizeCase(&c, predicate, &stats);
+
+    std::vector<uint8_t> payload;
+    sp_differ::SerializeCaseV1(c, &payload);
+    if (!Interesting(payload)) {
+        std::cerr << "FAIL: minimized case lost the behaviour" << std::endl;
+        return 2;
+    }
+    if (c.inputs.size() != 1 || c.labels.size() != 1 || c.header.flags != 0 ||
+        c.header.seed != 0 || c.header.output_count != 0 || c.inputs[0].input_type != 1 ||
+        c.inputs[0].outpoint_txid != std::vector<uint8_t>(sp_differ::kTxidSize, 0) ||
+        c.scan_pubkey[0] != 0x02 || c.scan_pubkey[1] != 0x79) {
+        std::cerr << "FAIL: case not fully minimized" << std::endl;
+        return 2;
+    }
+    if (stats.candidates != evaluated || stats.candidates > 2000) {
+        std::cerr << "FAIL: reducer evaluated " << stats.candidates << " candidates" << std::endl;
+        return 2;
+    }
+
+    std::vector<uint8_t> bytes(1000, 0x11);
+    bytes[637] = 0x5a;
+    bytes[901] = 0x5b;
+    sp_differ::BatchPredicate has_marker = [](const std::vector<std::vector<uint8_t>>& candidates,
+                                              std::vector<uint8_t>* keep) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            for (uint8_t b : candidates[i]) {
+                (*keep)[i] |= b == 0x5a;
+            }
+        }
+    };
+    sp_differ::MinimizeBytes(&bytes, has_marker, nullptr);
+    if (bytes != std::vector<uint8_t>{0x5a}) {
+        std::cerr << "FAIL: byte reducer left " << bytes.size() << " bytes" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: case reducer" << std::endl;
+    return 0;
+}
@@ -0,0 +1,405 @@
+#include "sha256.h"
+
+#include <atomic>
+#include <initializer_list>
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SP_DIFFER_SHA256_X86 1
+#include <immintrin.h>
+#else
+#define SP_DIFFER_SHA256_X86 0
+#endif
+
+namespace sp_differ {
+namespace {
+
+alignas(32) const uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2,
+};
+
+const uint32_t kInitialState[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+// States after compressing SHA256(tag) || SHA256(tag); sha256_smoke checks
+// them against Sha256InitTagged with the tag text.
+const uint32_t kInputsMidstate[8] = {0xd4143ffc, 0x012ea4b5, 0x36e21c8f, 0xf7ec7b54,
+                                     0x4dd4e2ac, 0x9bcaa0a4, 0xe244899b, 0xcd06903e};
+const uint32_t kSharedSecretMidstate[8] = {0x88831537, 0x5127079b, 0x69c2137b, 0xab0303e6,
+                                           0x98fa21fa, 0x4a888523, 0xbd99daab, 0xf25e5e0a};
+
+uint32_t Rotr(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+uint32_t LoadBe32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+void StoreBe32(uint32_t value, uint8_t* p) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+void CompressBlock(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = LoadBe32(block + 4 * i);
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = Rotr(w[i - 15], 7) ^ Rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = Rotr(w[i - 2], 17) ^ Rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t t1 = h + (Rotr(e, 6) ^ Rotr(e, 11) ^ Rotr(e, 25)) + ((e & f) ^ (~e & g)) +
+                      kRoundConstants[i] + w[i];
+        uint32_t t2 = (Rotr(a, 2) ^ Rotr(a, 13) ^ Rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void CompressScalar(uint32_t state[8], const uint8_t* blocks, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        CompressBlock(state, blocks + 64 * i);
+    }
+}
+
+#if SP_DIFFER_SHA256_X86
+// The SHA extensions keep the state as ABEF and CDGH halves; each
+// sha256rnds2 runs two rounds, and msg1 / msg2 extend the schedule four
+// words at a time.
+__attribute__((target("sha,sse4.1"))) void CompressShaNi(uint32_t state[8],
+                                                          const uint8_t* blocks, size_t count) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)),
+                                    0xb1);
+    __m128i state1 =
+        _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+    for (size_t block = 0; block < count; ++block) {
+        const __m128i* data = reinterpret_cast<const __m128i*>(blocks + 64 * block);
+        __m128i saved0 = state0;
+        __m128i saved1 = state1;
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i) {
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(data + i), byte_swap);
+        }
+        for (int g = 0; g < 16; ++g) {
+            __m128i words = _mm_add_epi32(
+                msg[g & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(kRoundConstants) + g));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, words);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(words, 0x0e));
+            if (g >= 3 && g <= 14) {
+                __m128i& next = msg[(g + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(msg[g & 3], msg[(g + 3) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, msg[g & 3]);
+            }
+            if (g >= 1 && g <= 12) {
+                msg[(g + 3) & 3] = _mm_sha256msg1_epu32(msg[(g + 3) & 3], msg[g & 3]);
+            }
+        }
+        state0 = _mm_add_epi32(state0, saved0);
+        state1 = _mm_add_epi32(state1, saved1);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(tmp, state1, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+}
+
+template <int kBits>
+__attribute__((target("avx2"))) inline __m256i Rotr8(__m256i x) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, kBits), _mm256_slli_epi32(x, 32 - kBits));
+}
+
+// Eight independent single-block hashes from one midstate, one message per
+// 32-bit lane. blocks holds the eight padded final blocks back to back.
+__attribute__((target("avx2"))) void FinalBlocksAvx2(const uint32_t midstate[8],
+                                                     const uint8_t* blocks, uint8_t* digests) {
+    const __m256i byte_swap =
+        _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+                         5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m256i lane_offsets = _mm256_setr_epi32(0, 64, 128, 192, 256, 320, 384, 448);
+    __m256i w[16];
+    for (int i = 0; i < 16; ++i) {
+        __m256i words =
+            _mm256_i32gather_epi32(reinterpret_cast<const int*>(blocks + 4 * i), lane_offsets, 1);
+        w[i] = _mm256_shuffle_epi8(words, byte_swap);
+    }
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i) {
+        v[i] = _mm256_set1_epi32(static_cast<int>(midstate[i]));
+    }
+    for (int i = 0; i < 64; ++i) {
+        if (i >= 16) {
+            __m256i w15 = w[(i - 15) & 15];
+            __m256i w2 = w[(i - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(Rotr8<7>(w15), Rotr8<18>(w15)),
+                                          _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(Rotr8<17>(w2), Rotr8<19>(w2)),
+                                          _mm256_srli_epi32(w2, 10));
+            w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0),
+                                         _mm256_add_epi32(w[(i - 7) & 15], s1));
+        }
+        __m256i a = v[0], b = v[1], c = v[2], e = v[4], f = v[5], g = v[6];
+        __m256i big_s1 =
+            _mm256_xor_si256(_mm256_xor_si256(Rotr8<6>(e), Rotr8<11>(e)), Rotr8<25>(e));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_add_epi32(v[7], big_s1), _mm256_add_epi32(ch, w[i & 15])),
+            _mm256_set1_epi32(static_cast<int>(kRoundConstants[i])));
+        __m256i big_s0 =
+            _mm256_xor_si256(_mm256_xor_si256(Rotr8<2>(a), Rotr8<13>(a)), Rotr8<22>(a));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b),
+                                      _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        v[7] = g;
+        v[6] = f;
+        v[5] = e;
+        v[4] = _mm256_add_epi32(v[3], t1);
+        v[3] = c;
+        v[2] = b;
+        v[1] = a;
+        v[0] = _mm256_add_epi32(t1, _mm256_add_epi32(big_s0, maj));
+    }
+    alignas(32) uint32_t words[8][8];
+    for (int i = 0; i < 8; ++i) {
+        v[i] = _mm256_add_epi32(v[i], _mm256_set1_epi32(static_cast<int>(midstate[i])));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), v[i]);
+    }
+    for (int lane = 0; lane < 8; ++lane) {
+        for (int i = 0; i < 8; ++i) {
+            StoreBe32(words[i][lane], digests + 32 * lane + 4 * i);
+        }
+    }
+}
+#endif
+
+using CompressFn = void (*)(uint32_t state[8], const uint8_t* blocks, size_t count);
+using FinalBlocks8Fn = void (*)(const uint32_t midstate[8], const uint8_t* blocks,
+                                uint8_t* digests);
+
+struct Engine {
+    Sha256Backend backend;
+    CompressFn compress;
+    // Eight single-block hashes at once, or null to go one block at a time.
+    FinalBlocks8Fn final_blocks8;
+};
+
+const Engine kScalarEngine = {Sha256Backend::kScalar, CompressScalar, nullptr};
+#if SP_DIFFER_SHA256_X86
+const Engine kAvx2Engine = {Sha256Backend::kAvx2, CompressScalar, FinalBlocksAvx2};
+// One SHA-NI block costs more than an eighth of an eight-lane AVX2 pass
+// (bench: tagged_hash_many), so batches still go through AVX2 when it is
+// there and SHA-NI takes single blocks and the leftovers.
+const Engine kShaNiEngine = {Sha256Backend::kShaNi, CompressShaNi, nullptr};
+const Engine kShaNiAvx2Engine = {Sha256Backend::kShaNi, CompressShaNi, FinalBlocksAvx2};
+#endif
+
+const Engine* EngineFor(Sha256Backend backend) {
+#if SP_DIFFER_SHA256_X86
+    __builtin_cpu_init();
+    if (backend == Sha256Backend::kShaNi && __builtin_cpu_supports("sha") &&
+        __builtin_cpu_supports("sse4.1")) {
+        return __builtin_cpu_supports("avx2") ? &kShaNiAvx2Engine : &kShaNiEngine;
+    }
+    if (backend == Sha256Backend::kAvx2 && __builtin_cpu_supports("avx2")) {
+        return &kAvx2Engine;
+    }
+#endif
+    return backend == Sha256Backend::kScalar ? &kScalarEngine : nullptr;
+}
+
+std::atomic<const Engine*>& ActiveEngine() {
+    static std::atomic<const Engine*> engine([] {
+        for (Sha256Backend backend : {Sha256Backend::kShaNi, Sha256Backend::kAvx2}) {
+            if (const Engine* found = EngineFor(backend)) {
+                return found;
+            }
+        }
+        return &kScalarEngine;
+    }());
+    return engine;
+}
+
+const Engine& CurrentEngine() {
+    return *ActiveEngine().load(std::memory_order_relaxed);
+}
+
+const uint32_t* Midstate(HashTag tag) {
+    return tag == HashTag::kBip352Inputs ? kInputsMidstate : kSharedSecretMidstate;
+}
+
+}  // namespace
+
+void Sha256Init(Sha256* sha) {
+    std::memcpy(sha->state, kInitialState, sizeof(kInitialState));
+    sha->length = 0;
+}
+
+void Sha256Update(Sha256* sha, const uint8_t* data, size_t len) {
+    size_t used = static_cast<size_t>(sha->length % 64);
+    sha->length += len;
+    if (used != 0) {
+        size_t take = len < 64 - used ? len : 64 - used;
+        std::memcpy(sha->buffer + used, data, take);
+        data += take;
+        len -= take;
+        if (used + take < 64) {
+            return;
+        }
+        CurrentEngine().compress(sha->state, sha->buffer, 1);
+    }
+    if (len >= 64) {
+        CurrentEngine().compress(sha->state, data, len / 64);
+        data += len & ~static_cast<size_t>(63);
+        len &= 63;
+    }
+    std::memcpy(sha->buffer, data, len);
+}
+
+void Sha256Final(Sha256* sha, uint8_t digest[32]) {
+    uint64_t bits = sha->length * 8;
+    uint8_t padding[72] = {0x80};
+    size_t used = static_cast<size_t>(sha->length % 64);
+    size_t pad = used < 56 ? 56 - used : 120 - used;
+    for (int i = 0; i < 8; ++i) {
+        padding[pad + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+    Sha256Update(sha, padding, pad + 8);
+    for (int i = 0; i < 8; ++i) {
+        StoreBe32(sha->state[i], digest + 4 * i);
+    }
+}
+
+void Sha256InitTagged(Sha256* sha, const char* tag) {
+    uint8_t tag_hash[32];
+    Sha256Init(sha);
+    Sha256Update(sha, reinterpret_cast<const uint8_t*>(tag), std::strlen(tag));
+    Sha256Final(sha, tag_hash);
+    Sha256Init(sha);
+    Sha256Update(sha, tag_hash, sizeof(tag_hash));
+    Sha256Update(sha, tag_hash, sizeof(tag_hash));
+}
+
+void Sha256InitTagged(Sha256* sha, HashTag tag) {
+    std::memcpy(sha->state, Midstate(tag), sizeof(sha->state));
+    sha->length = 64;
+}
+
+void TaggedHash(const char* tag, const uint8_t* data, size_t len, uint8_t digest[32]) {
+    Sha256 sha;
+    Sha256InitTagged(&sha, tag);
+    Sha256Update(&sha, data, len);
+    Sha256Final(&sha, digest);
+}
+
+void TaggedHash(HashTag tag, const uint8_t* data, size_t len, uint8_t digest[32]) {
+    Sha256 sha;
+    Sha256InitTagged(&sha, tag);
+    Sha256Update(&sha, data, len);
+    Sha256Final(&sha, digest);
+}
+
+void TaggedHashMany(HashTag tag, const uint8_t* messages, size_t message_len, size_t count,
+                    uint8_t* digests) {
+    if (message_len > 55) {
+        for (size_t i = 0; i < count; ++i) {
+            TaggedHash(tag, messages + i * message_len, message_len, digests + 32 * i);
+        }
+        return;
+    }
+    // Every message ends in the block after the midstate, so each lane's
+    // padding is the same and is written once; only the messages change.
+    const Engine& engine = CurrentEngine();
+    const uint32_t* midstate = Midstate(tag);
+    uint64_t bits = (64 + message_len) * 8;
+    uint8_t blocks[8 * 64] = {};
+    for (size_t lane = 0; lane < 8; ++lane) {
+        uint8_t* block = blocks + 64 * lane;
+        block[message_len] = 0x80;
+        for (int i = 0; i < 8; ++i) {
+            block[56 + i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        }
+    }
+    size_t i = 0;
+    if (engine.final_blocks8) {
+        for (; i + 8 <= count; i += 8) {
+            for (size_t lane = 0; lane < 8; ++lane) {
+                std::memcpy(blocks + 64 * lane, messages + (i + lane) * message_len, message_len);
+            }
+            engine.final_blocks8(midstate, blocks, digests + 32 * i);
+        }
+    }
+    for (; i < count; ++i) {
+        uint32_t state[8];
+        std::memcpy(state, midstate, sizeof(state));
+        std::memcpy(blocks, messages + i * message_len, message_len);
+        engine.compress(state, blocks, 1);
+        for (int word = 0; word < 8; ++word) {
+            StoreBe32(state[word], digests + 32 * i + 4 * word);
+        }
+    }
+}
+
+bool Sha256BackendSupported(Sha256Backend backend) {
+    return EngineFor(backend) != nullptr;
+}
+
+Sha256Backend Sha256ActiveBackend() {
+    return CurrentEngine().backend;
+}
+
+bool Sha256UseBackend(Sha256Backend backend) {
+    const Engine* engine = EngineFor(backend);
+    if (!engine) {
+        return false;
+    }
+    ActiveEngine().store(engine, std::memory_order_relaxed);
+    return true;
+}
+
+const char* Sha256BackendName(Sha256Backend backend) {
+    switch (backend) {
+        case Sha256Backend::kAvx2:
+            return "avx2";
+        case Sha256Backend::kShaNi:
+            return "sha-ni";
+        default:
+            return "scalar";
+    }
+}
+
+}  // namespace sp_differ
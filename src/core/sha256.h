@@ -0,0 +1,60 @@
+#ifndef SP_DIFFER_CORE_SHA256_H
+#define SP_DIFFER_CORE_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sp_differ {
+
+struct Sha256 {
+    uint32_t state[8];
+    uint8_t buffer[64];
+    uint64_t length = 0;
+};
+
+void Sha256Init(Sha256* sha);
+void Sha256Update(Sha256* sha, const uint8_t* data, size_t len);
+void Sha256Final(Sha256* sha, uint8_t digest[32]);
+
+// Tags whose midstates are compiled in, so their tagged hashes skip both
+// the tag hash and the first compression.
+enum class HashTag {
+    kBip352Inputs,        // "BIP0352/Inputs"
+    kBip352SharedSecret,  // "BIP0352/SharedSecret"
+};
+
+// Starts a tagged hash: sha holds SHA256(tag) || SHA256(tag) afterwards.
+void Sha256InitTagged(Sha256* sha, const char* tag);
+void Sha256InitTagged(Sha256* sha, HashTag tag);
+
+// BIP340 tagged hash: SHA256(SHA256(tag) || SHA256(tag) || data).
+void TaggedHash(const char* tag, const uint8_t* data, size_t len, uint8_t digest[32]);
+void TaggedHash(HashTag tag, const uint8_t* data, size_t len, uint8_t digest[32]);
+
+// Tagged hashes of count messages of message_len bytes each, stored back to
+// back; digest i goes to digests + 32 * i. Messages of up to 55 bytes fit
+// in the one block after the midstate, and those are hashed several at a
+// time when the backend allows it.
+void TaggedHashMany(HashTag tag, const uint8_t* messages, size_t message_len, size_t count,
+                    uint8_t* digests);
+
+// Compression backends. The default is the fastest one the CPU supports:
+// SHA-NI, then AVX2, then portable scalar code. AVX2 only speeds up
+// TaggedHashMany, eight messages per pass; SHA-NI uses it there too when
+// the CPU has both.
+enum class Sha256Backend {
+    kScalar,
+    kAvx2,
+    kShaNi,
+};
+
+bool Sha256BackendSupported(Sha256Backend backend);
+Sha256Backend Sha256ActiveBackend();
+// Switches every later hash to backend; false, with nothing changed, when
+// the CPU lacks it. For tests and benchmarks.
+bool Sha256UseBackend(Sha256Backend backend);
+const char* Sha256BackendName(Sha256Backend backend);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_SHA256_H
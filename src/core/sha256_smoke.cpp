@@ -0,0 +1,169 @@
+#include "sha256.h"
+
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string Hex(const uint8_t* data, size_t len) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string text;
+    for (size_t i = 0; i < len; ++i) {
+        text += kDigits[data[i] >> 4];
+        text += kDigits[data[i] & 15];
+    }
+    return text;
+}
+
+const uint8_t* Bytes(const std::string& text) {
+    return reinterpret_cast<const uint8_t*>(text.data());
+}
+
+std::string Sha256Hex(const std::string& message) {
+    sp_differ::Sha256 sha;
+    uint8_t digest[32];
+    sp_differ::Sha256Init(&sha);
+    sp_differ::Sha256Update(&sha, Bytes(message), message.size());
+    sp_differ::Sha256Final(&sha, digest);
+    return Hex(digest, sizeof(digest));
+}
+
+// The same message fed one byte at a time, which exercises the buffered
+// path of Sha256Update.
+std::string Sha256BytewiseHex(const std::string& message) {
+    sp_differ::Sha256 sha;
+    uint8_t digest[32];
+    sp_differ::Sha256Init(&sha);
+    for (size_t i = 0; i < message.size(); ++i) {
+        sp_differ::Sha256Update(&sha, Bytes(message) + i, 1);
+    }
+    sp_differ::Sha256Final(&sha, digest);
+    return Hex(digest, sizeof(digest));
+}
+
+bool Expect(const std::string& what, const std::string& got, const std::string& want) {
+    if (got != want) {
+        std::cerr << "FAIL: " << what << ": got " << got << ", want " << want << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool CheckBackend(sp_differ::Sha256Backend backend) {
+    const std::string name = sp_differ::Sha256BackendName(backend);
+    // FIPS 180-2 examples plus the one-million-'a' message.
+    struct Vector {
+        std::string message;
+        const char* digest;
+    };
+    const Vector vectors[] = {
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+         "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+        {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqr"
+         "lmnopqrsmnopqrstnopqrstu",
+         "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+        {std::string(1000000, 'a'),
+         "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+    };
+    for (const Vector& vector : vectors) {
+        std::string what = name + " sha256 of " + std::to_string(vector.message.size()) + " bytes";
+        if (!Expect(what, Sha256Hex(vector.message), vector.digest)) {
+            return false;
+        }
+        if (vector.message.size() < 1000 &&
+            !Expect(what + " bytewise", Sha256BytewiseHex(vector.message), vector.digest)) {
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> message(128);
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<uint8_t>(i);
+    }
+    uint8_t digest[32];
+    sp_differ::TaggedHash(sp_differ::HashTag::kBip352SharedSecret, message.data(), 37, digest);
+    if (!Expect(name + " shared secret tag", Hex(digest, sizeof(digest)),
+                "91aaaffdc46069761c1e5921b8b971aa595a1cd948c559f54236c709221cfbe6")) {
+        return false;
+    }
+    sp_differ::TaggedHash(sp_differ::HashTag::kBip352Inputs, message.data(), 69, digest);
+    if (!Expect(name + " inputs tag", Hex(digest, sizeof(digest)),
+                "dc395afa6d399bf7dd7d3f4f03930668b3f381db012dff8112316bf09a203bcc")) {
+        return false;
+    }
+
+    // Batches around the eight-lane width, at the one-block limit of 55
+    // bytes and past it, must match hashing each message on its own.
+    const std::vector<uint8_t>& pool = message;
+    for (size_t len : {0u, 1u, 37u, 55u, 56u, 100u}) {
+        for (size_t count = 0; count <= 17; ++count) {
+            std::vector<uint8_t> messages(len * count);
+            for (size_t i = 0; i < messages.size(); ++i) {
+                messages[i] = static_cast<uint8_t>(pool[i % pool.size()] * 7 + i / 64);
+            }
+            std::vector<uint8_t> digests(32 * count);
+            sp_differ::TaggedHashMany(sp_differ::HashTag::kBip352SharedSecret, messages.data(),
+                                      len, count, digests.data());
+            for (size_t i = 0; i < count; ++i) {
+                sp_differ::TaggedHash("BIP0352/SharedSecret", messages.data() + i * len, len,
+                                      digest);
+                if (!Expect(name + " batch of " + std::to_string(count) + " x " +
+                                std::to_string(len) + " bytes, message " + std::to_string(i),
+                            Hex(digests.data() + 32 * i, 32), Hex(digest, sizeof(digest)))) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    // The compiled-in midstates are the tag prefixes they stand for.
+    struct Tag {
+        sp_differ::HashTag tag;
+        const char* text;
+    };
+    const Tag tags[] = {
+        {sp_differ::HashTag::kBip352Inputs, "BIP0352/Inputs"},
+        {sp_differ::HashTag::kBip352SharedSecret, "BIP0352/SharedSecret"},
+    };
+    for (const Tag& tag : tags) {
+        sp_differ::Sha256 computed;
+        sp_differ::Sha256 precomputed;
+        sp_differ::Sha256InitTagged(&computed, tag.text);
+        sp_differ::Sha256InitTagged(&precomputed, tag.tag);
+        if (std::memcmp(computed.state, precomputed.state, sizeof(computed.state)) != 0 ||
+            computed.length != precomputed.length) {
+            std::cerr << "FAIL: midstate of " << tag.text << std::endl;
+            return 2;
+        }
+    }
+
+    const sp_differ::Sha256Backend active = sp_differ::Sha256ActiveBackend();
+    std::string checked;
+    for (sp_differ::Sha256Backend backend :
+         {sp_differ::Sha256Backend::kScalar, sp_differ::Sha256Backend::kAvx2,
+          sp_differ::Sha256Backend::kShaNi}) {
+        if (!sp_differ::Sha256UseBackend(backend)) {
+            continue;
+        }
+        if (!CheckBackend(backend)) {
+            return 2;
+        }
+        checked += checked.empty() ? "" : ",";
+        checked += sp_differ::Sha256BackendName(backend);
+    }
+    sp_differ::Sha256UseBackend(active);
+
+    std::cout << "OK: sha256 (" << checked << "; default "
+              << sp_differ::Sha256BackendName(active) << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "signature.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+constexpr size_t kOutputHeaderSize = 4;
+constexpr size_t kOutputPubkeySize = 33;
+constexpr size_t kTweakSize = 32;
+
+int StatusOf(const uint8_t* output, size_t len) {
+    return len >= 2 ? output[1] : -1;
+}
+
+size_t ShardOf(uint64_t key) {
+    // The key's low bits are the status pair, which few signatures vary in,
+    // so mix before picking a shard.
+    key ^= key >> 29;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 32;
+    return static_cast<size_t>(key % kSignatureShards);
+}
+
+}  // namespace
+
+const char* DiffFieldName(DiffField field) {
+    switch (field) {
+        case DiffField::kVersion:
+            return "version";
+        case DiffField::kStatus:
+            return "status";
+        case DiffField::kOutputCount:
+            return "output_count";
+        case DiffField::kPubkey:
+            return "pubkey";
+        case DiffField::kTweak:
+            return "tweak";
+        case DiffField::kLength:
+            return "length";
+        case DiffField::kRecord:
+            return "record";
+    }
+    return "unknown";
+}
+
+bool ClassifyMismatch(const uint8_t* left, size_t left_len, const uint8_t* right,
+                      size_t right_len, MismatchSignature* out) {
+    size_t min_len = std::min(left_len, right_len);
+    size_t i = 0;
+    while (i < min_len && left[i] == right[i]) {
+        ++i;
+    }
+    if (i == min_len && left_len == right_len) {
+        return false;
+    }
+
+    MismatchSignature signature;
+    signature.left_status = StatusOf(left, left_len);
+    signature.right_status = StatusOf(right, right_len);
+    if (i == min_len) {
+        signature.field = DiffField::kLength;
+    } else if (i == 0) {
+        signature.field = DiffField::kVersion;
+    } else if (i == 1) {
+        signature.field = DiffField::kStatus;
+    } else if (i < kOutputHeaderSize) {
+        signature.field = DiffField::kOutputCount;
+    } else {
+        // Both counts match here, and the payload holds every pubkey before
+        // any tweak.
+        size_t count = static_cast<size_t>(left[2]) | (static_cast<size_t>(left[3]) << 8);
+        size_t offset = i - kOutputHeaderSize;
+        if (offset < count * kOutputPubkeySize) {
+            signature.field = DiffField::kPubkey;
+            signature.output_index = static_cast<uint32_t>(offset / kOutputPubkeySize);
+        } else {
+            signature.field = DiffField::kTweak;
+            signature.output_index =
+                static_cast<uint32_t>((offset - count * kOutputPubkeySize) / kTweakSize);
+        }
+    }
+    *out = signature;
+    return true;
+}
+
+uint64_t SignatureKey(const MismatchSignature& signature) {
+    // Statuses are a byte or -1, stored offset by one in 9 bits each. The top
+    // bit keeps every key nonzero so reports can use 0 for "none".
+    return (1ull << 63) | static_cast<uint64_t>(signature.left_status + 1) |
+           (static_cast<uint64_t>(signature.right_status + 1) << 9) |
+           (static_cast<uint64_t>(signature.field) << 18) |
+           (static_cast<uint64_t>(signature.output_index) << 24);
+}
+
+std::string FormatMismatchSignature(const MismatchSignature& signature) {
+    std::string text = "status=" + std::to_string(signature.left_status) + "/" +
+                       std::to_string(signature.right_status) +
+                       " field=" + DiffFieldName(signature.field);
+    if (signature.field == DiffField::kPubkey || signature.field == DiffField::kTweak ||
+        signature.field == DiffField::kRecord) {
+        text += " output=" + std::to_string(signature.output_index);
+    }
+    return text;
+}
+
+SignatureTable::SignatureTable(size_t exemplar_limit)
+    : exemplar_limit(exemplar_limit), shards(new Shard[kSignatureShards]) {}
+
+bool RecordMismatch(SignatureTable* table, const MismatchSignature& signature,
+                    const std::string& case_name, uint64_t case_hash) {
+    uint64_t key = SignatureKey(signature);
+    SignatureTable::Shard& shard = table->shards[ShardOf(key)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    SignatureCount& entry = shard.entries[key];
+    if (entry.hits++ == 0) {
+        entry.signature = signature;
+    }
+    if (entry.exemplars.size() >= table->exemplar_limit) {
+        return false;
+    }
+    entry.exemplars.push_back({case_name, case_hash});
+    return true;
+}
+
+std::vector<SignatureCount> SnapshotSignatures(SignatureTable* table) {
+    std::vector<SignatureCount> counts;
+    for (size_t i = 0; i < kSignatureShards; ++i) {
+        std::lock_guard<std::mutex> lock(table->shards[i].mutex);
+        for (const auto& entry : table->shards[i].entries) {
+            counts.push_back(entry.second);
+        }
+    }
+    std::sort(counts.begin(), counts.end(), [](const SignatureCount& a, const SignatureCount& b) {
+        if (a.hits != b.hits) {
+            return a.hits > b.hits;
+        }
+        return SignatureKey(a.signature) < SignatureKey(b.signature);
+    });
+    return counts;
+}
+
+}  // namespace sp_differ
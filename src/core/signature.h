@@ -0,0 +1,95 @@
+#ifndef SP_DIFFER_CORE_SIGNATURE_H
+#define SP_DIFFER_CORE_SIGNATURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace sp_differ {
+
+// Where two v1 outputs first differ.
+enum class DiffField : uint8_t {
+    kVersion,
+    kStatus,
+    kOutputCount,
+    kPubkey,
+    kTweak,
+    // One output is a strict prefix of the other.
+    kLength,
+    // A whole record (pubkey and tweak) held by one output only: past the
+    // end of the other in ordered diffs, without a partner in unordered ones.
+    kRecord,
+};
+
+const char* DiffFieldName(DiffField field);
+
+// Compact description of a mismatch that stays the same across cases hitting
+// the same divergence: the two status bytes, the field class of the first
+// differing byte, and for pubkey/tweak differences the output index.
+struct MismatchSignature {
+    int left_status = -1;
+    int right_status = -1;
+    DiffField field = DiffField::kLength;
+    // Index into output_pubkeys or tweaks, or the record index; 0 for header
+    // and length classes.
+    uint32_t output_index = 0;
+
+    bool operator==(const MismatchSignature& other) const {
+        return left_status == other.left_status && right_status == other.right_status &&
+               field == other.field && output_index == other.output_index;
+    }
+};
+
+// Classifies two validated v1 outputs. Returns false when they are equal.
+bool ClassifyMismatch(const uint8_t* left, size_t left_len, const uint8_t* right,
+                      size_t right_len, MismatchSignature* out);
+
+// Nonzero 64-bit key; distinct signatures always get distinct keys.
+uint64_t SignatureKey(const MismatchSignature& signature);
+
+// e.g. "status=0/0 field=tweak output=2".
+std::string FormatMismatchSignature(const MismatchSignature& signature);
+
+struct SignatureExemplar {
+    std::string case_name;
+    uint64_t case_hash = 0;
+};
+
+struct SignatureCount {
+    MismatchSignature signature;
+    uint64_t hits = 0;
+    std::vector<SignatureExemplar> exemplars;
+};
+
+// Concurrent signature -> count table, split into independently locked
+// shards so threads recording different signatures rarely contend. Only the
+// first exemplar_limit cases of each signature are kept.
+struct SignatureTable {
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, SignatureCount> entries;
+    };
+
+    explicit SignatureTable(size_t exemplar_limit);
+
+    size_t exemplar_limit;
+    std::unique_ptr<Shard[]> shards;
+};
+
+constexpr size_t kSignatureShards = 32;
+
+// Counts one hit and returns true when the case was kept as an exemplar,
+// which is the caller's cue to store an artifact for it.
+bool RecordMismatch(SignatureTable* table, const MismatchSignature& signature,
+                    const std::string& case_name, uint64_t case_hash);
+
+// Every signature seen so far, most hits first.
+std::vector<SignatureCount> SnapshotSignatures(SignatureTable* table);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_SIGNATURE_H
@@ -0,0 +1,111 @@
+#include "signature.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A status-ok v1 output with count outputs; pubkeys then tweaks.
+std::vector<uint8_t> MakeOutput(uint8_t status, uint16_t count) {
+    std::vector<uint8_t> output = {1, status, static_cast<uint8_t>(count & 0xff),
+                                   static_cast<uint8_t>(count >> 8)};
+    output.resize(4 + count * (33 + 32), 0x11);
+    return output;
+}
+
+bool Classify(const std::vector<uint8_t>& left, const std::vector<uint8_t>& right,
+              sp_differ::MismatchSignature* signature) {
+    return sp_differ::ClassifyMismatch(left.data(), left.size(), right.data(), right.size(),
+                                       signature);
+}
+
+}  // namespace
+
+int main() {
+    sp_differ::MismatchSignature signature;
+    std::vector<uint8_t> left = MakeOutput(0, 3);
+    std::vector<uint8_t> right = left;
+    if (Classify(left, right, &signature)) {
+        std::cerr << "FAIL: equal outputs classified as a mismatch" << std::endl;
+        return 2;
+    }
+
+    // Second pubkey differs.
+    right[4 + 33 + 5] ^= 1;
+    if (!Classify(left, right, &signature) || signature.field != sp_differ::DiffField::kPubkey ||
+        signature.output_index != 1 || signature.left_status != 0 ||
+        signature.right_status != 0) {
+        std::cerr << "FAIL: pubkey mismatch misclassified" << std::endl;
+        return 2;
+    }
+
+    // Third tweak differs; a different byte of the same tweak keys the same.
+    right = left;
+    right[4 + 3 * 33 + 2 * 32] ^= 1;
+    sp_differ::MismatchSignature other;
+    std::vector<uint8_t> right_other = left;
+    right_other[4 + 3 * 33 + 2 * 32 + 31] ^= 1;
+    if (!Classify(left, right, &signature) || signature.field != sp_differ::DiffField::kTweak ||
+        signature.output_index != 2 || !Classify(left, right_other, &other) ||
+        sp_differ::SignatureKey(signature) != sp_differ::SignatureKey(other)) {
+        std::cerr << "FAIL: tweak mismatch misclassified" << std::endl;
+        return 2;
+    }
+
+    std::vector<uint8_t> invalid = {1, 1, 0, 0};
+    if (!Classify(invalid, left, &signature) || signature.field != sp_differ::DiffField::kStatus ||
+        signature.left_status != 1 || signature.right_status != 0) {
+        std::cerr << "FAIL: status mismatch misclassified" << std::endl;
+        return 2;
+    }
+    if (!Classify(MakeOutput(0, 1), left, &signature) ||
+        signature.field != sp_differ::DiffField::kOutputCount) {
+        std::cerr << "FAIL: count mismatch misclassified" << std::endl;
+        return 2;
+    }
+    std::vector<uint8_t> truncated(left.begin(), left.end() - 1);
+    if (!Classify(truncated, left, &signature) ||
+        signature.field != sp_differ::DiffField::kLength) {
+        std::cerr << "FAIL: length mismatch misclassified" << std::endl;
+        return 2;
+    }
+
+    // Many threads hitting two signatures: every hit is counted and each
+    // signature keeps exactly exemplar_limit exemplars.
+    sp_differ::MismatchSignature status_signature;
+    sp_differ::MismatchSignature tweak_signature;
+    Classify(invalid, left, &status_signature);
+    Classify(left, right, &tweak_signature);
+    sp_differ::SignatureTable table(3);
+    const int kThreads = 4;
+    const int kHits = 1000;
+    std::vector<std::thread> threads;
+    std::vector<int> kept(kThreads, 0);
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kHits; ++i) {
+                const sp_differ::MismatchSignature& hit =
+                    i % 4 == 0 ? tweak_signature : status_signature;
+                kept[t] += sp_differ::RecordMismatch(&table, hit, "case", i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::vector<sp_differ::SignatureCount> counts = sp_differ::SnapshotSignatures(&table);
+    int total_kept = 0;
+    for (int count : kept) {
+        total_kept += count;
+    }
+    if (counts.size() != 2 || !(counts[0].signature == status_signature) ||
+        counts[0].hits != kThreads * kHits * 3 / 4 || counts[1].hits != kThreads * kHits / 4 ||
+        counts[0].exemplars.size() != 3 || counts[1].exemplars.size() != 3 || total_kept != 6) {
+        std::cerr << "FAIL: signature table counts" << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: mismatch signatures" << std::endl;
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "stream.h"
+
+#include "io.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace sp_differ {
+namespace {
+
+constexpr size_t kStreamBufferSize = 64u << 10;
+// A hex line holds two digits per byte plus some whitespace.
+constexpr size_t kMaxHexLineSize = 2 * kMaxStreamCaseSize + 4096;
+
+// Moves unread bytes to the front and reads more behind them.
+void Refill(CaseStream* stream) {
+    if (stream->begin > 0) {
+        std::memmove(stream->buffer.data(), stream->buffer.data() + stream->begin,
+                     stream->end - stream->begin);
+        stream->end -= stream->begin;
+        stream->begin = 0;
+    }
+    size_t room = stream->buffer.size() - stream->end;
+    if (room == 0 || stream->eof) {
+        return;
+    }
+    size_t got = std::fread(stream->buffer.data() + stream->end, 1, room, stream->file);
+    stream->end += got;
+    if (got == 0) {
+        stream->eof = true;
+    }
+}
+
+size_t Available(const CaseStream& stream) {
+    return stream.end - stream.begin;
+}
+
+// Returns true once at least count bytes are buffered; count must not exceed
+// the buffer size.
+bool EnsureAvailable(CaseStream* stream, size_t count) {
+    while (Available(*stream) < count && !stream->eof) {
+        Refill(stream);
+    }
+    return Available(*stream) >= count;
+}
+
+bool SetError(std::string* error, const CaseStream& stream, const char* message) {
+    if (error) {
+        *error = "stream case " + std::to_string(stream.cases_read) + ": " + message;
+    }
+    return false;
+}
+
+bool NextFramedCase(CaseStream* stream, std::vector<uint8_t>* payload, std::string* error) {
+    if (!EnsureAvailable(stream, 1)) {
+        return false;
+    }
+    if (!EnsureAvailable(stream, 4)) {
+        return SetError(error, *stream, "truncated length prefix");
+    }
+    const uint8_t* prefix = stream->buffer.data() + stream->begin;
+    uint32_t len = static_cast<uint32_t>(prefix[0]) | (static_cast<uint32_t>(prefix[1]) << 8) |
+                   (static_cast<uint32_t>(prefix[2]) << 16) |
+                   (static_cast<uint32_t>(prefix[3]) << 24);
+    stream->begin += 4;
+    if (len > kMaxStreamCaseSize) {
+        return SetError(error, *stream, "case too large");
+    }
+
+    payload->resize(len);
+    size_t buffered = Available(*stream) < len ? Available(*stream) : len;
+    std::memcpy(payload->data(), stream->buffer.data() + stream->begin, buffered);
+    stream->begin += buffered;
+    // Large payloads bypass the refill buffer and land in place.
+    size_t copied = buffered;
+    while (copied < len && !stream->eof) {
+        size_t got = std::fread(payload->data() + copied, 1, len - copied, stream->file);
+        copied += got;
+        if (got == 0) {
+            stream->eof = true;
+        }
+    }
+    if (copied < len) {
+        return SetError(error, *stream, "truncated case");
+    }
+    ++stream->cases_read;
+    return true;
+}
+
+bool IsBlankOrComment(const uint8_t* line, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (line[i] == '#') {
+            return true;
+        }
+        if (line[i] != ' ' && (line[i] < '\t' || line[i] > '\r')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NextHexCase(CaseStream* stream, std::vector<uint8_t>* payload, std::string* error) {
+    for (;;) {
+        // Find the end of the next line. A line that fits in the buffer is
+        // decoded in place; a longer one is gathered into stream->record.
+        stream->record.clear();
+        const uint8_t* line = nullptr;
+        size_t line_len = 0;
+        for (;;) {
+            const uint8_t* start = stream->buffer.data() + stream->begin;
+            const void* newline = std::memchr(start, '\n', Available(*stream));
+            if (newline) {
+                size_t len = static_cast<const uint8_t*>(newline) - start;
+                if (stream->record.empty()) {
+                    line = start;
+                    line_len = len;
+                } else {
+                    stream->record.insert(stream->record.end(), start, start + len);
+                }
+                stream->begin += len + 1;
+                break;
+            }
+            if (stream->eof) {
+                if (stream->record.empty()) {
+                    line = start;
+                    line_len = Available(*stream);
+                } else {
+                    stream->record.insert(stream->record.end(), start, start + Available(*stream));
+                }
+                stream->begin = stream->end;
+                break;
+            }
+            if (Available(*stream) == stream->buffer.size()) {
+                if (stream->record.size() + Available(*stream) > kMaxHexLineSize) {
+                    return SetError(error, *stream, "case line too long");
+                }
+                stream->record.insert(stream->record.end(), start, start + Available(*stream));
+                stream->begin = stream->end;
+            }
+            Refill(stream);
+        }
+        if (!line) {
+            line = stream->record.data();
+            line_len = stream->record.size();
+        }
+
+        if (IsBlankOrComment(line, line_len)) {
+            if (stream->eof && Available(*stream) == 0) {
+                return false;
+            }
+            continue;
+        }
+        if (!DecodeHex(line, line_len, payload, nullptr)) {
+            return SetError(error, *stream, "invalid hex encoding");
+        }
+        ++stream->cases_read;
+        return true;
+    }
+}
+
+}  // namespace
+
+bool ParseStreamFraming(const std::string& name, StreamFraming* out) {
+    if (name == "auto") {
+        *out = StreamFraming::kAuto;
+    } else if (name == "binary") {
+        *out = StreamFraming::kLengthPrefixed;
+    } else if (name == "hex") {
+        *out = StreamFraming::kHexLines;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool OpenCaseStream(const std::string& path, StreamFraming framing, CaseStream* stream,
+                    std::string* error) {
+    CloseCaseStream(stream);
+    if (path == "-") {
+#if defined(_WIN32)
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        stream->file = stdin;
+        stream->owns_file = false;
+    } else {
+        stream->file = std::fopen(path.c_str(), "rb");
+        if (!stream->file) {
+            *error = "unable to open case stream";
+            return false;
+        }
+        stream->owns_file = true;
+    }
+    stream->framing = framing;
+    stream->buffer.resize(kStreamBufferSize);
+    stream->begin = 0;
+    stream->end = 0;
+    stream->eof = false;
+    stream->cases_read = 0;
+    return true;
+}
+
+void CloseCaseStream(CaseStream* stream) {
+    if (stream->file && stream->owns_file) {
+        std::fclose(stream->file);
+    }
+    stream->file = nullptr;
+    stream->owns_file = false;
+}
+
+bool NextStreamCase(CaseStream* stream, std::vector<uint8_t>* payload, std::string* error) {
+    if (error) {
+        error->clear();
+    }
+    if (!stream->file) {
+        return SetError(error, *stream, "stream is not open");
+    }
+    if (stream->framing == StreamFraming::kAuto) {
+        // Needs four bytes; a shorter stream can only be hex (or empty).
+        EnsureAvailable(stream, 4);
+        bool framed = Available(*stream) >= 4 && stream->buffer[stream->begin + 3] == 0;
+        stream->framing = framed ? StreamFraming::kLengthPrefixed : StreamFraming::kHexLines;
+    }
+    if (stream->framing == StreamFraming::kLengthPrefixed) {
+        return NextFramedCase(stream, payload, error);
+    }
+    return NextHexCase(stream, payload, error);
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,52 @@
+#ifndef SP_DIFFER_CORE_STREAM_H
+#define SP_DIFFER_CORE_STREAM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+
+enum class StreamFraming {
+    // Length-prefixed when the fourth byte of the stream is zero (a u32
+    // length below 16 MiB), newline-delimited hex otherwise.
+    kAuto,
+    // Each case is a u32 little-endian length followed by that many bytes.
+    kLengthPrefixed,
+    // One hex-encoded case per line; blank lines and '#' comments are skipped.
+    kHexLines,
+};
+
+// Largest case a stream accepts, which bounds the reader's memory use.
+constexpr size_t kMaxStreamCaseSize = 16u << 20;
+
+// Reads successive cases from a file, pipe, or stdin through a fixed-size
+// refill buffer, so memory stays bounded however long the stream runs.
+struct CaseStream {
+    std::FILE* file = nullptr;
+    bool owns_file = false;
+    StreamFraming framing = StreamFraming::kAuto;
+    std::vector<uint8_t> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    bool eof = false;
+    // Holds a record that straddles refills.
+    std::vector<uint8_t> record;
+    uint64_t cases_read = 0;
+};
+
+// path "-" reads stdin.
+bool OpenCaseStream(const std::string& path, StreamFraming framing, CaseStream* stream,
+                    std::string* error);
+void CloseCaseStream(CaseStream* stream);
+
+// Reads the next case into payload. Returns false at the end of the stream
+// with error cleared, or on a read or framing error with error set.
+bool NextStreamCase(CaseStream* stream, std::vector<uint8_t>* payload, std::string* error);
+
+bool ParseStreamFraming(const std::string& name, StreamFraming* out);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_STREAM_H
@@ -0,0 +1,80 @@
+#include "io.h"
+#include "stream.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+bool ReadAll(const std::string& path, sp_differ::StreamFraming framing,
+             std::vector<std::vector<uint8_t>>* cases, std::string* error) {
+    sp_differ::CaseStream stream;
+    if (!sp_differ::OpenCaseStream(path, framing, &stream, error)) {
+        return false;
+    }
+    cases->clear();
+    std::vector<uint8_t> payload;
+    while (sp_differ::NextStreamCase(&stream, &payload, error)) {
+        cases->push_back(payload);
+    }
+    sp_differ::CloseCaseStream(&stream);
+    return error->empty();
+}
+
+}  // namespace
+
+int main() {
+    std::string error;
+    std::vector<uint8_t> example;
+    if (!sp_differ::ReadCasePayload("tests/vectors/example.hex", &example, &error)) {
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+    }
+    // Longer than the refill buffer once hex encoded.
+    std::vector<uint8_t> large(50000);
+    for (size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<uint8_t>(i * 31);
+    }
+
+    static const char kDigits[] = "0123456789abcdef";
+    const std::string hex_path = "build/sp_differ_core_stream_smoke.hex";
+    {
+        std::ofstream file(hex_path, std::ios::binary | std::ios::trunc);
+        file << "# two cases\n\n";
+        for (const std::vector<uint8_t>* payload : {&example, &large}) {
+            for (uint8_t byte : *payload) {
+                file << kDigits[byte >> 4] << kDigits[byte & 0x0f];
+            }
+            file << "\r\n";
+        }
+    }
+    std::vector<std::vector<uint8_t>> cases;
+    if (!ReadAll(hex_path, sp_differ::StreamFraming::kAuto, &cases, &error) ||
+        cases.size() != 2 || cases[0] != example || cases[1] != large) {
+        std::cerr << "FAIL: hex line stream " << error << std::endl;
+        return 2;
+    }
+
+    const std::string framed_path = "build/sp_differ_core_stream_smoke.bin";
+    {
+        std::ofstream file(framed_path, std::ios::binary | std::ios::trunc);
+        for (const std::vector<uint8_t>* payload : {&large, &example, &example}) {
+            uint32_t len = static_cast<uint32_t>(payload->size());
+            for (int i = 0; i < 4; ++i) {
+                file.put(static_cast<char>(len >> (8 * i)));
+            }
+            file.write(reinterpret_cast<const char*>(payload->data()),
+                       static_cast<std::streamsize>(payload->size()));
+        }
+        file.put(5);
+    }
+    if (ReadAll(framed_path, sp_differ::StreamFraming::kAuto, &cases, &error) ||
+        cases.size() != 3 || cases[0] != large || cases[2] != example ||
+        error.find("truncated length prefix") == std::string::npos) {
+        std::cerr << "FAIL: length-prefixed stream " << error << std::endl;
+        return 2;
+    }
+
+    std::cout << "OK: case stream" << std::endl;
+    return 0;
+}
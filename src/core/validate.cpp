@@ -7,8 +7,8 @@
 namespace sp_differ {
 namespace {
 
-bool ReadU8(const std::vector<uint8_t>& buf, size_t* off, uint8_t* out) {
-    if (*off + 1 > buf.size()) {
+bool ReadU8(const uint8_t* buf, size_t len, size_t* off, uint8_t* out) {
+    if (*off + 1 > len) {
         return false;
     }
     *out = buf[*off];
@@ -16,8 +16,8 @@ bool ReadU8(const std::vector<uint8_t>& buf, size_t* off, uint8_t* out) {
     return true;
 }
 
-bool ReadU16(const std::vector<uint8_t>& buf, size_t* off, uint16_t* out) {
-    if (*off + 2 > buf.size()) {
+bool ReadU16(const uint8_t* buf, size_t len, size_t* off, uint16_t* out) {
+    if (*off + 2 > len) {
         return false;
     }
     *out = static_cast<uint16_t>(buf[*off] | (static_cast<uint16_t>(buf[*off + 1]) << 8));
@@ -25,8 +25,8 @@ bool ReadU16(const std::vector<uint8_t>& buf, size_t* off, uint16_t* out) {
     return true;
 }
 
-bool ReadU32(const std::vector<uint8_t>& buf, size_t* off, uint32_t* out) {
-    if (*off + 4 > buf.size()) {
+bool ReadU32(const uint8_t* buf, size_t len, size_t* off, uint32_t* out) {
+    if (*off + 4 > len) {
         return false;
     }
     *out = static_cast<uint32_t>(buf[*off]) |
@@ -37,8 +37,8 @@ bool ReadU32(const std::vector<uint8_t>& buf, size_t* off, uint32_t* out) {
     return true;
 }
 
-bool ReadU64(const std::vector<uint8_t>& buf, size_t* off, uint64_t* out) {
-    if (*off + 8 > buf.size()) {
+bool ReadU64(const uint8_t* buf, size_t len, size_t* off, uint64_t* out) {
+    if (*off + 8 > len) {
         return false;
     }
     *out = static_cast<uint64_t>(buf[*off]) |
@@ -55,7 +55,7 @@ bool ReadU64(const std::vector<uint8_t>& buf, size_t* off, uint64_t* out) {
 
 }  // namespace
 
-bool ValidateCaseHeader(const std::vector<uint8_t>& payload, std::string* error) {
+bool ValidateCaseHeader(const uint8_t* payload, size_t payload_len, std::string* error) {
     size_t off = 0;
     uint8_t version = 0;
     uint64_t seed = 0;
@@ -63,11 +63,11 @@ bool ValidateCaseHeader(const std::vector<uint8_t>& payload, std::string* error)
     uint16_t input_count = 0;
     uint16_t output_count = 0;
 
-    if (!ReadU8(payload, &off, &version) ||
-        !ReadU64(payload, &off, &seed) ||
-        !ReadU32(payload, &off, &flags) ||
-        !ReadU16(payload, &off, &input_count) ||
-        !ReadU16(payload, &off, &output_count)) {
+    if (!ReadU8(payload, payload_len, &off, &version) ||
+        !ReadU64(payload, payload_len, &off, &seed) ||
+        !ReadU32(payload, payload_len, &off, &flags) ||
+        !ReadU16(payload, payload_len, &off, &input_count) ||
+        !ReadU16(payload, payload_len, &off, &output_count)) {
         if (error) {
             *error = "case header too short";
         }
@@ -88,4 +88,8 @@ bool ValidateCaseHeader(const std::vector<uint8_t>& payload, std::string* error)
     return true;
 }
 
+bool ValidateCaseHeader(const std::vector<uint8_t>& payload, std::string* error) {
+    return ValidateCaseHeader(payload.data(), payload.size(), error);
+}
+
 }  // namespace sp_differ
@@ -8,6 +8,7 @@
 namespace sp_differ {
 
 bool ValidateCaseHeader(const std::vector<uint8_t>& payload, std::string* error);
+bool ValidateCaseHeader(const uint8_t* payload, size_t payload_len, std::string* error);
 
 }  // namespace sp_differ
 
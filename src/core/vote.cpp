@@ -0,0 +1,59 @@
+#include "vote.h"
+
+namespace sp_differ {
+
+const char* VoteClassName(VoteClass vote) {
+    switch (vote) {
+        case VoteClass::kAgree:
+            return "agree";
+        case VoteClass::kMajority:
+            return "majority";
+        case VoteClass::kSplit:
+            break;
+    }
+    return "split";
+}
+
+void VoteOutputs(const uint8_t* const* outputs, const size_t* output_lens, size_t count,
+                 CompareMode mode, DiffScratch* scratch, VoteResult* result) {
+    result->group.assign(count, kNoGroup);
+    result->group_size.clear();
+    result->group_first.clear();
+    result->majority = kNoGroup;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!outputs[i]) {
+            continue;
+        }
+        uint32_t g = 0;
+        for (; g < result->group_first.size(); ++g) {
+            uint32_t first = result->group_first[g];
+            if (OutputsEqual(outputs[first], output_lens[first], outputs[i], output_lens[i], mode,
+                             scratch)) {
+                break;
+            }
+        }
+        if (g == result->group_first.size()) {
+            result->group_first.push_back(static_cast<uint32_t>(i));
+            result->group_size.push_back(0);
+        }
+        result->group[i] = g;
+        ++result->group_size[g];
+    }
+
+    // At most one group can hold more than half the voters.
+    for (uint32_t g = 0; g < result->group_size.size(); ++g) {
+        if (2 * static_cast<size_t>(result->group_size[g]) > count) {
+            result->majority = g;
+        }
+    }
+    if (count == 0 || (result->majority != kNoGroup && result->group_size[0] == count)) {
+        result->vote = VoteClass::kAgree;
+    } else if (result->majority != kNoGroup) {
+        result->vote = VoteClass::kMajority;
+    } else {
+        result->vote = VoteClass::kSplit;
+    }
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,56 @@
+#ifndef SP_DIFFER_CORE_VOTE_H
+#define SP_DIFFER_CORE_VOTE_H
+
+#include "diff.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sp_differ {
+
+// How the outputs of several workers for one case relate.
+enum class VoteClass : uint8_t {
+    // Every worker produced the same output.
+    kAgree,
+    // More than half the workers agree; the others are outliers.
+    kMajority,
+    // No output is shared by more than half the workers.
+    kSplit,
+};
+
+const char* VoteClassName(VoteClass vote);
+
+// Group of a voter that produced no valid output.
+constexpr uint32_t kNoGroup = UINT32_MAX;
+
+struct VoteResult {
+    VoteClass vote = VoteClass::kAgree;
+    // Per voter: its group, numbered in order of first appearance, or
+    // kNoGroup.
+    std::vector<uint32_t> group;
+    // Per group: member count and first member, whose output stands for
+    // the group.
+    std::vector<uint32_t> group_size;
+    std::vector<uint32_t> group_first;
+    // The group holding more than half the voters; kNoGroup on a split.
+    uint32_t majority = kNoGroup;
+};
+
+// Groups the outputs of count voters by equality under mode. A null
+// outputs[i] is a voter without a valid output (a failed or crashed call);
+// it joins no group and counts against agreement. Each output is compared
+// with one representative per group seen so far, so N voters that agree
+// cost N - 1 comparisons. Outputs must have passed ValidateOutputPayload.
+void VoteOutputs(const uint8_t* const* outputs, const size_t* output_lens, size_t count,
+                 CompareMode mode, DiffScratch* scratch, VoteResult* result);
+
+// Voters outside the majority group; every voter on a split.
+inline bool IsOutlier(const VoteResult& result, size_t voter) {
+    return result.vote == VoteClass::kSplit ||
+           (result.vote == VoteClass::kMajority && result.group[voter] != result.majority);
+}
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_CORE_VOTE_H
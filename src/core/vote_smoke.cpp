@@ -0,0 +1,84 @@
+#include "vote.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// A status-ok v1 output whose record i carries the byte tags[i] in every
+// pubkey and tweak byte (the pubkey parity byte is always 0x02).
+std::vector<uint8_t> MakeOutput(const std::vector<uint8_t>& tags) {
+    uint16_t count = static_cast<uint16_t>(tags.size());
+    std::vector<uint8_t> output = {1, 0, static_cast<uint8_t>(count & 0xff),
+                                   static_cast<uint8_t>(count >> 8)};
+    for (uint8_t tag : tags) {
+        output.push_back(0x02);
+        output.insert(output.end(), 32, tag);
+    }
+    for (uint8_t tag : tags) {
+        output.insert(output.end(), 32, tag);
+    }
+    return output;
+}
+
+// Votes over the given outputs; an empty output stands for a failed voter.
+// Returns the class followed by each voter's group, "-" for none, with
+// outliers starred, e.g. "majority 0 0 1*".
+std::string Vote(const std::vector<std::vector<uint8_t>>& voters, sp_differ::CompareMode mode) {
+    std::vector<const uint8_t*> outputs;
+    std::vector<size_t> lens;
+    for (const std::vector<uint8_t>& output : voters) {
+        outputs.push_back(output.empty() ? nullptr : output.data());
+        lens.push_back(output.size());
+    }
+    sp_differ::DiffScratch scratch;
+    sp_differ::VoteResult result;
+    sp_differ::VoteOutputs(outputs.data(), lens.data(), voters.size(), mode, &scratch, &result);
+    std::string text = sp_differ::VoteClassName(result.vote);
+    for (size_t i = 0; i < voters.size(); ++i) {
+        uint32_t group = result.group[i];
+        text += group == sp_differ::kNoGroup ? " -" : " " + std::to_string(group);
+        text += sp_differ::IsOutlier(result, i) ? "*" : "";
+    }
+    return text;
+}
+
+bool Expect(const std::string& what, const std::string& got, const std::string& want) {
+    if (got != want) {
+        std::cerr << "FAIL: " << what << ": got '" << got << "', want '" << want << "'"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    const sp_differ::CompareMode ordered = sp_differ::CompareMode::kOrdered;
+    const sp_differ::CompareMode unordered = sp_differ::CompareMode::kUnordered;
+    std::vector<uint8_t> a = MakeOutput({1, 2, 3});
+    std::vector<uint8_t> b = MakeOutput({1, 2, 4});
+    std::vector<uint8_t> c = MakeOutput({5});
+    std::vector<uint8_t> reordered = MakeOutput({3, 1, 2});
+    std::vector<uint8_t> failed;
+
+    if (!Expect("all agree", Vote({a, a, a}, ordered), "agree 0 0 0") ||
+        !Expect("one outlier", Vote({a, b, a}, ordered), "majority 0 1* 0") ||
+        !Expect("outlier first", Vote({b, a, a}, ordered), "majority 0* 1 1") ||
+        !Expect("three ways", Vote({a, b, c}, ordered), "split 0* 1* 2*") ||
+        !Expect("even split", Vote({a, b, a, b}, ordered), "split 0* 1* 0* 1*") ||
+        !Expect("three of four", Vote({a, b, a, a}, ordered), "majority 0 1* 0 0") ||
+        !Expect("failed voter", Vote({a, failed, a}, ordered), "majority 0 -* 0") ||
+        !Expect("all failed", Vote({failed, failed, failed}, ordered), "split -* -* -*") ||
+        !Expect("two voters differ", Vote({a, b}, ordered), "split 0* 1*") ||
+        !Expect("reordered", Vote({a, reordered, a}, ordered), "majority 0 1* 0") ||
+        !Expect("reordered unordered", Vote({a, reordered, a}, unordered), "agree 0 0 0") ||
+        !Expect("no voters", Vote({}, ordered), "agree")) {
+        return 2;
+    }
+
+    std::cout << "OK: output vote" << std::endl;
+    return 0;
+}
@@ -0,0 +1,362 @@
+#include "reporter.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+namespace sp_differ {
+namespace {
+
+// The writer wakes early once this much is buffered.
+constexpr size_t kFlushThreshold = 256u << 10;
+constexpr std::chrono::seconds kFlushInterval{1};
+
+void AppendJsonString(const std::string& text, std::string* out) {
+  out->push_back('"');
+  for (char ch : text) {
+    unsigned char c = static_cast<unsigned char>(ch);
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(ch);
+    } else if (c < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out->append(escaped);
+    } else {
+      out->push_back(ch);
+    }
+  }
+  out->push_back('"');
+}
+
+void AppendHex64(uint64_t value, std::string* out) {
+  static const char kDigits[] = "0123456789abcdef";
+  char text[16];
+  for (int i = 15; i >= 0; --i) {
+    text[i] = kDigits[value & 0xf];
+    value >>= 4;
+  }
+  out->append(text, sizeof(text));
+}
+
+void AppendInt(int64_t value, std::string* out) {
+  char text[24];
+  size_t len = 0;
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : value;
+  do {
+    text[sizeof(text) - ++len] = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    text[sizeof(text) - ++len] = '-';
+  }
+  out->append(text + sizeof(text) - len, len);
+}
+
+// Three decimals, rounded; timings are never negative.
+void AppendMicros(double value, std::string* out) {
+  uint64_t thousandths = static_cast<uint64_t>(value * 1000.0 + 0.5);
+  AppendInt(static_cast<int64_t>(thousandths / 1000), out);
+  char frac[4] = {'.', static_cast<char>('0' + thousandths / 100 % 10),
+                  static_cast<char>('0' + thousandths / 10 % 10),
+                  static_cast<char>('0' + thousandths % 10)};
+  out->append(frac, sizeof(frac));
+}
+
+// Runs on the calling thread for every case, so it avoids printf.
+void FormatRecord(const ReportRecord& record, std::string* out) {
+  out->assign("{\"type\":\"case\",\"case\":");
+  AppendJsonString(record.case_name ? *record.case_name : std::string(), out);
+  out->append(",\"seed\":\"");
+  AppendHex64(record.seed, out);
+  out->append("\",\"hash\":\"");
+  AppendHex64(record.case_hash, out);
+  out->append("\",\"result\":\"");
+  out->append(ReportResultName(record.result));
+  out->append("\",\"left_status\":");
+  AppendInt(record.left_status, out);
+  out->append(",\"right_status\":");
+  AppendInt(record.right_status, out);
+  out->append(",\"first_diff\":");
+  AppendInt(record.first_diff, out);
+  if (record.signature != 0) {
+    out->append(",\"signature\":\"");
+    AppendHex64(record.signature, out);
+    out->push_back('"');
+  }
+  out->append(",\"left_us\":");
+  AppendMicros(record.left_us, out);
+  out->append(",\"right_us\":");
+  AppendMicros(record.right_us, out);
+  if (record.detail && !record.detail->empty()) {
+    out->append(",\"detail\":");
+    AppendJsonString(*record.detail, out);
+  }
+  out->append("}\n");
+}
+
+std::string MarkdownCell(const std::string& text) {
+  std::string cell;
+  for (char ch : text) {
+    if (ch == '|') {
+      cell.push_back('\\');
+    }
+    cell.push_back(ch == '\n' ? ' ' : ch);
+  }
+  return cell;
+}
+
+std::string FormatListedRow(const ReportRecord& record) {
+  char buffer[160];
+  std::snprintf(buffer, sizeof(buffer),
+                " | %s | `%016" PRIx64 "` | `%016" PRIx64 "` | %d | %d | %" PRId64 " | ",
+                ReportResultName(record.result), record.case_hash, record.seed,
+                record.left_status, record.right_status, record.first_diff);
+  std::string row = "| " + MarkdownCell(record.case_name ? *record.case_name : std::string());
+  row += buffer;
+  row += MarkdownCell(record.detail ? *record.detail : std::string());
+  row += " |\n";
+  return row;
+}
+
+std::string FormatMarkdown(const ReporterOptions& options, const ReportTotals& totals,
+                           double seconds, bool complete) {
+  char buffer[256];
+  std::string md = "# sp-differ report\n\n";
+  for (const std::string& line : options.run_info) {
+    md += "- " + line + "\n";
+  }
+  double rate = seconds > 0.0 ? static_cast<double>(totals.cases) / seconds : 0.0;
+  std::snprintf(buffer, sizeof(buffer),
+                "- status: %s\n- cases: %" PRIu64 "\n- elapsed_s: %.3f\n- cases_per_s: %.1f\n",
+                complete ? "complete" : "in progress", totals.cases, seconds, rate);
+  md += buffer;
+  if (totals.cases > 0) {
+    std::snprintf(buffer, sizeof(buffer), "- mean_left_us: %.3f\n- mean_right_us: %.3f\n",
+                  totals.left_us / totals.cases, totals.right_us / totals.cases);
+    md += buffer;
+  }
+
+  md += "\n| result | cases |\n|---|---|\n";
+  for (int i = 0; i < kReportResultCount; ++i) {
+    std::snprintf(buffer, sizeof(buffer), "| %s | %" PRIu64 " |\n",
+                  ReportResultName(static_cast<ReportResult>(i)), totals.by_result[i]);
+    md += buffer;
+  }
+
+  if (!totals.status_pairs.empty()) {
+    md += "\n## Status pairs\n\n| left | right | cases |\n|---|---|---|\n";
+    for (const auto& entry : totals.status_pairs) {
+      std::snprintf(buffer, sizeof(buffer), "| %d | %d | %" PRIu64 " |\n", entry.first.first,
+                    entry.first.second, entry.second);
+      md += buffer;
+    }
+  }
+
+  if (!totals.first_diffs.empty()) {
+    md += "\n## Mismatch first-diff offsets\n\n| offset | cases |\n|---|---|\n";
+    for (const auto& entry : totals.first_diffs) {
+      std::snprintf(buffer, sizeof(buffer), "| %" PRId64 " | %" PRIu64 " |\n", entry.first,
+                    entry.second);
+      md += buffer;
+    }
+  }
+
+  if (!totals.signatures.empty()) {
+    md += "\n## Mismatch signatures\n\n| signature | cases |\n|---|---|\n";
+    for (const auto& entry : totals.signatures) {
+      std::snprintf(buffer, sizeof(buffer), "| `%016" PRIx64 "` | %" PRIu64 " |\n", entry.first,
+                    entry.second);
+      md += buffer;
+    }
+  }
+
+  if (!totals.listed.empty()) {
+    md += "\n## Non-passing cases\n\n"
+          "| case | result | hash | seed | left | right | first_diff | detail |\n"
+          "|---|---|---|---|---|---|---|---|\n";
+    for (const std::string& row : totals.listed) {
+      md += row;
+    }
+    if (totals.unlisted > 0) {
+      std::snprintf(buffer, sizeof(buffer),
+                    "\n%" PRIu64 " more not listed; see the JSON-lines report.\n",
+                    totals.unlisted);
+      md += buffer;
+    }
+  }
+  return md;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// Writes through a temporary file and a rename, so a reader never sees a
+// half-written summary.
+bool WriteMarkdown(const std::string& path, const std::string& markdown) {
+  std::string temp = path + ".tmp";
+  std::FILE* file = std::fopen(temp.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  bool ok = std::fwrite(markdown.data(), 1, markdown.size(), file) == markdown.size();
+  ok = std::fclose(file) == 0 && ok;
+  return ok && std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+void WriterLoop(Reporter* reporter) {
+  std::string pending;
+  auto next_summary = std::chrono::steady_clock::now() + reporter->options.summary_interval;
+  std::unique_lock<std::mutex> lock(reporter->mutex);
+  for (;;) {
+    reporter->wake_writer.wait_for(lock, kFlushInterval, [reporter] {
+      return reporter->closing || reporter->active.size() >= kFlushThreshold;
+    });
+    // Swapping hands the producers the writer's (empty) buffer, so both keep
+    // their capacity and steady-state runs stop allocating.
+    pending.swap(reporter->active);
+    bool closing = reporter->closing;
+    bool summary_due = !closing && !reporter->options.markdown_path.empty() &&
+                       std::chrono::steady_clock::now() >= next_summary;
+    std::string markdown;
+    if (summary_due) {
+      markdown = FormatMarkdown(reporter->options, reporter->totals,
+                                SecondsSince(reporter->started), false);
+    }
+    lock.unlock();
+    reporter->wake_producer.notify_all();
+
+    bool ok = true;
+    if (!pending.empty() && reporter->jsonl) {
+      ok = std::fwrite(pending.data(), 1, pending.size(), reporter->jsonl) == pending.size() &&
+           std::fflush(reporter->jsonl) == 0;
+    }
+    pending.clear();
+    if (summary_due) {
+      ok = WriteMarkdown(reporter->options.markdown_path, markdown) && ok;
+      next_summary = std::chrono::steady_clock::now() + reporter->options.summary_interval;
+    }
+
+    lock.lock();
+    reporter->write_failed = reporter->write_failed || !ok;
+    if (closing && reporter->active.empty()) {
+      return;
+    }
+  }
+}
+
+}  // namespace
+
+const char* ReportResultName(ReportResult result) {
+  switch (result) {
+    case ReportResult::kPass:
+      return "pass";
+    case ReportResult::kMismatch:
+      return "mismatch";
+    case ReportResult::kError:
+      return "error";
+    case ReportResult::kCrash:
+      return "crash";
+    case ReportResult::kTimeout:
+      return "timeout";
+  }
+  return "unknown";
+}
+
+bool OpenReporter(const ReporterOptions& options, Reporter* reporter, std::string* error) {
+  reporter->options = options;
+  reporter->started = std::chrono::steady_clock::now();
+  reporter->closing = false;
+  reporter->write_failed = false;
+  reporter->totals = ReportTotals();
+  reporter->active.reserve(kFlushThreshold * 2);
+  if (!options.jsonl_path.empty()) {
+    reporter->jsonl = std::fopen(options.jsonl_path.c_str(), "wb");
+    if (!reporter->jsonl) {
+      *error = "unable to open report " + options.jsonl_path;
+      return false;
+    }
+  }
+  reporter->writer = std::thread(WriterLoop, reporter);
+  return true;
+}
+
+void AddReportRecord(Reporter* reporter, const ReportRecord& record) {
+  thread_local std::string line;
+  FormatRecord(record, &line);
+  bool wake = false;
+  {
+    std::unique_lock<std::mutex> lock(reporter->mutex);
+    reporter->wake_producer.wait(lock, [reporter] {
+      return reporter->active.size() < reporter->options.buffer_limit || reporter->closing;
+    });
+    reporter->active += line;
+    wake = reporter->active.size() >= kFlushThreshold;
+
+    ReportTotals& totals = reporter->totals;
+    ++totals.cases;
+    ++totals.by_result[static_cast<int>(record.result)];
+    ++totals.status_pairs[std::make_pair(record.left_status, record.right_status)];
+    totals.left_us += record.left_us;
+    totals.right_us += record.right_us;
+    if (record.result == ReportResult::kMismatch) {
+      ++totals.first_diffs[record.first_diff];
+      if (record.signature != 0) {
+        ++totals.signatures[record.signature];
+      }
+    }
+    if (record.result != ReportResult::kPass) {
+      // Rare enough that formatting the row under the lock is fine.
+      if (totals.listed.size() < reporter->options.max_listed) {
+        totals.listed.push_back(FormatListedRow(record));
+      } else {
+        ++totals.unlisted;
+      }
+    }
+  }
+  if (wake) {
+    reporter->wake_writer.notify_one();
+  }
+}
+
+bool CloseReporter(Reporter* reporter, std::string* error) {
+  if (!reporter->writer.joinable()) {
+    return true;
+  }
+  double seconds = SecondsSince(reporter->started);
+  {
+    std::lock_guard<std::mutex> lock(reporter->mutex);
+    const ReportTotals& totals = reporter->totals;
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"type\":\"summary\",\"cases\":%" PRIu64 ",\"pass\":%" PRIu64
+                  ",\"mismatch\":%" PRIu64 ",\"error\":%" PRIu64 ",\"crash\":%" PRIu64
+                  ",\"timeout\":%" PRIu64 ",\"elapsed_s\":%.3f}\n",
+                  totals.cases, totals.by_result[0], totals.by_result[1], totals.by_result[2],
+                  totals.by_result[3], totals.by_result[4], seconds);
+    reporter->active += buffer;
+    reporter->closing = true;
+  }
+  reporter->wake_writer.notify_one();
+  reporter->wake_producer.notify_all();
+  reporter->writer.join();
+
+  bool ok = !reporter->write_failed;
+  if (reporter->jsonl) {
+    ok = std::fclose(reporter->jsonl) == 0 && ok;
+    reporter->jsonl = nullptr;
+  }
+  if (!reporter->options.markdown_path.empty()) {
+    ok = WriteMarkdown(reporter->options.markdown_path,
+                       FormatMarkdown(reporter->options, reporter->totals, seconds, true)) &&
+         ok;
+  }
+  if (!ok) {
+    *error = "failed to write report";
+  }
+  return ok;
+}
+
+}  // namespace sp_differ
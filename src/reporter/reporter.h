@@ -0,0 +1,110 @@
+#ifndef SP_DIFFER_REPORTER_REPORTER_H
+#define SP_DIFFER_REPORTER_REPORTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sp_differ {
+
+enum class ReportResult {
+  kPass,
+  kMismatch,
+  kError,
+  kCrash,
+  kTimeout,
+};
+
+constexpr int kReportResultCount = 5;
+
+const char* ReportResultName(ReportResult result);
+
+// One compared case. Status codes are the second byte of each worker's
+// output, or -1 when that side produced no valid output. first_diff is -1
+// unless the outputs mismatch. Timings are per case; batch runs report the
+// batch call time divided evenly over its cases.
+struct ReportRecord {
+  const std::string* case_name = nullptr;
+  uint64_t seed = 0;
+  uint64_t case_hash = 0;
+  ReportResult result = ReportResult::kPass;
+  int left_status = -1;
+  int right_status = -1;
+  int64_t first_diff = -1;
+  // Mismatch signature key (see core/signature.h); 0 when there is none.
+  uint64_t signature = 0;
+  double left_us = 0.0;
+  double right_us = 0.0;
+  const std::string* detail = nullptr;
+};
+
+struct ReporterOptions {
+  // JSON-lines output, one object per case; empty to skip.
+  std::string jsonl_path;
+  // Markdown summary; empty to skip. Rewritten every summary_interval while
+  // the run is going, so an interrupted run still leaves one behind.
+  std::string markdown_path;
+  // Free-form lines describing the run (workers, corpus), shown at the top
+  // of the markdown summary.
+  std::vector<std::string> run_info;
+  // Buffered JSON lines beyond this many bytes make AddReportRecord wait for
+  // the writer thread, which bounds memory however long the run is.
+  size_t buffer_limit = 8u << 20;
+  // Non-passing cases listed individually in the markdown summary.
+  size_t max_listed = 50;
+  std::chrono::seconds summary_interval{60};
+};
+
+// Aggregates kept for the markdown summary. Its size depends only on
+// max_listed and the number of distinct status pairs and mismatch
+// signatures, never on run length.
+struct ReportTotals {
+  uint64_t cases = 0;
+  uint64_t by_result[kReportResultCount] = {0, 0, 0, 0, 0};
+  std::map<std::pair<int, int>, uint64_t> status_pairs;
+  std::map<int64_t, uint64_t> first_diffs;
+  std::map<uint64_t, uint64_t> signatures;
+  double left_us = 0.0;
+  double right_us = 0.0;
+  std::vector<std::string> listed;
+  uint64_t unlisted = 0;
+};
+
+// Streams records to disk from a background thread. Callers format a record
+// into an in-memory buffer and return; the writer thread swaps that buffer
+// out and writes it whenever it passes a flush threshold, and at least once
+// a second.
+struct Reporter {
+  ReporterOptions options;
+  std::FILE* jsonl = nullptr;
+  std::chrono::steady_clock::time_point started;
+
+  std::mutex mutex;
+  std::condition_variable wake_writer;
+  std::condition_variable wake_producer;
+  std::string active;
+  bool closing = false;
+  bool write_failed = false;
+  ReportTotals totals;
+  std::thread writer;
+};
+
+bool OpenReporter(const ReporterOptions& options, Reporter* reporter, std::string* error);
+
+// Thread-safe. Only blocks when the writer has fallen buffer_limit behind.
+void AddReportRecord(Reporter* reporter, const ReportRecord& record);
+
+// Flushes everything, appends a summary line to the JSON-lines file, writes
+// the final markdown summary, and stops the writer thread.
+bool CloseReporter(Reporter* reporter, std::string* error);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_REPORTER_REPORTER_H
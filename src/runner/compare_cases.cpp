@@ -0,0 +1,59 @@
+#include "compare_cases.h"
+
+#include "../core/hash.h"
+
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+namespace sp_differ {
+
+bool IsPacked(const CaseSource& source) {
+  return source.packed.base != nullptr;
+}
+
+size_t CaseCount(const CaseSource& source) {
+  if (source.streaming) {
+    return source.window_offsets.empty() ? 0 : source.window_offsets.size() - 1;
+  }
+  return IsPacked(source) ? static_cast<size_t>(source.packed.case_count) : source.paths.size();
+}
+
+std::string CaseName(const CaseSource& source, size_t index) {
+  if (source.streaming) {
+    uint64_t stream_index = source.window_indices.empty() ? source.window_first + index
+                                                          : source.window_indices[index];
+    return source.stream_name + "#" + std::to_string(stream_index);
+  }
+  return IsPacked(source) ? source.packed_path + "#" + std::to_string(index)
+                          : source.paths[index];
+}
+
+bool GetMappedCase(const CaseSource& source, size_t index, const uint8_t** payload,
+                   size_t* payload_len, std::string* error) {
+  if (source.streaming) {
+    *payload = source.window.data() + source.window_offsets[index];
+    *payload_len = source.window_offsets[index + 1] - source.window_offsets[index];
+    return true;
+  }
+  return GetPackedCase(source.packed, index, payload, payload_len, error);
+}
+
+std::string SaveCaseArtifact(const std::string& dir, const char* kind, const char* side,
+                             const uint8_t* payload, size_t payload_len) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  std::ostringstream name;
+  name << kind << "-" << side << "-" << std::hex << std::setw(16) << std::setfill('0')
+       << HashCase(payload, payload_len) << ".hex";
+  std::string path = (std::filesystem::path(dir) / name.str()).string();
+  std::string error;
+  if (!WriteCasePayloadHex(path, payload, payload_len, &error)) {
+    return std::string();
+  }
+  return path;
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,226 @@
+#ifndef SP_DIFFER_RUNNER_COMPARE_CASES_H
+#define SP_DIFFER_RUNNER_COMPARE_CASES_H
+
+#include "../core/canonical.h"
+#include "../core/io.h"
+#include "../core/metrics.h"
+#include "../core/pack.h"
+#include "../core/stream.h"
+#include "../core/validate.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The cases of a sp_differ_compare run and how they reach the workers,
+// shared by two-worker comparisons and --worker votes.
+
+namespace sp_differ {
+
+// Cases per worker call.
+constexpr size_t kBatchSize = 64;
+// Diverging fields listed per printed mismatch.
+constexpr size_t kMaxListedFields = 16;
+
+enum class CaseResult {
+  kPass,
+  kMismatch,
+  kError,
+  kCrash,
+  kTimeout,
+};
+
+// The cases of a batch run: individual case files, one mapped packed corpus,
+// or the window of a case stream currently held in memory.
+struct CaseSource {
+  std::vector<std::string> paths;
+  std::string packed_path;
+  PackedCorpus packed;
+  bool streaming = false;
+  std::string stream_name;
+  std::vector<uint8_t> window;
+  std::vector<size_t> window_offsets;
+  uint64_t window_first = 0;
+  // Stream index of each window case; filled only when duplicates are being
+  // dropped, since the window is then no longer a contiguous run.
+  std::vector<uint64_t> window_indices;
+};
+
+// The packed inputs of one chunk, reused by a scheduler thread for every
+// chunk it gathers. Case k of the span is case members[k] of the source and
+// lies at [offsets[k], offsets[k + 1]).
+struct ChunkInputs {
+  std::vector<uint8_t> raw;
+  std::vector<uint8_t> input;
+  std::vector<uint8_t> packed;
+  std::vector<size_t> offsets;
+  std::vector<size_t> members;
+};
+
+bool IsPacked(const CaseSource& source);
+size_t CaseCount(const CaseSource& source);
+std::string CaseName(const CaseSource& source, size_t index);
+
+// Points payload at an in-memory case of a packed or streamed source.
+bool GetMappedCase(const CaseSource& source, size_t index, const uint8_t** payload,
+                   size_t* payload_len, std::string* error);
+
+// Saves a case that crashed or hung a worker (kind "crash" or "timeout") so
+// it can be replayed on its own.
+std::string SaveCaseArtifact(const std::string& dir, const char* kind, const char* side,
+                             const uint8_t* payload, size_t payload_len);
+
+// Gathers the valid cases in [begin, end) into one packed span. Cases from a
+// packed corpus or stream window are handed over in place when the whole
+// range is valid and contiguous, which is how sp_differ_pack lays them out;
+// otherwise the valid ones are copied into scratch->packed.
+//
+// Case files are timed one stage at a time. Mapped cases are only validated
+// here, which takes nanoseconds, so that stage is timed over the whole chunk
+// rather than paying two clock reads per case.
+template <typename Outcome>
+void GatherChunk(const CaseSource& source, size_t begin, size_t end, ChunkInputs* scratch,
+                 StageRecorder* recorder, std::vector<Outcome>* outcomes,
+                 const uint8_t** inputs, size_t* inputs_len) {
+  scratch->packed.clear();
+  scratch->offsets.assign(1, 0);
+  scratch->members.clear();
+
+  if (!IsPacked(source) && !source.streaming) {
+    for (size_t i = begin; i < end; ++i) {
+      // Already timed out in an abandoned run of this chunk.
+      if ((*outcomes)[i].result == CaseResult::kTimeout) {
+        continue;
+      }
+      std::string* error = &(*outcomes)[i].error;
+      uint64_t t = StageStart(recorder);
+      if (!ReadCaseFile(source.paths[i], &scratch->raw, error)) {
+        continue;
+      }
+      t = RecordStage(recorder, Stage::kRead, t);
+      if (!DecodeCasePayload(&scratch->raw, &scratch->input, error)) {
+        continue;
+      }
+      t = RecordStage(recorder, Stage::kDecode, t);
+      if (!ValidateCaseHeader(scratch->input, error)) {
+        continue;
+      }
+      RecordStage(recorder, Stage::kValidateCase, t);
+      scratch->packed.insert(scratch->packed.end(), scratch->input.begin(), scratch->input.end());
+      scratch->offsets.push_back(scratch->packed.size());
+      scratch->members.push_back(i);
+    }
+    *inputs = scratch->packed.data();
+    *inputs_len = scratch->packed.size();
+    return;
+  }
+
+  const uint8_t* first = nullptr;
+  const uint8_t* next = nullptr;
+  bool contiguous = true;
+  uint64_t validate_start = StageStart(recorder);
+  for (size_t i = begin; i < end; ++i) {
+    std::string* error = &(*outcomes)[i].error;
+    const uint8_t* payload = nullptr;
+    size_t payload_len = 0;
+    if ((*outcomes)[i].result == CaseResult::kTimeout ||
+        !GetMappedCase(source, i, &payload, &payload_len, error) ||
+        !ValidateCaseHeader(payload, payload_len, error)) {
+      contiguous = false;
+      continue;
+    }
+    if (!first) {
+      first = payload;
+      next = payload;
+    }
+    contiguous = contiguous && payload == next;
+    next = payload + payload_len;
+    scratch->offsets.push_back(scratch->offsets.back() + payload_len);
+    scratch->members.push_back(i);
+  }
+  RecordStage(recorder, Stage::kValidateCase, validate_start, end - begin);
+  if (contiguous) {
+    *inputs = first;
+    *inputs_len = scratch->offsets.back();
+    return;
+  }
+
+  for (size_t member : scratch->members) {
+    const uint8_t* payload = nullptr;
+    size_t payload_len = 0;
+    GetMappedCase(source, member, &payload, &payload_len, nullptr);
+    scratch->packed.insert(scratch->packed.end(), payload, payload + payload_len);
+  }
+  *inputs = scratch->packed.data();
+  *inputs_len = scratch->packed.size();
+}
+
+// Reads the stream one window at a time into source and hands each window to
+// run_window, so memory stays bounded however many cases the stream carries.
+// With dedup, repeats are dropped against a hash set of at most
+// dedup_max_bytes (0 for no limit), which forgets old hashes rather than
+// grow. A read error ends the stream early and is left in stream_error.
+template <typename RunWindow>
+bool ReadStreamWindows(const std::string& stream_path, StreamFraming framing, size_t window_cases,
+                       bool dedup, size_t dedup_max_bytes, StageRecorder* reader,
+                       CaseSource* source, std::string* stream_error, RunWindow run_window) {
+  CaseStream stream;
+  if (!OpenCaseStream(stream_path, framing, &stream, stream_error)) {
+    return false;
+  }
+
+  source->streaming = true;
+  source->stream_name = stream_path == "-" ? "stdin" : stream_path;
+  size_t case_count = 0;
+  uint64_t stream_index = 0;
+  uint64_t duplicates = 0;
+  CaseHashSet seen;
+  seen.max_slots = dedup_max_bytes == 0 ? 0 : CaseHashSlotsFor(dedup_max_bytes);
+  std::vector<uint8_t> canonical;
+  std::vector<uint8_t> payload;
+  bool more = true;
+  while (more) {
+    source->window.clear();
+    source->window_offsets.assign(1, 0);
+    source->window_indices.clear();
+    source->window_first = case_count;
+    // Timed per window: a streamed case takes well under a microsecond to
+    // read, so per-case clock reads would cost as much as the read.
+    uint64_t read_start = StageStart(reader);
+    uint64_t window_start_index = stream_index;
+    while (source->window_offsets.size() <= window_cases) {
+      more = NextStreamCase(&stream, &payload, stream_error);
+      if (!more) {
+        break;
+      }
+      uint64_t index = stream_index++;
+      if (dedup) {
+        uint64_t hash = CanonicalCaseHash(payload.data(), payload.size(), &canonical);
+        if (!InsertCaseHash(&seen, hash)) {
+          ++duplicates;
+          continue;
+        }
+        source->window_indices.push_back(index);
+      }
+      source->window.insert(source->window.end(), payload.begin(), payload.end());
+      source->window_offsets.push_back(source->window.size());
+    }
+    RecordStage(reader, Stage::kRead, read_start, stream_index - window_start_index);
+    case_count += CaseCount(*source);
+    if (!run_window(*source)) {
+      break;
+    }
+  }
+  CloseCaseStream(&stream);
+  if (dedup) {
+    std::cout << "DEDUP: read=" << stream_index << " duplicates=" << duplicates
+              << " forgotten=" << seen.forgotten << std::endl;
+  }
+  return true;
+}
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_RUNNER_COMPARE_CASES_H
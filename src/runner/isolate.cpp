@@ -0,0 +1,521 @@
+#include "isolate.h"
+
+#include "../../ffi/sp_differ.h"
+#include "watchdog.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace sp_differ {
+namespace {
+
+constexpr uint32_t kMaxSlots = 64;
+constexpr size_t kInputCapacity = size_t{16} << 20;
+constexpr size_t kOutputCapacity = size_t{16} << 20;
+constexpr int kWaitMs = 100;
+constexpr int32_t kSlotNotRun = -2;
+
+enum ChildState : uint32_t {
+  kChildIdle = 0,
+  kChildRunning = 1,
+  kChildDead = 2,
+};
+
+}  // namespace
+
+// Shared between the runner, the forkserver, and the serving child. The input
+// and output areas follow the header in the same mapping.
+struct IsolatedChannel {
+  struct Slot {
+    uint64_t input_offset;
+    uint64_t input_len;
+    uint64_t output_offset;
+    uint64_t output_len;
+    int32_t rc;
+  };
+
+  // Bumped by the runner to submit slots [first_slot, slot_count).
+  std::atomic<uint32_t> request_seq;
+  // Set by the child to the request it has finished.
+  std::atomic<uint32_t> handled_seq;
+  // Bumped on every event the runner waits for; the runner's futex word.
+  std::atomic<uint32_t> event_seq;
+  std::atomic<uint32_t> child_state;
+  // Slot the child is currently running.
+  std::atomic<uint32_t> progress;
+  std::atomic<int32_t> child_pid;
+  // Beaten by the child per slot; busy while the runner waits on a request.
+  Heartbeat heartbeat;
+  // Set when the watchdog killed the child, so its death is a timeout.
+  std::atomic<uint32_t> timed_out;
+  int32_t exit_status;
+  uint32_t first_slot;
+  uint32_t slot_count;
+  uint64_t output_start;
+  Slot slots[kMaxSlots];
+};
+
+#if !defined(_WIN32)
+namespace {
+
+uint8_t* InputArea(IsolatedChannel* channel) {
+  return reinterpret_cast<uint8_t*>(channel) + sizeof(IsolatedChannel);
+}
+
+uint8_t* OutputArea(IsolatedChannel* channel) {
+  return InputArea(channel) + kInputCapacity;
+}
+
+// Returns false when the wait timed out.
+bool FutexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeout_ms) {
+#if defined(__linux__)
+  timespec ts{};
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000L;
+  long rc = syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected,
+                    timeout_ms >= 0 ? &ts : nullptr, nullptr, 0);
+  return !(rc != 0 && errno == ETIMEDOUT);
+#else
+  (void)timeout_ms;
+  if (word->load(std::memory_order_acquire) == expected) {
+    timespec ts{0, 50000};
+    nanosleep(&ts, nullptr);
+  }
+  return true;
+#endif
+}
+
+void FutexWake(std::atomic<uint32_t>* word) {
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+void SignalEvent(IsolatedChannel* channel) {
+  channel->event_seq.fetch_add(1, std::memory_order_acq_rel);
+  FutexWake(&channel->event_seq);
+}
+
+void DieWithParent() {
+#if defined(__linux__)
+  prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+}
+
+int RunIntoArea(const WorkerApi& api, const uint8_t* input, size_t input_len, uint8_t* output,
+                size_t capacity, size_t* output_len) {
+  if (api.run_into) {
+    return api.run_into(input, input_len, output, capacity, output_len);
+  }
+  uint8_t* result = nullptr;
+  size_t result_len = 0;
+  int rc = api.run(input, input_len, &result, &result_len);
+  if (rc != 0) {
+    return rc;
+  }
+  *output_len = result_len;
+  if (result_len > capacity) {
+    api.free(result);
+    return SP_DIFFER_WORKER_NEED_BUFFER;
+  }
+  std::memcpy(output, result, result_len);
+  api.free(result);
+  return 0;
+}
+
+[[noreturn]] void ServeChannel(const WorkerApi& api, IsolatedChannel* channel) {
+  channel->child_pid.store(static_cast<int32_t>(getpid()), std::memory_order_release);
+  for (;;) {
+    uint32_t request = channel->request_seq.load(std::memory_order_acquire);
+    while (request == channel->handled_seq.load(std::memory_order_acquire)) {
+      FutexWait(&channel->request_seq, request, -1);
+      request = channel->request_seq.load(std::memory_order_acquire);
+    }
+
+    uint64_t out = channel->output_start;
+    for (uint32_t i = channel->first_slot; i < channel->slot_count; ++i) {
+      channel->progress.store(i, std::memory_order_release);
+      BeatCase(&channel->heartbeat, i);
+      IsolatedChannel::Slot& slot = channel->slots[i];
+      size_t output_len = 0;
+      slot.output_offset = out;
+      slot.rc = RunIntoArea(api, InputArea(channel) + slot.input_offset, slot.input_len,
+                            OutputArea(channel) + out, kOutputCapacity - out, &output_len);
+      slot.output_len = slot.rc == 0 || slot.rc == SP_DIFFER_WORKER_NEED_BUFFER ? output_len : 0;
+      if (slot.rc == SP_DIFFER_WORKER_NEED_BUFFER) {
+        break;
+      }
+      out += slot.output_len;
+    }
+
+    channel->handled_seq.store(request, std::memory_order_release);
+    SignalEvent(channel);
+  }
+}
+
+[[noreturn]] void ServeForks(const WorkerApi& api, IsolatedChannel* channel, int command_fd) {
+  DieWithParent();
+  for (;;) {
+    char command = 0;
+    ssize_t n = read(command_fd, &command, 1);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n != 1 || command != 's') {
+      _exit(0);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      DieWithParent();
+      ServeChannel(api, channel);
+    }
+
+    int status = 0;
+    if (pid < 0) {
+      status = 0x7f00;
+    } else {
+      while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+      }
+    }
+    channel->child_pid.store(0, std::memory_order_release);
+    channel->exit_status = status;
+    channel->child_state.store(kChildDead, std::memory_order_release);
+    SignalEvent(channel);
+  }
+}
+
+bool EnsureChild(IsolatedWorker* worker, std::string* error) {
+  IsolatedChannel* channel = worker->channel;
+  if (worker->child_running &&
+      channel->child_state.load(std::memory_order_acquire) != kChildDead) {
+    return true;
+  }
+  channel->child_state.store(kChildRunning, std::memory_order_release);
+  char command = 's';
+  if (write(worker->command_fd, &command, 1) != 1) {
+    if (error) {
+      *error = "isolated worker forkserver is gone";
+    }
+    return false;
+  }
+  worker->child_running = true;
+  return true;
+}
+
+enum class WaitResult {
+  kHandled,
+  kChildDied,
+  kLost,
+};
+
+WaitResult WaitForRequest(IsolatedWorker* worker, uint32_t request) {
+  IsolatedChannel* channel = worker->channel;
+  for (;;) {
+    uint32_t seen = channel->event_seq.load(std::memory_order_acquire);
+    if (channel->handled_seq.load(std::memory_order_acquire) == request) {
+      return WaitResult::kHandled;
+    }
+    if (channel->child_state.load(std::memory_order_acquire) == kChildDead) {
+      return WaitResult::kChildDied;
+    }
+    if (!FutexWait(&channel->event_seq, seen, kWaitMs)) {
+      int status = 0;
+      if (waitpid(static_cast<pid_t>(worker->forkserver_pid), &status, WNOHANG) != 0) {
+        return WaitResult::kLost;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+bool IsolationSupported() {
+  return true;
+}
+
+bool StartIsolatedWorker(const WorkerApi& api, IsolatedWorker* worker, std::string* error) {
+  size_t size = sizeof(IsolatedChannel) + kInputCapacity + kOutputCapacity;
+  int flags = MAP_SHARED | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+  flags |= MAP_NORESERVE;
+#endif
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED) {
+    *error = "unable to map isolated worker channel";
+    return false;
+  }
+  IsolatedChannel* channel = new (mapping) IsolatedChannel();
+
+  int fds[2];
+  if (pipe(fds) != 0) {
+    munmap(mapping, size);
+    *error = "unable to create forkserver pipe";
+    return false;
+  }
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    munmap(mapping, size);
+    *error = "unable to fork isolated worker";
+    return false;
+  }
+  if (pid == 0) {
+    close(fds[1]);
+    ServeForks(api, channel, fds[0]);
+  }
+
+  close(fds[0]);
+  worker->channel = channel;
+  worker->channel_size = size;
+  worker->command_fd = fds[1];
+  worker->forkserver_pid = pid;
+  worker->child_running = false;
+  worker->respawns = 0;
+  return true;
+}
+
+void StopIsolatedWorker(IsolatedWorker* worker) {
+  if (!worker->channel) {
+    return;
+  }
+  int32_t child = worker->channel->child_pid.load(std::memory_order_acquire);
+  if (worker->child_running && child > 0) {
+    kill(child, SIGKILL);
+  }
+  close(worker->command_fd);
+  kill(static_cast<pid_t>(worker->forkserver_pid), SIGKILL);
+  while (waitpid(static_cast<pid_t>(worker->forkserver_pid), nullptr, 0) < 0 && errno == EINTR) {
+  }
+  munmap(worker->channel, worker->channel_size);
+  worker->channel = nullptr;
+  worker->command_fd = -1;
+  worker->forkserver_pid = -1;
+  worker->child_running = false;
+}
+
+bool RunIsolatedBatch(IsolatedWorker* worker, const uint8_t* inputs, size_t inputs_len,
+                      const std::vector<size_t>& input_offsets, std::vector<uint8_t>* outputs,
+                      std::vector<size_t>* output_offsets, std::vector<IsolatedCrash>* crashes,
+                      std::string* error) {
+  if (input_offsets.empty() || input_offsets.back() > inputs_len) {
+    if (error) {
+      *error = "invalid batch offsets";
+    }
+    return false;
+  }
+  size_t case_count = input_offsets.size() - 1;
+  output_offsets->assign(case_count + 1, 0);
+  outputs->clear();
+  crashes->clear();
+
+  IsolatedChannel* channel = worker->channel;
+  size_t next = 0;
+  while (next < case_count) {
+    // Fill the ring with as many cases as fit in the input area.
+    uint32_t count = 0;
+    uint64_t input_used = 0;
+    while (next + count < case_count && count < kMaxSlots) {
+      size_t len = input_offsets[next + count + 1] - input_offsets[next + count];
+      if (input_used + len > kInputCapacity) {
+        break;
+      }
+      IsolatedChannel::Slot& slot = channel->slots[count];
+      std::memcpy(InputArea(channel) + input_used, inputs + input_offsets[next + count],
+                  len);
+      slot.input_offset = input_used;
+      slot.input_len = len;
+      slot.rc = kSlotNotRun;
+      input_used += len;
+      ++count;
+    }
+    if (count == 0) {
+      // A single case larger than the input area cannot be isolated. It is
+      // reported rather than left as a bare empty span, which two isolated
+      // sides would otherwise agree on.
+      IsolatedCrash skipped;
+      skipped.case_index = next;
+      skipped.not_run = true;
+      crashes->push_back(skipped);
+      (*output_offsets)[next + 1] = outputs->size();
+      ++next;
+      continue;
+    }
+
+    uint32_t first = 0;
+    channel->slot_count = count;
+    while (first < count) {
+      channel->first_slot = first;
+      channel->output_start = 0;
+      channel->progress.store(first, std::memory_order_release);
+      channel->heartbeat.state.store(kHeartbeatBusy, std::memory_order_release);
+      uint32_t request = channel->request_seq.fetch_add(1, std::memory_order_acq_rel) + 1;
+      FutexWake(&channel->request_seq);
+      if (!EnsureChild(worker, error)) {
+        channel->heartbeat.state.store(kHeartbeatIdle, std::memory_order_release);
+        return false;
+      }
+
+      WaitResult wait = WaitForRequest(worker, request);
+      channel->heartbeat.state.store(kHeartbeatIdle, std::memory_order_release);
+      if (wait == WaitResult::kLost) {
+        worker->child_running = false;
+        if (error) {
+          *error = "isolated worker forkserver exited";
+        }
+        return false;
+      }
+
+      uint32_t stop = count;
+      if (wait == WaitResult::kChildDied) {
+        stop = channel->progress.load(std::memory_order_acquire);
+      }
+      uint32_t i = first;
+      for (; i < stop; ++i) {
+        const IsolatedChannel::Slot& slot = channel->slots[i];
+        if (slot.rc == SP_DIFFER_WORKER_NEED_BUFFER || slot.rc == kSlotNotRun) {
+          break;
+        }
+        if (slot.rc == 0) {
+          const uint8_t* result = OutputArea(channel) + slot.output_offset;
+          outputs->insert(outputs->end(), result, result + slot.output_len);
+        }
+        (*output_offsets)[next + i + 1] = outputs->size();
+      }
+
+      if (wait == WaitResult::kChildDied && i == stop) {
+        bool timed_out = channel->timed_out.exchange(0, std::memory_order_acq_rel) != 0;
+        crashes->push_back(IsolatedCrash{next + stop, channel->exit_status, timed_out});
+        (*output_offsets)[next + stop + 1] = outputs->size();
+        worker->child_running = false;
+        ++worker->respawns;
+        // The replacement child must not pick up the stale request.
+        channel->handled_seq.store(request, std::memory_order_release);
+        channel->child_state.store(kChildIdle, std::memory_order_release);
+        first = stop + 1;
+      } else if (i < count && i == first &&
+                 channel->slots[i].rc == SP_DIFFER_WORKER_NEED_BUFFER) {
+        // Even an empty output area is too small for this result.
+        (*output_offsets)[next + i + 1] = outputs->size();
+        first = i + 1;
+      } else {
+        first = i;
+      }
+    }
+    next += count;
+  }
+  return true;
+}
+
+Heartbeat* IsolatedHeartbeat(IsolatedWorker* worker) {
+  return &worker->channel->heartbeat;
+}
+
+void ExpireIsolatedCase(IsolatedWorker* worker, uint64_t beat) {
+  IsolatedChannel* channel = worker->channel;
+  int32_t child = channel->child_pid.load(std::memory_order_acquire);
+  // The case may have finished since the watchdog sampled it.
+  if (child <= 0 ||
+      channel->heartbeat.state.load(std::memory_order_acquire) != kHeartbeatBusy ||
+      channel->heartbeat.beat.load(std::memory_order_acquire) != beat) {
+    return;
+  }
+  channel->timed_out.store(1, std::memory_order_release);
+  kill(child, SIGKILL);
+}
+
+std::string DescribeExitStatus(int status) {
+  if (WIFSIGNALED(status)) {
+    return "signal " + std::to_string(WTERMSIG(status));
+  }
+  if (WIFEXITED(status)) {
+    return "exit " + std::to_string(WEXITSTATUS(status));
+  }
+  return "status " + std::to_string(status);
+}
+
+#else
+
+bool IsolationSupported() {
+  return false;
+}
+
+bool StartIsolatedWorker(const WorkerApi& api, IsolatedWorker* worker, std::string* error) {
+  (void)api;
+  (void)worker;
+  *error = "worker isolation is not supported on this platform";
+  return false;
+}
+
+void StopIsolatedWorker(IsolatedWorker* worker) {
+  (void)worker;
+}
+
+bool RunIsolatedBatch(IsolatedWorker* worker, const uint8_t* inputs, size_t inputs_len,
+                      const std::vector<size_t>& input_offsets, std::vector<uint8_t>* outputs,
+                      std::vector<size_t>* output_offsets, std::vector<IsolatedCrash>* crashes,
+                      std::string* error) {
+  (void)worker;
+  (void)inputs;
+  (void)inputs_len;
+  (void)input_offsets;
+  (void)outputs;
+  (void)output_offsets;
+  (void)crashes;
+  if (error) {
+    *error = "worker isolation is not supported on this platform";
+  }
+  return false;
+}
+
+Heartbeat* IsolatedHeartbeat(IsolatedWorker* worker) {
+  (void)worker;
+  return nullptr;
+}
+
+void ExpireIsolatedCase(IsolatedWorker* worker, uint64_t beat) {
+  (void)worker;
+  (void)beat;
+}
+
+std::string DescribeExitStatus(int status) {
+  return "status " + std::to_string(status);
+}
+
+#endif
+
+std::string DescribeIsolatedCrash(const IsolatedCrash& crash) {
+  if (crash.not_run) {
+    return "not run (case exceeds the " + std::to_string(kInputCapacity >> 20) +
+           " MiB isolated input area)";
+  }
+  if (crash.timed_out) {
+    return "timed out";
+  }
+  return "crashed (" + DescribeExitStatus(crash.status) + ")";
+}
+
+}  // namespace sp_differ
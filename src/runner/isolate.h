@@ -0,0 +1,75 @@
+#ifndef SP_DIFFER_RUNNER_ISOLATE_H
+#define SP_DIFFER_RUNNER_ISOLATE_H
+
+#include "watchdog.h"
+#include "worker.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+
+struct IsolatedChannel;
+
+// A worker running in a child process, AFL-forkserver style. A forkserver is
+// forked once from the loaded worker; it forks a fresh serving child on
+// demand and reports the child's exit back through shared memory. Cases and
+// results travel through a shared-memory ring of case slots, signalled with
+// futexes on Linux.
+struct IsolatedWorker {
+  IsolatedChannel* channel = nullptr;
+  size_t channel_size = 0;
+  int command_fd = -1;
+  long forkserver_pid = -1;
+  bool child_running = false;
+  uint64_t respawns = 0;
+};
+
+struct IsolatedCrash {
+  // Index of the crashing case within the batch.
+  size_t case_index = 0;
+  // Raw wait status of the child.
+  int status = 0;
+  // The watchdog killed the child because the case ran past its deadline.
+  bool timed_out = false;
+  // The case is larger than the shared input area and was never sent to
+  // the child; status is 0.
+  bool not_run = false;
+};
+
+bool IsolationSupported();
+
+// Forks the forkserver for an already loaded worker. Must be called before
+// the runner starts any threads.
+bool StartIsolatedWorker(const WorkerApi& api, IsolatedWorker* worker, std::string* error);
+void StopIsolatedWorker(IsolatedWorker* worker);
+
+// Same contract as RunWorkerBatch. A case that kills the child gets an empty
+// span and an entry in crashes; the child is respawned and the remaining
+// cases continue in the new child. A case too large for the input area also
+// gets an empty span and an entry, with not_run set.
+bool RunIsolatedBatch(IsolatedWorker* worker, const uint8_t* inputs, size_t inputs_len,
+                      const std::vector<size_t>& input_offsets, std::vector<uint8_t>* outputs,
+                      std::vector<size_t>* output_offsets, std::vector<IsolatedCrash>* crashes,
+                      std::string* error);
+
+// The child's heartbeat, beaten once per case, for a Watchdog to watch.
+Heartbeat* IsolatedHeartbeat(IsolatedWorker* worker);
+
+// Kills the serving child from another thread and flags the death as a
+// timeout, unless the heartbeat has moved past beat. RunIsolatedBatch then
+// reports the running case as a crash with timed_out set, respawns the
+// child, and carries on with the next case.
+void ExpireIsolatedCase(IsolatedWorker* worker, uint64_t beat);
+
+// Human-readable form of a wait status, e.g. "signal 11".
+std::string DescribeExitStatus(int status);
+
+// Why an isolated case has no output, e.g. "crashed (signal 11)" or "not
+// run (case exceeds the 16 MiB isolated input area)".
+std::string DescribeIsolatedCrash(const IsolatedCrash& crash);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_RUNNER_ISOLATE_H
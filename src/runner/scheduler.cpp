@@ -0,0 +1,235 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace sp_differ {
+namespace {
+
+struct Range {
+  size_t begin;
+  size_t end;
+};
+
+struct WorkQueue {
+  std::mutex mutex;
+  std::deque<Range> ranges;
+};
+
+bool PopFront(WorkQueue* queue, Range* out) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  if (queue->ranges.empty()) {
+    return false;
+  }
+  *out = queue->ranges.front();
+  queue->ranges.pop_front();
+  return true;
+}
+
+bool StealBack(WorkQueue* queue, Range* out) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  if (queue->ranges.empty()) {
+    return false;
+  }
+  *out = queue->ranges.back();
+  queue->ranges.pop_back();
+  return true;
+}
+
+void PinCurrentThread(unsigned index) {
+#if defined(__linux__)
+  unsigned cpus = std::thread::hardware_concurrency();
+  if (cpus == 0) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % cpus, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)index;
+#endif
+}
+
+// Splits count into chunk-sized ranges dealt out in contiguous runs to one
+// queue per job, plus spare empty queues for replacement threads. Returns
+// the job count, which is never more than the number of chunks.
+unsigned PlanQueues(size_t count, const SchedulerOptions& options, unsigned spare,
+                    std::vector<std::unique_ptr<WorkQueue>>* queues) {
+  size_t chunk = std::max<size_t>(1, options.chunk_size);
+  size_t chunk_count = (count + chunk - 1) / chunk;
+  unsigned jobs = ResolveJobCount(options.jobs);
+  if (chunk_count < jobs) {
+    jobs = static_cast<unsigned>(std::max<size_t>(1, chunk_count));
+  }
+  queues->reserve(jobs + spare);
+  for (unsigned t = 0; t < jobs + spare; ++t) {
+    queues->push_back(std::make_unique<WorkQueue>());
+  }
+  for (size_t c = 0; c < chunk_count; ++c) {
+    size_t owner = c * jobs / chunk_count;
+    size_t begin = c * chunk;
+    (*queues)[owner]->ranges.push_back(Range{begin, std::min(count, begin + chunk)});
+  }
+  return jobs;
+}
+
+}  // namespace
+
+// State of one replaceable run. Queues and thread slots are allocated for
+// every index up front, so a replacement never reallocates them under
+// threads that are already stealing.
+struct StealingRun {
+  const RangeTask* task = nullptr;
+  bool pin_threads = false;
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+  std::atomic<unsigned> queue_count{0};
+  std::vector<std::thread> threads;
+  // Threads still running; guarded by SchedulerControl::mutex.
+  unsigned live = 0;
+  unsigned replacements = 0;
+  // Set by StopStalledRun; threads take no further work once it is.
+  std::atomic<bool> stopped{false};
+  std::condition_variable done;
+};
+
+namespace {
+
+void RunStealingThread(SchedulerControl* control, StealingRun* run, unsigned self) {
+  if (run->pin_threads) {
+    PinCurrentThread(self);
+  }
+  Range range{};
+  while (!run->stopped.load(std::memory_order_acquire)) {
+    bool found = PopFront(run->queues[self].get(), &range);
+    unsigned count = run->queue_count.load(std::memory_order_acquire);
+    for (unsigned step = 1; step < count && !found; ++step) {
+      found = StealBack(run->queues[(self + step) % count].get(), &range);
+    }
+    if (!found) {
+      break;
+    }
+    (*run->task)(self, range.begin, range.end);
+  }
+  std::lock_guard<std::mutex> lock(control->mutex);
+  --run->live;
+  run->done.notify_all();
+}
+
+}  // namespace
+
+unsigned ResolveJobCount(unsigned jobs) {
+  if (jobs != 0) {
+    return jobs;
+  }
+  unsigned cpus = std::thread::hardware_concurrency();
+  return cpus == 0 ? 1 : cpus;
+}
+
+void RunWorkStealing(size_t count, const SchedulerOptions& options, const RangeTask& task) {
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+  unsigned jobs = PlanQueues(count, options, 0, &queues);
+
+  auto run_thread = [&](unsigned self) {
+    if (options.pin_threads) {
+      PinCurrentThread(self);
+    }
+    Range range{};
+    for (;;) {
+      if (PopFront(queues[self].get(), &range)) {
+        task(self, range.begin, range.end);
+        continue;
+      }
+      bool stole = false;
+      for (unsigned step = 1; step < jobs && !stole; ++step) {
+        stole = StealBack(queues[(self + step) % jobs].get(), &range);
+      }
+      if (!stole) {
+        // Queues only shrink once the run starts, so an empty sweep means
+        // every chunk has been claimed.
+        return;
+      }
+      task(self, range.begin, range.end);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(jobs - 1);
+  for (unsigned t = 1; t < jobs; ++t) {
+    threads.emplace_back(run_thread, t);
+  }
+  run_thread(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+void RunWorkStealing(size_t count, const SchedulerOptions& options, const RangeTask& task,
+                     SchedulerControl* control) {
+  StealingRun run;
+  run.task = &task;
+  run.pin_threads = options.pin_threads;
+  unsigned jobs = PlanQueues(count, options, control->max_replacements, &run.queues);
+  run.threads.resize(run.queues.size());
+  run.queue_count.store(jobs, std::memory_order_release);
+
+  std::unique_lock<std::mutex> lock(control->mutex);
+  control->run = &run;
+  run.live = jobs;
+  for (unsigned t = 0; t < jobs; ++t) {
+    run.threads[t] = std::thread(RunStealingThread, control, &run, t);
+  }
+  run.done.wait(lock, [&run] { return run.live == 0; });
+  control->run = nullptr;
+  lock.unlock();
+  for (std::thread& thread : run.threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+bool ReplaceStalledThread(SchedulerControl* control, unsigned thread, size_t begin, size_t end) {
+  std::lock_guard<std::mutex> lock(control->mutex);
+  StealingRun* run = control->run;
+  if (!run || run->stopped.load(std::memory_order_relaxed) ||
+      run->replacements >= control->max_replacements || !run->threads[thread].joinable()) {
+    return false;
+  }
+  unsigned self = run->queue_count.load(std::memory_order_relaxed);
+  ++run->replacements;
+  run->queues[self]->ranges.push_back(Range{begin, end});
+  run->queue_count.store(self + 1, std::memory_order_release);
+  // The stalled thread never comes back, so it is neither joined nor
+  // counted; the replacement takes its place in live.
+  run->threads[thread].detach();
+  run->threads[self] = std::thread(RunStealingThread, control, run, self);
+  return true;
+}
+
+bool StopStalledRun(SchedulerControl* control, unsigned thread) {
+  std::lock_guard<std::mutex> lock(control->mutex);
+  StealingRun* run = control->run;
+  if (!run || !run->threads[thread].joinable()) {
+    return false;
+  }
+  run->stopped.store(true, std::memory_order_release);
+  run->threads[thread].detach();
+  --run->live;
+  run->done.notify_all();
+  return true;
+}
+
+}  // namespace sp_differ
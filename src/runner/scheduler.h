@@ -0,0 +1,64 @@
+#ifndef SP_DIFFER_RUNNER_SCHEDULER_H
+#define SP_DIFFER_RUNNER_SCHEDULER_H
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+
+namespace sp_differ {
+
+struct SchedulerOptions {
+  // Number of threads; 0 means one per hardware thread.
+  unsigned jobs = 1;
+  // Number of consecutive indices handed out per task.
+  size_t chunk_size = 1;
+  // Pin thread i to CPU i (modulo the CPU count) where supported.
+  bool pin_threads = false;
+};
+
+// Signature of a task: the thread index in [0, jobs) and a half-open range of
+// item indices. Each index in [0, count) is delivered exactly once.
+using RangeTask = std::function<void(unsigned thread, size_t begin, size_t end)>;
+
+unsigned ResolveJobCount(unsigned jobs);
+
+// Splits [0, count) into chunks and runs them on a work-stealing pool. Every
+// thread starts with a contiguous block of chunks in its own deque, takes
+// work from the front of that deque, and steals from the back of another
+// thread's deque once its own is empty. With one job the tasks run inline on
+// the calling thread in index order.
+void RunWorkStealing(size_t count, const SchedulerOptions& options, const RangeTask& task);
+
+struct StealingRun;
+
+// Lets a watchdog swap a stalled thread out of a running RunWorkStealing.
+// Replacement r of a run gets thread index jobs + r, so per-thread state
+// must be sized for jobs + max_replacements.
+struct SchedulerControl {
+  unsigned max_replacements = 0;
+  std::mutex mutex;
+  // The active run, if any; guarded by mutex.
+  StealingRun* run = nullptr;
+};
+
+// As above, but replaceable through control. Every job runs on its own
+// thread, even with one job, so that the calling thread only waits and a
+// stalled job can be left behind.
+void RunWorkStealing(size_t count, const SchedulerOptions& options, const RangeTask& task,
+                     SchedulerControl* control);
+
+// Gives up on thread, which is stuck inside the task and must never return
+// to the scheduler, and starts a replacement with a fresh thread index. The
+// replacement first runs [begin, end), then steals like any other thread.
+// Returns false when no run is active or the replacement budget is spent.
+bool ReplaceStalledThread(SchedulerControl* control, unsigned thread, size_t begin, size_t end);
+
+// Gives up on thread as above, without a replacement, and stops the run:
+// the other threads finish the task they are in and take no more work, so
+// RunWorkStealing returns with some ranges never delivered. Further
+// replacements are refused. Returns false when no run is active.
+bool StopStalledRun(SchedulerControl* control, unsigned thread);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_RUNNER_SCHEDULER_H
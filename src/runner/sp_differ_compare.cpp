@@ -1,42 +1,927 @@
 #include "../../ffi/sp_differ.h"
+#include "../core/cache.h"
+#include "../core/corpus.h"
+#include "../core/diff.h"
+#include "../core/hash.h"
 #include "../core/io.h"
+#include "../core/metrics.h"
+#include "../core/pack.h"
+#include "../core/signature.h"
+#include "../core/stream.h"
 #include "../core/validate.h"
+#include "../reporter/reporter.h"
+#include "compare_cases.h"
+#include "isolate.h"
+#include "scheduler.h"
+#include "vote_mode.h"
+#include "watchdog.h"
 #include "worker.h"
+#include "worker_pool.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <filesystem>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 namespace {
 
-void PrintMismatch(const std::vector<uint8_t>& left, const std::vector<uint8_t>& right) {
+// In-process --timeout leaves each hung call's thread behind; past this many
+// the run gives up rather than keep leaking threads.
+constexpr unsigned kMaxAbandonedThreads = 8;
+// Such runs start fresh threads for every RunCases call, so their stream
+// windows hold this many batches per thread to keep thread startup off the
+// per-case cost.
+constexpr size_t kWatchedWindowBatches = 16;
+
+struct MismatchInfo {
+  size_t left_len = 0;
+  size_t right_len = 0;
+  size_t first_diff = 0;
+  // -1 when first_diff is past the end of that side (length mismatch).
+  int left_byte = -1;
+  int right_byte = -1;
+  // Every diverging field, e.g. "pubkey[1] tweak[1]".
+  std::string fields;
+};
+
+struct CaseOutcome {
+  sp_differ::CaseResult result = sp_differ::CaseResult::kError;
+  std::string error;
+  MismatchInfo mismatch;
+  // Filled only when a report is being written.
+  uint64_t seed = 0;
+  uint64_t case_hash = 0;
+  int left_status = -1;
+  int right_status = -1;
+  double left_us = 0.0;
+  double right_us = 0.0;
+  // Mismatches only. Non-exemplars are counted under their signature and
+  // otherwise stay quiet.
+  sp_differ::MismatchSignature signature;
+  bool exemplar = false;
+};
+
+struct BatchTotals {
+  size_t pass = 0;
+  size_t mismatch = 0;
+  size_t error = 0;
+  size_t crash = 0;
+  size_t timeout = 0;
+};
+
+struct BatchOptions {
+  sp_differ::SchedulerOptions scheduler;
+  std::string artifact_dir = "artifacts";
+  sp_differ::Reporter* reporter = nullptr;
+  sp_differ::SignatureTable* signatures = nullptr;
+  // Outputs are cached per worker library build (XXH64 of the file).
+  sp_differ::OutputCache* cache = nullptr;
+  uint64_t left_library = 0;
+  uint64_t right_library = 0;
+  // Streams only: drop cases whose canonical hash was already seen, keeping
+  // at most dedup_max_mb of hashes; 0 for no limit.
+  bool dedup = false;
+  size_t dedup_max_mb = 64;
+  sp_differ::CompareMode compare_mode = sp_differ::CompareMode::kOrdered;
+  // Stage timings, one recorder per scheduler thread plus one for the
+  // stream reader; null when --metrics and --trace are both off.
+  std::vector<sp_differ::StageRecorder>* recorders = nullptr;
+  // Per-case deadline; 0 for none.
+  uint32_t timeout_ms = 0;
+  // Watchdog state for in-process workers under a deadline; null otherwise.
+  struct InProcessTimeouts* timeouts = nullptr;
+};
+
+// Buffers owned by one scheduler thread and reused for every chunk it runs.
+struct ThreadScratch : sp_differ::ChunkInputs {
+  // The chunk being run and the cases of the worker call in flight, for the
+  // watchdog: call case k is members[misses[k]] when only cache misses were
+  // sent, else members[k].
+  size_t chunk_begin = 0;
+  size_t chunk_end = 0;
+  const uint8_t* call_inputs = nullptr;
+  const std::vector<size_t>* call_offsets = nullptr;
+  bool call_misses = false;
+  std::vector<uint8_t> left_outputs;
+  std::vector<size_t> left_offsets;
+  std::vector<uint8_t> right_outputs;
+  std::vector<size_t> right_offsets;
+  std::vector<sp_differ::IsolatedCrash> left_crashes;
+  std::vector<sp_differ::IsolatedCrash> right_crashes;
+  // Per member: both outputs passed validation.
+  std::vector<uint8_t> valid;
+  sp_differ::DiffScratch diff;
+  std::vector<sp_differ::FieldDiff> diffs;
+  // Output cache bookkeeping, one side at a time.
+  std::vector<uint64_t> case_hashes;
+  std::vector<uint8_t> cached;
+  std::vector<size_t> cached_offsets;
+  std::vector<uint8_t> miss_inputs;
+  std::vector<size_t> miss_offsets;
+  std::vector<size_t> misses;
+  std::vector<uint8_t> miss_outputs;
+  std::vector<size_t> miss_output_offsets;
+};
+
+// In-process --timeout state, shared with the watchdog thread. Heartbeats
+// and scratch are indexed by scheduler thread, replacement threads included.
+// Scratch outlives each RunCases call because an abandoned worker call may
+// still be reading the inputs it was handed.
+struct InProcessTimeouts {
+  std::unique_ptr<sp_differ::Heartbeat[]> left;
+  std::unique_ptr<sp_differ::Heartbeat[]> right;
+  std::vector<ThreadScratch> scratch;
+  sp_differ::SchedulerControl control;
+  // Cases of the RunCases call in flight.
+  std::vector<CaseOutcome>* outcomes = nullptr;
+  std::atomic<unsigned> abandoned{0};
+  // Set once the replacement budget is spent: the run in flight drains and
+  // no further cases are started.
+  std::atomic<bool> stopped{false};
+};
+
+// Describes two outputs that compared unequal under mode: the first
+// differing byte and, in diffs, every diverging field. Mismatches are rare,
+// so this full pass only runs once the fast comparison has failed.
+MismatchInfo DescribeMismatch(const uint8_t* left, size_t left_len, const uint8_t* right,
+                              size_t right_len, sp_differ::CompareMode mode,
+                              sp_differ::DiffScratch* scratch,
+                              std::vector<sp_differ::FieldDiff>* diffs) {
+  sp_differ::DiffOutputs(left, left_len, right, right_len, mode, scratch, diffs);
+  MismatchInfo info;
+  info.fields = sp_differ::FormatFieldDiffs(*diffs, sp_differ::kMaxListedFields);
+  info.left_len = left_len;
+  info.right_len = right_len;
+
+  size_t min_len = left_len < right_len ? left_len : right_len;
+  size_t i = 0;
+  while (i < min_len && left[i] == right[i]) {
+    ++i;
+  }
+  info.first_diff = i;
+  if (i < left_len) {
+    info.left_byte = left[i];
+  }
+  if (i < right_len) {
+    info.right_byte = right[i];
+  }
+  return info;
+}
+
+void PrintMismatch(const MismatchInfo& info) {
   std::cerr << "MISMATCH: outputs differ" << std::endl;
-  std::cerr << "  left_len: " << left.size() << std::endl;
-  std::cerr << "  right_len: " << right.size() << std::endl;
+  std::cerr << "  left_len: " << info.left_len << std::endl;
+  std::cerr << "  right_len: " << info.right_len << std::endl;
+  if (!info.fields.empty()) {
+    std::cerr << "  fields: " << info.fields << std::endl;
+  }
+
+  if (info.left_byte >= 0 && info.right_byte >= 0) {
+    std::cerr << "  first_diff: " << info.first_diff << " left=0x" << std::hex << std::setw(2)
+              << std::setfill('0') << info.left_byte << " right=0x" << std::setw(2)
+              << info.right_byte << std::dec << std::endl;
+    return;
+  }
+
+  if (info.left_len != info.right_len) {
+    std::cerr << "  first_diff: " << info.first_diff << " (length mismatch)" << std::endl;
+  }
+}
+
+// Saves the first cases of each mismatch signature; later hits of the same
+// signature only bump its count.
+std::string SaveMismatchArtifact(const std::string& dir, uint64_t signature_key,
+                                 uint64_t case_hash, const uint8_t* payload, size_t payload_len) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  std::ostringstream name;
+  name << "mismatch-" << std::hex << std::setfill('0') << std::setw(16) << signature_key << "-"
+       << std::setw(16) << case_hash << ".hex";
+  std::string path = (std::filesystem::path(dir) / name.str()).string();
+  std::string error;
+  if (!sp_differ::WriteCasePayloadHex(path, payload, payload_len, &error)) {
+    return std::string();
+  }
+  return path;
+}
+
+bool OpenSide(const std::string& worker, const char* side, unsigned threads, bool isolate,
+              sp_differ::WorkerPool* pool, std::string* error) {
+  if (!sp_differ::OpenWorkerPool(sp_differ::ResolveWorkerPath(worker), threads, isolate, pool,
+                                 error)) {
+    *error = std::string(side) + ": " + *error;
+    return false;
+  }
+  if (pool->mode != sp_differ::WorkerConcurrency::kConcurrent &&
+      pool->mode != sp_differ::WorkerConcurrency::kIsolated) {
+    std::cerr << "NOTE: " << side << " worker is not reentrant; calls are "
+              << sp_differ::WorkerConcurrencyName(pool->mode) << std::endl;
+  }
+  return true;
+}
+
+bool ValidateOutputs(const uint8_t* left, size_t left_len, const uint8_t* right,
+                     size_t right_len, std::string* error) {
+  if (!sp_differ::ValidateOutputPayload(left, left_len, error)) {
+    *error = "left output invalid";
+    return false;
+  }
+  if (!sp_differ::ValidateOutputPayload(right, right_len, error)) {
+    *error = "right output invalid";
+    return false;
+  }
+  return true;
+}
+
+// Compares two validated outputs.
+sp_differ::CaseResult CompareOutputs(const uint8_t* left, size_t left_len, const uint8_t* right,
+                                     size_t right_len, sp_differ::CompareMode mode,
+                                     sp_differ::DiffScratch* scratch) {
+  if (!sp_differ::OutputsEqual(left, left_len, right, right_len, mode, scratch)) {
+    return sp_differ::CaseResult::kMismatch;
+  }
+  return sp_differ::CaseResult::kPass;
+}
+
+// A single case is timed like a batch; its read stage includes the decode.
+int RunSingle(const std::string& case_path, sp_differ::WorkerPool& left,
+              sp_differ::WorkerPool& right, sp_differ::CompareMode mode,
+              sp_differ::StageRecorder* recorder) {
+  std::vector<uint8_t> input;
+  std::string error;
+  uint64_t t = sp_differ::StageStart(recorder);
+  bool read = sp_differ::ReadCaseRef(case_path, &input, &error);
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kRead, t);
+  if (!read || !sp_differ::ValidateCaseHeader(input, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kValidateCase, t);
+
+  std::vector<uint8_t> left_output;
+  std::vector<uint8_t> right_output;
+  if (!sp_differ::RunPooledWorker(left, 0, input, &left_output, &error)) {
+    std::cerr << "FAIL: left: " << error << std::endl;
+    return 2;
+  }
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kLeftWorker, t);
+  if (!sp_differ::RunPooledWorker(right, 0, input, &right_output, &error)) {
+    std::cerr << "FAIL: right: " << error << std::endl;
+    return 2;
+  }
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kRightWorker, t);
+
+  if (!ValidateOutputs(left_output.data(), left_output.size(), right_output.data(),
+                       right_output.size(), &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kValidateOutput, t);
+  sp_differ::DiffScratch scratch;
+  sp_differ::CaseResult result = CompareOutputs(left_output.data(), left_output.size(),
+                                                right_output.data(), right_output.size(), mode,
+                                                &scratch);
+  sp_differ::RecordStage(recorder, sp_differ::Stage::kCompare, t);
+  if (result == sp_differ::CaseResult::kMismatch) {
+    std::vector<sp_differ::FieldDiff> diffs;
+    PrintMismatch(DescribeMismatch(left_output.data(), left_output.size(), right_output.data(),
+                                   right_output.size(), mode, &scratch, &diffs));
+    return 2;
+  }
+
+  std::cout << "OK: outputs match" << std::endl;
+  return 0;
+}
+
+// The seed field of a validated v1 case header.
+uint64_t CaseSeed(const uint8_t* payload) {
+  uint64_t seed = 0;
+  for (int b = 0; b < 8; ++b) {
+    seed |= static_cast<uint64_t>(payload[1 + b]) << (8 * b);
+  }
+  return seed;
+}
+
+// Fills the report fields of every case in the chunk. Worker time is the
+// batch call time split evenly over its cases.
+void DescribeForReport(const uint8_t* inputs, const ThreadScratch& scratch,
+                       std::chrono::steady_clock::time_point left_start,
+                       std::chrono::steady_clock::time_point right_start, bool ran,
+                       std::vector<CaseOutcome>* outcomes) {
+  size_t count = scratch.members.size();
+  if (count == 0) {
+    return;
+  }
+  std::chrono::duration<double, std::micro> left_time = right_start - left_start;
+  std::chrono::duration<double, std::micro> right_time =
+      std::chrono::steady_clock::now() - right_start;
+  for (size_t j = 0; j < count; ++j) {
+    CaseOutcome& outcome = (*outcomes)[scratch.members[j]];
+    const uint8_t* payload = inputs + scratch.offsets[j];
+    size_t payload_len = scratch.offsets[j + 1] - scratch.offsets[j];
+    outcome.case_hash = sp_differ::HashCase(payload, payload_len);
+    outcome.seed = CaseSeed(payload);
+    outcome.left_us = left_time.count() / count;
+    outcome.right_us = right_time.count() / count;
+    if (!ran) {
+      continue;
+    }
+    // Status is the second output byte; a failed or crashed call leaves an
+    // empty span.
+    if (scratch.left_offsets[j + 1] - scratch.left_offsets[j] >= 2) {
+      outcome.left_status = scratch.left_outputs[scratch.left_offsets[j] + 1];
+    }
+    if (scratch.right_offsets[j + 1] - scratch.right_offsets[j] >= 2) {
+      outcome.right_status = scratch.right_outputs[scratch.right_offsets[j] + 1];
+    }
+  }
+}
+
+// Stores the valid outputs of a worker batch. Crashed and failed cases have
+// no valid output and are never cached. The cache is best effort, so a
+// failed store only costs a rerun next time.
+void StoreSideOutputs(sp_differ::OutputCache* cache, uint64_t library,
+                      const std::vector<uint64_t>& case_hashes, const std::vector<size_t>* members,
+                      const std::vector<uint8_t>& outputs, const std::vector<size_t>& offsets) {
+  std::string error;
+  for (size_t k = 0; k + 1 < offsets.size(); ++k) {
+    const uint8_t* output = outputs.data() + offsets[k];
+    size_t output_len = offsets[k + 1] - offsets[k];
+    if (sp_differ::ValidateOutputPayload(output, output_len, &error)) {
+      uint64_t case_hash = case_hashes[members ? (*members)[k] : k];
+      sp_differ::StoreCachedOutput(cache, library, case_hash, output, output_len, &error);
+    }
+  }
+}
 
-  size_t min_len = left.size() < right.size() ? left.size() : right.size();
-  for (size_t i = 0; i < min_len; ++i) {
-    if (left[i] != right[i]) {
-      std::cerr << "  first_diff: " << i << " left=0x" << std::hex << std::setw(2)
-                << std::setfill('0') << static_cast<int>(left[i]) << " right=0x"
-                << std::setw(2) << static_cast<int>(right[i]) << std::dec << std::endl;
-      return;
+// Runs one side of a chunk. With an output cache, cached outputs are copied
+// out and only the misses reach the worker, in one batch call.
+bool RunSide(sp_differ::WorkerPool& pool, unsigned thread, sp_differ::OutputCache* cache,
+             uint64_t library, const uint8_t* inputs, size_t inputs_len, ThreadScratch* scratch,
+             std::vector<uint8_t>* outputs, std::vector<size_t>* offsets,
+             std::vector<sp_differ::IsolatedCrash>* crashes, sp_differ::Heartbeat* heartbeat,
+             std::string* error) {
+  scratch->call_inputs = inputs;
+  scratch->call_offsets = &scratch->offsets;
+  scratch->call_misses = false;
+  if (!cache) {
+    return sp_differ::RunPooledWorkerBatch(pool, thread, inputs, inputs_len, scratch->offsets,
+                                           outputs, offsets, crashes, error, heartbeat);
+  }
+  size_t count = scratch->members.size();
+  scratch->cached.clear();
+  scratch->cached_offsets.assign(1, 0);
+  scratch->miss_inputs.clear();
+  scratch->miss_offsets.assign(1, 0);
+  scratch->misses.clear();
+  for (size_t j = 0; j < count; ++j) {
+    if (!sp_differ::LookupCachedOutput(cache, library, scratch->case_hashes[j],
+                                       &scratch->cached)) {
+      scratch->miss_inputs.insert(scratch->miss_inputs.end(), inputs + scratch->offsets[j],
+                                  inputs + scratch->offsets[j + 1]);
+      scratch->miss_offsets.push_back(scratch->miss_inputs.size());
+      scratch->misses.push_back(j);
     }
+    scratch->cached_offsets.push_back(scratch->cached.size());
   }
 
-  if (left.size() != right.size()) {
-    std::cerr << "  first_diff: " << min_len << " (length mismatch)" << std::endl;
+  crashes->clear();
+  if (scratch->misses.empty()) {
+    outputs->swap(scratch->cached);
+    offsets->swap(scratch->cached_offsets);
+    return true;
+  }
+  if (scratch->misses.size() == count) {
+    if (!sp_differ::RunPooledWorkerBatch(pool, thread, inputs, inputs_len, scratch->offsets,
+                                         outputs, offsets, crashes, error, heartbeat)) {
+      return false;
+    }
+    StoreSideOutputs(cache, library, scratch->case_hashes, nullptr, *outputs, *offsets);
+    return true;
+  }
+
+  scratch->call_inputs = scratch->miss_inputs.data();
+  scratch->call_offsets = &scratch->miss_offsets;
+  scratch->call_misses = true;
+  if (!sp_differ::RunPooledWorkerBatch(pool, thread, scratch->miss_inputs.data(),
+                                       scratch->miss_inputs.size(), scratch->miss_offsets,
+                                       &scratch->miss_outputs, &scratch->miss_output_offsets,
+                                       crashes, error, heartbeat)) {
+    return false;
+  }
+  StoreSideOutputs(cache, library, scratch->case_hashes, &scratch->misses, scratch->miss_outputs,
+                   scratch->miss_output_offsets);
+  // Interleave cached and fresh outputs back into case order.
+  outputs->clear();
+  offsets->assign(1, 0);
+  size_t k = 0;
+  for (size_t j = 0; j < count; ++j) {
+    if (k < scratch->misses.size() && scratch->misses[k] == j) {
+      outputs->insert(outputs->end(),
+                      scratch->miss_outputs.begin() + scratch->miss_output_offsets[k],
+                      scratch->miss_outputs.begin() + scratch->miss_output_offsets[k + 1]);
+      ++k;
+    } else {
+      outputs->insert(outputs->end(), scratch->cached.begin() + scratch->cached_offsets[j],
+                      scratch->cached.begin() + scratch->cached_offsets[j + 1]);
+    }
+    offsets->push_back(outputs->size());
+  }
+  for (sp_differ::IsolatedCrash& crash : *crashes) {
+    crash.case_index = scratch->misses[crash.case_index];
   }
+  return true;
+}
+
+// Gathers the cases in [begin, end) and sends each side a single
+// RunWorkerBatch call.
+void RunChunk(const sp_differ::CaseSource& source, size_t begin, size_t end,
+              sp_differ::WorkerPool& left, sp_differ::WorkerPool& right, unsigned thread,
+              const BatchOptions& options, ThreadScratch* scratch,
+              std::vector<CaseOutcome>* outcomes) {
+  sp_differ::StageRecorder* recorder =
+      options.recorders ? &(*options.recorders)[thread] : nullptr;
+  const uint8_t* inputs = nullptr;
+  size_t inputs_len = 0;
+  scratch->chunk_begin = begin;
+  scratch->chunk_end = end;
+  sp_differ::GatherChunk(source, begin, end, scratch, recorder, outcomes, &inputs, &inputs_len);
+  size_t count = scratch->members.size();
+  sp_differ::Heartbeat* left_beat = options.timeouts ? &options.timeouts->left[thread] : nullptr;
+  sp_differ::Heartbeat* right_beat = options.timeouts ? &options.timeouts->right[thread] : nullptr;
+
+  if (options.cache) {
+    scratch->case_hashes.clear();
+    for (size_t j = 0; j < scratch->members.size(); ++j) {
+      scratch->case_hashes.push_back(sp_differ::HashCase(
+          inputs + scratch->offsets[j], scratch->offsets[j + 1] - scratch->offsets[j]));
+    }
+  }
+
+  // Worker stages are batch calls, so each case is charged the batch
+  // average.
+  std::string batch_error;
+  auto left_start = std::chrono::steady_clock::now();
+  uint64_t t = sp_differ::StageStart(recorder);
+  bool ran = RunSide(left, thread, options.cache, options.left_library, inputs, inputs_len,
+                     scratch, &scratch->left_outputs, &scratch->left_offsets,
+                     &scratch->left_crashes, left_beat, &batch_error);
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kLeftWorker, t, count);
+  auto right_start = std::chrono::steady_clock::now();
+  ran = ran && RunSide(right, thread, options.cache, options.right_library, inputs, inputs_len,
+                       scratch, &scratch->right_outputs, &scratch->right_offsets,
+                       &scratch->right_crashes, right_beat, &batch_error);
+  if (ran) {
+    sp_differ::RecordStage(recorder, sp_differ::Stage::kRightWorker, t, count);
+  }
+  if (options.reporter) {
+    DescribeForReport(inputs, *scratch, left_start, right_start, ran, outcomes);
+  }
+  if (ran) {
+    for (const char* side : {"left", "right"}) {
+      const auto& crashes = side[0] == 'l' ? scratch->left_crashes : scratch->right_crashes;
+      for (const sp_differ::IsolatedCrash& crash : crashes) {
+        CaseOutcome& outcome = (*outcomes)[scratch->members[crash.case_index]];
+        if (crash.not_run) {
+          // An error, not a crash: nothing ran, so there is no artifact.
+          if (outcome.error.empty()) {
+            outcome.error =
+                std::string(side) + " worker " + sp_differ::DescribeIsolatedCrash(crash);
+          }
+          continue;
+        }
+        const uint8_t* payload = inputs + scratch->offsets[crash.case_index];
+        size_t payload_len =
+            scratch->offsets[crash.case_index + 1] - scratch->offsets[crash.case_index];
+        std::string artifact = sp_differ::SaveCaseArtifact(
+            options.artifact_dir, crash.timed_out ? "timeout" : "crash", side, payload,
+            payload_len);
+        if (crash.timed_out) {
+          outcome.result = sp_differ::CaseResult::kTimeout;
+          outcome.error = std::string(side) + " worker timed out after " +
+                          std::to_string(options.timeout_ms) + " ms; child killed";
+        } else {
+          outcome.result = sp_differ::CaseResult::kCrash;
+          outcome.error = std::string(side) + " worker crashed (" +
+                          sp_differ::DescribeExitStatus(crash.status) + ")";
+        }
+        if (!artifact.empty()) {
+          outcome.error += "; saved " + artifact;
+        }
+      }
+    }
+  }
+
+  if (!ran) {
+    for (size_t j = 0; j < count; ++j) {
+      (*outcomes)[scratch->members[j]].error = batch_error;
+    }
+    return;
+  }
+
+  // Validation and comparison are separate passes so each is one stage.
+  t = sp_differ::StageStart(recorder);
+  scratch->valid.assign(count, 0);
+  for (size_t j = 0; j < count; ++j) {
+    CaseOutcome& outcome = (*outcomes)[scratch->members[j]];
+    if (outcome.result == sp_differ::CaseResult::kCrash ||
+        outcome.result == sp_differ::CaseResult::kTimeout) {
+      continue;
+    }
+    const uint8_t* left = scratch->left_outputs.data() + scratch->left_offsets[j];
+    size_t left_len = scratch->left_offsets[j + 1] - scratch->left_offsets[j];
+    const uint8_t* right = scratch->right_outputs.data() + scratch->right_offsets[j];
+    size_t right_len = scratch->right_offsets[j + 1] - scratch->right_offsets[j];
+    if (left_len == 0 || right_len == 0) {
+      if (outcome.error.empty()) {
+        outcome.error = "worker run failed";
+      }
+      continue;
+    }
+    scratch->valid[j] = ValidateOutputs(left, left_len, right, right_len, &outcome.error);
+  }
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kValidateOutput, t, count);
+
+  for (size_t j = 0; j < count; ++j) {
+    if (!scratch->valid[j]) {
+      continue;
+    }
+    CaseOutcome& outcome = (*outcomes)[scratch->members[j]];
+    const uint8_t* left = scratch->left_outputs.data() + scratch->left_offsets[j];
+    size_t left_len = scratch->left_offsets[j + 1] - scratch->left_offsets[j];
+    const uint8_t* right = scratch->right_outputs.data() + scratch->right_offsets[j];
+    size_t right_len = scratch->right_offsets[j + 1] - scratch->right_offsets[j];
+    outcome.result =
+        CompareOutputs(left, left_len, right, right_len, options.compare_mode, &scratch->diff);
+    if (outcome.result != sp_differ::CaseResult::kMismatch) {
+      continue;
+    }
+    outcome.mismatch = DescribeMismatch(left, left_len, right, right_len, options.compare_mode,
+                                        &scratch->diff, &scratch->diffs);
+    outcome.exemplar = true;
+    if (!options.signatures) {
+      continue;
+    }
+    // Classified and recorded here rather than in ReportOutcome so that
+    // hashing and artifact writes stay off the reporting lock. With several
+    // jobs the exemplars are the first cases to finish, not the lowest
+    // indices. Ordered runs keep the first-differing-byte signature, so keys
+    // stay comparable with earlier runs; a reordering says nothing in
+    // unordered runs, which key on the first unmatched field instead.
+    if (options.compare_mode == sp_differ::CompareMode::kUnordered) {
+      outcome.signature = sp_differ::SignatureOfDiff(scratch->diffs, left[1], right[1]);
+    } else {
+      sp_differ::ClassifyMismatch(left, left_len, right, right_len, &outcome.signature);
+    }
+    const uint8_t* payload = inputs + scratch->offsets[j];
+    size_t payload_len = scratch->offsets[j + 1] - scratch->offsets[j];
+    uint64_t case_hash = sp_differ::HashCase(payload, payload_len);
+    outcome.exemplar = sp_differ::RecordMismatch(options.signatures, outcome.signature,
+                                                 sp_differ::CaseName(source, scratch->members[j]),
+                                                 case_hash);
+    if (outcome.exemplar) {
+      std::string artifact =
+          SaveMismatchArtifact(options.artifact_dir, sp_differ::SignatureKey(outcome.signature),
+                               case_hash, payload, payload_len);
+      if (!artifact.empty()) {
+        outcome.error = "saved " + artifact;
+      }
+    }
+  }
+  sp_differ::RecordStage(recorder, sp_differ::Stage::kCompare, t, count);
+}
+
+sp_differ::ReportResult ToReportResult(sp_differ::CaseResult result) {
+  switch (result) {
+    case sp_differ::CaseResult::kPass:
+      return sp_differ::ReportResult::kPass;
+    case sp_differ::CaseResult::kMismatch:
+      return sp_differ::ReportResult::kMismatch;
+    case sp_differ::CaseResult::kCrash:
+      return sp_differ::ReportResult::kCrash;
+    case sp_differ::CaseResult::kTimeout:
+      return sp_differ::ReportResult::kTimeout;
+    case sp_differ::CaseResult::kError:
+      break;
+  }
+  return sp_differ::ReportResult::kError;
+}
+
+void RecordOutcome(sp_differ::Reporter* reporter, const std::string& path,
+                   const CaseOutcome& outcome) {
+  sp_differ::ReportRecord record;
+  record.case_name = &path;
+  record.seed = outcome.seed;
+  record.case_hash = outcome.case_hash;
+  record.result = ToReportResult(outcome.result);
+  record.left_status = outcome.left_status;
+  record.right_status = outcome.right_status;
+  if (outcome.result == sp_differ::CaseResult::kMismatch) {
+    record.first_diff = static_cast<int64_t>(outcome.mismatch.first_diff);
+    record.signature = sp_differ::SignatureKey(outcome.signature);
+  }
+  record.left_us = outcome.left_us;
+  record.right_us = outcome.right_us;
+  record.detail = &outcome.error;
+  sp_differ::AddReportRecord(reporter, record);
+}
+
+void ReportOutcome(const std::string& path, sp_differ::Reporter* reporter, CaseOutcome* outcome,
+                   BatchTotals* totals) {
+  if (reporter) {
+    RecordOutcome(reporter, path, *outcome);
+  }
+  if (outcome->result == sp_differ::CaseResult::kPass) {
+    ++totals->pass;
+  } else if (outcome->result == sp_differ::CaseResult::kMismatch) {
+    ++totals->mismatch;
+    if (outcome->exemplar) {
+      std::cerr << "CASE: " << path << std::endl;
+      PrintMismatch(outcome->mismatch);
+      std::cerr << "  signature: " << sp_differ::FormatMismatchSignature(outcome->signature)
+                << std::endl;
+      if (!outcome->error.empty()) {
+        std::cerr << "  " << outcome->error << std::endl;
+      }
+    }
+  } else if (outcome->result == sp_differ::CaseResult::kCrash) {
+    ++totals->crash;
+    std::cerr << "CRASH: " << path << ": " << outcome->error << std::endl;
+  } else if (outcome->result == sp_differ::CaseResult::kTimeout) {
+    ++totals->timeout;
+    std::cerr << "TIMEOUT: " << path << ": " << outcome->error << std::endl;
+  } else {
+    ++totals->error;
+    std::cerr << "ERROR: " << path << ": " << outcome->error << std::endl;
+  }
+  outcome->error.clear();
+  outcome->error.shrink_to_fit();
+}
+
+// Watchdog expiry for an in-process call: abandons the stalled thread, marks
+// its running case as timed out, and hands its chunk to a replacement. The
+// replacement reruns the chunk without the timed-out case; outputs the
+// abandoned call had already produced are recomputed. Once the replacement
+// budget is spent, the run is stopped instead, so that what it has collected
+// is still reported.
+void ExpireInProcessCall(InProcessTimeouts* timeouts, const BatchOptions& batch, const char* side,
+                         unsigned thread, uint64_t beat) {
+  sp_differ::Heartbeat* heartbeat =
+      side[0] == 'l' ? &timeouts->left[thread] : &timeouts->right[thread];
+  uint32_t busy = sp_differ::kHeartbeatBusy;
+  if (heartbeat->beat.load(std::memory_order_acquire) != beat ||
+      !heartbeat->state.compare_exchange_strong(busy, sp_differ::kHeartbeatAbandoned,
+                                                std::memory_order_acq_rel)) {
+    return;
+  }
+  // While the call is busy the scratch fields describing it stay put.
+  ThreadScratch& scratch = timeouts->scratch[thread];
+  if (heartbeat->beat.load(std::memory_order_acquire) == beat) {
+    size_t k = sp_differ::BeatIndex(beat);
+    size_t member = scratch.call_misses ? scratch.misses[k] : k;
+    const uint8_t* payload = scratch.call_inputs + (*scratch.call_offsets)[k];
+    size_t payload_len = (*scratch.call_offsets)[k + 1] - (*scratch.call_offsets)[k];
+    std::string artifact =
+        sp_differ::SaveCaseArtifact(batch.artifact_dir, "timeout", side, payload, payload_len);
+    CaseOutcome& outcome = (*timeouts->outcomes)[scratch.members[member]];
+    outcome.result = sp_differ::CaseResult::kTimeout;
+    outcome.case_hash = sp_differ::HashCase(payload, payload_len);
+    outcome.seed = CaseSeed(payload);
+    outcome.error = std::string(side) + " worker timed out after " +
+                    std::to_string(batch.timeout_ms) + " ms; thread abandoned";
+    if (!artifact.empty()) {
+      outcome.error += "; saved " + artifact;
+    }
+  }
+  timeouts->abandoned.fetch_add(1);
+  if (sp_differ::ReplaceStalledThread(&timeouts->control, thread, scratch.chunk_begin,
+                                      scratch.chunk_end)) {
+    return;
+  }
+  if (!timeouts->stopped.exchange(true)) {
+    std::cerr << "FAIL: " << side << " worker hung in more than " << kMaxAbandonedThreads
+              << " calls; stopping the run, rerun with --isolate" << std::endl;
+  }
+  sp_differ::StopStalledRun(&timeouts->control, thread);
+}
+
+// Runs every case of source on the work-stealing scheduler. Chunks finish in
+// any order, but outcomes are reported strictly by case index: whichever
+// thread completes the lowest outstanding chunk flushes every finished chunk
+// after it.
+void RunCases(const sp_differ::CaseSource& source, sp_differ::WorkerPool& left,
+              sp_differ::WorkerPool& right, const BatchOptions& batch, BatchTotals* totals) {
+  size_t case_count = sp_differ::CaseCount(source);
+  sp_differ::SchedulerOptions options = batch.scheduler;
+  unsigned jobs = sp_differ::ResolveJobCount(options.jobs);
+  options.jobs = jobs;
+  options.chunk_size =
+      std::max<size_t>(1, std::min(sp_differ::kBatchSize, case_count / (jobs * 4)));
+
+  size_t chunk_count = (case_count + options.chunk_size - 1) / options.chunk_size;
+  std::vector<CaseOutcome> outcomes(case_count);
+  std::vector<ThreadScratch> local_scratch;
+  if (!batch.timeouts) {
+    local_scratch.resize(jobs);
+  }
+  std::vector<ThreadScratch>& scratch = batch.timeouts ? batch.timeouts->scratch : local_scratch;
+  std::vector<uint8_t> chunk_done(chunk_count, 0);
+  size_t next_chunk = 0;
+  std::mutex report_mutex;
+
+  auto task = [&](unsigned thread, size_t begin, size_t end) {
+    RunChunk(source, begin, end, left, right, thread, batch, &scratch[thread], &outcomes);
+
+    std::lock_guard<std::mutex> lock(report_mutex);
+    chunk_done[begin / options.chunk_size] = 1;
+    while (next_chunk < chunk_count && chunk_done[next_chunk]) {
+      size_t first = next_chunk * options.chunk_size;
+      size_t last = std::min(case_count, first + options.chunk_size);
+      for (size_t i = first; i < last; ++i) {
+        ReportOutcome(sp_differ::CaseName(source, i), batch.reporter, &outcomes[i], totals);
+      }
+      ++next_chunk;
+    }
+  };
+  if (!batch.timeouts) {
+    sp_differ::RunWorkStealing(case_count, options, task);
+    return;
+  }
+  InProcessTimeouts* timeouts = batch.timeouts;
+  {
+    std::lock_guard<std::mutex> lock(timeouts->control.mutex);
+    timeouts->outcomes = &outcomes;
+    timeouts->control.max_replacements = kMaxAbandonedThreads - timeouts->abandoned.load();
+  }
+  sp_differ::RunWorkStealing(case_count, options, task, &timeouts->control);
+  {
+    std::lock_guard<std::mutex> lock(timeouts->control.mutex);
+    timeouts->outcomes = nullptr;
+  }
+  if (!timeouts->stopped.load()) {
+    return;
+  }
+  // A stopped run leaves chunks unfinished, which hold back the in-order
+  // flush. Every thread still running has finished its task, and abandoned
+  // ones never touch outcomes again.
+  for (size_t i = next_chunk * options.chunk_size; i < case_count; ++i) {
+    CaseOutcome& outcome = outcomes[i];
+    if (!chunk_done[i / options.chunk_size] &&
+        outcome.result != sp_differ::CaseResult::kTimeout && outcome.error.empty()) {
+      outcome.error = "not run: the run stopped after " +
+                      std::to_string(kMaxAbandonedThreads) + " hung calls";
+    }
+    ReportOutcome(sp_differ::CaseName(source, i), batch.reporter, &outcome, totals);
+  }
+}
+
+// One line per distinct mismatch signature, most hits first.
+void PrintSignatures(sp_differ::SignatureTable* signatures) {
+  if (!signatures) {
+    return;
+  }
+  for (const sp_differ::SignatureCount& count : sp_differ::SnapshotSignatures(signatures)) {
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0')
+        << sp_differ::SignatureKey(count.signature);
+    std::cout << "SIGNATURE: key=" << key.str() << " "
+              << sp_differ::FormatMismatchSignature(count.signature) << " hits=" << count.hits
+              << " exemplars=" << count.exemplars.size() << std::endl;
+  }
+}
+
+int PrintSummary(size_t case_count, const BatchTotals& totals, const BatchOptions& batch,
+                 std::chrono::steady_clock::time_point start) {
+  unsigned jobs = sp_differ::ResolveJobCount(batch.scheduler.jobs);
+  PrintSignatures(batch.signatures);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  double seconds = elapsed.count();
+  double rate = seconds > 0.0 ? static_cast<double>(case_count) / seconds : 0.0;
+  std::cout << "BATCH: cases=" << case_count << " pass=" << totals.pass
+            << " mismatch=" << totals.mismatch << " error=" << totals.error
+            << " crash=" << totals.crash << " timeout=" << totals.timeout << " jobs=" << jobs
+            << std::fixed << std::setprecision(3) << " elapsed_s=" << seconds
+            << std::setprecision(1) << " cases_per_s=" << rate << std::endl;
+
+  return totals.mismatch == 0 && totals.error == 0 && totals.crash == 0 && totals.timeout == 0
+             ? 0
+             : 2;
+}
+
+// Merges the per-thread histograms and prints one line per stage that saw
+// any cases; worker stages also name their worker.
+void PrintLatency(const std::vector<sp_differ::StageRecorder>& recorders,
+                  const std::string& left_worker, const std::string& right_worker) {
+  sp_differ::StageRecorder total;
+  for (const sp_differ::StageRecorder& recorder : recorders) {
+    sp_differ::MergeRecorder(&total, recorder);
+  }
+  for (size_t i = 0; i < sp_differ::kStageCount; ++i) {
+    const sp_differ::LatencyHistogram& histogram = total.stages[i];
+    if (histogram.count == 0) {
+      continue;
+    }
+    sp_differ::Stage stage = static_cast<sp_differ::Stage>(i);
+    std::cout << "LATENCY: stage=" << sp_differ::StageName(stage);
+    if (stage == sp_differ::Stage::kLeftWorker || stage == sp_differ::Stage::kRightWorker) {
+      std::cout << " worker=" << (stage == sp_differ::Stage::kLeftWorker ? left_worker
+                                                                          : right_worker);
+    }
+    std::cout << " count=" << histogram.count << std::fixed << std::setprecision(3)
+              << " mean_us=" << histogram.total_ns / 1000.0 / histogram.count << " "
+              << sp_differ::FormatLatency(histogram) << std::endl;
+  }
+}
+
+bool WriteTrace(const std::string& path, const std::vector<sp_differ::StageRecorder>& recorders,
+                const std::string& left_worker, const std::string& right_worker,
+                std::string* error) {
+  std::vector<std::string> threads;
+  for (size_t i = 0; i + 1 < recorders.size(); ++i) {
+    threads.push_back("job " + std::to_string(i));
+  }
+  threads.push_back("reader");
+  std::array<std::string, sp_differ::kStageCount> names;
+  for (size_t i = 0; i < sp_differ::kStageCount; ++i) {
+    names[i] = sp_differ::StageName(static_cast<sp_differ::Stage>(i));
+  }
+  names[static_cast<size_t>(sp_differ::Stage::kLeftWorker)] += " " + left_worker;
+  names[static_cast<size_t>(sp_differ::Stage::kRightWorker)] += " " + right_worker;
+  return sp_differ::WriteChromeTrace(path, recorders, threads, names, error);
+}
+
+int RunBatch(const sp_differ::CaseSource& source, sp_differ::WorkerPool& left,
+             sp_differ::WorkerPool& right, const BatchOptions& batch) {
+  auto start = std::chrono::steady_clock::now();
+  BatchTotals totals;
+  RunCases(source, left, right, batch, &totals);
+  return PrintSummary(sp_differ::CaseCount(source), totals, batch, start);
+}
+
+// Reads the stream one window of kBatchSize cases per thread (more under an
+// in-process --timeout) at a time and runs each window like a batch.
+int RunStream(const std::string& stream_path, sp_differ::StreamFraming framing,
+              sp_differ::WorkerPool& left, sp_differ::WorkerPool& right,
+              const BatchOptions& batch) {
+  auto start = std::chrono::steady_clock::now();
+  unsigned jobs = sp_differ::ResolveJobCount(batch.scheduler.jobs);
+  size_t window_cases =
+      jobs * sp_differ::kBatchSize * (batch.timeouts ? kWatchedWindowBatches : 1);
+  sp_differ::StageRecorder* reader = batch.recorders ? &batch.recorders->back() : nullptr;
+  sp_differ::CaseSource source;
+  BatchTotals totals;
+  size_t case_count = 0;
+  std::string error;
+  bool opened = sp_differ::ReadStreamWindows(
+      stream_path, framing, window_cases, batch.dedup, batch.dedup_max_mb << 20, reader, &source,
+      &error, [&](const sp_differ::CaseSource& window) {
+        RunCases(window, left, right, batch, &totals);
+        case_count += sp_differ::CaseCount(window);
+        // A stopped run reads no further windows.
+        return !batch.timeouts || !batch.timeouts->stopped;
+      });
+  if (!opened) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  if (!error.empty()) {
+    ++totals.error;
+    std::cerr << "ERROR: " << source.stream_name << ": " << error << std::endl;
+  }
+  return PrintSummary(case_count, totals, batch, start);
 }
 
 }  // namespace
 
 int main(int argc, char** argv) {
   std::string case_path;
+  std::string batch_spec;
+  std::string stream_path;
+  sp_differ::StreamFraming framing = sp_differ::StreamFraming::kAuto;
   std::string left_worker = "cpp";
   std::string right_worker = "rust";
+  bool sides_given = false;
+  std::vector<std::string> vote_workers;
+  BatchOptions batch;
+  bool isolate = false;
+  sp_differ::ReporterOptions report;
+  size_t exemplars = 3;
+  std::string cache_dir;
+  uint64_t cache_max_mb = 1024;
+  bool metrics = false;
+  std::string trace_path;
 
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
@@ -46,14 +931,140 @@ int main(int argc, char** argv) {
         return 2;
       }
       left_worker = argv[++i];
+      sides_given = true;
     } else if (arg == "--right") {
       if (i + 1 >= argc) {
         std::cerr << "FAIL: --right requires a value" << std::endl;
         return 2;
       }
       right_worker = argv[++i];
+      sides_given = true;
+    } else if (arg == "--worker") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --worker requires a value" << std::endl;
+        return 2;
+      }
+      vote_workers.push_back(argv[++i]);
+    } else if (arg == "--batch") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --batch requires a directory, glob, list file, or packed corpus"
+                  << std::endl;
+        return 2;
+      }
+      batch_spec = argv[++i];
+    } else if (arg == "--stream") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --stream requires a path or -" << std::endl;
+        return 2;
+      }
+      stream_path = argv[++i];
+    } else if (arg == "--framing") {
+      if (i + 1 >= argc || !sp_differ::ParseStreamFraming(argv[i + 1], &framing)) {
+        std::cerr << "FAIL: --framing requires auto, hex, or binary" << std::endl;
+        return 2;
+      }
+      ++i;
+    } else if (arg == "--jobs" || arg == "-j") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --jobs requires a value" << std::endl;
+        return 2;
+      }
+      uint64_t jobs = 0;
+      if (!sp_differ::ParseUnsigned(argv[++i], UINT32_MAX, &jobs)) {
+        std::cerr << "FAIL: --jobs requires a non-negative integer" << std::endl;
+        return 2;
+      }
+      batch.scheduler.jobs = static_cast<unsigned>(jobs);
+    } else if (arg == "--pin") {
+      batch.scheduler.pin_threads = true;
+    } else if (arg == "--isolate") {
+      isolate = true;
+    } else if (arg == "--timeout") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --timeout requires milliseconds" << std::endl;
+        return 2;
+      }
+      uint64_t timeout_ms = 0;
+      if (!sp_differ::ParseUnsigned(argv[++i], UINT32_MAX, &timeout_ms)) {
+        std::cerr << "FAIL: --timeout requires a non-negative integer" << std::endl;
+        return 2;
+      }
+      batch.timeout_ms = static_cast<uint32_t>(timeout_ms);
+    } else if (arg == "--artifacts") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --artifacts requires a directory" << std::endl;
+        return 2;
+      }
+      batch.artifact_dir = argv[++i];
+    } else if (arg == "--exemplars") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --exemplars requires a count" << std::endl;
+        return 2;
+      }
+      uint64_t count = 0;
+      if (!sp_differ::ParseUnsigned(argv[++i], SIZE_MAX, &count)) {
+        std::cerr << "FAIL: --exemplars requires a non-negative integer" << std::endl;
+        return 2;
+      }
+      exemplars = static_cast<size_t>(count);
+    } else if (arg == "--unordered") {
+      batch.compare_mode = sp_differ::CompareMode::kUnordered;
+    } else if (arg == "--dedup") {
+      batch.dedup = true;
+    } else if (arg == "--dedup-max-mb") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --dedup-max-mb requires a size" << std::endl;
+        return 2;
+      }
+      uint64_t megabytes = 0;
+      if (!sp_differ::ParseUnsigned(argv[++i], SIZE_MAX >> 20, &megabytes)) {
+        std::cerr << "FAIL: --dedup-max-mb requires a non-negative integer" << std::endl;
+        return 2;
+      }
+      batch.dedup_max_mb = static_cast<size_t>(megabytes);
+    } else if (arg == "--cache") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --cache requires a directory" << std::endl;
+        return 2;
+      }
+      cache_dir = argv[++i];
+    } else if (arg == "--cache-max-mb") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --cache-max-mb requires a size" << std::endl;
+        return 2;
+      }
+      if (!sp_differ::ParseUnsigned(argv[++i], UINT64_MAX >> 20, &cache_max_mb)) {
+        std::cerr << "FAIL: --cache-max-mb requires a non-negative integer" << std::endl;
+        return 2;
+      }
+    } else if (arg == "--metrics") {
+      metrics = true;
+    } else if (arg == "--trace") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --trace requires a path" << std::endl;
+        return 2;
+      }
+      trace_path = argv[++i];
+    } else if (arg == "--report" || arg == "--report-md") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: " << arg << " requires a path" << std::endl;
+        return 2;
+      }
+      (arg == "--report" ? report.jsonl_path : report.markdown_path) = argv[++i];
     } else if (arg == "--help" || arg == "-h") {
-      std::cout << "usage: sp_differ_compare <case> [--left <path|cpp|rust>] [--right <path|cpp|rust>]"
+      std::cout << "usage: sp_differ_compare <case|pack#index> [--left <path|cpp|rust>]"
+                << " [--right <path|cpp|rust>] [--unordered] [--metrics] [--trace <json>]"
+                << std::endl;
+      std::cout << "       sp_differ_compare --batch <dir|glob|list|pack> [--left <path|cpp|rust>]"
+                << " [--right <path|cpp|rust>] [--unordered] [--jobs <n|0>] [--pin] [--isolate]"
+                << " [--timeout <ms>] [--artifacts <dir>] [--exemplars <n|0>] [--cache <dir>]"
+                << " [--cache-max-mb <n>] [--report <jsonl>] [--report-md <md>] [--metrics]"
+                << " [--trace <json>]" << std::endl;
+      std::cout << "       sp_differ_compare - | --stream <path> [--framing auto|hex|binary]"
+                << " [--dedup] [--dedup-max-mb <n>] [batch options]" << std::endl;
+      std::cout << "       sp_differ_compare <case> | --batch <spec> | --stream <path>"
+                << " --worker <path|cpp|rust> --worker ... (3 or more) [--unordered] [--jobs <n|0>]"
+                << " [--pin] [--isolate] [--artifacts <dir>] [--exemplars <n|0>] [--dedup]"
                 << std::endl;
       return 0;
     } else if (case_path.empty()) {
@@ -64,86 +1075,268 @@ int main(int argc, char** argv) {
     }
   }
 
-  if (case_path.empty()) {
-    std::cerr << "FAIL: case path required" << std::endl;
+  if (case_path == "-") {
+    stream_path = "-";
+    case_path.clear();
+  }
+  int modes = !case_path.empty() + !batch_spec.empty() + !stream_path.empty();
+  if (modes != 1) {
+    std::cerr << "FAIL: exactly one of <case>, --batch, or --stream is required" << std::endl;
     return 2;
   }
-
-  std::vector<uint8_t> input;
-  std::string error;
-  if (!sp_differ::ReadCasePayload(case_path, &input, &error)) {
-    std::cerr << "FAIL: " << error << std::endl;
+  bool reporting = !report.jsonl_path.empty() || !report.markdown_path.empty();
+  if (reporting && !case_path.empty()) {
+    std::cerr << "FAIL: reports are written for --batch and --stream runs" << std::endl;
     return 2;
   }
-
-  if (!sp_differ::ValidateCaseHeader(input, &error)) {
-    std::cerr << "FAIL: " << error << std::endl;
+  if (batch.dedup && stream_path.empty()) {
+    std::cerr << "FAIL: --dedup applies to streams; use sp_differ_dedup on a corpus"
+              << std::endl;
+    return 2;
+  }
+  if (!cache_dir.empty() && !case_path.empty()) {
+    std::cerr << "FAIL: --cache is used by --batch and --stream runs" << std::endl;
+    return 2;
+  }
+  if (batch.timeout_ms > 0 && !case_path.empty()) {
+    std::cerr << "FAIL: --timeout applies to --batch and --stream runs" << std::endl;
     return 2;
   }
 
-  std::string left_path = sp_differ::ResolveWorkerPath(left_worker);
-  std::string right_path = sp_differ::ResolveWorkerPath(right_worker);
+  bool voting = !vote_workers.empty();
+  if (voting) {
+    if (vote_workers.size() < 3) {
+      std::cerr << "FAIL: --worker needs at least 3 workers; compare two with --left/--right"
+                << std::endl;
+      return 2;
+    }
+    if (sides_given) {
+      std::cerr << "FAIL: --worker does not combine with --left/--right" << std::endl;
+      return 2;
+    }
+    if (reporting || !cache_dir.empty() || batch.timeout_ms > 0 || metrics ||
+        !trace_path.empty()) {
+      std::cerr << "FAIL: --report, --cache, --timeout, --metrics, and --trace are for"
+                << " two-worker runs" << std::endl;
+      return 2;
+    }
+  }
 
-  sp_differ::WorkerApi left_api{};
-  if (!sp_differ::LoadWorker(left_path, &left_api, &error)) {
-    std::cerr << "FAIL: " << error << std::endl;
-    return 2;
+  std::string error;
+  sp_differ::CaseSource source;
+  // A single case file votes as a batch of one.
+  if (voting && !case_path.empty()) {
+    source.paths.push_back(case_path);
+    case_path.clear();
+  }
+  if (!batch_spec.empty()) {
+    bool listed = sp_differ::IsPackedCorpus(batch_spec)
+                      ? sp_differ::OpenPackedCorpus(batch_spec, &source.packed, &error)
+                      : sp_differ::ListCaseFiles(batch_spec, &source.paths, &error);
+    if (!listed) {
+      std::cerr << "FAIL: " << error << std::endl;
+      return 2;
+    }
+    source.packed_path = batch_spec;
   }
 
-  if (left_api.api_version() != SP_DIFFER_WORKER_API_VERSION) {
-    sp_differ::UnloadWorker(&left_api);
-    std::cerr << "FAIL: left worker ABI version mismatch" << std::endl;
-    return 2;
+  unsigned threads = case_path.empty() ? sp_differ::ResolveJobCount(batch.scheduler.jobs) : 1;
+  batch.scheduler.jobs = threads;
+  // In-process timeouts may start replacement threads with indices past
+  // threads; isolated children are killed and respawned in place instead.
+  bool in_process_timeouts = batch.timeout_ms > 0 && !isolate;
+  unsigned thread_slots = threads + (in_process_timeouts ? kMaxAbandonedThreads : 0);
+
+  if (voting) {
+    std::vector<std::string> labels = sp_differ::VoterLabels(vote_workers);
+    std::vector<sp_differ::Voter> voters(vote_workers.size());
+    for (size_t v = 0; v < voters.size(); ++v) {
+      voters[v].label = labels[v];
+      if (!OpenSide(vote_workers[v], labels[v].c_str(), threads, isolate, &voters[v].pool,
+                    &error)) {
+        for (size_t k = 0; k < v; ++k) {
+          sp_differ::CloseWorkerPool(&voters[k].pool);
+        }
+        sp_differ::ClosePackedCorpus(&source.packed);
+        std::cerr << "FAIL: " << error << std::endl;
+        return 2;
+      }
+    }
+    sp_differ::VotePatterns patterns;
+    // 0 keeps every disagreement as an exemplar.
+    patterns.max_exemplars = exemplars == 0 ? SIZE_MAX : exemplars;
+    sp_differ::VoteOptions options;
+    options.scheduler = batch.scheduler;
+    options.artifact_dir = batch.artifact_dir;
+    options.compare_mode = batch.compare_mode;
+    options.dedup = batch.dedup;
+    options.dedup_max_mb = batch.dedup_max_mb;
+    options.patterns = &patterns;
+    int rc = sp_differ::RunVote(source, stream_path, framing, voters, options);
+    for (sp_differ::Voter& voter : voters) {
+      sp_differ::CloseWorkerPool(&voter.pool);
+    }
+    sp_differ::ClosePackedCorpus(&source.packed);
+    return rc;
   }
 
-  sp_differ::WorkerApi right_api{};
-  if (!sp_differ::LoadWorker(right_path, &right_api, &error)) {
-    sp_differ::UnloadWorker(&left_api);
+  sp_differ::WorkerPool left;
+  if (!OpenSide(left_worker, "left", threads, isolate, &left, &error)) {
+    sp_differ::ClosePackedCorpus(&source.packed);
     std::cerr << "FAIL: " << error << std::endl;
     return 2;
   }
 
-  if (right_api.api_version() != SP_DIFFER_WORKER_API_VERSION) {
-    sp_differ::UnloadWorker(&left_api);
-    sp_differ::UnloadWorker(&right_api);
-    std::cerr << "FAIL: right worker ABI version mismatch" << std::endl;
+  sp_differ::WorkerPool right;
+  if (!OpenSide(right_worker, "right", threads, isolate, &right, &error)) {
+    sp_differ::CloseWorkerPool(&left);
+    sp_differ::ClosePackedCorpus(&source.packed);
+    std::cerr << "FAIL: " << error << std::endl;
     return 2;
   }
 
-  std::vector<uint8_t> left_output;
-  if (!sp_differ::RunWorker(left_api, input, &left_output, &error)) {
-    sp_differ::UnloadWorker(&left_api);
-    sp_differ::UnloadWorker(&right_api);
-    std::cerr << "FAIL: " << error << std::endl;
+  // A hung call can only be abandoned when other threads may keep calling
+  // the same library. This is a property of the library, not of the pool:
+  // a single-threaded pool shares its one copy whatever the worker
+  // supports, and the replacement thread would call into it.
+  auto reentrant = [](const sp_differ::WorkerPool& pool) {
+    return (pool.shards[0].capabilities & SP_DIFFER_WORKER_CAP_REENTRANT) != 0;
+  };
+  if (in_process_timeouts && (!reentrant(left) || !reentrant(right))) {
+    sp_differ::CloseWorkerPool(&left);
+    sp_differ::CloseWorkerPool(&right);
+    sp_differ::ClosePackedCorpus(&source.packed);
+    std::cerr << "FAIL: --timeout needs reentrant workers unless --isolate is set" << std::endl;
     return 2;
   }
 
-  std::vector<uint8_t> right_output;
-  if (!sp_differ::RunWorker(right_api, input, &right_output, &error)) {
-    sp_differ::UnloadWorker(&left_api);
-    sp_differ::UnloadWorker(&right_api);
-    std::cerr << "FAIL: " << error << std::endl;
-    return 2;
+  // Opened after the workers: the reporter starts a thread, and isolated
+  // workers fork.
+  sp_differ::Reporter reporter;
+  if (reporting) {
+    report.run_info = {"left: " + left_worker, "right: " + right_worker,
+                       "source: " + (batch_spec.empty() ? stream_path : batch_spec)};
+    if (!sp_differ::OpenReporter(report, &reporter, &error)) {
+      sp_differ::CloseWorkerPool(&left);
+      sp_differ::CloseWorkerPool(&right);
+      sp_differ::ClosePackedCorpus(&source.packed);
+      std::cerr << "FAIL: " << error << std::endl;
+      return 2;
+    }
+    batch.reporter = &reporter;
   }
 
-  sp_differ::UnloadWorker(&left_api);
-  sp_differ::UnloadWorker(&right_api);
+  // Keyed by the library files' contents, so rebuilding one worker only
+  // invalidates that side.
+  sp_differ::OutputCache cache;
+  if (!cache_dir.empty()) {
+    if (!sp_differ::HashFile(sp_differ::ResolveWorkerPath(left_worker), &batch.left_library,
+                             &error) ||
+        !sp_differ::HashFile(sp_differ::ResolveWorkerPath(right_worker), &batch.right_library,
+                             &error) ||
+        !sp_differ::OpenOutputCache(cache_dir, cache_max_mb << 20, &cache, &error)) {
+      if (reporting) {
+        sp_differ::CloseReporter(&reporter, &error);
+      }
+      sp_differ::CloseWorkerPool(&left);
+      sp_differ::CloseWorkerPool(&right);
+      sp_differ::ClosePackedCorpus(&source.packed);
+      std::cerr << "FAIL: " << error << std::endl;
+      return 2;
+    }
+    if (cache.read_only) {
+      std::cerr << "NOTE: cache " << cache_dir << " is in use; not storing outputs" << std::endl;
+    }
+    batch.cache = &cache;
+  }
 
-  if (!sp_differ::ValidateOutputPayload(left_output, &error)) {
-    std::cerr << "FAIL: left output invalid" << std::endl;
-    return 2;
+  // 0 keeps every mismatch as an exemplar.
+  sp_differ::SignatureTable signatures(exemplars == 0 ? SIZE_MAX : exemplars);
+  batch.signatures = &signatures;
+
+  // Thread i records into recorders[i]; the last one is the stream reader.
+  std::vector<sp_differ::StageRecorder> recorders;
+  if (metrics || !trace_path.empty()) {
+    recorders.resize(thread_slots + 1);
+    for (sp_differ::StageRecorder& recorder : recorders) {
+      recorder.trace = !trace_path.empty();
+    }
+    batch.recorders = &recorders;
   }
 
-  if (!sp_differ::ValidateOutputPayload(right_output, &error)) {
-    std::cerr << "FAIL: right output invalid" << std::endl;
-    return 2;
+  // Started after the workers fork; stopped once the run is over.
+  sp_differ::Watchdog watchdog;
+  InProcessTimeouts timeouts;
+  if (in_process_timeouts) {
+    timeouts.left = std::make_unique<sp_differ::Heartbeat[]>(thread_slots);
+    timeouts.right = std::make_unique<sp_differ::Heartbeat[]>(thread_slots);
+    timeouts.scratch.resize(thread_slots);
+    for (unsigned t = 0; t < thread_slots; ++t) {
+      for (const char* side : {"left", "right"}) {
+        sp_differ::WatchHeartbeat(
+            &watchdog, side[0] == 'l' ? &timeouts.left[t] : &timeouts.right[t],
+            [&timeouts, &batch, side, t](uint64_t beat) {
+              ExpireInProcessCall(&timeouts, batch, side, t, beat);
+            });
+      }
+    }
+    batch.timeouts = &timeouts;
+  } else if (batch.timeout_ms > 0) {
+    for (sp_differ::WorkerPool* pool : {&left, &right}) {
+      for (sp_differ::IsolatedWorker& worker : pool->isolated) {
+        sp_differ::IsolatedWorker* target = &worker;
+        sp_differ::WatchHeartbeat(&watchdog, sp_differ::IsolatedHeartbeat(target),
+                                  [target](uint64_t beat) {
+                                    sp_differ::ExpireIsolatedCase(target, beat);
+                                  });
+      }
+    }
+  }
+  if (batch.timeout_ms > 0) {
+    sp_differ::StartWatchdog(&watchdog, batch.timeout_ms);
   }
 
-  if (left_output != right_output) {
-    PrintMismatch(left_output, right_output);
-    return 2;
+  int rc = 0;
+  if (!case_path.empty()) {
+    rc = RunSingle(case_path, left, right, batch.compare_mode,
+                   batch.recorders ? &recorders[0] : nullptr);
+  } else if (!stream_path.empty()) {
+    rc = RunStream(stream_path, framing, left, right, batch);
+  } else {
+    rc = RunBatch(source, left, right, batch);
   }
+  sp_differ::StopWatchdog(&watchdog);
 
-  std::cout << "OK: outputs match" << std::endl;
-  return 0;
+  sp_differ::CacheStats cache_stats;
+  if (batch.cache && !sp_differ::CloseOutputCache(&cache, &cache_stats, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    rc = 2;
+  } else if (batch.cache) {
+    std::cout << "CACHE: hits=" << cache_stats.hits << " misses=" << cache_stats.misses
+              << " stored=" << cache_stats.stored << " skipped=" << cache_stats.skipped
+              << " evicted=" << cache_stats.evicted << " entries=" << cache_stats.entries
+              << " bytes=" << cache_stats.data_size << std::endl;
+  }
+  if (batch.recorders) {
+    PrintLatency(recorders, left_worker, right_worker);
+  }
+  if (!trace_path.empty() &&
+      !WriteTrace(trace_path, recorders, left_worker, right_worker, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    rc = 2;
+  }
+  if (reporting && !sp_differ::CloseReporter(&reporter, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    rc = 2;
+  }
+  if (timeouts.abandoned.load() > 0) {
+    // An abandoned call may still be running inside a worker library or
+    // reading its scratch, so nothing is unloaded or destroyed.
+    std::cout.flush();
+    std::_Exit(rc);
+  }
+  sp_differ::CloseWorkerPool(&left);
+  sp_differ::CloseWorkerPool(&right);
+  sp_differ::ClosePackedCorpus(&source.packed);
+  return rc;
 }
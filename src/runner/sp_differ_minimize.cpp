@@ -0,0 +1,207 @@
+#include "../core/case.h"
+#include "../core/hash.h"
+#include "../core/io.h"
+#include "../core/pack.h"
+#include "../core/reduce.h"
+#include "../core/signature.h"
+#include "scheduler.h"
+#include "worker_pool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct ThreadScratch {
+  std::vector<uint8_t> left_output;
+  std::vector<uint8_t> right_output;
+};
+
+// Runs input through both workers and returns true when it mismatches,
+// filling signature. Reductions change the derived keys and tweaks, so a
+// candidate counts as the same bug by its divergence class (the status
+// pair, field, and output index) rather than by the differing bytes.
+bool Mismatches(sp_differ::WorkerPool& left, sp_differ::WorkerPool& right, unsigned thread,
+                const std::vector<uint8_t>& input, ThreadScratch* scratch,
+                sp_differ::MismatchSignature* signature) {
+  std::string error;
+  if (!sp_differ::RunPooledWorker(left, thread, input, &scratch->left_output, &error) ||
+      !sp_differ::RunPooledWorker(right, thread, input, &scratch->right_output, &error) ||
+      !sp_differ::ValidateOutputPayload(scratch->left_output, &error) ||
+      !sp_differ::ValidateOutputPayload(scratch->right_output, &error)) {
+    return false;
+  }
+  return sp_differ::ClassifyMismatch(scratch->left_output.data(), scratch->left_output.size(),
+                                     scratch->right_output.data(),
+                                     scratch->right_output.size(), signature);
+}
+
+// Writes <dir>/mismatch-<hash>.hex and a .txt note recording where it came
+// from. Returns the case path, or an empty string on failure.
+std::string SaveRegression(const std::string& dir, const std::string& name,
+                           const std::vector<uint8_t>& payload, const std::string& note,
+                           std::string* error) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  std::string stem = name;
+  if (stem.empty()) {
+    std::ostringstream hashed;
+    hashed << "mismatch-" << std::hex << std::setw(16) << std::setfill('0')
+           << sp_differ::HashCase(payload.data(), payload.size());
+    stem = hashed.str();
+  }
+  std::filesystem::path base = std::filesystem::path(dir) / stem;
+  std::string path = base.string() + ".hex";
+  if (!sp_differ::WriteCasePayloadHex(path, payload.data(), payload.size(), error)) {
+    return std::string();
+  }
+  std::ofstream meta(base.string() + ".txt");
+  meta << note;
+  return path;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string case_path;
+  std::string left_worker = "cpp";
+  std::string right_worker = "rust";
+  std::string out_dir = "tests/regressions";
+  std::string name;
+  sp_differ::SchedulerOptions scheduler;
+  scheduler.jobs = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--left" && has_value) {
+      left_worker = argv[++i];
+    } else if (arg == "--right" && has_value) {
+      right_worker = argv[++i];
+    } else if ((arg == "--jobs" || arg == "-j") && has_value) {
+      uint64_t jobs = 0;
+      if (!sp_differ::ParseUnsigned(argv[++i], UINT32_MAX, &jobs)) {
+        std::cerr << "FAIL: --jobs requires a non-negative integer" << std::endl;
+        return 2;
+      }
+      scheduler.jobs = static_cast<unsigned>(jobs);
+    } else if (arg == "--out-dir" && has_value) {
+      out_dir = argv[++i];
+    } else if (arg == "--name" && has_value) {
+      name = argv[++i];
+    } else if (arg == "--help" || arg == "-h") {
+      std::cout << "usage: sp_differ_minimize <case|pack#index> [--left <path|cpp|rust>]"
+                << " [--right <path|cpp|rust>] [--jobs <n|0>] [--out-dir <dir>]"
+                << " [--name <stem>]" << std::endl;
+      return 0;
+    } else if (case_path.empty() && (arg.empty() || arg[0] != '-')) {
+      case_path = arg;
+    } else {
+      std::cerr << "FAIL: unexpected argument " << arg << std::endl;
+      return 2;
+    }
+  }
+  if (case_path.empty()) {
+    std::cerr << "FAIL: a case is required" << std::endl;
+    return 2;
+  }
+
+  std::vector<uint8_t> payload;
+  sp_differ::Case c;
+  std::string error;
+  if (!sp_differ::ReadCaseRef(case_path, &payload, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  // A case that does not parse cannot be reduced field by field, so it falls
+  // back to removing bytes.
+  bool structural = sp_differ::ParseCaseV1(payload, &c, &error);
+
+  // Workers stay loaded for the whole run; every thread gets its own slot.
+  unsigned threads = sp_differ::ResolveJobCount(scheduler.jobs);
+  scheduler.jobs = threads;
+  sp_differ::WorkerPool left;
+  sp_differ::WorkerPool right;
+  if (!sp_differ::OpenWorkerPool(sp_differ::ResolveWorkerPath(left_worker), threads, false,
+                                 &left, &error)) {
+    std::cerr << "FAIL: left: " << error << std::endl;
+    return 2;
+  }
+  if (!sp_differ::OpenWorkerPool(sp_differ::ResolveWorkerPath(right_worker), threads, false,
+                                 &right, &error)) {
+    sp_differ::CloseWorkerPool(&left);
+    std::cerr << "FAIL: right: " << error << std::endl;
+    return 2;
+  }
+
+  std::vector<ThreadScratch> scratch(threads);
+  sp_differ::MismatchSignature target;
+  if (!Mismatches(left, right, 0, payload, &scratch[0], &target)) {
+    sp_differ::CloseWorkerPool(&left);
+    sp_differ::CloseWorkerPool(&right);
+    std::cerr << "FAIL: case does not mismatch" << std::endl;
+    return 2;
+  }
+  std::cout << "TARGET: " << sp_differ::FormatMismatchSignature(target) << std::endl;
+
+  sp_differ::BatchPredicate predicate =
+      [&](const std::vector<std::vector<uint8_t>>& candidates, std::vector<uint8_t>* keep) {
+        sp_differ::RunWorkStealing(candidates.size(), scheduler,
+                                   [&](unsigned thread, size_t begin, size_t end) {
+                                     for (size_t i = begin; i < end; ++i) {
+                                       sp_differ::MismatchSignature signature;
+                                       (*keep)[i] = Mismatches(left, right, thread, candidates[i],
+                                                               &scratch[thread], &signature) &&
+                                                    signature == target;
+                                     }
+                                   });
+      };
+
+  size_t before_inputs = c.inputs.size();
+  size_t before_labels = c.labels.size();
+  sp_differ::ReduceStats stats;
+  std::vector<uint8_t> minimized;
+  auto began = std::chrono::steady_clock::now();
+  if (structural) {
+    sp_differ::MinimizeCase(&c, predicate, &stats);
+    sp_differ::SerializeCaseV1(c, &minimized);
+  } else {
+    std::cout << "NOTE: case does not parse (" << error << "); minimizing bytes" << std::endl;
+    minimized = payload;
+    sp_differ::MinimizeBytes(&minimized, predicate, &stats);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - began;
+  sp_differ::CloseWorkerPool(&left);
+  sp_differ::CloseWorkerPool(&right);
+
+  std::ostringstream note;
+  note << "origin: " << case_path << "\n"
+       << "left: " << left_worker << "\n"
+       << "right: " << right_worker << "\n"
+       << "signature: " << sp_differ::FormatMismatchSignature(target) << "\n"
+       << "reduced: " << payload.size() << " -> " << minimized.size() << " bytes\n";
+  std::string saved = SaveRegression(out_dir, name, minimized, note.str(), &error);
+  if (saved.empty()) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+
+  std::cout << "MINIMIZED: " << saved << " bytes=" << payload.size() << "->" << minimized.size();
+  if (structural) {
+    std::cout << " inputs=" << before_inputs << "->" << c.inputs.size()
+              << " labels=" << before_labels << "->" << c.labels.size();
+  }
+  std::cout << " candidates=" << stats.candidates << " batches=" << stats.batches
+            << " jobs=" << threads << std::fixed << std::setprecision(3)
+            << " elapsed_s=" << elapsed.count() << std::endl;
+  return 0;
+}
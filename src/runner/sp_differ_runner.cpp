@@ -1,16 +1,105 @@
 #include "../../ffi/sp_differ.h"
 #include "../core/io.h"
+#include "../core/metrics.h"
+#include "../core/pack.h"
+#include "../core/stream.h"
 #include "../core/validate.h"
 #include "worker.h"
 
+#include <array>
 #include <cstdint>
+#include <iomanip>
 #include <iostream>
 #include <string>
 #include <vector>
 
+namespace {
+
+// The runner has one worker, recorded under the left worker stage.
+const char* RunnerStageName(sp_differ::Stage stage) {
+  return stage == sp_differ::Stage::kLeftWorker ? "worker" : sp_differ::StageName(stage);
+}
+
+void PrintLatency(const sp_differ::StageRecorder& recorder, const std::string& worker_path) {
+  for (size_t i = 0; i < sp_differ::kStageCount; ++i) {
+    const sp_differ::LatencyHistogram& histogram = recorder.stages[i];
+    if (histogram.count == 0) {
+      continue;
+    }
+    sp_differ::Stage stage = static_cast<sp_differ::Stage>(i);
+    std::cout << "LATENCY: stage=" << RunnerStageName(stage);
+    if (stage == sp_differ::Stage::kLeftWorker) {
+      std::cout << " worker=" << worker_path;
+    }
+    std::cout << " count=" << histogram.count << std::fixed << std::setprecision(3)
+              << " mean_us=" << histogram.total_ns / 1000.0 / histogram.count << " "
+              << sp_differ::FormatLatency(histogram) << std::endl;
+  }
+}
+
+bool WriteTrace(const std::string& path, const sp_differ::StageRecorder& recorder,
+                std::string* error) {
+  std::array<std::string, sp_differ::kStageCount> names;
+  for (size_t i = 0; i < sp_differ::kStageCount; ++i) {
+    names[i] = RunnerStageName(static_cast<sp_differ::Stage>(i));
+  }
+  return sp_differ::WriteChromeTrace(path, {recorder}, {"runner"}, names, error);
+}
+
+// Runs every case of a stream through one worker and validates each output.
+int RunStream(const sp_differ::WorkerApi& api, const std::string& stream_path,
+              sp_differ::StreamFraming framing, sp_differ::StageRecorder* recorder) {
+  std::string error;
+  sp_differ::CaseStream stream;
+  if (!sp_differ::OpenCaseStream(stream_path, framing, &stream, &error)) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+
+  uint64_t ok = 0;
+  uint64_t failed = 0;
+  std::vector<uint8_t> input;
+  std::vector<uint8_t> output;
+  for (;;) {
+    uint64_t t = sp_differ::StageStart(recorder);
+    if (!sp_differ::NextStreamCase(&stream, &input, &error)) {
+      break;
+    }
+    t = sp_differ::RecordStage(recorder, sp_differ::Stage::kRead, t);
+    uint64_t index = stream.cases_read - 1;
+    bool valid = sp_differ::ValidateCaseHeader(input, &error);
+    t = sp_differ::RecordStage(recorder, sp_differ::Stage::kValidateCase, t);
+    bool ran = valid && sp_differ::RunWorker(api, input, &output, &error);
+    if (valid) {
+      t = sp_differ::RecordStage(recorder, sp_differ::Stage::kLeftWorker, t);
+    }
+    if (!ran || !sp_differ::ValidateOutputPayload(output, &error)) {
+      std::cerr << "FAIL: case " << index << ": " << error << std::endl;
+      ++failed;
+      continue;
+    }
+    sp_differ::RecordStage(recorder, sp_differ::Stage::kValidateOutput, t);
+    ++ok;
+  }
+  sp_differ::CloseCaseStream(&stream);
+  if (!error.empty()) {
+    std::cerr << "FAIL: " << error << std::endl;
+    ++failed;
+  }
+
+  std::cout << "STREAM: cases=" << stream.cases_read << " ok=" << ok << " failed=" << failed
+            << std::endl;
+  return failed == 0 ? 0 : 2;
+}
+
+}  // namespace
+
 int main(int argc, char** argv) {
   std::string case_path;
   std::string worker_path = sp_differ::DefaultCppWorkerPath();
+  sp_differ::StreamFraming framing = sp_differ::StreamFraming::kAuto;
+  bool metrics = false;
+  std::string trace_path;
 
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
@@ -20,8 +109,25 @@ int main(int argc, char** argv) {
         return 2;
       }
       worker_path = sp_differ::ResolveWorkerPath(argv[++i]);
+    } else if (arg == "--framing") {
+      if (i + 1 >= argc || !sp_differ::ParseStreamFraming(argv[i + 1], &framing)) {
+        std::cerr << "FAIL: --framing requires auto, hex, or binary" << std::endl;
+        return 2;
+      }
+      ++i;
+    } else if (arg == "--metrics") {
+      metrics = true;
+    } else if (arg == "--trace") {
+      if (i + 1 >= argc) {
+        std::cerr << "FAIL: --trace requires a path" << std::endl;
+        return 2;
+      }
+      trace_path = argv[++i];
     } else if (arg == "--help" || arg == "-h") {
-      std::cout << "usage: sp_differ_runner <case> [--worker <path|cpp|rust>]" << std::endl;
+      std::cout << "usage: sp_differ_runner <case|pack#index> [--worker <path|cpp|rust>]"
+                << " [--metrics] [--trace <json>]" << std::endl;
+      std::cout << "       sp_differ_runner - [--framing auto|hex|binary] [--worker <path|cpp|rust>]"
+                << " [--metrics] [--trace <json>]" << std::endl;
       return 0;
     } else if (case_path.empty()) {
       case_path = arg;
@@ -36,17 +142,38 @@ int main(int argc, char** argv) {
     return 2;
   }
 
+  sp_differ::StageRecorder recording;
+  recording.trace = !trace_path.empty();
+  sp_differ::StageRecorder* recorder = metrics || recording.trace ? &recording : nullptr;
+  // Prints the stage latencies and writes the trace once the run is over.
+  auto finish = [&](int rc) {
+    std::string trace_error;
+    if (recorder) {
+      PrintLatency(recording, worker_path);
+    }
+    if (recording.trace && !WriteTrace(trace_path, recording, &trace_error)) {
+      std::cerr << "FAIL: " << trace_error << std::endl;
+      rc = 2;
+    }
+    return rc;
+  };
+
+  // A single case's read stage includes the decode.
+  bool streaming = case_path == "-";
   std::vector<uint8_t> input;
   std::string error;
-  if (!sp_differ::ReadCasePayload(case_path, &input, &error)) {
+  uint64_t t = sp_differ::StageStart(recorder);
+  if (!streaming && !sp_differ::ReadCaseRef(case_path, &input, &error)) {
     std::cerr << "FAIL: " << error << std::endl;
     return 2;
   }
+  t = sp_differ::RecordStage(streaming ? nullptr : recorder, sp_differ::Stage::kRead, t);
 
-  if (!sp_differ::ValidateCaseHeader(input, &error)) {
+  if (!streaming && !sp_differ::ValidateCaseHeader(input, &error)) {
     std::cerr << "FAIL: " << error << std::endl;
     return 2;
   }
+  sp_differ::RecordStage(streaming ? nullptr : recorder, sp_differ::Stage::kValidateCase, t);
 
   sp_differ::WorkerApi api{};
   if (!sp_differ::LoadWorker(worker_path, &api, &error)) {
@@ -60,12 +187,20 @@ int main(int argc, char** argv) {
     return 2;
   }
 
+  if (streaming) {
+    int rc = RunStream(api, case_path, framing, recorder);
+    sp_differ::UnloadWorker(&api);
+    return finish(rc);
+  }
+
   std::vector<uint8_t> output;
+  t = sp_differ::StageStart(recorder);
   if (!sp_differ::RunWorker(api, input, &output, &error)) {
     sp_differ::UnloadWorker(&api);
     std::cerr << "FAIL: " << error << std::endl;
     return 2;
   }
+  t = sp_differ::RecordStage(recorder, sp_differ::Stage::kLeftWorker, t);
 
   sp_differ::UnloadWorker(&api);
 
@@ -73,7 +208,8 @@ int main(int argc, char** argv) {
     std::cerr << "FAIL: " << error << std::endl;
     return 2;
   }
+  sp_differ::RecordStage(recorder, sp_differ::Stage::kValidateOutput, t);
 
   std::cout << "OK: output valid" << std::endl;
-  return 0;
+  return finish(0);
 }
@@ -0,0 +1,389 @@
+#include "vote_mode.h"
+
+#include "../core/io.h"
+#include "../core/vote.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+namespace sp_differ {
+namespace {
+
+struct VoteOutcome {
+  // kPass when every worker agrees, kMismatch on a majority or split, and
+  // kError for a case that never reached the workers.
+  CaseResult result = CaseResult::kError;
+  VoteClass vote = VoteClass::kAgree;
+  std::string error;
+  // Disagreements only: voters outside the majority (all of them on a
+  // split) and voters without a valid output.
+  std::vector<uint32_t> outliers;
+  std::vector<uint32_t> failed;
+  // Disagreements only: e.g. "majority outliers=rust". Exemplars of each
+  // pattern also carry the lines printed for them in error.
+  std::string pattern;
+  bool exemplar = false;
+};
+
+struct VoteTotals {
+  size_t agree = 0;
+  size_t majority = 0;
+  size_t split = 0;
+  size_t error = 0;
+  // Per voter.
+  std::vector<size_t> outliers;
+  std::vector<size_t> failed;
+};
+
+// Buffers owned by one scheduler thread; outputs and their offsets are kept
+// per voter.
+struct VoteScratch {
+  ChunkInputs gather;
+  std::vector<std::vector<uint8_t>> outputs;
+  std::vector<std::vector<size_t>> offsets;
+  std::vector<std::vector<IsolatedCrash>> crashes;
+  std::vector<std::string> errors;
+  std::vector<uint8_t> ran;
+  std::vector<const uint8_t*> case_outputs;
+  std::vector<size_t> case_lens;
+  std::string validate_error;
+  VoteResult vote;
+  DiffScratch diff;
+  std::vector<FieldDiff> diffs;
+};
+
+// Why voter v has no valid output for case j of the chunk.
+std::string VoterFailure(const VoteScratch& scratch, size_t v, size_t j) {
+  if (!scratch.ran[v]) {
+    return scratch.errors[v];
+  }
+  for (const IsolatedCrash& crash : scratch.crashes[v]) {
+    if (crash.case_index == j) {
+      return DescribeIsolatedCrash(crash);
+    }
+  }
+  return scratch.offsets[v][j + 1] == scratch.offsets[v][j] ? "worker run failed"
+                                                            : "output invalid";
+}
+
+// Names the voters of a disagreement, e.g. "majority outliers=rust" or
+// "split groups=cpp|rust,ref". Failed voters are marked "(failed)".
+std::string VotePattern(const VoteResult& vote, const std::vector<Voter>& voters) {
+  auto name = [&](size_t v) {
+    return voters[v].label + (vote.group[v] == kNoGroup ? "(failed)" : "");
+  };
+  std::string pattern = VoteClassName(vote.vote);
+  if (vote.vote == VoteClass::kMajority) {
+    pattern += " outliers=";
+    bool first = true;
+    for (size_t v = 0; v < voters.size(); ++v) {
+      if (IsOutlier(vote, v)) {
+        pattern += (first ? "" : ",") + name(v);
+        first = false;
+      }
+    }
+    return pattern;
+  }
+  pattern += " groups=";
+  for (uint32_t g = 0; g < vote.group_first.size(); ++g) {
+    bool first = true;
+    for (size_t v = 0; v < voters.size(); ++v) {
+      if (vote.group[v] == g) {
+        pattern += (first ? (g == 0 ? "" : "|") : ",") + name(v);
+        first = false;
+      }
+    }
+  }
+  for (size_t v = 0; v < voters.size(); ++v) {
+    if (vote.group[v] == kNoGroup) {
+      pattern += (vote.group_first.empty() && pattern.back() == '=' ? "" : "|") + name(v);
+    }
+  }
+  return pattern;
+}
+
+// The lines printed for an exemplar disagreement: the diverging fields of
+// every other group against the majority (on a split, the first group),
+// then why each failed voter has no output.
+std::string DescribeVote(VoteScratch* scratch, size_t j, const std::vector<Voter>& voters,
+                         CompareMode mode) {
+  const VoteResult& vote = scratch->vote;
+  std::vector<std::string> lines;
+  if (!vote.group_first.empty()) {
+    uint32_t reference_group = vote.vote == VoteClass::kMajority ? vote.majority : 0;
+    size_t reference = vote.group_first[reference_group];
+    for (uint32_t g = 0; g < vote.group_first.size(); ++g) {
+      if (g == reference_group) {
+        continue;
+      }
+      std::string members;
+      for (size_t v = 0; v < voters.size(); ++v) {
+        if (vote.group[v] == g) {
+          members += (members.empty() ? "" : ",") + voters[v].label;
+        }
+      }
+      size_t first = vote.group_first[g];
+      DiffOutputs(scratch->case_outputs[reference], scratch->case_lens[reference],
+                  scratch->case_outputs[first], scratch->case_lens[first], mode, &scratch->diff,
+                  &scratch->diffs);
+      lines.push_back("  " + members + " vs " + voters[reference].label + ": " +
+                      FormatFieldDiffs(scratch->diffs, kMaxListedFields));
+    }
+  }
+  for (size_t v = 0; v < voters.size(); ++v) {
+    if (vote.group[v] == kNoGroup) {
+      lines.push_back("  " + voters[v].label + ": " + VoterFailure(*scratch, v, j));
+    }
+  }
+  std::string text;
+  for (const std::string& line : lines) {
+    text += (text.empty() ? "" : "\n") + line;
+  }
+  return text;
+}
+
+// Gathers the cases in [begin, end) once and hands the same packed span to
+// every voter as one RunWorkerBatch call, then votes on each case in a
+// single pass over the outputs. The voters of a chunk run at once, voter 0
+// on this thread and each other voter on a helper thread; every voter has
+// its own pool, so each uses only its own slot for this thread.
+void RunVoteChunk(const CaseSource& source, size_t begin, size_t end,
+                  std::vector<Voter>& voters, unsigned thread, const VoteOptions& options,
+                  VoteScratch* scratch, std::vector<VoteOutcome>* outcomes) {
+  const uint8_t* inputs = nullptr;
+  size_t inputs_len = 0;
+  GatherChunk(source, begin, end, &scratch->gather, nullptr, outcomes, &inputs, &inputs_len);
+  size_t count = scratch->gather.members.size();
+  if (count == 0) {
+    return;
+  }
+  size_t n = voters.size();
+  scratch->outputs.resize(n);
+  scratch->offsets.resize(n);
+  scratch->crashes.resize(n);
+  scratch->errors.resize(n);
+  scratch->ran.assign(n, 0);
+  auto run_voter = [&](size_t v) {
+    scratch->crashes[v].clear();
+    scratch->ran[v] = RunPooledWorkerBatch(
+        voters[v].pool, thread, inputs, inputs_len, scratch->gather.offsets,
+        &scratch->outputs[v], &scratch->offsets[v], &scratch->crashes[v], &scratch->errors[v]);
+  };
+  std::vector<std::thread> helpers;
+  helpers.reserve(n - 1);
+  for (size_t v = 1; v < n; ++v) {
+    helpers.emplace_back(run_voter, v);
+  }
+  run_voter(0);
+  for (std::thread& helper : helpers) {
+    helper.join();
+  }
+
+  scratch->case_outputs.resize(n);
+  scratch->case_lens.resize(n);
+  for (size_t j = 0; j < count; ++j) {
+    // A crashed or failed call leaves an empty span.
+    for (size_t v = 0; v < n; ++v) {
+      const uint8_t* output = nullptr;
+      size_t output_len = 0;
+      if (scratch->ran[v]) {
+        output = scratch->outputs[v].data() + scratch->offsets[v][j];
+        output_len = scratch->offsets[v][j + 1] - scratch->offsets[v][j];
+      }
+      if (output_len == 0 ||
+          !ValidateOutputPayload(output, output_len, &scratch->validate_error)) {
+        output = nullptr;
+      }
+      scratch->case_outputs[v] = output;
+      scratch->case_lens[v] = output_len;
+    }
+    VoteOutputs(scratch->case_outputs.data(), scratch->case_lens.data(), n, options.compare_mode,
+                &scratch->diff, &scratch->vote);
+
+    VoteOutcome& outcome = (*outcomes)[scratch->gather.members[j]];
+    outcome.vote = scratch->vote.vote;
+    if (outcome.vote == VoteClass::kAgree) {
+      outcome.result = CaseResult::kPass;
+      continue;
+    }
+    outcome.result = CaseResult::kMismatch;
+    for (size_t v = 0; v < n; ++v) {
+      if (IsOutlier(scratch->vote, v)) {
+        outcome.outliers.push_back(static_cast<uint32_t>(v));
+      }
+      if (scratch->vote.group[v] == kNoGroup) {
+        outcome.failed.push_back(static_cast<uint32_t>(v));
+      }
+    }
+    outcome.pattern = VotePattern(scratch->vote, voters);
+    {
+      std::lock_guard<std::mutex> lock(options.patterns->mutex);
+      outcome.exemplar = ++options.patterns->hits[outcome.pattern] <=
+                         options.patterns->max_exemplars;
+    }
+    if (!outcome.exemplar) {
+      continue;
+    }
+    // Like mismatch exemplars, these are described off the reporting lock.
+    outcome.error = DescribeVote(scratch, j, voters, options.compare_mode);
+    std::string side;
+    for (uint32_t v : outcome.outliers) {
+      side += (side.empty() ? "" : "+") + voters[v].label;
+    }
+    if (outcome.vote == VoteClass::kSplit) {
+      side = "all";
+    }
+    const uint8_t* payload = inputs + scratch->gather.offsets[j];
+    size_t payload_len = scratch->gather.offsets[j + 1] - scratch->gather.offsets[j];
+    std::string artifact = SaveCaseArtifact(options.artifact_dir, VoteClassName(outcome.vote),
+                                            side.c_str(), payload, payload_len);
+    if (!artifact.empty()) {
+      outcome.error += (outcome.error.empty() ? "  saved " : "\n  saved ") + artifact;
+    }
+  }
+}
+
+void ReportVoteOutcome(const std::string& path, VoteOutcome* outcome, VoteTotals* totals) {
+  if (outcome->result == CaseResult::kPass) {
+    ++totals->agree;
+  } else if (outcome->result == CaseResult::kMismatch) {
+    ++(outcome->vote == VoteClass::kMajority ? totals->majority : totals->split);
+    for (uint32_t v : outcome->outliers) {
+      ++totals->outliers[v];
+    }
+    for (uint32_t v : outcome->failed) {
+      ++totals->failed[v];
+    }
+    if (outcome->exemplar) {
+      std::cerr << "VOTE: " << path << ": " << outcome->pattern << std::endl;
+      if (!outcome->error.empty()) {
+        std::cerr << outcome->error << std::endl;
+      }
+    }
+  } else {
+    ++totals->error;
+    std::cerr << "ERROR: " << path << ": " << outcome->error << std::endl;
+  }
+  // Outcomes live for one RunVoteCases call; drop what they hold once
+  // reported, as ReportOutcome does.
+  *outcome = VoteOutcome();
+}
+
+// Runs every case of source through all voters on the work-stealing
+// scheduler, reporting in case order as RunCases does.
+void RunVoteCases(const CaseSource& source, std::vector<Voter>& voters,
+                  const VoteOptions& vote_options, VoteTotals* totals) {
+  size_t case_count = CaseCount(source);
+  SchedulerOptions options = vote_options.scheduler;
+  unsigned jobs = ResolveJobCount(options.jobs);
+  options.jobs = jobs;
+  options.chunk_size = std::max<size_t>(1, std::min(kBatchSize, case_count / (jobs * 4)));
+
+  size_t chunk_count = (case_count + options.chunk_size - 1) / options.chunk_size;
+  std::vector<VoteOutcome> outcomes(case_count);
+  std::vector<VoteScratch> scratch(jobs);
+  std::vector<uint8_t> chunk_done(chunk_count, 0);
+  size_t next_chunk = 0;
+  std::mutex report_mutex;
+
+  RunWorkStealing(case_count, options, [&](unsigned thread, size_t begin, size_t end) {
+    RunVoteChunk(source, begin, end, voters, thread, vote_options, &scratch[thread], &outcomes);
+
+    std::lock_guard<std::mutex> lock(report_mutex);
+    chunk_done[begin / options.chunk_size] = 1;
+    while (next_chunk < chunk_count && chunk_done[next_chunk]) {
+      size_t first = next_chunk * options.chunk_size;
+      size_t last = std::min(case_count, first + options.chunk_size);
+      for (size_t i = first; i < last; ++i) {
+        ReportVoteOutcome(CaseName(source, i), &outcomes[i], totals);
+      }
+      ++next_chunk;
+    }
+  });
+}
+
+// One PATTERN line per distinct disagreement, most hits first, then one
+// WORKER line per voter and the VOTE totals. Exits 0 only when every case
+// reached every worker and all of them agreed.
+int PrintVoteSummary(size_t case_count, const VoteTotals& totals,
+                     const std::vector<Voter>& voters, const VoteOptions& options,
+                     std::chrono::steady_clock::time_point start) {
+  std::vector<std::pair<std::string, size_t>> patterns(options.patterns->hits.begin(),
+                                                       options.patterns->hits.end());
+  std::sort(patterns.begin(), patterns.end(), [](const auto& a, const auto& b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  });
+  for (const auto& pattern : patterns) {
+    std::cout << "PATTERN: " << pattern.first << " hits=" << pattern.second << std::endl;
+  }
+  for (size_t v = 0; v < voters.size(); ++v) {
+    std::cout << "WORKER: name=" << voters[v].label << " outlier=" << totals.outliers[v]
+              << " failed=" << totals.failed[v] << std::endl;
+  }
+  unsigned jobs = ResolveJobCount(options.scheduler.jobs);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  double seconds = elapsed.count();
+  double rate = seconds > 0.0 ? static_cast<double>(case_count) / seconds : 0.0;
+  std::cout << "VOTE: cases=" << case_count << " agree=" << totals.agree
+            << " majority=" << totals.majority << " split=" << totals.split
+            << " error=" << totals.error << " workers=" << voters.size() << " jobs=" << jobs
+            << std::fixed << std::setprecision(3) << " elapsed_s=" << seconds
+            << std::setprecision(1) << " cases_per_s=" << rate << std::endl;
+  return totals.majority == 0 && totals.split == 0 && totals.error == 0 ? 0 : 2;
+}
+
+}  // namespace
+
+std::vector<std::string> VoterLabels(const std::vector<std::string>& specs) {
+  std::vector<std::string> labels;
+  for (size_t i = 0; i < specs.size(); ++i) {
+    std::string label = specs[i] == "cpp" || specs[i] == "rust"
+                            ? specs[i]
+                            : std::filesystem::path(specs[i]).stem().string();
+    if (std::find(labels.begin(), labels.end(), label) != labels.end()) {
+      label += "#" + std::to_string(i + 1);
+    }
+    labels.push_back(label);
+  }
+  return labels;
+}
+
+int RunVote(const CaseSource& batch_source, const std::string& stream_path, StreamFraming framing,
+            std::vector<Voter>& voters, const VoteOptions& options) {
+  auto start = std::chrono::steady_clock::now();
+  VoteTotals totals;
+  totals.outliers.assign(voters.size(), 0);
+  totals.failed.assign(voters.size(), 0);
+  if (stream_path.empty()) {
+    RunVoteCases(batch_source, voters, options, &totals);
+    return PrintVoteSummary(CaseCount(batch_source), totals, voters, options, start);
+  }
+
+  unsigned jobs = ResolveJobCount(options.scheduler.jobs);
+  CaseSource source;
+  size_t case_count = 0;
+  std::string error;
+  bool opened = ReadStreamWindows(stream_path, framing, jobs * kBatchSize, options.dedup,
+                                  options.dedup_max_mb << 20, nullptr, &source, &error,
+                                  [&](const CaseSource& window) {
+                                    RunVoteCases(window, voters, options, &totals);
+                                    case_count += CaseCount(window);
+                                    return true;
+                                  });
+  if (!opened) {
+    std::cerr << "FAIL: " << error << std::endl;
+    return 2;
+  }
+  if (!error.empty()) {
+    ++totals.error;
+    std::cerr << "ERROR: " << source.stream_name << ": " << error << std::endl;
+  }
+  return PrintVoteSummary(case_count, totals, voters, options, start);
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,54 @@
+#ifndef SP_DIFFER_RUNNER_VOTE_MODE_H
+#define SP_DIFFER_RUNNER_VOTE_MODE_H
+
+#include "../core/diff.h"
+#include "../core/stream.h"
+#include "compare_cases.h"
+#include "scheduler.h"
+#include "worker_pool.h"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// sp_differ_compare's --worker mode: every case through three or more
+// workers, classed by vote.
+
+namespace sp_differ {
+
+// One worker of a --worker run.
+struct Voter {
+  std::string label;
+  WorkerPool pool;
+};
+
+// Disagreement patterns seen so far, shared by every thread.
+struct VotePatterns {
+  std::mutex mutex;
+  std::unordered_map<std::string, size_t> hits;
+  size_t max_exemplars = 3;
+};
+
+struct VoteOptions {
+  SchedulerOptions scheduler;
+  std::string artifact_dir = "artifacts";
+  CompareMode compare_mode = CompareMode::kOrdered;
+  bool dedup = false;
+  size_t dedup_max_mb = 64;
+  VotePatterns* patterns = nullptr;
+};
+
+// Display names for --worker specs: "cpp" and "rust" as given, paths by
+// file stem. A repeated name is suffixed with its position, e.g. "cpp#3".
+std::vector<std::string> VoterLabels(const std::vector<std::string>& specs);
+
+// A case file, batch, or stream through every voter. A single case runs as
+// a batch of one.
+int RunVote(const CaseSource& batch_source, const std::string& stream_path, StreamFraming framing,
+            std::vector<Voter>& voters, const VoteOptions& options);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_RUNNER_VOTE_MODE_H
@@ -0,0 +1,80 @@
+#include "watchdog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace sp_differ {
+namespace {
+
+void Sample(Watchdog* watchdog, std::chrono::steady_clock::time_point now) {
+  auto timeout = std::chrono::milliseconds(watchdog->timeout_ms);
+  for (Watchdog::Watch& watch : watchdog->watches) {
+    uint64_t beat = watch.heartbeat->beat.load(std::memory_order_acquire);
+    bool busy = watch.heartbeat->state.load(std::memory_order_acquire) == kHeartbeatBusy;
+    if (!busy || beat != watch.last_beat) {
+      watch.last_beat = beat;
+      watch.since = now;
+      watch.fired = false;
+      continue;
+    }
+    if (!watch.fired && now - watch.since >= timeout) {
+      watch.fired = true;
+      watchdog->expiries.fetch_add(1, std::memory_order_relaxed);
+      watch.on_expire(beat);
+    }
+  }
+}
+
+void RunWatchdog(Watchdog* watchdog) {
+  // Sampling four times per timeout bounds detection at 1.25x the timeout.
+  auto period = std::chrono::milliseconds(std::max<uint32_t>(1, watchdog->timeout_ms / 4));
+  std::unique_lock<std::mutex> lock(watchdog->mutex);
+  while (!watchdog->stop) {
+    watchdog->wake.wait_for(lock, period, [watchdog] { return watchdog->stop; });
+    if (!watchdog->stop) {
+      Sample(watchdog, std::chrono::steady_clock::now());
+    }
+  }
+}
+
+}  // namespace
+
+void WatchHeartbeat(Watchdog* watchdog, Heartbeat* heartbeat, ExpireFn on_expire) {
+  Watchdog::Watch watch;
+  watch.heartbeat = heartbeat;
+  watch.on_expire = std::move(on_expire);
+  watchdog->watches.push_back(std::move(watch));
+}
+
+void StartWatchdog(Watchdog* watchdog, uint32_t timeout_ms) {
+  watchdog->timeout_ms = timeout_ms;
+  watchdog->stop = false;
+  auto now = std::chrono::steady_clock::now();
+  for (Watchdog::Watch& watch : watchdog->watches) {
+    watch.last_beat = watch.heartbeat->beat.load(std::memory_order_acquire);
+    watch.since = now;
+  }
+  watchdog->thread = std::thread(RunWatchdog, watchdog);
+}
+
+void StopWatchdog(Watchdog* watchdog) {
+  if (!watchdog->thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(watchdog->mutex);
+    watchdog->stop = true;
+  }
+  watchdog->wake.notify_all();
+  watchdog->thread.join();
+}
+
+void ParkAbandonedThread() {
+  for (;;) {
+    std::this_thread::sleep_for(std::chrono::hours(1));
+  }
+}
+
+}  // namespace sp_differ
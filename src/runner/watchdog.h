@@ -0,0 +1,85 @@
+#ifndef SP_DIFFER_RUNNER_WATCHDOG_H
+#define SP_DIFFER_RUNNER_WATCHDOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sp_differ {
+
+enum HeartbeatState : uint32_t {
+  kHeartbeatIdle = 0,
+  // A worker call is in flight.
+  kHeartbeatBusy = 1,
+  // The watchdog gave up on the call; its thread must not go on.
+  kHeartbeatAbandoned = 2,
+};
+
+// Progress of one calling thread (or one isolated child). The owner beats
+// at the start of every case; a beat that stays put for the whole timeout
+// while the state is busy means one case has run that long. The hot path is
+// one plain atomic store per case: no clock reads, no syscalls. Both members
+// are lock-free and address-free, so a Heartbeat can live in memory shared
+// with a child process.
+struct Heartbeat {
+  // Cases started so far in the high 32 bits, the index of the running case
+  // within the current call in the low 32, so a sampled beat always names
+  // its own case.
+  std::atomic<uint64_t> beat{0};
+  std::atomic<uint32_t> state{kHeartbeatIdle};
+};
+
+// Marks the start of case index of the current call. Single writer, so a
+// load and store replace the locked increment.
+inline void BeatCase(Heartbeat* heartbeat, uint32_t index) {
+  uint64_t started = (heartbeat->beat.load(std::memory_order_relaxed) >> 32) + 1;
+  heartbeat->beat.store(started << 32 | index, std::memory_order_release);
+}
+
+inline uint32_t BeatIndex(uint64_t beat) {
+  return static_cast<uint32_t>(beat);
+}
+
+// Called on the watchdog thread with the beat value that went stale.
+using ExpireFn = std::function<void(uint64_t beat)>;
+
+// One thread that samples every watched heartbeat a few times per timeout
+// and calls the expiry function of any that is busy with an unchanged beat
+// for timeout_ms. Each stall expires once.
+struct Watchdog {
+  struct Watch {
+    Heartbeat* heartbeat = nullptr;
+    ExpireFn on_expire;
+    uint64_t last_beat = 0;
+    std::chrono::steady_clock::time_point since;
+    bool fired = false;
+  };
+
+  uint32_t timeout_ms = 0;
+  std::vector<Watch> watches;
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stop = false;
+  std::atomic<uint64_t> expiries{0};
+};
+
+// Adds a heartbeat; only before StartWatchdog.
+void WatchHeartbeat(Watchdog* watchdog, Heartbeat* heartbeat, ExpireFn on_expire);
+
+void StartWatchdog(Watchdog* watchdog, uint32_t timeout_ms);
+void StopWatchdog(Watchdog* watchdog);
+
+// Never returns. For a thread whose call was abandoned and has come back:
+// its caller has been replaced, so it must not touch anything again.
+[[noreturn]] void ParkAbandonedThread();
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_RUNNER_WATCHDOG_H
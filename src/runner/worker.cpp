@@ -1,9 +1,46 @@
 #include "worker.h"
 
+#include "../../ffi/sp_differ.h"
+
+#include <algorithm>
 #include <string>
 #include <vector>
 
 namespace sp_differ {
+namespace {
+
+constexpr size_t kInitialOutputCapacity = 256;
+
+// Largest result size a NEED_BUFFER has reported on this thread. Later
+// calls open a window that large, so a run of big results is derived twice
+// only for the first of them.
+thread_local size_t run_into_window = kInitialOutputCapacity;
+
+// Runs one case through run_into, appending the result to the end of out.
+// out keeps its capacity between calls. Only a bounded window is opened:
+// resizing to the full capacity would zero-fill the whole spare tail on
+// every case of a batch.
+int AppendRunInto(const WorkerApi& api, const uint8_t* input, size_t input_len,
+                  std::vector<uint8_t>* out) {
+  size_t base = out->size();
+  out->resize(base + run_into_window);
+
+  size_t output_len = 0;
+  int rc = api.run_into(input, input_len, out->data() + base, run_into_window, &output_len);
+  if (rc == SP_DIFFER_WORKER_NEED_BUFFER) {
+    run_into_window = std::max(run_into_window, output_len);
+    out->resize(base + output_len);
+    rc = api.run_into(input, input_len, out->data() + base, output_len, &output_len);
+  }
+  if (rc != 0 || output_len > out->size() - base) {
+    out->resize(base);
+    return rc != 0 ? rc : -1;
+  }
+  out->resize(base + output_len);
+  return 0;
+}
+
+}  // namespace
 
 std::string DefaultCppWorkerPath() {
 #if defined(_WIN32)
@@ -36,6 +73,10 @@ std::string ResolveWorkerPath(const std::string& arg) {
 }
 
 bool LoadWorker(const std::string& path, WorkerApi* api, std::string* error) {
+  using BatchFn = int (*)(const uint8_t*, const size_t*, size_t, uint8_t**, size_t*, size_t*);
+  using RunIntoFn = int (*)(const uint8_t*, size_t, uint8_t*, size_t, size_t*);
+  uint32_t (*batch_api_version)() = nullptr;
+  uint32_t (*capabilities)() = nullptr;
 #if defined(_WIN32)
   HMODULE handle = LoadLibraryA(path.c_str());
   if (!handle) {
@@ -46,6 +87,11 @@ bool LoadWorker(const std::string& path, WorkerApi* api, std::string* error) {
   api->run = reinterpret_cast<int (*)(const uint8_t*, size_t, uint8_t**, size_t*)>(
       GetProcAddress(handle, "sp_differ_worker_run"));
   api->free = reinterpret_cast<void (*)(uint8_t*)>(GetProcAddress(handle, "sp_differ_worker_free"));
+  batch_api_version = reinterpret_cast<uint32_t (*)()>(
+      GetProcAddress(handle, "sp_differ_worker_batch_api_version"));
+  api->run_batch = reinterpret_cast<BatchFn>(GetProcAddress(handle, "sp_differ_worker_run_batch"));
+  api->run_into = reinterpret_cast<RunIntoFn>(GetProcAddress(handle, "sp_differ_worker_run_into"));
+  capabilities = reinterpret_cast<uint32_t (*)()>(GetProcAddress(handle, "sp_differ_worker_capabilities"));
   api->handle = handle;
 #else
   void* handle = dlopen(path.c_str(), RTLD_LAZY);
@@ -57,12 +103,36 @@ bool LoadWorker(const std::string& path, WorkerApi* api, std::string* error) {
   api->run = reinterpret_cast<int (*)(const uint8_t*, size_t, uint8_t**, size_t*)>(
       dlsym(handle, "sp_differ_worker_run"));
   api->free = reinterpret_cast<void (*)(uint8_t*)>(dlsym(handle, "sp_differ_worker_free"));
+  batch_api_version = reinterpret_cast<uint32_t (*)()>(
+      dlsym(handle, "sp_differ_worker_batch_api_version"));
+  api->run_batch = reinterpret_cast<BatchFn>(dlsym(handle, "sp_differ_worker_run_batch"));
+  api->run_into = reinterpret_cast<RunIntoFn>(dlsym(handle, "sp_differ_worker_run_into"));
+  capabilities = reinterpret_cast<uint32_t (*)()>(dlsym(handle, "sp_differ_worker_capabilities"));
   api->handle = handle;
 #endif
   if (!api->api_version || !api->run || !api->free) {
     *error = "worker is missing required symbols";
     return false;
   }
+  if (!batch_api_version || batch_api_version() != SP_DIFFER_WORKER_BATCH_API_VERSION) {
+    api->run_batch = nullptr;
+  }
+  // Without a capabilities export the worker is treated as not reentrant and
+  // optional entry points are detected by symbol alone.
+  api->capabilities = capabilities ? capabilities()
+                                   : SP_DIFFER_WORKER_CAP_BATCH | SP_DIFFER_WORKER_CAP_RUN_INTO;
+  if ((api->capabilities & SP_DIFFER_WORKER_CAP_BATCH) == 0) {
+    api->run_batch = nullptr;
+  }
+  if ((api->capabilities & SP_DIFFER_WORKER_CAP_RUN_INTO) == 0) {
+    api->run_into = nullptr;
+  }
+  if (!api->run_batch) {
+    api->capabilities &= ~SP_DIFFER_WORKER_CAP_BATCH;
+  }
+  if (!api->run_into) {
+    api->capabilities &= ~SP_DIFFER_WORKER_CAP_RUN_INTO;
+  }
   return true;
 }
 
@@ -80,9 +150,25 @@ void UnloadWorker(WorkerApi* api) {
 
 bool RunWorker(const WorkerApi& api, const std::vector<uint8_t>& input,
                std::vector<uint8_t>* output, std::string* error) {
+  return RunWorker(api, input.data(), input.size(), output, error);
+}
+
+bool RunWorker(const WorkerApi& api, const uint8_t* input, size_t input_len,
+               std::vector<uint8_t>* output, std::string* error) {
+  if (api.run_into) {
+    output->clear();
+    if (AppendRunInto(api, input, input_len, output) != 0) {
+      if (error) {
+        *error = "worker run failed";
+      }
+      return false;
+    }
+    return true;
+  }
+
   uint8_t* output_ptr = nullptr;
   size_t output_len = 0;
-  int rc = api.run(input.data(), input.size(), &output_ptr, &output_len);
+  int rc = api.run(input, input_len, &output_ptr, &output_len);
   if (rc != 0) {
     if (error) {
       *error = "worker run failed";
@@ -95,4 +181,75 @@ bool RunWorker(const WorkerApi& api, const std::vector<uint8_t>& input,
   return true;
 }
 
+bool AppendWorkerResult(const WorkerApi& api, const uint8_t* input, size_t input_len,
+                        std::vector<uint8_t>* output) {
+  if (api.run_into) {
+    return AppendRunInto(api, input, input_len, output) == 0;
+  }
+  uint8_t* output_ptr = nullptr;
+  size_t output_len = 0;
+  if (api.run(input, input_len, &output_ptr, &output_len) != 0) {
+    return false;
+  }
+  output->insert(output->end(), output_ptr, output_ptr + output_len);
+  api.free(output_ptr);
+  return true;
+}
+
+bool RunWorkerBatch(const WorkerApi& api, const uint8_t* inputs, size_t inputs_len,
+                    const std::vector<size_t>& input_offsets, std::vector<uint8_t>* outputs,
+                    std::vector<size_t>* output_offsets, std::string* error) {
+  if (input_offsets.empty() || input_offsets.back() > inputs_len) {
+    if (error) {
+      *error = "invalid batch offsets";
+    }
+    return false;
+  }
+  size_t case_count = input_offsets.size() - 1;
+  output_offsets->assign(case_count + 1, 0);
+  outputs->clear();
+  if (case_count == 0) {
+    return true;
+  }
+
+  if (api.run_batch) {
+    uint8_t* output_ptr = nullptr;
+    size_t output_len = 0;
+    int rc = api.run_batch(inputs, input_offsets.data(), case_count, &output_ptr,
+                           &output_len, output_offsets->data());
+    if (rc != 0) {
+      if (error) {
+        *error = "worker batch run failed";
+      }
+      return false;
+    }
+    for (size_t i = 0; i < case_count; ++i) {
+      if ((*output_offsets)[i] > (*output_offsets)[i + 1]) {
+        api.free(output_ptr);
+        if (error) {
+          *error = "worker returned invalid batch offsets";
+        }
+        return false;
+      }
+    }
+    if ((*output_offsets)[0] != 0 || (*output_offsets)[case_count] != output_len) {
+      api.free(output_ptr);
+      if (error) {
+        *error = "worker returned invalid batch offsets";
+      }
+      return false;
+    }
+    outputs->assign(output_ptr, output_ptr + output_len);
+    api.free(output_ptr);
+    return true;
+  }
+
+  for (size_t i = 0; i < case_count; ++i) {
+    AppendWorkerResult(api, inputs + input_offsets[i], input_offsets[i + 1] - input_offsets[i],
+                       outputs);
+    (*output_offsets)[i + 1] = outputs->size();
+  }
+  return true;
+}
+
 }  // namespace sp_differ
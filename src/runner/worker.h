@@ -17,6 +17,15 @@ struct WorkerApi {
   uint32_t (*api_version)();
   int (*run)(const uint8_t*, size_t, uint8_t**, size_t*);
   void (*free)(uint8_t*);
+  // Optional batch entry point; null when the worker does not export a
+  // compatible sp_differ_worker_run_batch.
+  int (*run_batch)(const uint8_t*, const size_t*, size_t, uint8_t**, size_t*, size_t*);
+  // Optional caller-buffer entry point; null when the worker does not export
+  // sp_differ_worker_run_into.
+  int (*run_into)(const uint8_t*, size_t, uint8_t*, size_t, size_t*);
+  // SP_DIFFER_WORKER_CAP_* bits, either reported by the worker or inferred
+  // from the exported symbols.
+  uint32_t capabilities;
 #if defined(_WIN32)
   HMODULE handle;
 #else
@@ -31,8 +40,28 @@ std::string ResolveWorkerPath(const std::string& arg);
 bool LoadWorker(const std::string& path, WorkerApi* api, std::string* error);
 void UnloadWorker(WorkerApi* api);
 
+// Runs one case. When the worker exports sp_differ_worker_run_into, the
+// result is written straight into output, whose capacity is reused across
+// calls, so a caller that keeps one output vector per thread does no heap
+// allocation per case once the buffer has grown to the largest result.
 bool RunWorker(const WorkerApi& api, const std::vector<uint8_t>& input,
                std::vector<uint8_t>* output, std::string* error);
+bool RunWorker(const WorkerApi& api, const uint8_t* input, size_t input_len,
+               std::vector<uint8_t>* output, std::string* error);
+
+// Runs one case and appends its result to output, leaving output as it was
+// when the call fails. Uses run_into when available, so a reused output
+// vector stops allocating once it has grown.
+bool AppendWorkerResult(const WorkerApi& api, const uint8_t* input, size_t input_len,
+                        std::vector<uint8_t>* output);
+
+// Runs every case packed in inputs (case i spans input_offsets[i] to
+// input_offsets[i + 1]) and packs the results the same way. A case whose
+// worker call failed gets an empty span. Uses the worker batch entry point
+// when available and falls back to one RunWorker call per case.
+bool RunWorkerBatch(const WorkerApi& api, const uint8_t* inputs, size_t inputs_len,
+                    const std::vector<size_t>& input_offsets, std::vector<uint8_t>* outputs,
+                    std::vector<size_t>* output_offsets, std::string* error);
 
 }  // namespace sp_differ
 
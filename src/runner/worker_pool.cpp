@@ -0,0 +1,236 @@
+#include "worker_pool.h"
+
+#include "../../ffi/sp_differ.h"
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+namespace sp_differ {
+namespace {
+
+unsigned long CurrentProcessId() {
+#if defined(_WIN32)
+  return static_cast<unsigned long>(GetCurrentProcessId());
+#else
+  return static_cast<unsigned long>(getpid());
+#endif
+}
+
+bool LoadChecked(const std::string& path, WorkerApi* api, std::string* error) {
+  if (!LoadWorker(path, api, error)) {
+    return false;
+  }
+  if (api->api_version() != SP_DIFFER_WORKER_API_VERSION) {
+    UnloadWorker(api);
+    *error = "worker ABI version mismatch";
+    return false;
+  }
+  return true;
+}
+
+// Loads one private copy of the library per thread. The dynamic loader hands
+// back the same handle for the same file, so each shard is loaded from a
+// separate temporary copy.
+bool LoadShards(const std::string& path, unsigned threads, WorkerPool* pool) {
+  std::error_code ec;
+  std::filesystem::path source(path);
+  std::filesystem::path dir = std::filesystem::temp_directory_path(ec);
+  if (ec) {
+    return false;
+  }
+  static std::atomic<unsigned> next_copy{0};
+  for (unsigned t = 1; t < threads; ++t) {
+    std::filesystem::path copy =
+        dir / ("sp_differ_shard_" + std::to_string(CurrentProcessId()) + "_" +
+               std::to_string(next_copy++) + source.extension().string());
+    if (!std::filesystem::copy_file(source, copy,
+                                    std::filesystem::copy_options::overwrite_existing, ec)) {
+      return false;
+    }
+    pool->shard_copies.push_back(copy.string());
+
+    WorkerApi api{};
+    std::string error;
+    if (!LoadChecked(copy.string(), &api, &error)) {
+      return false;
+    }
+    pool->shards.push_back(api);
+  }
+  return true;
+}
+
+WorkerApi& ShardFor(WorkerPool& pool, unsigned thread) {
+  return pool.mode == WorkerConcurrency::kSharded ? pool.shards[thread] : pool.shards[0];
+}
+
+// RunWorkerBatch one case at a time under a heartbeat. Per case this costs a
+// few plain stores and one load, no clock read or syscall.
+bool RunWatchedBatch(const WorkerApi& api, Heartbeat* heartbeat, const uint8_t* inputs,
+                     size_t inputs_len, const std::vector<size_t>& input_offsets,
+                     std::vector<uint8_t>* outputs, std::vector<size_t>* output_offsets,
+                     std::string* error) {
+  if (input_offsets.empty() || input_offsets.back() > inputs_len) {
+    if (error) {
+      *error = "invalid batch offsets";
+    }
+    return false;
+  }
+  size_t case_count = input_offsets.size() - 1;
+  output_offsets->assign(case_count + 1, 0);
+  outputs->clear();
+  heartbeat->state.store(kHeartbeatBusy, std::memory_order_release);
+  for (size_t i = 0; i < case_count; ++i) {
+    const uint8_t* input = inputs + input_offsets[i];
+    size_t input_len = input_offsets[i + 1] - input_offsets[i];
+    BeatCase(heartbeat, static_cast<uint32_t>(i));
+    AppendWorkerResult(api, input, input_len, outputs);
+    if (heartbeat->state.load(std::memory_order_acquire) == kHeartbeatAbandoned) {
+      ParkAbandonedThread();
+    }
+    (*output_offsets)[i + 1] = outputs->size();
+  }
+  // The watchdog may abandon the call between the last check and here.
+  uint32_t busy = kHeartbeatBusy;
+  if (!heartbeat->state.compare_exchange_strong(busy, kHeartbeatIdle,
+                                                std::memory_order_acq_rel)) {
+    ParkAbandonedThread();
+  }
+  return true;
+}
+
+}  // namespace
+
+const char* WorkerConcurrencyName(WorkerConcurrency mode) {
+  switch (mode) {
+    case WorkerConcurrency::kConcurrent:
+      return "concurrent";
+    case WorkerConcurrency::kSharded:
+      return "sharded";
+    case WorkerConcurrency::kSerialized:
+      return "serialized";
+    case WorkerConcurrency::kIsolated:
+      return "isolated";
+  }
+  return "unknown";
+}
+
+bool OpenWorkerPool(const std::string& path, unsigned threads, bool isolate, WorkerPool* pool,
+                    std::string* error) {
+  WorkerApi first{};
+  if (!LoadChecked(path, &first, error)) {
+    return false;
+  }
+  pool->shards.assign(1, first);
+  pool->mode = WorkerConcurrency::kConcurrent;
+  if (isolate) {
+    pool->mode = WorkerConcurrency::kIsolated;
+    pool->isolated.resize(threads == 0 ? 1 : threads);
+    for (IsolatedWorker& worker : pool->isolated) {
+      if (!StartIsolatedWorker(first, &worker, error)) {
+        CloseWorkerPool(pool);
+        return false;
+      }
+    }
+    return true;
+  }
+  if (threads <= 1 || (first.capabilities & SP_DIFFER_WORKER_CAP_REENTRANT) != 0) {
+    return true;
+  }
+
+  pool->mode = WorkerConcurrency::kSharded;
+  if (!LoadShards(path, threads, pool)) {
+    for (size_t i = 1; i < pool->shards.size(); ++i) {
+      UnloadWorker(&pool->shards[i]);
+    }
+    pool->shards.resize(1);
+    pool->mode = WorkerConcurrency::kSerialized;
+    pool->lock = std::make_unique<std::mutex>();
+  }
+  return true;
+}
+
+void CloseWorkerPool(WorkerPool* pool) {
+  for (IsolatedWorker& worker : pool->isolated) {
+    StopIsolatedWorker(&worker);
+  }
+  pool->isolated.clear();
+  for (WorkerApi& api : pool->shards) {
+    UnloadWorker(&api);
+  }
+  pool->shards.clear();
+  std::error_code ec;
+  for (const std::string& copy : pool->shard_copies) {
+    std::filesystem::remove(copy, ec);
+  }
+  pool->shard_copies.clear();
+}
+
+bool RunPooledWorker(WorkerPool& pool, unsigned thread, const std::vector<uint8_t>& input,
+                     std::vector<uint8_t>* output, std::string* error) {
+  if (pool.mode == WorkerConcurrency::kIsolated) {
+    std::vector<size_t> offsets = {0, input.size()};
+    std::vector<size_t> output_offsets;
+    std::vector<IsolatedCrash> crashes;
+    if (!RunIsolatedBatch(&pool.isolated[thread], input.data(), input.size(), offsets, output,
+                          &output_offsets, &crashes, error)) {
+      return false;
+    }
+    if (!crashes.empty()) {
+      if (error) {
+        *error = "worker " + DescribeIsolatedCrash(crashes[0]);
+      }
+      return false;
+    }
+    if (output->empty()) {
+      if (error) {
+        *error = "worker run failed";
+      }
+      return false;
+    }
+    return true;
+  }
+  if (pool.mode == WorkerConcurrency::kSerialized) {
+    std::lock_guard<std::mutex> guard(*pool.lock);
+    return RunWorker(pool.shards[0], input, output, error);
+  }
+  return RunWorker(ShardFor(pool, thread), input, output, error);
+}
+
+bool RunPooledWorkerBatch(WorkerPool& pool, unsigned thread, const uint8_t* inputs,
+                          size_t inputs_len, const std::vector<size_t>& input_offsets,
+                          std::vector<uint8_t>* outputs, std::vector<size_t>* output_offsets,
+                          std::vector<IsolatedCrash>* crashes, std::string* error,
+                          Heartbeat* heartbeat) {
+  if (crashes) {
+    crashes->clear();
+  }
+  if (pool.mode == WorkerConcurrency::kIsolated) {
+    std::vector<IsolatedCrash> ignored;
+    return RunIsolatedBatch(&pool.isolated[thread], inputs, inputs_len, input_offsets, outputs,
+                            output_offsets, crashes ? crashes : &ignored, error);
+  }
+  if (pool.mode == WorkerConcurrency::kSerialized) {
+    std::lock_guard<std::mutex> guard(*pool.lock);
+    if (heartbeat) {
+      return RunWatchedBatch(pool.shards[0], heartbeat, inputs, inputs_len, input_offsets,
+                             outputs, output_offsets, error);
+    }
+    return RunWorkerBatch(pool.shards[0], inputs, inputs_len, input_offsets, outputs,
+                          output_offsets, error);
+  }
+  if (heartbeat) {
+    return RunWatchedBatch(ShardFor(pool, thread), heartbeat, inputs, inputs_len, input_offsets,
+                           outputs, output_offsets, error);
+  }
+  return RunWorkerBatch(ShardFor(pool, thread), inputs, inputs_len, input_offsets, outputs,
+                        output_offsets, error);
+}
+
+}  // namespace sp_differ
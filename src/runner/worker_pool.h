@@ -0,0 +1,62 @@
+#ifndef SP_DIFFER_RUNNER_WORKER_POOL_H
+#define SP_DIFFER_RUNNER_WORKER_POOL_H
+
+#include "isolate.h"
+#include "worker.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sp_differ {
+
+enum class WorkerConcurrency {
+  // One shared copy called from every thread (SP_DIFFER_WORKER_CAP_REENTRANT).
+  kConcurrent,
+  // One private copy of the library per thread, each loaded from its own file
+  // so that no static state is shared.
+  kSharded,
+  // One shared copy with every call serialized behind a lock.
+  kSerialized,
+  // One crash-isolated child process per thread.
+  kIsolated,
+};
+
+struct WorkerPool {
+  WorkerConcurrency mode = WorkerConcurrency::kConcurrent;
+  std::vector<WorkerApi> shards;
+  std::vector<std::string> shard_copies;
+  std::unique_ptr<std::mutex> lock;
+  std::vector<IsolatedWorker> isolated;
+};
+
+const char* WorkerConcurrencyName(WorkerConcurrency mode);
+
+// Loads the worker at path for use from `threads` threads and picks a
+// concurrency mode from its capabilities: reentrant workers are shared,
+// others get one copy per thread, falling back to a serialized shared copy
+// when the copies cannot be loaded. With isolate set, every thread instead
+// gets its own crash-isolated child process; this forks, so it must happen
+// before any threads start. Fails on an ABI version mismatch.
+bool OpenWorkerPool(const std::string& path, unsigned threads, bool isolate, WorkerPool* pool,
+                    std::string* error);
+void CloseWorkerPool(WorkerPool* pool);
+
+bool RunPooledWorker(WorkerPool& pool, unsigned thread, const std::vector<uint8_t>& input,
+                     std::vector<uint8_t>* output, std::string* error);
+// crashes, when non-null, receives the cases that killed an isolated child.
+// With a heartbeat, an in-process pool runs the batch one case at a time and
+// beats before each case, so a watchdog can see which case hangs; a call
+// the watchdog has abandoned parks this thread for good once the worker
+// returns. Isolated pools beat from the child and ignore heartbeat.
+bool RunPooledWorkerBatch(WorkerPool& pool, unsigned thread, const uint8_t* inputs,
+                          size_t inputs_len, const std::vector<size_t>& input_offsets,
+                          std::vector<uint8_t>* outputs, std::vector<size_t>* output_offsets,
+                          std::vector<IsolatedCrash>* crashes, std::string* error,
+                          Heartbeat* heartbeat = nullptr);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_RUNNER_WORKER_POOL_H
@@ -0,0 +1,209 @@
+#include "bip352.h"
+
+#include "../../ffi/sp_differ.h"
+#include "../../src/core/sha256.h"
+#include "secp256k1.h"
+
+#include <cstring>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+constexpr uint32_t kFlagPrivkeys = 1u << 1;
+constexpr uint8_t kInputTaproot = 0x02;
+constexpr size_t kOutpointSize = kTxidSize + 4;
+constexpr size_t kTweakSize = 32;
+// K_max from BIP352: the most outputs a sender may create for one recipient.
+constexpr size_t kMaxOutputs = 2323;
+
+// Per-thread buffers, so a run reuses them from case to case.
+struct DeriveScratch {
+    std::vector<Scalar> keys;
+    std::vector<JacobianPoint> points;
+    std::vector<AffinePoint> affine;
+    std::vector<AffinePoint> recipients;
+    std::vector<uint8_t> messages;
+};
+
+// The spend key each output pays: spend itself without labels, otherwise
+// spend + m * G for every label m. All of them are normalized together, so
+// a receiver with thousands of labels costs one field inversion here rather
+// than one per label.
+bool LabeledSpendKeys(const CaseView& view, const AffinePoint& spend, DeriveScratch* scratch) {
+    size_t label_count = view.label_count;
+    if (label_count == 0) {
+        scratch->recipients.assign(1, spend);
+        return true;
+    }
+    scratch->points.resize(label_count);
+    scratch->recipients.resize(label_count);
+    for (size_t i = 0; i < label_count; ++i) {
+        uint32_t label = GetLabel(view, i);
+        uint8_t bytes[32] = {};
+        bytes[28] = static_cast<uint8_t>(label >> 24);
+        bytes[29] = static_cast<uint8_t>(label >> 16);
+        bytes[30] = static_cast<uint8_t>(label >> 8);
+        bytes[31] = static_cast<uint8_t>(label);
+        Scalar m;
+        ScalarSetBytes(bytes, &m);
+        GeneratorMultiply(m, &scratch->points[i]);
+        PointAddAffine(&scratch->points[i], spend);
+    }
+    PointsToAffine(scratch->points.data(), label_count, scratch->recipients.data());
+    for (const AffinePoint& recipient : scratch->recipients) {
+        if (recipient.infinity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+sp_differ_status Derive(const CaseView& view, DeriveScratch* scratch, size_t base,
+                        std::vector<uint8_t>* out) {
+    size_t input_count = view.header.input_count;
+    if (input_count == 0 || (view.header.flags & kFlagPrivkeys) == 0 ||
+        view.header.output_count > kMaxOutputs) {
+        return SP_DIFFER_STATUS_INVALID_INPUT;
+    }
+    AffinePoint scan, spend;
+    if (!ParsePubkey(view.scan_pubkey, &scan) || !ParsePubkey(view.spend_pubkey, &spend)) {
+        return SP_DIFFER_STATUS_INVALID_PUBKEY;
+    }
+
+    // Key checks and taproot parities need each d_i * G; those are found
+    // together so that one inversion covers every input.
+    scratch->keys.resize(input_count);
+    scratch->points.resize(input_count);
+    scratch->affine.resize(input_count);
+    const uint8_t* smallest_outpoint = nullptr;
+    for (size_t i = 0; i < input_count; ++i) {
+        InputView input = GetInput(view, i);
+        Scalar* key = &scratch->keys[i];
+        AffinePoint given;
+        if (!ScalarSetBytes(input.privkey, key) || ScalarIsZero(*key)) {
+            return SP_DIFFER_STATUS_INVALID_INPUT;
+        }
+        if (input.pubkey && !ParsePubkey(input.pubkey, &given)) {
+            return SP_DIFFER_STATUS_INVALID_PUBKEY;
+        }
+        if (input.pubkey || input.input_type == kInputTaproot) {
+            GeneratorMultiply(*key, &scratch->points[i]);
+        } else {
+            scratch->points[i].infinity = true;
+        }
+        // txid || vout is already the serialized outpoint.
+        if (!smallest_outpoint ||
+            std::memcmp(input.outpoint_txid, smallest_outpoint, kOutpointSize) < 0) {
+            smallest_outpoint = input.outpoint_txid;
+        }
+    }
+    PointsToAffine(scratch->points.data(), input_count, scratch->affine.data());
+
+    Scalar sum = {{0, 0, 0, 0}};
+    for (size_t i = 0; i < input_count; ++i) {
+        InputView input = GetInput(view, i);
+        const AffinePoint& point = scratch->affine[i];
+        Scalar key = scratch->keys[i];
+        if (input.pubkey) {
+            uint8_t derived[kPubkeySize];
+            SerializePubkey(point, derived);
+            if (std::memcmp(derived, input.pubkey, kPubkeySize) != 0) {
+                return SP_DIFFER_STATUS_INVALID_INPUT;
+            }
+        }
+        if (input.input_type == kInputTaproot && HasOddY(point)) {
+            ScalarNegate(&key, key);
+        }
+        ScalarAdd(&sum, sum, key);
+    }
+    if (ScalarIsZero(sum)) {
+        return SP_DIFFER_STATUS_ZERO_SCALAR;
+    }
+
+    uint8_t message[kOutpointSize + kPubkeySize];
+    JacobianPoint point;
+    AffinePoint affine;
+    GeneratorMultiply(sum, &point);
+    PointToAffine(point, &affine);
+    std::memcpy(message, smallest_outpoint, kOutpointSize);
+    SerializePubkey(affine, message + kOutpointSize);
+    uint8_t digest[32];
+    Scalar input_hash;
+    TaggedHash(HashTag::kBip352Inputs, message, sizeof(message), digest);
+    if (!ScalarSetBytes(digest, &input_hash) || ScalarIsZero(input_hash)) {
+        return SP_DIFFER_STATUS_TWEAK_OUT_OF_RANGE;
+    }
+
+    // Both factors are nonzero mod the prime n, so S is never infinity.
+    Scalar ecdh;
+    ScalarMul(&ecdh, input_hash, sum);
+    PointMultiply(scan, ecdh, &point);
+    PointToAffine(point, &affine);
+    uint8_t shared[kPubkeySize + 4];
+    SerializePubkey(affine, shared);
+
+    if (!LabeledSpendKeys(view, spend, scratch)) {
+        return SP_DIFFER_STATUS_POINT_AT_INFINITY;
+    }
+    size_t recipient_count = scratch->recipients.size();
+
+    size_t output_count = view.header.output_count;
+    out->resize(base + 4 + output_count * (kPubkeySize + kTweakSize));
+    uint8_t* header = out->data() + base;
+    header[0] = 1;
+    header[1] = SP_DIFFER_STATUS_OK;
+    header[2] = static_cast<uint8_t>(output_count);
+    header[3] = static_cast<uint8_t>(output_count >> 8);
+    uint8_t* pubkeys = header + 4;
+    uint8_t* tweaks = pubkeys + output_count * kPubkeySize;
+
+    // Every t_k is hashed up front in one call, so the hash backend can
+    // work on several of them at once.
+    scratch->messages.resize(output_count * sizeof(shared));
+    for (size_t k = 0; k < output_count; ++k) {
+        shared[kPubkeySize] = static_cast<uint8_t>(k >> 24);
+        shared[kPubkeySize + 1] = static_cast<uint8_t>(k >> 16);
+        shared[kPubkeySize + 2] = static_cast<uint8_t>(k >> 8);
+        shared[kPubkeySize + 3] = static_cast<uint8_t>(k);
+        std::memcpy(scratch->messages.data() + k * sizeof(shared), shared, sizeof(shared));
+    }
+    TaggedHashMany(HashTag::kBip352SharedSecret, scratch->messages.data(), sizeof(shared),
+                   output_count, tweaks);
+
+    scratch->points.resize(output_count);
+    scratch->affine.resize(output_count);
+    for (size_t k = 0; k < output_count; ++k) {
+        Scalar t;
+        if (!ScalarSetBytes(tweaks + k * kTweakSize, &t)) {
+            return SP_DIFFER_STATUS_TWEAK_OUT_OF_RANGE;
+        }
+        GeneratorMultiply(t, &scratch->points[k]);
+        PointAddAffine(&scratch->points[k], scratch->recipients[k % recipient_count]);
+    }
+    PointsToAffine(scratch->points.data(), output_count, scratch->affine.data());
+    for (size_t k = 0; k < output_count; ++k) {
+        if (scratch->affine[k].infinity) {
+            return SP_DIFFER_STATUS_POINT_AT_INFINITY;
+        }
+        SerializePubkey(scratch->affine[k], pubkeys + k * kPubkeySize);
+    }
+    return SP_DIFFER_STATUS_OK;
+}
+
+}  // namespace
+
+void AppendSilentPaymentOutputs(const CaseView& view, std::vector<uint8_t>* out) {
+    thread_local DeriveScratch scratch;
+    size_t base = out->size();
+    sp_differ_status status = Derive(view, &scratch, base, out);
+    if (status != SP_DIFFER_STATUS_OK) {
+        out->resize(base);
+        out->push_back(1);
+        out->push_back(static_cast<uint8_t>(status));
+        out->push_back(0);
+        out->push_back(0);
+    }
+}
+
+}  // namespace sp_differ
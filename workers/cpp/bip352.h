@@ -0,0 +1,40 @@
+#ifndef SP_DIFFER_WORKER_BIP352_H
+#define SP_DIFFER_WORKER_BIP352_H
+
+#include "../../src/core/case.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace sp_differ {
+
+// Sender-side BIP352 derivation for a parsed case, appended to out as a v1
+// result: the status, then on success output_count pubkeys and tweaks.
+//
+//   a = sum of the input private keys, each negated first when it is a
+//       taproot input whose public key has an odd y
+//   input_hash = hash_BIP0352/Inputs(smallest outpoint || ser(a * G))
+//   S = (input_hash * a) * scan_pubkey
+//   t_k = hash_BIP0352/SharedSecret(ser(S) || ser32(k))
+//   P_k = B_k + t_k * G, for k = 0 .. output_count - 1
+//
+// B_k is spend_pubkey when the case has no labels. With labels m_0 ..
+// m_(j-1) the case pays the labeled addresses in turn: B_k is
+// spend_pubkey + m_(k mod j) * G. BIP352 derives the label tweak from the
+// scan private key, which a sender-side case does not carry, so the label
+// value itself stands in for it.
+//
+// Failures are reported in this order: invalid_input for a case without
+// inputs or private keys, or asking for more than K_max = 2323 outputs;
+// invalid_pubkey for the scan, then the spend key; per input, invalid_input
+// for a private key of zero or not below n and invalid_pubkey for an
+// unparsable public key; then invalid_input for any public key that is not
+// its private key times G; zero_scalar when a is zero; tweak_out_of_range
+// when input_hash is zero or not below n; point_at_infinity when any
+// labeled spend key is infinity; tweak_out_of_range when any t_k is not
+// below n; point_at_infinity when any P_k is infinity.
+void AppendSilentPaymentOutputs(const CaseView& view, std::vector<uint8_t>* out);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_WORKER_BIP352_H
@@ -0,0 +1,299 @@
+#include "../../ffi/sp_differ.h"
+#include "../../src/core/case.h"
+#include "../../src/core/sha256.h"
+#include "bip352.h"
+#include "secp256k1.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string Hex(const uint8_t* data, size_t len) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string text;
+    for (size_t i = 0; i < len; ++i) {
+        text += kDigits[data[i] >> 4];
+        text += kDigits[data[i] & 15];
+    }
+    return text;
+}
+
+std::vector<uint8_t> FromHex(const std::string& text) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i + 1 < text.size(); i += 2) {
+        bytes.push_back(static_cast<uint8_t>(std::stoi(text.substr(i, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+bool Expect(const std::string& what, const std::string& got, const std::string& want) {
+    if (got != want) {
+        std::cerr << "FAIL: " << what << ": got " << got << ", want " << want << std::endl;
+        return false;
+    }
+    return true;
+}
+
+sp_differ::Scalar SmallScalar(uint64_t value) {
+    sp_differ::Scalar scalar = {{value, 0, 0, 0}};
+    return scalar;
+}
+
+std::string Compressed(const sp_differ::JacobianPoint& point) {
+    sp_differ::AffinePoint affine;
+    sp_differ::PointToAffine(point, &affine);
+    if (affine.infinity) {
+        return "infinity";
+    }
+    uint8_t bytes[33];
+    sp_differ::SerializePubkey(affine, bytes);
+    return Hex(bytes, sizeof(bytes));
+}
+
+std::string GeneratorTimes(const sp_differ::Scalar& k) {
+    sp_differ::JacobianPoint point;
+    sp_differ::GeneratorMultiply(k, &point);
+    return Compressed(point);
+}
+
+std::vector<uint8_t> ScalarBytes(const sp_differ::Scalar& k) {
+    std::vector<uint8_t> bytes(32);
+    sp_differ::ScalarGetBytes(k, bytes.data());
+    return bytes;
+}
+
+// A one-output case paying G, 2G with the given inputs.
+sp_differ::Case MakeCase(const std::vector<sp_differ::InputEntry>& inputs) {
+    sp_differ::Case c;
+    c.header.version = 1;
+    c.header.flags = 1u << 1;
+    c.header.output_count = 1;
+    c.inputs = inputs;
+    c.scan_pubkey = FromHex("0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798");
+    c.spend_pubkey = FromHex("02c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5");
+    return c;
+}
+
+sp_differ::InputEntry MakeInput(uint8_t input_type, const sp_differ::Scalar& key, uint8_t tag) {
+    sp_differ::InputEntry input;
+    input.outpoint_txid.assign(sp_differ::kTxidSize, tag);
+    input.outpoint_vout = tag;
+    input.input_type = input_type;
+    input.privkey = ScalarBytes(key);
+    return input;
+}
+
+std::string Derive(const sp_differ::Case& c) {
+    std::vector<uint8_t> payload;
+    sp_differ::SerializeCaseV1(c, &payload);
+    sp_differ::CaseView view;
+    if (!sp_differ::ParseCaseViewV1(payload.data(), payload.size(), &view, nullptr)) {
+        return "unparsable";
+    }
+    std::vector<uint8_t> out = {0xaa};
+    sp_differ::AppendSilentPaymentOutputs(view, &out);
+    return Hex(out.data() + 1, out.size() - 1);
+}
+
+std::string StatusOnly(sp_differ_status status) {
+    uint8_t bytes[4] = {1, static_cast<uint8_t>(status), 0, 0};
+    return Hex(bytes, sizeof(bytes));
+}
+
+}  // namespace
+
+int main() {
+    const std::string g = "0279be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798";
+    sp_differ::Scalar order_minus_one;
+    sp_differ::ScalarNegate(&order_minus_one, SmallScalar(1));
+    if (!Expect("1G", GeneratorTimes(SmallScalar(1)), g) ||
+        !Expect("2G", GeneratorTimes(SmallScalar(2)),
+                "02c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5") ||
+        !Expect("3G", GeneratorTimes(SmallScalar(3)),
+                "02f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9") ||
+        !Expect("-G", GeneratorTimes(order_minus_one), "03" + g.substr(2)) ||
+        !Expect("0G", GeneratorTimes(SmallScalar(0)), "infinity")) {
+        return 2;
+    }
+    std::vector<uint8_t> order = ScalarBytes(order_minus_one);
+    order[31] += 1;
+    sp_differ::Scalar rejected;
+    if (sp_differ::ScalarSetBytes(order.data(), &rejected)) {
+        std::cerr << "FAIL: n accepted as a scalar" << std::endl;
+        return 2;
+    }
+
+    // The comb and the wNAF ladder must agree on any scalar.
+    sp_differ::AffinePoint generator;
+    std::vector<uint8_t> g_bytes = FromHex(g);
+    if (!sp_differ::ParsePubkey(g_bytes.data(), &generator)) {
+        std::cerr << "FAIL: G did not parse" << std::endl;
+        return 2;
+    }
+    uint8_t seed[32] = {0};
+    for (int i = 0; i < 64; ++i) {
+        uint8_t digest[32];
+        sp_differ::TaggedHash("sp-differ smoke", seed, sizeof(seed), digest);
+        std::memcpy(seed, digest, sizeof(seed));
+        sp_differ::Scalar k;
+        if (!sp_differ::ScalarSetBytes(digest, &k)) {
+            continue;
+        }
+        sp_differ::JacobianPoint ladder;
+        sp_differ::PointMultiply(generator, k, &ladder);
+        if (!Expect("wnaf vs comb", Compressed(ladder), GeneratorTimes(k))) {
+            return 2;
+        }
+    }
+    sp_differ::JacobianPoint ladder;
+    sp_differ::PointMultiply(generator, order_minus_one, &ladder);
+    if (!Expect("wnaf -G", Compressed(ladder), "03" + g.substr(2))) {
+        return 2;
+    }
+
+    // One inversion for a batch, with points at infinity left in place.
+    sp_differ::JacobianPoint batch[4];
+    sp_differ::GeneratorMultiply(SmallScalar(2), &batch[0]);
+    batch[1].infinity = true;
+    sp_differ::GeneratorMultiply(SmallScalar(3), &batch[2]);
+    sp_differ::GeneratorMultiply(SmallScalar(1), &batch[3]);
+    sp_differ::AffinePoint affine[4];
+    sp_differ::PointsToAffine(batch, 4, affine);
+    for (int i = 0; i < 4; ++i) {
+        std::string want = Compressed(batch[i]);
+        std::string got = "infinity";
+        if (!affine[i].infinity) {
+            uint8_t bytes[33];
+            sp_differ::SerializePubkey(affine[i], bytes);
+            got = Hex(bytes, sizeof(bytes));
+        }
+        if (!Expect("batch affine", got, want)) {
+            return 2;
+        }
+    }
+
+    // tests/vectors/example.hex, checked against an independent
+    // big-integer implementation.
+    sp_differ::Case example = MakeCase({MakeInput(0x01, SmallScalar(1), 0)});
+    example.header.seed = 0x42;
+    for (uint8_t i = 0; i < sp_differ::kTxidSize; ++i) {
+        example.inputs[0].outpoint_txid[i] = i;
+    }
+    example.inputs[0].outpoint_vout = 0;
+    if (!Expect("example", Derive(example),
+                "010001000229753a8c5b275de1bcd10fab2d3e012df5883b861d65ee039876fab9c19b0182"
+                "18963e78a64aafe7768060eda0611b47e33b299615098c14d4e1912dfc1a3956")) {
+        return 2;
+    }
+
+    // A taproot key with an odd-y public key counts as its negation.
+    uint64_t odd = 1;
+    for (;; ++odd) {
+        sp_differ::JacobianPoint point;
+        sp_differ::AffinePoint point_affine;
+        sp_differ::GeneratorMultiply(SmallScalar(odd), &point);
+        sp_differ::PointToAffine(point, &point_affine);
+        if (sp_differ::HasOddY(point_affine)) {
+            break;
+        }
+    }
+    sp_differ::Scalar negated;
+    sp_differ::ScalarNegate(&negated, SmallScalar(odd));
+    std::string taproot = Derive(MakeCase({MakeInput(0x02, SmallScalar(odd), 1)}));
+    if (!Expect("taproot negation", taproot,
+                Derive(MakeCase({MakeInput(0x01, negated, 1)}))) ||
+        taproot == Derive(MakeCase({MakeInput(0x01, SmallScalar(odd), 1)}))) {
+        std::cerr << "FAIL: taproot key was not negated" << std::endl;
+        return 2;
+    }
+
+    sp_differ::Case c = MakeCase({MakeInput(0x01, SmallScalar(5), 1),
+                                  MakeInput(0x01, sp_differ::Scalar(), 2)});
+    sp_differ::ScalarNegate(&negated, SmallScalar(5));
+    c.inputs[1].privkey = ScalarBytes(negated);
+    if (!Expect("zero sum", Derive(c), StatusOnly(SP_DIFFER_STATUS_ZERO_SCALAR))) {
+        return 2;
+    }
+    c.inputs[1].privkey.assign(32, 0);
+    if (!Expect("zero key", Derive(c), StatusOnly(SP_DIFFER_STATUS_INVALID_INPUT))) {
+        return 2;
+    }
+    c.inputs[1].privkey = order;
+    if (!Expect("key overflow", Derive(c), StatusOnly(SP_DIFFER_STATUS_INVALID_INPUT))) {
+        return 2;
+    }
+
+    c = MakeCase({MakeInput(0x01, SmallScalar(1), 1)});
+    c.header.flags |= 1u << 2;
+    c.inputs[0].pubkey = FromHex(g);
+    std::string with_pubkey = Derive(c);
+    c.inputs[0].pubkey[0] = 0x03;
+    if (!Expect("key match", with_pubkey, Derive(MakeCase({MakeInput(0x01, SmallScalar(1), 1)}))) ||
+        !Expect("key mismatch", Derive(c), StatusOnly(SP_DIFFER_STATUS_INVALID_INPUT))) {
+        return 2;
+    }
+    c.inputs[0].pubkey[0] = 0x04;
+    if (!Expect("bad input pubkey", Derive(c), StatusOnly(SP_DIFFER_STATUS_INVALID_PUBKEY))) {
+        return 2;
+    }
+
+    c = MakeCase({MakeInput(0x01, SmallScalar(1), 1)});
+    c.scan_pubkey.assign(sp_differ::kPubkeySize, 0);
+    c.scan_pubkey[0] = 0x02;  // x = 0 is not on the curve
+    if (!Expect("bad scan key", Derive(c), StatusOnly(SP_DIFFER_STATUS_INVALID_PUBKEY))) {
+        return 2;
+    }
+    c = MakeCase({MakeInput(0x01, SmallScalar(1), 1)});
+    c.header.flags = 0;
+    c.inputs[0].privkey.clear();
+    if (!Expect("no private keys", Derive(c), StatusOnly(SP_DIFFER_STATUS_INVALID_INPUT))) {
+        return 2;
+    }
+    c = MakeCase({MakeInput(0x01, SmallScalar(1), 1)});
+    c.header.output_count = 0;
+    if (!Expect("no outputs", Derive(c), StatusOnly(SP_DIFFER_STATUS_OK))) {
+        return 2;
+    }
+    c.header.output_count = 2324;
+    if (!Expect("above K_max", Derive(c), StatusOnly(SP_DIFFER_STATUS_INVALID_INPUT))) {
+        return 2;
+    }
+
+    // Labels: label 0 is the spend key itself, and labels are paid in turn,
+    // each output matching an unlabeled case paying spend + m * G (the
+    // spend key is 2G, so labels 2 and 5 give 4G and 7G).
+    c = MakeCase({MakeInput(0x01, SmallScalar(1), 1)});
+    c.labels = {0};
+    if (!Expect("label zero", Derive(c), Derive(MakeCase({MakeInput(0x01, SmallScalar(1), 1)})))) {
+        return 2;
+    }
+    c.header.output_count = 3;
+    c.labels = {2, 5};
+    std::string labeled = Derive(c);
+    const uint64_t paid[3] = {4, 7, 4};
+    for (size_t k = 0; k < 3; ++k) {
+        sp_differ::Case plain = c;
+        plain.labels.clear();
+        plain.spend_pubkey = FromHex(GeneratorTimes(SmallScalar(paid[k])));
+        std::string want = Derive(plain);
+        if (!Expect("labeled output " + std::to_string(k), labeled.substr(8 + k * 66, 66),
+                    want.substr(8 + k * 66, 66)) ||
+            !Expect("labeled tweak " + std::to_string(k), labeled.substr(8 + 3 * 66 + k * 64, 64),
+                    want.substr(8 + 3 * 66 + k * 64, 64))) {
+            return 2;
+        }
+    }
+    sp_differ::ScalarNegate(&negated, SmallScalar(5));
+    c.spend_pubkey = FromHex(GeneratorTimes(negated));
+    if (!Expect("label cancels spend key", Derive(c),
+                StatusOnly(SP_DIFFER_STATUS_POINT_AT_INFINITY))) {
+        return 2;
+    }
+
+    std::cout << "OK: bip352 derivation" << std::endl;
+    return 0;
+}
@@ -0,0 +1,796 @@
+#include "secp256k1.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace sp_differ {
+namespace {
+
+using uint128 = unsigned __int128;
+
+// 2^256 mod p.
+constexpr uint64_t kFieldC = 0x1000003d1ULL;
+// The group order n and 2^256 - n.
+constexpr uint64_t kOrder[4] = {0xbfd25e8cd0364141ULL, 0xbaaedce6af48a03bULL,
+                                0xfffffffffffffffeULL, 0xffffffffffffffffULL};
+constexpr uint64_t kOrderC[3] = {0x402da1732fc9bebfULL, 0x4551231950b75fc4ULL, 1};
+
+const FieldElement kFieldOne = {{1, 0, 0, 0}};
+const FieldElement kCurveB = {{7, 0, 0, 0}};
+const AffinePoint kGenerator = {
+    {{0x59f2815b16f81798ULL, 0x029bfcdb2dce28d9ULL, 0x55a06295ce870b07ULL,
+      0x79be667ef9dcbbacULL}},
+    {{0x9c47d08ffb10d4b8ULL, 0xfd17b448a6855419ULL, 0x5da4fbfc0e1108a8ULL,
+      0x483ada7726a3c465ULL}},
+    false};
+
+// Comb layout for k * G: bit (b * kCombTeeth + t) * kCombSpacing + s of k
+// is tooth t of block b in column s. Each block has a table of every sum of
+// its teeth, so one column costs one addition per block.
+constexpr int kCombBlocks = 8;
+constexpr int kCombTeeth = 8;
+constexpr int kCombSpacing = 4;
+constexpr int kCombEntries = 1 << kCombTeeth;
+static_assert(kCombBlocks * kCombTeeth * kCombSpacing == 256, "comb must cover 256 bits");
+
+constexpr int kWnafWindow = 5;
+constexpr int kWnafTableSize = 1 << (kWnafWindow - 2);
+
+// r + carry * 2^256, folded back below 2^256 as carry * kFieldC.
+void FeFold(FieldElement* r, uint64_t carry) {
+    while (carry != 0) {
+        uint128 t = static_cast<uint128>(carry) * kFieldC + r->n[0];
+        r->n[0] = static_cast<uint64_t>(t);
+        for (int i = 1; i < 4; ++i) {
+            t = (t >> 64) + r->n[i];
+            r->n[i] = static_cast<uint64_t>(t);
+        }
+        carry = static_cast<uint64_t>(t >> 64);
+    }
+}
+
+void FeAdd(FieldElement* r, const FieldElement& a, const FieldElement& b) {
+    uint128 t = 0;
+    for (int i = 0; i < 4; ++i) {
+        t += static_cast<uint128>(a.n[i]) + b.n[i];
+        r->n[i] = static_cast<uint64_t>(t);
+        t >>= 64;
+    }
+    FeFold(r, static_cast<uint64_t>(t));
+}
+
+void FeSub(FieldElement* r, const FieldElement& a, const FieldElement& b) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128 t = static_cast<uint128>(a.n[i]) - b.n[i] - borrow;
+        r->n[i] = static_cast<uint64_t>(t);
+        borrow = static_cast<uint64_t>(t >> 64) & 1;
+    }
+    // A borrow stands for -2^256, which is -kFieldC mod p.
+    while (borrow != 0) {
+        uint128 t = static_cast<uint128>(r->n[0]) - kFieldC;
+        r->n[0] = static_cast<uint64_t>(t);
+        borrow = static_cast<uint64_t>(t >> 64) & 1;
+        for (int i = 1; i < 4; ++i) {
+            t = static_cast<uint128>(r->n[i]) - borrow;
+            r->n[i] = static_cast<uint64_t>(t);
+            borrow = static_cast<uint64_t>(t >> 64) & 1;
+        }
+    }
+}
+
+void FeNegate(FieldElement* r, const FieldElement& a) {
+    const FieldElement zero = {{0, 0, 0, 0}};
+    FeSub(r, zero, a);
+}
+
+// (c0, c1, c2) += a * b, a three-limb column accumulator.
+inline void MulAdd(uint64_t a, uint64_t b, uint64_t* c0, uint64_t* c1, uint64_t* c2) {
+    uint128 t = static_cast<uint128>(a) * b;
+    uint64_t high = static_cast<uint64_t>(t >> 64);
+    uint64_t low = static_cast<uint64_t>(t);
+    *c0 += low;
+    high += *c0 < low;
+    *c1 += high;
+    *c2 += *c1 < high;
+}
+
+// (c0, c1, c2) += 2 * a * b.
+inline void MulAdd2(uint64_t a, uint64_t b, uint64_t* c0, uint64_t* c1, uint64_t* c2) {
+    MulAdd(a, b, c0, c1, c2);
+    MulAdd(a, b, c0, c1, c2);
+}
+
+// Emits the finished low limb of the column accumulator and shifts it down.
+inline uint64_t Extract(uint64_t* c0, uint64_t* c1, uint64_t* c2) {
+    uint64_t limb = *c0;
+    *c0 = *c1;
+    *c1 = *c2;
+    *c2 = 0;
+    return limb;
+}
+
+// Reduces a 512-bit product with 2^256 = kFieldC.
+inline void FeReduceWide(const uint64_t t[8], FieldElement* r) {
+    uint128 c = static_cast<uint128>(t[4]) * kFieldC + t[0];
+    uint64_t r0 = static_cast<uint64_t>(c);
+    c = (c >> 64) + static_cast<uint128>(t[5]) * kFieldC + t[1];
+    uint64_t r1 = static_cast<uint64_t>(c);
+    c = (c >> 64) + static_cast<uint128>(t[6]) * kFieldC + t[2];
+    uint64_t r2 = static_cast<uint64_t>(c);
+    c = (c >> 64) + static_cast<uint128>(t[7]) * kFieldC + t[3];
+    uint64_t r3 = static_cast<uint64_t>(c);
+    // The top carry is below 2^34, so one more fold leaves at most a carry
+    // of one, which FeFold absorbs.
+    c = (c >> 64) * kFieldC + r0;
+    r->n[0] = static_cast<uint64_t>(c);
+    c = (c >> 64) + r1;
+    r->n[1] = static_cast<uint64_t>(c);
+    c = (c >> 64) + r2;
+    r->n[2] = static_cast<uint64_t>(c);
+    c = (c >> 64) + r3;
+    r->n[3] = static_cast<uint64_t>(c);
+    FeFold(r, static_cast<uint64_t>(c >> 64));
+}
+
+// Product scanning: each column of the 512-bit product is summed in a
+// three-limb accumulator, which keeps every partial product in registers.
+void FeMul(FieldElement* r, const FieldElement& a, const FieldElement& b) {
+    uint64_t t[8];
+    uint64_t c0 = 0, c1 = 0, c2 = 0;
+    MulAdd(a.n[0], b.n[0], &c0, &c1, &c2);
+    t[0] = Extract(&c0, &c1, &c2);
+    MulAdd(a.n[0], b.n[1], &c0, &c1, &c2);
+    MulAdd(a.n[1], b.n[0], &c0, &c1, &c2);
+    t[1] = Extract(&c0, &c1, &c2);
+    MulAdd(a.n[0], b.n[2], &c0, &c1, &c2);
+    MulAdd(a.n[1], b.n[1], &c0, &c1, &c2);
+    MulAdd(a.n[2], b.n[0], &c0, &c1, &c2);
+    t[2] = Extract(&c0, &c1, &c2);
+    MulAdd(a.n[0], b.n[3], &c0, &c1, &c2);
+    MulAdd(a.n[1], b.n[2], &c0, &c1, &c2);
+    MulAdd(a.n[2], b.n[1], &c0, &c1, &c2);
+    MulAdd(a.n[3], b.n[0], &c0, &c1, &c2);
+    t[3] = Extract(&c0, &c1, &c2);
+    MulAdd(a.n[1], b.n[3], &c0, &c1, &c2);
+    MulAdd(a.n[2], b.n[2], &c0, &c1, &c2);
+    MulAdd(a.n[3], b.n[1], &c0, &c1, &c2);
+    t[4] = Extract(&c0, &c1, &c2);
+    MulAdd(a.n[2], b.n[3], &c0, &c1, &c2);
+    MulAdd(a.n[3], b.n[2], &c0, &c1, &c2);
+    t[5] = Extract(&c0, &c1, &c2);
+    MulAdd(a.n[3], b.n[3], &c0, &c1, &c2);
+    t[6] = Extract(&c0, &c1, &c2);
+    t[7] = c0;
+    FeReduceWide(t, r);
+}
+
+// Squaring computes each cross product once and counts it twice.
+void FeSqr(FieldElement* r, const FieldElement& a) {
+    uint64_t t[8];
+    uint64_t c0 = 0, c1 = 0, c2 = 0;
+    MulAdd(a.n[0], a.n[0], &c0, &c1, &c2);
+    t[0] = Extract(&c0, &c1, &c2);
+    MulAdd2(a.n[0], a.n[1], &c0, &c1, &c2);
+    t[1] = Extract(&c0, &c1, &c2);
+    MulAdd2(a.n[0], a.n[2], &c0, &c1, &c2);
+    MulAdd(a.n[1], a.n[1], &c0, &c1, &c2);
+    t[2] = Extract(&c0, &c1, &c2);
+    MulAdd2(a.n[0], a.n[3], &c0, &c1, &c2);
+    MulAdd2(a.n[1], a.n[2], &c0, &c1, &c2);
+    t[3] = Extract(&c0, &c1, &c2);
+    MulAdd2(a.n[1], a.n[3], &c0, &c1, &c2);
+    MulAdd(a.n[2], a.n[2], &c0, &c1, &c2);
+    t[4] = Extract(&c0, &c1, &c2);
+    MulAdd2(a.n[2], a.n[3], &c0, &c1, &c2);
+    t[5] = Extract(&c0, &c1, &c2);
+    MulAdd(a.n[3], a.n[3], &c0, &c1, &c2);
+    t[6] = Extract(&c0, &c1, &c2);
+    t[7] = c0;
+    FeReduceWide(t, r);
+}
+
+void FeSqrN(FieldElement* r, const FieldElement& a, int count) {
+    *r = a;
+    for (int i = 0; i < count; ++i) {
+        FeSqr(r, *r);
+    }
+}
+
+// Brings a value into [0, p). It is below 2^256 < 2p, and it is at least p
+// exactly when adding kFieldC carries out of 2^256.
+void FeNormalize(FieldElement* r) {
+    uint64_t s[4];
+    uint128 t = static_cast<uint128>(r->n[0]) + kFieldC;
+    s[0] = static_cast<uint64_t>(t);
+    for (int i = 1; i < 4; ++i) {
+        t = (t >> 64) + r->n[i];
+        s[i] = static_cast<uint64_t>(t);
+    }
+    if ((t >> 64) != 0) {
+        for (int i = 0; i < 4; ++i) {
+            r->n[i] = s[i];
+        }
+    }
+}
+
+bool FeIsZero(const FieldElement& a) {
+    FieldElement t = a;
+    FeNormalize(&t);
+    return (t.n[0] | t.n[1] | t.n[2] | t.n[3]) == 0;
+}
+
+bool FeEqual(const FieldElement& a, const FieldElement& b) {
+    FieldElement d;
+    FeSub(&d, a, b);
+    return FeIsZero(d);
+}
+
+// Reads a big-endian field element; false when it is not below p.
+bool FeSetBytes(const uint8_t bytes[32], FieldElement* r) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t limb = 0;
+        for (int j = 0; j < 8; ++j) {
+            limb = (limb << 8) | bytes[(3 - i) * 8 + j];
+        }
+        r->n[i] = limb;
+    }
+    FieldElement reduced = *r;
+    FeNormalize(&reduced);
+    return reduced.n[0] == r->n[0] && reduced.n[1] == r->n[1] && reduced.n[2] == r->n[2] &&
+           reduced.n[3] == r->n[3];
+}
+
+void FeGetBytes(const FieldElement& a, uint8_t bytes[32]) {
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            bytes[(3 - i) * 8 + j] = static_cast<uint8_t>(a.n[i] >> (56 - 8 * j));
+        }
+    }
+}
+
+// Powers of a of the form a^(2^k - 1) for the exponent chains below.
+struct FePowers {
+    FieldElement x2;
+    FieldElement x3;
+    FieldElement x22;
+    FieldElement x223;
+};
+
+void FeChainPowers(const FieldElement& a, FePowers* powers) {
+    FieldElement x6, x9, x11, x44, x88, x176, x220;
+    FeSqr(&powers->x2, a);
+    FeMul(&powers->x2, powers->x2, a);
+    FeSqr(&powers->x3, powers->x2);
+    FeMul(&powers->x3, powers->x3, a);
+    FeSqrN(&x6, powers->x3, 3);
+    FeMul(&x6, x6, powers->x3);
+    FeSqrN(&x9, x6, 3);
+    FeMul(&x9, x9, powers->x3);
+    FeSqrN(&x11, x9, 2);
+    FeMul(&x11, x11, powers->x2);
+    FeSqrN(&powers->x22, x11, 11);
+    FeMul(&powers->x22, powers->x22, x11);
+    FeSqrN(&x44, powers->x22, 22);
+    FeMul(&x44, x44, powers->x22);
+    FeSqrN(&x88, x44, 44);
+    FeMul(&x88, x88, x44);
+    FeSqrN(&x176, x88, 88);
+    FeMul(&x176, x176, x88);
+    FeSqrN(&x220, x176, 44);
+    FeMul(&x220, x220, x44);
+    FeSqrN(&powers->x223, x220, 3);
+    FeMul(&powers->x223, powers->x223, powers->x3);
+}
+
+// a^(p - 2). The exponent is 223 ones, a zero, 22 ones, then 0000101101.
+void FeInv(FieldElement* r, const FieldElement& a) {
+    FePowers powers;
+    FeChainPowers(a, &powers);
+    FieldElement t;
+    FeSqrN(&t, powers.x223, 23);
+    FeMul(&t, t, powers.x22);
+    FeSqrN(&t, t, 5);
+    FeMul(&t, t, a);
+    FeSqrN(&t, t, 3);
+    FeMul(&t, t, powers.x2);
+    FeSqrN(&t, t, 2);
+    FeMul(r, t, a);
+}
+
+// a^((p + 1) / 4), a square root since p = 3 mod 4. False when a is not a
+// square.
+bool FeSqrt(FieldElement* r, const FieldElement& a) {
+    FePowers powers;
+    FeChainPowers(a, &powers);
+    FieldElement t;
+    FeSqrN(&t, powers.x223, 23);
+    FeMul(&t, t, powers.x22);
+    FeSqrN(&t, t, 6);
+    FeMul(&t, t, powers.x2);
+    FeSqrN(r, t, 2);
+    FieldElement check;
+    FeSqr(&check, *r);
+    return FeEqual(check, a);
+}
+
+bool ScalarAtLeastOrder(const uint64_t n[4]) {
+    for (int i = 3; i >= 0; --i) {
+        if (n[i] != kOrder[i]) {
+            return n[i] > kOrder[i];
+        }
+    }
+    return true;
+}
+
+void ScalarSubOrder(uint64_t n[4]) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128 t = static_cast<uint128>(n[i]) - kOrder[i] - borrow;
+        n[i] = static_cast<uint64_t>(t);
+        borrow = static_cast<uint64_t>(t >> 64) & 1;
+    }
+}
+
+// Reduces a little-endian integer of up to eight limbs mod n by folding the
+// limbs above 2^256 back in as multiples of 2^256 - n.
+void ScalarReduce(const uint64_t* limbs, int count, Scalar* r) {
+    uint64_t acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < count; ++i) {
+        acc[i] = limbs[i];
+    }
+    int used = count;
+    while (used > 4) {
+        uint64_t next[8] = {acc[0], acc[1], acc[2], acc[3], 0, 0, 0, 0};
+        for (int i = 0; i < used - 4; ++i) {
+            uint128 carry = 0;
+            for (int j = 0; j < 3; ++j) {
+                carry += static_cast<uint128>(acc[4 + i]) * kOrderC[j] + next[i + j];
+                next[i + j] = static_cast<uint64_t>(carry);
+                carry >>= 64;
+            }
+            for (int k = i + 3; carry != 0 && k < 8; ++k) {
+                carry += next[k];
+                next[k] = static_cast<uint64_t>(carry);
+                carry >>= 64;
+            }
+        }
+        used = 4;
+        for (int i = 0; i < 8; ++i) {
+            acc[i] = next[i];
+            if (next[i] != 0 && i >= 4) {
+                used = i + 1;
+            }
+        }
+    }
+    if (ScalarAtLeastOrder(acc)) {
+        ScalarSubOrder(acc);
+    }
+    for (int i = 0; i < 4; ++i) {
+        r->n[i] = acc[i];
+    }
+}
+
+int ScalarBit(const Scalar& k, int bit) {
+    return static_cast<int>((k.n[bit >> 6] >> (bit & 63)) & 1);
+}
+
+// count <= kWnafWindow bits of k starting at offset.
+int ScalarBits(const Scalar& k, int offset, int count) {
+    int limb = offset >> 6;
+    int shift = offset & 63;
+    uint64_t bits = k.n[limb] >> shift;
+    if (shift + count > 64 && limb + 1 < 4) {
+        bits |= k.n[limb + 1] << (64 - shift);
+    }
+    return static_cast<int>(bits & ((1u << count) - 1));
+}
+
+// Width-w NAF of k: every nonzero digit is odd and below 2^(w-1) in absolute
+// value, and any two nonzero digits are at least w positions apart. Returns
+// the number of digits, at most 257.
+int ScalarWnaf(const Scalar& k, int digits[257]) {
+    for (int i = 0; i < 257; ++i) {
+        digits[i] = 0;
+    }
+    int carry = 0;
+    int length = 0;
+    for (int bit = 0; bit < 256;) {
+        if (ScalarBit(k, bit) == carry) {
+            ++bit;
+            continue;
+        }
+        int now = kWnafWindow < 256 - bit ? kWnafWindow : 256 - bit;
+        int word = ScalarBits(k, bit, now) + carry;
+        carry = (word >> (kWnafWindow - 1)) & 1;
+        word -= carry << kWnafWindow;
+        digits[bit] = word;
+        length = bit + 1;
+        bit += now;
+    }
+    if (carry != 0) {
+        digits[256] = carry;
+        length = 257;
+    }
+    return length;
+}
+
+void PointSetAffine(JacobianPoint* r, const AffinePoint& a) {
+    r->x = a.x;
+    r->y = a.y;
+    r->z = kFieldOne;
+    r->infinity = a.infinity;
+}
+
+// 2 * (X, Y, Z) with S = 4XY^2, M = 3X^2. secp256k1 has no point of order
+// two, so a finite point never doubles to infinity.
+void PointDouble(JacobianPoint* r, const JacobianPoint& p) {
+    if (p.infinity) {
+        *r = p;
+        return;
+    }
+    FieldElement yy, s, m, t, x3, y3, z3;
+    FeSqr(&yy, p.y);
+    FeMul(&s, p.x, yy);
+    FeAdd(&s, s, s);
+    FeAdd(&s, s, s);
+    FeSqr(&t, p.x);
+    FeAdd(&m, t, t);
+    FeAdd(&m, m, t);
+    FeSqr(&x3, m);
+    FeSub(&x3, x3, s);
+    FeSub(&x3, x3, s);
+    FeSqr(&t, yy);
+    FeAdd(&t, t, t);
+    FeAdd(&t, t, t);
+    FeAdd(&t, t, t);
+    FeSub(&y3, s, x3);
+    FeMul(&y3, y3, m);
+    FeSub(&y3, y3, t);
+    FeMul(&z3, p.y, p.z);
+    FeAdd(&z3, z3, z3);
+    r->x = x3;
+    r->y = y3;
+    r->z = z3;
+    r->infinity = false;
+}
+
+void PointAdd(JacobianPoint* r, const JacobianPoint& a, const JacobianPoint& b) {
+    if (a.infinity) {
+        *r = b;
+        return;
+    }
+    if (b.infinity) {
+        *r = a;
+        return;
+    }
+    FieldElement z1z1, z2z2, u1, u2, s1, s2, h, rr;
+    FeSqr(&z1z1, a.z);
+    FeSqr(&z2z2, b.z);
+    FeMul(&u1, a.x, z2z2);
+    FeMul(&u2, b.x, z1z1);
+    FeMul(&s1, a.y, b.z);
+    FeMul(&s1, s1, z2z2);
+    FeMul(&s2, b.y, a.z);
+    FeMul(&s2, s2, z1z1);
+    FeSub(&h, u2, u1);
+    FeSub(&rr, s2, s1);
+    if (FeIsZero(h)) {
+        if (FeIsZero(rr)) {
+            PointDouble(r, a);
+        } else {
+            r->infinity = true;
+        }
+        return;
+    }
+    FieldElement hh, hhh, v, x3, y3, z3;
+    FeSqr(&hh, h);
+    FeMul(&hhh, h, hh);
+    FeMul(&v, u1, hh);
+    FeSqr(&x3, rr);
+    FeSub(&x3, x3, hhh);
+    FeSub(&x3, x3, v);
+    FeSub(&x3, x3, v);
+    FeSub(&y3, v, x3);
+    FeMul(&y3, y3, rr);
+    FeMul(&s1, s1, hhh);
+    FeSub(&y3, y3, s1);
+    FeMul(&z3, a.z, b.z);
+    FeMul(&z3, z3, h);
+    r->x = x3;
+    r->y = y3;
+    r->z = z3;
+    r->infinity = false;
+}
+
+void SetAffineFromInverse(const JacobianPoint& p, const FieldElement& zinv, AffinePoint* r) {
+    FieldElement zinv2, zinv3;
+    FeSqr(&zinv2, zinv);
+    FeMul(&zinv3, zinv2, zinv);
+    FeMul(&r->x, p.x, zinv2);
+    FeMul(&r->y, p.y, zinv3);
+    FeNormalize(&r->x);
+    FeNormalize(&r->y);
+    r->infinity = false;
+}
+
+std::vector<AffinePoint> BuildCombTable() {
+    // Tooth t of block b is 2^((b * kCombTeeth + t) * kCombSpacing) * G.
+    std::vector<JacobianPoint> teeth(kCombBlocks * kCombTeeth);
+    JacobianPoint p;
+    PointSetAffine(&p, kGenerator);
+    for (int bit = 0; bit < 256; ++bit) {
+        if (bit % kCombSpacing == 0) {
+            teeth[bit / kCombSpacing] = p;
+        }
+        PointDouble(&p, p);
+    }
+    std::vector<AffinePoint> teeth_affine(teeth.size());
+    PointsToAffine(teeth.data(), teeth.size(), teeth_affine.data());
+
+    // Entry i of a block sums the teeth whose bits are set in i; each one
+    // adds its lowest tooth to the entry without that bit.
+    std::vector<JacobianPoint> entries(kCombBlocks * kCombEntries);
+    for (int b = 0; b < kCombBlocks; ++b) {
+        JacobianPoint* block = &entries[b * kCombEntries];
+        block[0].infinity = true;
+        for (int i = 1; i < kCombEntries; ++i) {
+            block[i] = block[i & (i - 1)];
+            PointAddAffine(&block[i], teeth_affine[b * kCombTeeth + __builtin_ctz(i)]);
+        }
+    }
+    std::vector<AffinePoint> table(entries.size());
+    PointsToAffine(entries.data(), entries.size(), table.data());
+    return table;
+}
+
+const AffinePoint* CombTable() {
+    static const std::vector<AffinePoint> table = BuildCombTable();
+    return table.data();
+}
+
+}  // namespace
+
+bool ScalarSetBytes(const uint8_t bytes[32], Scalar* out) {
+    for (int i = 0; i < 4; ++i) {
+        uint64_t limb = 0;
+        for (int j = 0; j < 8; ++j) {
+            limb = (limb << 8) | bytes[(3 - i) * 8 + j];
+        }
+        out->n[i] = limb;
+    }
+    return !ScalarAtLeastOrder(out->n);
+}
+
+void ScalarGetBytes(const Scalar& scalar, uint8_t bytes[32]) {
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            bytes[(3 - i) * 8 + j] = static_cast<uint8_t>(scalar.n[i] >> (56 - 8 * j));
+        }
+    }
+}
+
+bool ScalarIsZero(const Scalar& scalar) {
+    return (scalar.n[0] | scalar.n[1] | scalar.n[2] | scalar.n[3]) == 0;
+}
+
+void ScalarAdd(Scalar* r, const Scalar& a, const Scalar& b) {
+    uint64_t sum[5];
+    uint128 t = 0;
+    for (int i = 0; i < 4; ++i) {
+        t += static_cast<uint128>(a.n[i]) + b.n[i];
+        sum[i] = static_cast<uint64_t>(t);
+        t >>= 64;
+    }
+    sum[4] = static_cast<uint64_t>(t);
+    ScalarReduce(sum, 5, r);
+}
+
+void ScalarMul(Scalar* r, const Scalar& a, const Scalar& b) {
+    uint64_t t[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        uint128 carry = 0;
+        for (int j = 0; j < 4; ++j) {
+            carry += static_cast<uint128>(a.n[i]) * b.n[j] + t[i + j];
+            t[i + j] = static_cast<uint64_t>(carry);
+            carry >>= 64;
+        }
+        t[i + 4] = static_cast<uint64_t>(carry);
+    }
+    ScalarReduce(t, 8, r);
+}
+
+void ScalarNegate(Scalar* r, const Scalar& a) {
+    if (ScalarIsZero(a)) {
+        *r = a;
+        return;
+    }
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint128 t = static_cast<uint128>(kOrder[i]) - a.n[i] - borrow;
+        r->n[i] = static_cast<uint64_t>(t);
+        borrow = static_cast<uint64_t>(t >> 64) & 1;
+    }
+}
+
+bool ParsePubkey(const uint8_t bytes[33], AffinePoint* out) {
+    if (bytes[0] != 0x02 && bytes[0] != 0x03) {
+        return false;
+    }
+    FieldElement x, y, y2;
+    if (!FeSetBytes(bytes + 1, &x)) {
+        return false;
+    }
+    FeSqr(&y2, x);
+    FeMul(&y2, y2, x);
+    FeAdd(&y2, y2, kCurveB);
+    if (!FeSqrt(&y, y2)) {
+        return false;
+    }
+    FeNormalize(&y);
+    if ((y.n[0] & 1) != (bytes[0] & 1)) {
+        FeNegate(&y, y);
+        FeNormalize(&y);
+    }
+    out->x = x;
+    out->y = y;
+    out->infinity = false;
+    return true;
+}
+
+void SerializePubkey(const AffinePoint& point, uint8_t bytes[33]) {
+    bytes[0] = HasOddY(point) ? 0x03 : 0x02;
+    FeGetBytes(point.x, bytes + 1);
+}
+
+bool HasOddY(const AffinePoint& point) {
+    return (point.y.n[0] & 1) != 0;
+}
+
+void GeneratorMultiply(const Scalar& k, JacobianPoint* r) {
+    const AffinePoint* table = CombTable();
+    JacobianPoint acc;
+    acc.infinity = true;
+    for (int s = kCombSpacing - 1; s >= 0; --s) {
+        PointDouble(&acc, acc);
+        for (int b = 0; b < kCombBlocks; ++b) {
+            int first = b * kCombTeeth * kCombSpacing + s;
+            int index = 0;
+            for (int t = 0; t < kCombTeeth; ++t) {
+                index |= ScalarBit(k, first + t * kCombSpacing) << t;
+            }
+            if (index != 0) {
+                PointAddAffine(&acc, table[b * kCombEntries + index]);
+            }
+        }
+    }
+    *r = acc;
+}
+
+void PointMultiply(const AffinePoint& point, const Scalar& k, JacobianPoint* r) {
+    // Odd multiples 1P, 3P, ..., (2^(w-1) - 1)P.
+    JacobianPoint table[kWnafTableSize];
+    JacobianPoint twice;
+    PointSetAffine(&table[0], point);
+    PointDouble(&twice, table[0]);
+    for (int i = 1; i < kWnafTableSize; ++i) {
+        PointAdd(&table[i], table[i - 1], twice);
+    }
+
+    int digits[257];
+    int length = ScalarWnaf(k, digits);
+    JacobianPoint acc;
+    acc.infinity = true;
+    for (int i = length - 1; i >= 0; --i) {
+        PointDouble(&acc, acc);
+        int digit = digits[i];
+        if (digit > 0) {
+            PointAdd(&acc, acc, table[(digit - 1) / 2]);
+        } else if (digit < 0) {
+            JacobianPoint negated = table[(-digit - 1) / 2];
+            FeNegate(&negated.y, negated.y);
+            PointAdd(&acc, acc, negated);
+        }
+    }
+    *r = acc;
+}
+
+void PointAddAffine(JacobianPoint* r, const AffinePoint& q) {
+    if (q.infinity) {
+        return;
+    }
+    if (r->infinity) {
+        PointSetAffine(r, q);
+        return;
+    }
+    // Mixed addition: q has Z = 1, which saves the multiplications by Z2.
+    FieldElement z1z1, u2, s2, h, rr;
+    FeSqr(&z1z1, r->z);
+    FeMul(&u2, q.x, z1z1);
+    FeMul(&s2, q.y, r->z);
+    FeMul(&s2, s2, z1z1);
+    FeSub(&h, u2, r->x);
+    FeSub(&rr, s2, r->y);
+    if (FeIsZero(h)) {
+        if (FeIsZero(rr)) {
+            PointDouble(r, *r);
+        } else {
+            r->infinity = true;
+        }
+        return;
+    }
+    FieldElement hh, hhh, v, x3, y3;
+    FeSqr(&hh, h);
+    FeMul(&hhh, h, hh);
+    FeMul(&v, r->x, hh);
+    FeSqr(&x3, rr);
+    FeSub(&x3, x3, hhh);
+    FeSub(&x3, x3, v);
+    FeSub(&x3, x3, v);
+    FeSub(&y3, v, x3);
+    FeMul(&y3, y3, rr);
+    FeMul(&hhh, hhh, r->y);
+    FeSub(&y3, y3, hhh);
+    FeMul(&r->z, r->z, h);
+    r->x = x3;
+    r->y = y3;
+}
+
+void PointToAffine(const JacobianPoint& point, AffinePoint* r) {
+    if (point.infinity) {
+        r->infinity = true;
+        return;
+    }
+    FieldElement zinv;
+    FeInv(&zinv, point.z);
+    SetAffineFromInverse(point, zinv, r);
+}
+
+void PointsToAffine(const JacobianPoint* points, size_t count, AffinePoint* out) {
+    // out[i].x first holds the product of the Z coordinates of the finite
+    // points up to i; one inversion of the full product then peels off each
+    // 1 / Z from the back.
+    FieldElement product = kFieldOne;
+    size_t last = count;
+    for (size_t i = 0; i < count; ++i) {
+        if (points[i].infinity) {
+            out[i].infinity = true;
+            continue;
+        }
+        if (last == count) {
+            product = points[i].z;
+        } else {
+            FeMul(&product, product, points[i].z);
+        }
+        out[i].x = product;
+        last = i;
+    }
+    if (last == count) {
+        return;
+    }
+    FieldElement inverse;
+    FeInv(&inverse, product);
+    size_t i = last;
+    while (true) {
+        size_t previous = i;
+        bool has_previous = false;
+        while (previous > 0) {
+            --previous;
+            if (!points[previous].infinity) {
+                has_previous = true;
+                break;
+            }
+        }
+        if (!has_previous) {
+            SetAffineFromInverse(points[i], inverse, &out[i]);
+            return;
+        }
+        FieldElement zinv;
+        FeMul(&zinv, inverse, out[previous].x);
+        FeMul(&inverse, inverse, points[i].z);
+        SetAffineFromInverse(points[i], zinv, &out[i]);
+        i = previous;
+    }
+}
+
+}  // namespace sp_differ
@@ -0,0 +1,67 @@
+#ifndef SP_DIFFER_WORKER_SECP256K1_H
+#define SP_DIFFER_WORKER_SECP256K1_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace sp_differ {
+
+// secp256k1 arithmetic for the C++ worker. It is variable time: the worker
+// derives outputs for test cases, it never holds a wallet's keys.
+
+// An integer mod p = 2^256 - 2^32 - 977 in four little-endian 64-bit limbs.
+// Between operations a value only stays below 2^256; points handed out by
+// this module always carry fully reduced coordinates.
+struct FieldElement {
+    uint64_t n[4];
+};
+
+// An integer mod the group order n, always fully reduced.
+struct Scalar {
+    uint64_t n[4];
+};
+
+struct AffinePoint {
+    FieldElement x;
+    FieldElement y;
+    bool infinity = false;
+};
+
+// (X, Y, Z) stands for the affine point (X / Z^2, Y / Z^3).
+struct JacobianPoint {
+    FieldElement x;
+    FieldElement y;
+    FieldElement z;
+    bool infinity = false;
+};
+
+// Reads a big-endian scalar; false when it is not below n.
+bool ScalarSetBytes(const uint8_t bytes[32], Scalar* out);
+void ScalarGetBytes(const Scalar& scalar, uint8_t bytes[32]);
+bool ScalarIsZero(const Scalar& scalar);
+void ScalarAdd(Scalar* r, const Scalar& a, const Scalar& b);
+void ScalarMul(Scalar* r, const Scalar& a, const Scalar& b);
+void ScalarNegate(Scalar* r, const Scalar& a);
+
+// Parses a 33-byte compressed key; false unless it is a point on the curve
+// with x below p and a 0x02 or 0x03 prefix.
+bool ParsePubkey(const uint8_t bytes[33], AffinePoint* out);
+// Compressed encoding of a finite point.
+void SerializePubkey(const AffinePoint& point, uint8_t bytes[33]);
+bool HasOddY(const AffinePoint& point);
+
+// k * G from a precomputed comb table: a few doublings and one table
+// addition per comb block and column.
+void GeneratorMultiply(const Scalar& k, JacobianPoint* r);
+// k * point with a width-5 NAF of k over the odd multiples of the point.
+void PointMultiply(const AffinePoint& point, const Scalar& k, JacobianPoint* r);
+// r += q for an affine q.
+void PointAddAffine(JacobianPoint* r, const AffinePoint& q);
+void PointToAffine(const JacobianPoint& point, AffinePoint* r);
+// Converts count points with a single field inversion (Montgomery's trick).
+// Points at infinity stay at infinity.
+void PointsToAffine(const JacobianPoint* points, size_t count, AffinePoint* out);
+
+}  // namespace sp_differ
+
+#endif  // SP_DIFFER_WORKER_SECP256K1_H
@@ -1,21 +1,46 @@
 #include "../../ffi/sp_differ.h"
 #include "../../src/core/case.h"
+#include "bip352.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 namespace {
 
-int parse_case_v1(const uint8_t* input, size_t input_len) {
-    if (!input || input_len == 0) {
-        return -1;
+// Appends the serialized result for one case to out.
+void run_case(const uint8_t* input, size_t input_len, std::vector<uint8_t>* out) {
+    sp_differ::CaseView parsed;
+    if (!input || input_len == 0 ||
+        !sp_differ::ParseCaseViewV1(input, input_len, &parsed, nullptr)) {
+        out->push_back(1);
+        out->push_back(static_cast<uint8_t>(SP_DIFFER_STATUS_INVALID_INPUT));
+        out->push_back(0);
+        out->push_back(0);
+        return;
     }
+    sp_differ::AppendSilentPaymentOutputs(parsed, out);
+}
 
-    std::vector<uint8_t> payload(input, input + input_len);
-    sp_differ::Case parsed;
-    std::string error;
-    if (!sp_differ::ParseCaseV1(payload, &parsed, &error)) {
+// The result of a run_into call that returned NEED_BUFFER, kept with a copy
+// of its input so that the retry with a larger buffer copies it out rather
+// than deriving the outputs again.
+struct RunIntoResult {
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    bool pending = false;
+};
+
+int export_buffer(const std::vector<uint8_t>& result, uint8_t** output, size_t* output_len) {
+    uint8_t* buffer = (uint8_t*)malloc(result.empty() ? 1 : result.size());
+    if (!buffer) {
         return -1;
     }
+    if (!result.empty()) {
+        memcpy(buffer, result.data(), result.size());
+    }
+
+    *output = buffer;
+    *output_len = result.size();
     return 0;
 }
 
@@ -31,26 +56,65 @@ int sp_differ_worker_run(const uint8_t* input, size_t input_len, uint8_t** outpu
         return -1;
     }
 
-    sp_differ_status status = SP_DIFFER_STATUS_INVALID_INPUT;
-    if (parse_case_v1(input, input_len) == 0) {
-        status = SP_DIFFER_STATUS_OK;
+    std::vector<uint8_t> result;
+    run_case(input, input_len, &result);
+    return export_buffer(result, output, output_len);
+}
+
+void sp_differ_worker_free(uint8_t* output) {
+    free(output);
+}
+
+uint32_t sp_differ_worker_capabilities(void) {
+    return SP_DIFFER_WORKER_CAP_REENTRANT | SP_DIFFER_WORKER_CAP_BATCH |
+           SP_DIFFER_WORKER_CAP_RUN_INTO;
+}
+
+uint32_t sp_differ_worker_batch_api_version(void) {
+    return SP_DIFFER_WORKER_BATCH_API_VERSION;
+}
+
+int sp_differ_worker_run_batch(const uint8_t* inputs, const size_t* input_offsets,
+                               size_t case_count, uint8_t** output, size_t* output_len,
+                               size_t* output_offsets) {
+    if (!inputs || !input_offsets || !output || !output_len || !output_offsets) {
+        return -1;
     }
 
-    uint8_t* buffer = (uint8_t*)malloc(4);
-    if (!buffer) {
+    std::vector<uint8_t> result;
+    result.reserve(case_count * 4);
+    output_offsets[0] = 0;
+    for (size_t i = 0; i < case_count; ++i) {
+        if (input_offsets[i + 1] < input_offsets[i]) {
+            return -1;
+        }
+        run_case(inputs + input_offsets[i], input_offsets[i + 1] - input_offsets[i], &result);
+        output_offsets[i + 1] = result.size();
+    }
+    return export_buffer(result, output, output_len);
+}
+
+int sp_differ_worker_run_into(const uint8_t* input, size_t input_len, uint8_t* output,
+                              size_t output_capacity, size_t* output_len) {
+    if (!input || !output_len || (!output && output_capacity != 0)) {
         return -1;
     }
 
-    buffer[0] = 1;
-    buffer[1] = static_cast<uint8_t>(status);
-    buffer[2] = 0;
-    buffer[3] = 0;
+    thread_local RunIntoResult result;
+    bool retry = result.pending && result.input.size() == input_len &&
+                 (input_len == 0 || memcmp(result.input.data(), input, input_len) == 0);
+    result.pending = false;
+    if (!retry) {
+        result.output.clear();
+        run_case(input, input_len, &result.output);
+    }
 
-    *output = buffer;
-    *output_len = 4;
+    *output_len = result.output.size();
+    if (result.output.size() > output_capacity) {
+        result.input.assign(input, input + input_len);
+        result.pending = true;
+        return SP_DIFFER_WORKER_NEED_BUFFER;
+    }
+    memcpy(output, result.output.data(), result.output.size());
     return 0;
 }
-
-void sp_differ_worker_free(uint8_t* output) {
-    free(output);
-}
@@ -0,0 +1,193 @@
+//! Case parsing and sender-side BIP352 derivation, following the same
+//! status order as the C++ worker (see workers/cpp/bip352.h).
+
+use crate::secp256k1::{self as secp, Point, U256};
+use crate::sha256::tagged_hash;
+use crate::Status;
+
+const TXID_SIZE: usize = 32;
+const OUTPOINT_SIZE: usize = TXID_SIZE + 4;
+const PRIVKEY_SIZE: usize = 32;
+const PUBKEY_SIZE: usize = 33;
+const FLAG_PRIVKEYS: u32 = 1 << 1;
+const FLAG_PUBKEYS: u32 = 1 << 2;
+const INPUT_TAPROOT: u8 = 0x02;
+/// K_max from BIP352.
+const MAX_OUTPUTS: u16 = 2323;
+
+struct Input<'a> {
+    outpoint: &'a [u8],
+    input_type: u8,
+    privkey: Option<&'a [u8]>,
+    pubkey: Option<&'a [u8]>,
+}
+
+struct Case<'a> {
+    output_count: u16,
+    has_privkeys: bool,
+    inputs: Vec<Input<'a>>,
+    scan_pubkey: &'a [u8],
+    spend_pubkey: &'a [u8],
+    labels: Vec<u32>,
+}
+
+struct Reader<'a> {
+    data: &'a [u8],
+    offset: usize,
+}
+
+impl<'a> Reader<'a> {
+    fn take(&mut self, count: usize) -> Option<&'a [u8]> {
+        if count > self.data.len() - self.offset {
+            return None;
+        }
+        let slice = &self.data[self.offset..self.offset + count];
+        self.offset += count;
+        Some(slice)
+    }
+}
+
+fn u16_at(bytes: &[u8]) -> u16 {
+    u16::from_le_bytes([bytes[0], bytes[1]])
+}
+
+/// Parses a v1 case (spec/FORMAT.md); None for anything malformed.
+fn parse_case(data: &[u8]) -> Option<Case<'_>> {
+    let mut reader = Reader { data, offset: 0 };
+    if reader.take(1)?[0] != 1 {
+        return None;
+    }
+    let header = reader.take(16)?;
+    let flags = u32::from_le_bytes([header[8], header[9], header[10], header[11]]);
+    let input_count = u16_at(&header[12..]);
+    let output_count = u16_at(&header[14..]);
+    let has_privkeys = flags & FLAG_PRIVKEYS != 0;
+    let has_pubkeys = flags & FLAG_PUBKEYS != 0;
+
+    let mut inputs = Vec::with_capacity(input_count as usize);
+    for _ in 0..input_count {
+        let fixed = reader.take(OUTPOINT_SIZE + 1)?;
+        let input_type = fixed[OUTPOINT_SIZE];
+        if !(1..=3).contains(&input_type) {
+            return None;
+        }
+        let privkey = if has_privkeys { Some(reader.take(PRIVKEY_SIZE)?) } else { None };
+        let pubkey = if has_pubkeys { Some(reader.take(PUBKEY_SIZE)?) } else { None };
+        inputs.push(Input { outpoint: &fixed[..OUTPOINT_SIZE], input_type, privkey, pubkey });
+    }
+    let scan_pubkey = reader.take(PUBKEY_SIZE)?;
+    let spend_pubkey = reader.take(PUBKEY_SIZE)?;
+    let label_count = u16_at(reader.take(2)?);
+    let labels = reader
+        .take(label_count as usize * 4)?
+        .chunks(4)
+        .map(|label| u32::from_le_bytes([label[0], label[1], label[2], label[3]]))
+        .collect();
+    if reader.offset != data.len() {
+        return None;
+    }
+    Some(Case { output_count, has_privkeys, inputs, scan_pubkey, spend_pubkey, labels })
+}
+
+fn affine(point: &Point) -> Option<(U256, U256)> {
+    point.to_affine()
+}
+
+fn derive(case: &Case, out: &mut Vec<u8>) -> Result<(), Status> {
+    if case.inputs.is_empty() || !case.has_privkeys || case.output_count > MAX_OUTPUTS {
+        return Err(Status::InvalidInput);
+    }
+    let scan = secp::parse_pubkey(case.scan_pubkey).ok_or(Status::InvalidPubkey)?;
+    let spend = secp::parse_pubkey(case.spend_pubkey).ok_or(Status::InvalidPubkey)?;
+
+    let mut keys = Vec::with_capacity(case.inputs.len());
+    for input in &case.inputs {
+        let key = secp::from_be(input.privkey.unwrap());
+        if secp::is_zero(&key) || !secp::less_than(&key, &secp::N) {
+            return Err(Status::InvalidInput);
+        }
+        if let Some(pubkey) = input.pubkey {
+            secp::parse_pubkey(pubkey).ok_or(Status::InvalidPubkey)?;
+        }
+        keys.push(key);
+    }
+
+    let mut sum: U256 = [0; 4];
+    for (input, key) in case.inputs.iter().zip(&keys) {
+        let mut key = *key;
+        if input.pubkey.is_some() || input.input_type == INPUT_TAPROOT {
+            let (x, y) = affine(&Point::generator().mul(&key)).ok_or(Status::Internal)?;
+            if let Some(pubkey) = input.pubkey {
+                if secp::serialize(&x, &y)[..] != pubkey[..] {
+                    return Err(Status::InvalidInput);
+                }
+            }
+            if input.input_type == INPUT_TAPROOT && y[0] & 1 == 1 {
+                key = secp::sub_mod(&[0; 4], &key, &secp::N);
+            }
+        }
+        sum = secp::add_mod(&sum, &key, &secp::N);
+    }
+    if secp::is_zero(&sum) {
+        return Err(Status::ZeroScalar);
+    }
+
+    let (ax, ay) = affine(&Point::generator().mul(&sum)).ok_or(Status::Internal)?;
+    let smallest = case.inputs.iter().map(|input| input.outpoint).min().unwrap();
+    let input_hash =
+        secp::from_be(&tagged_hash("BIP0352/Inputs", &[smallest, &secp::serialize(&ax, &ay)]));
+    if secp::is_zero(&input_hash) || !secp::less_than(&input_hash, &secp::N) {
+        return Err(Status::TweakOutOfRange);
+    }
+    let ecdh = secp::mul_mod_slow(&input_hash, &sum, &secp::N);
+    let (sx, sy) = affine(&scan.mul(&ecdh)).ok_or(Status::Internal)?;
+    let shared = secp::serialize(&sx, &sy);
+
+    // Without labels every output pays the spend key; with labels they pay
+    // spend + m * G for each label m in turn.
+    let recipients = if case.labels.is_empty() {
+        vec![spend]
+    } else {
+        let mut recipients = Vec::with_capacity(case.labels.len());
+        for &label in &case.labels {
+            let labeled = spend.add(&Point::generator().mul(&[label as u64, 0, 0, 0]));
+            let (x, y) = affine(&labeled).ok_or(Status::PointAtInfinity)?;
+            recipients.push(Point::affine(x, y));
+        }
+        recipients
+    };
+
+    let count = case.output_count as usize;
+    let mut pubkeys = Vec::with_capacity(count * PUBKEY_SIZE);
+    let mut tweaks = Vec::with_capacity(count * 32);
+    let mut points = Vec::with_capacity(count);
+    for k in 0..count as u32 {
+        let tweak = tagged_hash("BIP0352/SharedSecret", &[&shared, &k.to_be_bytes()]);
+        let t = secp::from_be(&tweak);
+        if !secp::less_than(&t, &secp::N) {
+            return Err(Status::TweakOutOfRange);
+        }
+        tweaks.extend_from_slice(&tweak);
+        let recipient = &recipients[k as usize % recipients.len()];
+        points.push(recipient.add(&Point::generator().mul(&t)));
+    }
+    for point in &points {
+        let (x, y) = affine(point).ok_or(Status::PointAtInfinity)?;
+        pubkeys.extend_from_slice(&secp::serialize(&x, &y));
+    }
+    out.extend_from_slice(&[1, Status::Ok as u8, count as u8, (count >> 8) as u8]);
+    out.extend_from_slice(&pubkeys);
+    out.extend_from_slice(&tweaks);
+    Ok(())
+}
+
+/// Appends the v1 result for one case payload.
+pub fn run_case(data: &[u8], out: &mut Vec<u8>) {
+    let result = match parse_case(data) {
+        Some(case) => derive(&case, out),
+        None => Err(Status::InvalidInput),
+    };
+    if let Err(status) = result {
+        out.extend_from_slice(&[1, status as u8, 0, 0]);
+    }
+}
@@ -1,11 +1,36 @@
+mod bip352;
+mod secp256k1;
+mod sha256;
+
 use libc::{free, malloc};
+use std::cell::RefCell;
 use std::ptr;
 
 const WORKER_API_VERSION: u32 = 1;
+const WORKER_BATCH_API_VERSION: u32 = 1;
+const WORKER_NEED_BUFFER: i32 = 1;
+
+const WORKER_CAP_REENTRANT: u32 = 1 << 0;
+const WORKER_CAP_BATCH: u32 = 1 << 1;
+const WORKER_CAP_RUN_INTO: u32 = 1 << 2;
+
+// The result of a run_into call that returned WORKER_NEED_BUFFER, kept with a
+// copy of its input so that the retry with a larger buffer copies it out
+// rather than deriving the outputs again.
+#[derive(Default)]
+struct RunIntoResult {
+    input: Vec<u8>,
+    output: Vec<u8>,
+    pending: bool,
+}
+
+thread_local! {
+    static RUN_INTO_RESULT: RefCell<RunIntoResult> = RefCell::new(RunIntoResult::default());
+}
 
 #[repr(u32)]
 #[allow(dead_code)]
-enum Status {
+pub(crate) enum Status {
     Ok = 0,
     InvalidInput = 1,
     PointAtInfinity = 2,
@@ -15,16 +40,29 @@ enum Status {
     Internal = 255,
 }
 
-fn validate_case_header(input: *const u8, input_len: usize) -> bool {
+fn run_case(input: *const u8, input_len: usize, out: &mut Vec<u8>) {
     if input.is_null() {
-        return false;
+        out.extend_from_slice(&[1u8, Status::InvalidInput as u8, 0, 0]);
+        return;
     }
-    if input_len < 17 {
-        return false;
+    let slice = unsafe { std::slice::from_raw_parts(input, input_len) };
+    bip352::run_case(slice, out);
+}
+
+fn export_buffer(payload: &[u8], output: *mut *mut u8, output_len: *mut usize) -> i32 {
+    let size = payload.len();
+
+    unsafe {
+        let ptr = malloc(size.max(1)) as *mut u8;
+        if ptr.is_null() {
+            return -1;
+        }
+        ptr::copy_nonoverlapping(payload.as_ptr(), ptr, size);
+        *output = ptr;
+        *output_len = size;
     }
 
-    let slice = unsafe { std::slice::from_raw_parts(input, input_len) };
-    slice[0] == 1
+    0
 }
 
 #[no_mangle]
@@ -43,31 +81,99 @@ pub extern "C" fn sp_differ_worker_run(
         return -1;
     }
 
-    let status = if validate_case_header(input, input_len) {
-        Status::Ok
-    } else {
-        Status::InvalidInput
-    };
+    let mut payload = Vec::with_capacity(4);
+    run_case(input, input_len, &mut payload);
+    export_buffer(&payload, output, output_len)
+}
 
-    let payload = [1u8, status as u8, 0, 0];
-    let size = payload.len();
+#[no_mangle]
+pub extern "C" fn sp_differ_worker_free(output: *mut u8) {
+    if !output.is_null() {
+        unsafe { free(output as *mut libc::c_void) };
+    }
+}
 
-    unsafe {
-        let ptr = malloc(size) as *mut u8;
-        if ptr.is_null() {
+#[no_mangle]
+pub extern "C" fn sp_differ_worker_capabilities() -> u32 {
+    WORKER_CAP_REENTRANT | WORKER_CAP_BATCH | WORKER_CAP_RUN_INTO
+}
+
+#[no_mangle]
+pub extern "C" fn sp_differ_worker_batch_api_version() -> u32 {
+    WORKER_BATCH_API_VERSION
+}
+
+#[no_mangle]
+pub extern "C" fn sp_differ_worker_run_batch(
+    inputs: *const u8,
+    input_offsets: *const usize,
+    case_count: usize,
+    output: *mut *mut u8,
+    output_len: *mut usize,
+    output_offsets: *mut usize,
+) -> i32 {
+    if inputs.is_null()
+        || input_offsets.is_null()
+        || output.is_null()
+        || output_len.is_null()
+        || output_offsets.is_null()
+    {
+        return -1;
+    }
+
+    let in_offsets = unsafe { std::slice::from_raw_parts(input_offsets, case_count + 1) };
+    let out_offsets = unsafe { std::slice::from_raw_parts_mut(output_offsets, case_count + 1) };
+
+    let mut payload = Vec::with_capacity(case_count * 4);
+    out_offsets[0] = 0;
+    for i in 0..case_count {
+        let (begin, end) = (in_offsets[i], in_offsets[i + 1]);
+        if end < begin {
             return -1;
         }
-        ptr::copy_nonoverlapping(payload.as_ptr(), ptr, size);
-        *output = ptr;
-        *output_len = size;
+        run_case(unsafe { inputs.add(begin) }, end - begin, &mut payload);
+        out_offsets[i + 1] = payload.len();
     }
 
-    0
+    export_buffer(&payload, output, output_len)
 }
 
 #[no_mangle]
-pub extern "C" fn sp_differ_worker_free(output: *mut u8) {
-    if !output.is_null() {
-        unsafe { free(output as *mut libc::c_void) };
+pub extern "C" fn sp_differ_worker_run_into(
+    input: *const u8,
+    input_len: usize,
+    output: *mut u8,
+    output_capacity: usize,
+    output_len: *mut usize,
+) -> i32 {
+    if output_len.is_null() || (output.is_null() && output_capacity != 0) {
+        return -1;
     }
+
+    RUN_INTO_RESULT.with(|cell| {
+        let mut result = cell.borrow_mut();
+        let input_slice: &[u8] = if input.is_null() {
+            &[]
+        } else {
+            unsafe { std::slice::from_raw_parts(input, input_len) }
+        };
+        let retry = result.pending && !input.is_null() && result.input == input_slice;
+        result.pending = false;
+        if !retry {
+            result.output.clear();
+            run_case(input, input_len, &mut result.output);
+        }
+
+        unsafe {
+            *output_len = result.output.len();
+            if result.output.len() > output_capacity {
+                result.input.clear();
+                result.input.extend_from_slice(input_slice);
+                result.pending = !input.is_null();
+                return WORKER_NEED_BUFFER;
+            }
+            ptr::copy_nonoverlapping(result.output.as_ptr(), output, result.output.len());
+        }
+        0
+    })
 }
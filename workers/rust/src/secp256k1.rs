@@ -0,0 +1,322 @@
+//! Straightforward secp256k1 arithmetic on 256-bit integers.
+//!
+//! This is the reference side of the differential: it favours obviously
+//! correct code over speed, and shares no tables or tricks with the C++
+//! worker. Inversions and square roots are plain exponentiations, and point
+//! multiplication uses a fixed 4-bit window.
+
+/// Little-endian 64-bit limbs.
+pub type U256 = [u64; 4];
+
+pub const P: U256 = [
+    0xfffffffefffffc2f,
+    0xffffffffffffffff,
+    0xffffffffffffffff,
+    0xffffffffffffffff,
+];
+pub const N: U256 = [
+    0xbfd25e8cd0364141,
+    0xbaaedce6af48a03b,
+    0xfffffffffffffffe,
+    0xffffffffffffffff,
+];
+const GX: U256 = [
+    0x59f2815b16f81798,
+    0x029bfcdb2dce28d9,
+    0x55a06295ce870b07,
+    0x79be667ef9dcbbac,
+];
+const GY: U256 = [
+    0x9c47d08ffb10d4b8,
+    0xfd17b448a6855419,
+    0x5da4fbfc0e1108a8,
+    0x483ada7726a3c465,
+];
+
+pub fn from_be(bytes: &[u8]) -> U256 {
+    let mut r = [0u64; 4];
+    for i in 0..4 {
+        let start = 24 - 8 * i;
+        r[i] = u64::from_be_bytes(bytes[start..start + 8].try_into().unwrap());
+    }
+    r
+}
+
+pub fn to_be(a: &U256) -> [u8; 32] {
+    let mut out = [0u8; 32];
+    for i in 0..4 {
+        out[24 - 8 * i..32 - 8 * i].copy_from_slice(&a[i].to_be_bytes());
+    }
+    out
+}
+
+pub fn is_zero(a: &U256) -> bool {
+    a.iter().all(|&limb| limb == 0)
+}
+
+pub fn less_than(a: &U256, b: &U256) -> bool {
+    for i in (0..4).rev() {
+        if a[i] != b[i] {
+            return a[i] < b[i];
+        }
+    }
+    false
+}
+
+/// (a + b, carry out of 2^256).
+fn add_raw(a: &U256, b: &U256) -> (U256, bool) {
+    let mut r = [0u64; 4];
+    let mut carry = 0u128;
+    for i in 0..4 {
+        let t = a[i] as u128 + b[i] as u128 + carry;
+        r[i] = t as u64;
+        carry = t >> 64;
+    }
+    (r, carry != 0)
+}
+
+/// (a - b, borrow).
+fn sub_raw(a: &U256, b: &U256) -> (U256, bool) {
+    let mut r = [0u64; 4];
+    let mut borrow = false;
+    for i in 0..4 {
+        let (d1, b1) = a[i].overflowing_sub(b[i]);
+        let (d2, b2) = d1.overflowing_sub(borrow as u64);
+        r[i] = d2;
+        borrow = b1 || b2;
+    }
+    (r, borrow)
+}
+
+/// (a + b) mod m for a, b < m.
+pub fn add_mod(a: &U256, b: &U256, m: &U256) -> U256 {
+    let (sum, carry) = add_raw(a, b);
+    if carry || !less_than(&sum, m) {
+        sub_raw(&sum, m).0
+    } else {
+        sum
+    }
+}
+
+/// (a - b) mod m for a, b < m.
+pub fn sub_mod(a: &U256, b: &U256, m: &U256) -> U256 {
+    let (diff, borrow) = sub_raw(a, b);
+    if borrow {
+        add_raw(&diff, m).0
+    } else {
+        diff
+    }
+}
+
+/// a * b mod m by binary long multiplication. Only used for the handful of
+/// scalar products per case.
+pub fn mul_mod_slow(a: &U256, b: &U256, m: &U256) -> U256 {
+    let mut r = [0u64; 4];
+    for bit in (0..256).rev() {
+        r = add_mod(&r, &r, m);
+        if (b[bit / 64] >> (bit % 64)) & 1 == 1 {
+            r = add_mod(&r, a, m);
+        }
+    }
+    r
+}
+
+/// a * b mod p, using 2^256 = 2^32 + 977 (mod p).
+pub fn fmul(a: &U256, b: &U256) -> U256 {
+    let mut t = [0u64; 8];
+    for i in 0..4 {
+        let mut carry = 0u128;
+        for j in 0..4 {
+            let v = a[i] as u128 * b[j] as u128 + t[i + j] as u128 + carry;
+            t[i + j] = v as u64;
+            carry = v >> 64;
+        }
+        t[i + 4] = carry as u64;
+    }
+    const C: u128 = 0x1000003d1;
+    // Fold the high half: value = lo + hi * C, at most 2^256 * 2^34.
+    let mut r = [0u64; 5];
+    let mut carry = 0u128;
+    for i in 0..4 {
+        let v = t[i] as u128 + t[i + 4] as u128 * C + carry;
+        r[i] = v as u64;
+        carry = v >> 64;
+    }
+    r[4] = carry as u64;
+    // Fold the top limb again, then subtract p while needed.
+    let mut out = [0u64; 4];
+    let mut carry = r[4] as u128 * C;
+    for i in 0..4 {
+        let v = r[i] as u128 + carry;
+        out[i] = v as u64;
+        carry = v >> 64;
+    }
+    if carry != 0 {
+        out = add_raw(&out, &[C as u64, 0, 0, 0]).0;
+    }
+    while !less_than(&out, &P) {
+        out = sub_raw(&out, &P).0;
+    }
+    out
+}
+
+pub fn fpow(a: &U256, e: &U256) -> U256 {
+    let mut r: U256 = [1, 0, 0, 0];
+    for bit in (0..256).rev() {
+        r = fmul(&r, &r);
+        if (e[bit / 64] >> (bit % 64)) & 1 == 1 {
+            r = fmul(&r, a);
+        }
+    }
+    r
+}
+
+pub fn finv(a: &U256) -> U256 {
+    fpow(a, &sub_raw(&P, &[2, 0, 0, 0]).0)
+}
+
+/// A square root of a, if a is a square mod p.
+pub fn fsqrt(a: &U256) -> Option<U256> {
+    // (p + 1) / 4
+    let (p1, _) = add_raw(&P, &[1, 0, 0, 0]);
+    let e = [
+        (p1[0] >> 2) | (p1[1] << 62),
+        (p1[1] >> 2) | (p1[2] << 62),
+        (p1[2] >> 2) | (p1[3] << 62),
+        p1[3] >> 2,
+    ];
+    let r = fpow(a, &e);
+    if fmul(&r, &r) == *a {
+        Some(r)
+    } else {
+        None
+    }
+}
+
+/// Jacobian point; z == 0 stands for infinity.
+#[derive(Clone, Copy)]
+pub struct Point {
+    x: U256,
+    y: U256,
+    z: U256,
+}
+
+pub const INFINITY: Point = Point {
+    x: [0; 4],
+    y: [1, 0, 0, 0],
+    z: [0; 4],
+};
+
+impl Point {
+    pub fn affine(x: U256, y: U256) -> Point {
+        Point { x, y, z: [1, 0, 0, 0] }
+    }
+
+    pub fn generator() -> Point {
+        Point::affine(GX, GY)
+    }
+
+    pub fn is_infinity(&self) -> bool {
+        is_zero(&self.z)
+    }
+
+    pub fn double(&self) -> Point {
+        if self.is_infinity() {
+            return *self;
+        }
+        // a = 0: lambda = 3x^2 / 2y in Jacobian form.
+        let xx = fmul(&self.x, &self.x);
+        let yy = fmul(&self.y, &self.y);
+        let yyyy = fmul(&yy, &yy);
+        let xyy = fmul(&self.x, &yy);
+        let s = add_mod(&add_mod(&xyy, &xyy, &P), &add_mod(&xyy, &xyy, &P), &P);
+        let m = add_mod(&add_mod(&xx, &xx, &P), &xx, &P);
+        let x3 = sub_mod(&sub_mod(&fmul(&m, &m), &s, &P), &s, &P);
+        let y4_2 = add_mod(&yyyy, &yyyy, &P);
+        let y4_4 = add_mod(&y4_2, &y4_2, &P);
+        let y4_8 = add_mod(&y4_4, &y4_4, &P);
+        let y3 = sub_mod(&fmul(&m, &sub_mod(&s, &x3, &P)), &y4_8, &P);
+        let yz = fmul(&self.y, &self.z);
+        Point { x: x3, y: y3, z: add_mod(&yz, &yz, &P) }
+    }
+
+    pub fn add(&self, other: &Point) -> Point {
+        if self.is_infinity() {
+            return *other;
+        }
+        if other.is_infinity() {
+            return *self;
+        }
+        let z1z1 = fmul(&self.z, &self.z);
+        let z2z2 = fmul(&other.z, &other.z);
+        let u1 = fmul(&self.x, &z2z2);
+        let u2 = fmul(&other.x, &z1z1);
+        let s1 = fmul(&fmul(&self.y, &other.z), &z2z2);
+        let s2 = fmul(&fmul(&other.y, &self.z), &z1z1);
+        if u1 == u2 {
+            return if s1 == s2 { self.double() } else { INFINITY };
+        }
+        let h = sub_mod(&u2, &u1, &P);
+        let r = sub_mod(&s2, &s1, &P);
+        let hh = fmul(&h, &h);
+        let hhh = fmul(&h, &hh);
+        let v = fmul(&u1, &hh);
+        let x3 = sub_mod(&sub_mod(&sub_mod(&fmul(&r, &r), &hhh, &P), &v, &P), &v, &P);
+        let y3 = sub_mod(&fmul(&r, &sub_mod(&v, &x3, &P)), &fmul(&s1, &hhh), &P);
+        let z3 = fmul(&fmul(&self.z, &other.z), &h);
+        Point { x: x3, y: y3, z: z3 }
+    }
+
+    /// k * self with a fixed 4-bit window, most significant nibble first.
+    pub fn mul(&self, k: &U256) -> Point {
+        let mut table = [INFINITY; 16];
+        for i in 1..16 {
+            table[i] = table[i - 1].add(self);
+        }
+        let mut acc = INFINITY;
+        for nibble in (0..64).rev() {
+            for _ in 0..4 {
+                acc = acc.double();
+            }
+            let digit = (k[nibble / 16] >> ((nibble % 16) * 4)) & 15;
+            acc = acc.add(&table[digit as usize]);
+        }
+        acc
+    }
+
+    /// (x, y) with both below p, or None at infinity.
+    pub fn to_affine(&self) -> Option<(U256, U256)> {
+        if self.is_infinity() {
+            return None;
+        }
+        let zinv = finv(&self.z);
+        let zinv2 = fmul(&zinv, &zinv);
+        let zinv3 = fmul(&zinv2, &zinv);
+        Some((fmul(&self.x, &zinv2), fmul(&self.y, &zinv3)))
+    }
+}
+
+/// Decodes a 33-byte compressed public key.
+pub fn parse_pubkey(bytes: &[u8]) -> Option<Point> {
+    if bytes.len() != 33 || (bytes[0] != 2 && bytes[0] != 3) {
+        return None;
+    }
+    let x = from_be(&bytes[1..]);
+    if !less_than(&x, &P) {
+        return None;
+    }
+    let rhs = add_mod(&fmul(&fmul(&x, &x), &x), &[7, 0, 0, 0], &P);
+    let mut y = fsqrt(&rhs)?;
+    if (y[0] & 1) as u8 != bytes[0] & 1 {
+        y = sub_mod(&[0; 4], &y, &P);
+    }
+    Some(Point::affine(x, y))
+}
+
+/// Compressed encoding of an affine point.
+pub fn serialize(x: &U256, y: &U256) -> [u8; 33] {
+    let mut out = [0u8; 33];
+    out[0] = 2 | (y[0] & 1) as u8;
+    out[1..].copy_from_slice(&to_be(x));
+    out
+}